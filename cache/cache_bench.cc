@@ -14,6 +14,9 @@ int main() {
 #include <cinttypes>
 #include <sys/types.h>
 #include <stdio.h>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include "port/port.h"
 #include "rocksdb/cache.h"
@@ -43,7 +46,18 @@ DEFINE_int32(lookup_percent, 50,
 DEFINE_int32(erase_percent, 10,
              "Ratio of erase to total workload (expressed as a percentage)");
 
-DEFINE_bool(use_clock_cache, false, "");
+DEFINE_int32(hot_key_percent, 0,
+             "Ratio of operations on the first num_hot_keys keys (expressed "
+             "as a percentage), to run a skewed workload");
+DEFINE_int64(num_hot_keys, 16, "Number of hot keys");
+DEFINE_bool(replicate_hot_entries, false,
+            "Replicate the hot entries of lru_cache on each core");
+
+DEFINE_bool(use_clock_cache, false, "Same as --cache_type=clock_cache.");
+DEFINE_string(cache_type, "lru_cache",
+              "Type of cache to run the workload on: lru_cache, clock_cache, "
+              "or a comma separated list of them to run it on each in turn, "
+              "e.g. lru_cache,clock_cache --threads=64 to compare them.");
 
 namespace rocksdb {
 
@@ -128,17 +142,8 @@ struct ThreadState {
 
 class CacheBench {
  public:
-  CacheBench() : num_threads_(FLAGS_threads) {
-    if (FLAGS_use_clock_cache) {
-      cache_ = NewClockCache(FLAGS_cache_size, FLAGS_num_shard_bits);
-      if (!cache_) {
-        fprintf(stderr, "Clock cache not supported.\n");
-        exit(1);
-      }
-    } else {
-      cache_ = NewLRUCache(FLAGS_cache_size, FLAGS_num_shard_bits);
-    }
-  }
+  explicit CacheBench(std::shared_ptr<Cache> cache)
+      : cache_(std::move(cache)), num_threads_(FLAGS_threads) {}
 
   ~CacheBench() {}
 
@@ -151,6 +156,13 @@ class CacheBench {
       // do insert
       cache_->Insert(key, new char[10], 1, &deleter);
     }
+    if (FLAGS_hot_key_percent > 0) {
+      for (uint64_t hot_key = 0;
+           hot_key < static_cast<uint64_t>(FLAGS_num_hot_keys); hot_key++) {
+        Slice key(reinterpret_cast<char*>(&hot_key), 8);
+        cache_->Insert(key, new char[10], 1, &deleter);
+      }
+    }
   }
 
   bool Run() {
@@ -185,7 +197,8 @@ class CacheBench {
       double elapsed = static_cast<double>(end_time - start_time) * 1e-6;
       uint32_t qps = static_cast<uint32_t>(
           static_cast<double>(FLAGS_threads * FLAGS_ops_per_thread) / elapsed);
-      fprintf(stdout, "Complete in %.3f s; QPS = %u\n", elapsed, qps);
+      fprintf(stdout, "%s: Complete in %.3f s; QPS = %u\n", cache_->Name(),
+              elapsed, qps);
     }
     return true;
   }
@@ -221,7 +234,10 @@ class CacheBench {
 
   void OperateCache(ThreadState* thread) {
     for (uint64_t i = 0; i < FLAGS_ops_per_thread; i++) {
-      uint64_t rand_key = thread->rnd.Next() % FLAGS_max_key;
+      uint64_t rand_key =
+          static_cast<int32_t>(thread->rnd.Uniform(100)) < FLAGS_hot_key_percent
+              ? thread->rnd.Next() % FLAGS_num_hot_keys
+              : thread->rnd.Next() % FLAGS_max_key;
       // Cast uint64* to be char*, data would be copied to cache
       Slice key(reinterpret_cast<char*>(&rand_key), 8);
       int32_t prob_op = thread->rnd.Uniform(100);
@@ -245,6 +261,7 @@ class CacheBench {
 
   void PrintEnv() const {
     printf("RocksDB version     : %d.%d\n", kMajorVersion, kMinorVersion);
+    printf("Cache               : %s\n", cache_->Name());
     printf("Number of threads   : %d\n", FLAGS_threads);
     printf("Ops per thread      : %" PRIu64 "\n", FLAGS_ops_per_thread);
     printf("Cache size          : %" PRIu64 "\n", FLAGS_cache_size);
@@ -254,6 +271,9 @@ class CacheBench {
     printf("Insert percentage   : %d%%\n", FLAGS_insert_percent);
     printf("Lookup percentage   : %d%%\n", FLAGS_lookup_percent);
     printf("Erase percentage    : %d%%\n", FLAGS_erase_percent);
+    printf("Hot key percentage  : %d%%\n", FLAGS_hot_key_percent);
+    printf("Number of hot keys  : %" PRIu64 "\n", FLAGS_num_hot_keys);
+    printf("Replicate hot keys  : %d\n", FLAGS_replicate_hot_entries);
     printf("----------------------------\n");
   }
 };
@@ -267,15 +287,43 @@ int main(int argc, char** argv) {
     exit(1);
   }
 
-  rocksdb::CacheBench bench;
-  if (FLAGS_populate_cache) {
-    bench.PopulateCache();
+  if (FLAGS_use_clock_cache) {
+    FLAGS_cache_type = "clock_cache";
   }
-  if (bench.Run()) {
-    return 0;
-  } else {
-    return 1;
+  std::vector<std::shared_ptr<rocksdb::Cache>> caches;
+  std::stringstream cache_types(FLAGS_cache_type);
+  std::string cache_type;
+  while (std::getline(cache_types, cache_type, ',')) {
+    std::shared_ptr<rocksdb::Cache> cache;
+    if (cache_type == "lru_cache") {
+      rocksdb::LRUCacheOptions opts(FLAGS_cache_size, FLAGS_num_shard_bits,
+                                    false /* strict_capacity_limit */,
+                                    0.5 /* high_pri_pool_ratio */);
+      opts.replicate_hot_entries = FLAGS_replicate_hot_entries;
+      cache = rocksdb::NewLRUCache(opts);
+    } else if (cache_type == "clock_cache") {
+      cache = rocksdb::NewClockCache(FLAGS_cache_size, FLAGS_num_shard_bits);
+      if (!cache) {
+        fprintf(stderr, "Clock cache not supported.\n");
+        exit(1);
+      }
+    } else {
+      fprintf(stderr, "Unknown cache type: %s\n", cache_type.c_str());
+      exit(1);
+    }
+    caches.push_back(std::move(cache));
+  }
+
+  for (auto& cache : caches) {
+    rocksdb::CacheBench bench(std::move(cache));
+    if (FLAGS_populate_cache) {
+      bench.PopulateCache();
+    }
+    if (!bench.Run()) {
+      return 1;
+    }
   }
+  return 0;
 }
 
 #endif  // GFLAGS
@@ -9,6 +9,7 @@
 
 #include "rocksdb/cache.h"
 
+#include <atomic>
 #include <forward_list>
 #include <functional>
 #include <iostream>
@@ -696,6 +697,50 @@ TEST_P(CacheTest, GetCharge) {
   cache_->Release(h1);
 }
 
+TEST_P(CacheTest, ConcurrentLookup) {
+  std::shared_ptr<Cache> cache = NewCache(1 << 20, 0, false);
+  const int kNumKeys = 100;
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_OK(cache->Insert(EncodeKey(i), EncodeValue(i), 1, &dumbDeleter));
+  }
+
+  // Lookups race with inserts and erases of other keys, which move the
+  // looked up entries around in the cache's internal structures.
+  std::atomic<bool> done(false);
+  std::atomic<int> mismatches(0);
+  std::vector<port::Thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&]() {
+      while (!done.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < kNumKeys; i++) {
+          Cache::Handle* h = cache->Lookup(EncodeKey(i));
+          if (h != nullptr) {
+            if (DecodeValue(cache->Value(h)) != i) {
+              mismatches.fetch_add(1, std::memory_order_relaxed);
+            }
+            cache->Release(h);
+          }
+        }
+      }
+    });
+  }
+  for (int i = kNumKeys; i < 20 * kNumKeys; i++) {
+    ASSERT_OK(cache->Insert(EncodeKey(i), EncodeValue(i), 1, &dumbDeleter));
+    if (i % 2 == 1) {
+      cache->Erase(EncodeKey(i - 1));
+    }
+  }
+  done.store(true, std::memory_order_relaxed);
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  ASSERT_EQ(0, mismatches.load());
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_EQ(i, Lookup(cache, i));
+  }
+}
+
 #ifdef SUPPORT_CLOCK_CACHE
 std::shared_ptr<Cache> (*new_clock_cache_func)(size_t, int,
                                                bool) = NewClockCache;
@@ -26,13 +26,8 @@ std::shared_ptr<Cache> NewClockCache(size_t /*capacity*/, int /*num_shard_bits*/
 #include <assert.h>
 #include <atomic>
 #include <deque>
-
-// "tbb/concurrent_hash_map.h" requires RTTI if exception is enabled.
-// Disable it so users can chooose to disable RTTI.
-#ifndef ROCKSDB_USE_RTTI
-#define TBB_USE_EXCEPTIONS 0
-#endif
-#include "tbb/concurrent_hash_map.h"
+#include <memory>
+#include <vector>
 
 #include "cache/sharded_cache.h"
 #include "port/port.h"
@@ -59,9 +54,9 @@ namespace {
 // to be re-use. This is to avoid memory dealocation, which is hard to deal
 // with in concurrent environment.
 //
-// The cache also maintains a concurrent hash map for lookup. Any concurrent
-// hash map implementation should do the work. We currently use
-// tbb::concurrent_hash_map because it supports concurrent erase.
+// The cache also maintains a concurrent hash map for lookup. It is an
+// open-addressed table of handle pointers (ClockHandleTable below), which
+// readers probe without any lock while writers serialize on the mutex.
 //
 // Each cache handle has the following flags and counters, which are squeeze
 // in an atomic interger, to make sure the handle always be in a consistent
@@ -204,25 +199,190 @@ struct CacheHandle {
   }
 };
 
-// Key of hash map. We store hash value with the key for convenience.
-struct CacheKey {
-  Slice key;
-  uint32_t hash_value;
+// Hash map from the key of a cache entry to its handle, open-addressed with
+// linear probing. Each slot holds a handle pointer together with the hash of
+// its key, so that a probe only dereferences handles whose hash matches.
+//
+// Only Find() can be called without holding the shard mutex. It never
+// blocks, and in exchange it is allowed to be wrong in two benign ways:
+//   * A handle it returns may be evicted, erased or even re-used for another
+//     key at any time. Callers have to hold a reference to the handle and
+//     check its key again before using it, as ClockCacheShard::Lookup() does.
+//   * It may miss an entry moved by a concurrent Remove(), which is reported
+//     as a cache miss.
+// Handles are never freed while the cache is alive (see list_ below), so a
+// stale pointer read by Find() is always safe to dereference.
+//
+// Slot arrays are doubled when half full. The old arrays are kept until the
+// table is destroyed since lock-free readers may still be probing them; as
+// the table never shrinks, they take less memory than the current array.
+class ClockHandleTable {
+ public:
+  ClockHandleTable() : size_(0) {
+    arrays_.emplace_back(new SlotArray(kInitialSlots));
+    array_.store(arrays_.back().get(), std::memory_order_relaxed);
+  }
 
-  CacheKey() = default;
+  // Call `match` on the handles whose key may have the hash, in probe order,
+  // and return the first one it accepts, or nullptr.
+  //
+  // Not necessary to hold mutex before being called.
+  template <typename Match>
+  CacheHandle* Find(uint32_t hash, const Match& match) const {
+    const SlotArray* array = array_.load(std::memory_order_acquire);
+    for (size_t i = hash & array->mask, probes = 0; probes <= array->mask;
+         i = (i + 1) & array->mask, probes++) {
+      const Slot& slot = array->slots[i];
+      CacheHandle* handle = slot.handle.load(std::memory_order_acquire);
+      if (handle == nullptr) {
+        break;
+      }
+      if (slot.hash.load(std::memory_order_relaxed) == hash && match(handle)) {
+        return handle;
+      }
+    }
+    return nullptr;
+  }
 
-  CacheKey(const Slice& k, uint32_t h) {
-    key = k;
-    hash_value = h;
+  // Insert the handle. If the table has a handle of the same key, replace and
+  // return it, return nullptr otherwise.
+  //
+  // Has to hold mutex before being called.
+  CacheHandle* Insert(CacheHandle* handle) {
+    SlotArray* array = array_.load(std::memory_order_relaxed);
+    size_t i = FindSlot(*array, handle->key, handle->hash);
+    CacheHandle* existing =
+        array->slots[i].handle.load(std::memory_order_relaxed);
+    if (existing != nullptr) {
+      array->slots[i].handle.store(handle, std::memory_order_release);
+      return existing;
+    }
+    if ((size_ + 1) * 2 > array->mask + 1) {
+      array = Grow();
+      i = FindSlot(*array, handle->key, handle->hash);
+    }
+    Set(array, i, handle->hash, handle);
+    size_++;
+    return nullptr;
   }
 
-  static bool equal(const CacheKey& a, const CacheKey& b) {
-    return a.hash_value == b.hash_value && a.key == b.key;
+  // Remove and return the handle of the key, or nullptr if there is none.
+  //
+  // Has to hold mutex before being called.
+  CacheHandle* Remove(const Slice& key, uint32_t hash) {
+    SlotArray* array = array_.load(std::memory_order_relaxed);
+    size_t i = FindSlot(*array, key, hash);
+    CacheHandle* handle =
+        array->slots[i].handle.load(std::memory_order_relaxed);
+    if (handle != nullptr) {
+      RemoveSlot(array, i);
+    }
+    return handle;
   }
 
-  static size_t hash(const CacheKey& a) {
-    return static_cast<size_t>(a.hash_value);
+  // Remove every handle.
+  //
+  // Has to hold mutex before being called.
+  void Clear() {
+    SlotArray* array = array_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i <= array->mask; i++) {
+      array->slots[i].handle.store(nullptr, std::memory_order_release);
+    }
+    size_ = 0;
   }
+
+ private:
+  static const size_t kInitialSlots = 64;
+
+  struct Slot {
+    std::atomic<uint32_t> hash;
+    std::atomic<CacheHandle*> handle;
+
+    Slot() : hash(0), handle(nullptr) {}
+  };
+
+  struct SlotArray {
+    // Number of slots minus one, the number of slots is a power of two.
+    const size_t mask;
+    std::unique_ptr<Slot[]> slots;
+
+    explicit SlotArray(size_t num_slots)
+        : mask(num_slots - 1), slots(new Slot[num_slots]) {}
+  };
+
+  // Return the slot of the key, or the empty slot ending its probe sequence.
+  size_t FindSlot(const SlotArray& array, const Slice& key,
+                  uint32_t hash) const {
+    size_t i = hash & array.mask;
+    while (true) {
+      const Slot& slot = array.slots[i];
+      CacheHandle* handle = slot.handle.load(std::memory_order_relaxed);
+      if (handle == nullptr ||
+          (slot.hash.load(std::memory_order_relaxed) == hash &&
+           handle->key == key)) {
+        return i;
+      }
+      i = (i + 1) & array.mask;
+    }
+  }
+
+  // Publish the handle in the i-th slot. Readers see the hash of the slot
+  // once they see the handle.
+  static void Set(SlotArray* array, size_t i, uint32_t hash,
+                  CacheHandle* handle) {
+    array->slots[i].hash.store(hash, std::memory_order_relaxed);
+    array->slots[i].handle.store(handle, std::memory_order_release);
+  }
+
+  // Empty the i-th slot, and move back the entries following it in the same
+  // cluster so that none of them gets separated from its home slot. This
+  // keeps probe sequences short without tombstones.
+  void RemoveSlot(SlotArray* array, size_t i) {
+    size_t j = i;
+    while (true) {
+      j = (j + 1) & array->mask;
+      CacheHandle* handle =
+          array->slots[j].handle.load(std::memory_order_relaxed);
+      if (handle == nullptr) {
+        break;
+      }
+      uint32_t hash = array->slots[j].hash.load(std::memory_order_relaxed);
+      size_t home = hash & array->mask;
+      // Leave the entry if its home slot is cyclically in (i, j].
+      if (i <= j ? (i < home && home <= j) : (i < home || home <= j)) {
+        continue;
+      }
+      Set(array, i, hash, handle);
+      i = j;
+    }
+    array->slots[i].handle.store(nullptr, std::memory_order_release);
+    size_--;
+  }
+
+  SlotArray* Grow() {
+    const SlotArray* old_array = array_.load(std::memory_order_relaxed);
+    SlotArray* array = new SlotArray((old_array->mask + 1) * 2);
+    for (size_t i = 0; i <= old_array->mask; i++) {
+      const Slot& slot = old_array->slots[i];
+      CacheHandle* handle = slot.handle.load(std::memory_order_relaxed);
+      if (handle != nullptr) {
+        uint32_t hash = slot.hash.load(std::memory_order_relaxed);
+        Set(array, FindSlot(*array, handle->key, hash), hash, handle);
+      }
+    }
+    arrays_.emplace_back(array);
+    array_.store(array, std::memory_order_release);
+    return array;
+  }
+
+  // The array probed by Find().
+  std::atomic<SlotArray*> array_;
+
+  // Every array allocated so far, the current one last.
+  std::vector<std::unique_ptr<SlotArray>> arrays_;
+
+  // Number of handles in the table.
+  size_t size_;
 };
 
 struct CleanupContext {
@@ -236,9 +396,6 @@ struct CleanupContext {
 // A cache shard which maintains its own CLOCK cache.
 class ClockCacheShard final : public CacheShard {
  public:
-  // Hash map type.
-  typedef tbb::concurrent_hash_map<CacheKey, CacheHandle*, CacheKey> HashTable;
-
   ClockCacheShard();
   ~ClockCacheShard() override;
 
@@ -353,8 +510,8 @@ class ClockCacheShard final : public CacheShard {
   // Whether allow insert into cache if cache is full.
   std::atomic<bool> strict_capacity_limit_;
 
-  // Hash table (tbb::concurrent_hash_map) for lookup.
-  HashTable table_;
+  // Hash table for lookup.
+  ClockHandleTable table_;
 };
 
 ClockCacheShard::ClockCacheShard()
@@ -484,9 +641,9 @@ bool ClockCacheShard::TryEvict(CacheHandle* handle, CleanupContext* context) {
   uint32_t flags = kInCacheBit;
   if (handle->flags.compare_exchange_strong(flags, 0, std::memory_order_acquire,
                                             std::memory_order_relaxed)) {
-    bool erased __attribute__((__unused__)) =
-        table_.erase(CacheKey(handle->key, handle->hash));
-    assert(erased);
+    CacheHandle* erased __attribute__((__unused__)) =
+        table_.Remove(handle->key, handle->hash);
+    assert(erased == handle);
     RecycleHandle(handle, context);
     return true;
   }
@@ -567,13 +724,10 @@ CacheHandle* ClockCacheShard::Insert(
   handle->deleter = deleter;
   uint32_t flags = hold_reference ? kInCacheBit + kOneRef : kInCacheBit;
   handle->flags.store(flags, std::memory_order_relaxed);
-  HashTable::accessor accessor;
-  if (table_.find(accessor, CacheKey(key, hash))) {
-    CacheHandle* existing_handle = accessor->second;
-    table_.erase(accessor);
+  CacheHandle* existing_handle = table_.Insert(handle);
+  if (existing_handle != nullptr) {
     UnsetInCache(existing_handle, context);
   }
-  table_.insert(HashTable::value_type(CacheKey(key, hash), handle));
   if (hold_reference) {
     pinned_usage_.fetch_add(charge, std::memory_order_relaxed);
   }
@@ -587,7 +741,6 @@ Status ClockCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
                                Cache::Handle** out_handle,
                                Cache::Priority /*priority*/) {
   CleanupContext context;
-  HashTable::accessor accessor;
   char* key_data = new char[key.size()];
   memcpy(key_data, key.data(), key.size());
   Slice key_copy(key_data, key.size());
@@ -606,27 +759,24 @@ Status ClockCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
 }
 
 Cache::Handle* ClockCacheShard::Lookup(const Slice& key, uint32_t hash) {
-  HashTable::const_accessor accessor;
-  if (!table_.find(accessor, CacheKey(key, hash))) {
-    return nullptr;
-  }
-  CacheHandle* handle = accessor->second;
-  accessor.release();
-  // Ref() could fail if another thread sneak in and evict/erase the cache
-  // entry before we are able to hold reference.
-  if (!Ref(reinterpret_cast<Cache::Handle*>(handle))) {
-    return nullptr;
-  }
-  // Double check the key since the handle may now representing another key
-  // if other threads sneak in, evict/erase the entry and re-used the handle
-  // for another cache entry.
-  if (hash != handle->hash || key != handle->key) {
-    CleanupContext context;
-    Unref(handle, false, &context);
-    // It is possible Unref() delete the entry, so we need to cleanup.
-    Cleanup(context);
-    return nullptr;
-  }
+  CacheHandle* handle = table_.Find(hash, [&](CacheHandle* candidate) {
+    // Ref() could fail if another thread sneak in and evict/erase the cache
+    // entry before we are able to hold reference.
+    if (!Ref(reinterpret_cast<Cache::Handle*>(candidate))) {
+      return false;
+    }
+    // Double check the key since the handle may now representing another key
+    // if other threads sneak in, evict/erase the entry and re-used the handle
+    // for another cache entry.
+    if (hash != candidate->hash || key != candidate->key) {
+      CleanupContext context;
+      Unref(candidate, false, &context);
+      // It is possible Unref() delete the entry, so we need to cleanup.
+      Cleanup(context);
+      return false;
+    }
+    return true;
+  });
   return reinterpret_cast<Cache::Handle*>(handle);
 }
 
@@ -650,11 +800,9 @@ void ClockCacheShard::Erase(const Slice& key, uint32_t hash) {
 bool ClockCacheShard::EraseAndConfirm(const Slice& key, uint32_t hash,
                                       CleanupContext* context) {
   MutexLock l(&mutex_);
-  HashTable::accessor accessor;
   bool erased = false;
-  if (table_.find(accessor, CacheKey(key, hash))) {
-    CacheHandle* handle = accessor->second;
-    table_.erase(accessor);
+  CacheHandle* handle = table_.Remove(key, hash);
+  if (handle != nullptr) {
     erased = UnsetInCache(handle, context);
   }
   return erased;
@@ -664,7 +812,7 @@ void ClockCacheShard::EraseUnRefEntries() {
   CleanupContext context;
   {
     MutexLock l(&mutex_);
-    table_.clear();
+    table_.Clear();
     for (auto& handle : list_) {
       UnsetInCache(&handle, &context);
     }
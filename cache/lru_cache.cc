@@ -12,6 +12,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits>
 #include <string>
 
 #include "util/mutexlock.h"
@@ -110,6 +111,8 @@ LRUCacheShard::LRUCacheShard(size_t capacity, bool strict_capacity_limit,
   lru_.next = &lru_;
   lru_.prev = &lru_;
   lru_low_pri_ = &lru_;
+  detached_.next = &detached_;
+  detached_.prev = &detached_;
   SetCapacity(capacity);
 }
 
@@ -212,6 +215,21 @@ void LRUCacheShard::LRU_Insert(LRUHandle* e) {
   lru_usage_ += e->charge;
 }
 
+void LRUCacheShard::Detached_Insert(LRUHandle* e) {
+  assert(e->next == nullptr);
+  assert(e->prev == nullptr);
+  e->next = &detached_;
+  e->prev = detached_.prev;
+  e->prev->next = e;
+  e->next->prev = e;
+}
+
+void LRUCacheShard::Detached_Remove(LRUHandle* e) {
+  e->next->prev = e->prev;
+  e->prev->next = e->next;
+  e->prev = e->next = nullptr;
+}
+
 void LRUCacheShard::MaintainPoolSize() {
   while (high_pri_pool_usage_ > high_pri_pool_capacity_) {
     // Overflow last entry in high-pri pool to low-pri pool.
@@ -296,6 +314,9 @@ bool LRUCacheShard::Release(Cache::Handle* handle, bool force_erase) {
   {
     MutexLock l(&mutex_);
     last_reference = e->Unref();
+    if (last_reference && !e->InCache()) {
+      Detached_Remove(e);
+    }
     if (last_reference && e->InCache()) {
       // The item is still in cache, and nobody else holds a reference to it
       if (usage_ > capacity_ || force_erase) {
@@ -378,6 +399,8 @@ Status LRUCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
           LRU_Remove(old);
           usage_ -= old->charge;
           last_reference_list.push_back(old);
+        } else {
+          Detached_Insert(old);
         }
       }
       if (handle == nullptr) {
@@ -411,6 +434,8 @@ void LRUCacheShard::Erase(const Slice& key, uint32_t hash) {
         LRU_Remove(e);
         usage_ -= e->charge;
         last_reference = true;
+      } else {
+        Detached_Insert(e);
       }
     }
   }
@@ -433,6 +458,48 @@ size_t LRUCacheShard::GetPinnedUsage() const {
   return usage_ - lru_usage_;
 }
 
+void LRUCacheShard::DetachAllEntries(std::vector<LRUHandle*>* entries) {
+  MutexLock l(&mutex_);
+  size_t begin = entries->size();
+  while (lru_.next != &lru_) {
+    LRUHandle* e = lru_.next;
+    LRU_Remove(e);
+    entries->push_back(e);
+  }
+  table_.ApplyToAllCacheEntries([entries](LRUHandle* e) {
+    if (e->HasRefs()) {
+      entries->push_back(e);
+    }
+  });
+  for (size_t i = begin; i < entries->size(); i++) {
+    LRUHandle* e = (*entries)[i];
+    table_.Remove(e->key(), e->hash);
+  }
+  while (detached_.next != &detached_) {
+    LRUHandle* e = detached_.next;
+    Detached_Remove(e);
+    entries->push_back(e);
+  }
+  assert(lru_low_pri_ == &lru_);
+  assert(lru_usage_ == 0);
+  usage_ = 0;
+}
+
+void LRUCacheShard::AttachEntry(LRUHandle* e) {
+  MutexLock l(&mutex_);
+  usage_ += e->charge;
+  if (!e->InCache()) {
+    Detached_Insert(e);
+    return;
+  }
+  LRUHandle* old = table_.Insert(e);
+  assert(old == nullptr);
+  (void)old;
+  if (!e->HasRefs()) {
+    LRU_Insert(e);
+  }
+}
+
 std::string LRUCacheShard::GetPrintableOptions() const {
   const int kBufferSize = 200;
   char buffer[kBufferSize];
@@ -447,9 +514,11 @@ std::string LRUCacheShard::GetPrintableOptions() const {
 LRUCache::LRUCache(size_t capacity, int num_shard_bits,
                    bool strict_capacity_limit, double high_pri_pool_ratio,
                    std::shared_ptr<MemoryAllocator> allocator,
-                   bool use_adaptive_mutex)
+                   bool use_adaptive_mutex, bool replicate_hot_entries,
+                   bool allow_online_resharding)
     : ShardedCache(capacity, num_shard_bits, strict_capacity_limit,
-                   std::move(allocator)) {
+                   std::move(allocator)),
+      use_adaptive_mutex_(use_adaptive_mutex) {
   num_shards_ = 1 << num_shard_bits;
   shards_ = reinterpret_cast<LRUCacheShard*>(
       port::cacheline_aligned_alloc(sizeof(LRUCacheShard) * num_shards_));
@@ -459,11 +528,21 @@ LRUCache::LRUCache(size_t capacity, int num_shard_bits,
         LRUCacheShard(per_shard, strict_capacity_limit, high_pri_pool_ratio,
             use_adaptive_mutex);
   }
+  if (replicate_hot_entries) {
+    hot_tables_.reset(new CoreLocalArray<HotTable>());
+    hot_slot_states_.reset(new HotSlotState[kNumHotSlots]);
+  }
+  if (allow_online_resharding) {
+    AllowResharding();
+  }
 }
 
 LRUCache::~LRUCache() {
   if (shards_ != nullptr) {
     assert(num_shards_ > 0);
+    if (hot_tables_ != nullptr) {
+      DropHotEntries();
+    }
     for (int i = 0; i < num_shards_; i++) {
       shards_[i].~LRUCacheShard();
     }
@@ -479,16 +558,256 @@ const CacheShard* LRUCache::GetShard(int shard) const {
   return reinterpret_cast<CacheShard*>(&shards_[shard]);
 }
 
-void* LRUCache::Value(Handle* handle) {
-  return reinterpret_cast<const LRUHandle*>(handle)->value;
-}
+void* LRUCache::Value(Handle* handle) { return GetLRUHandle(handle)->value; }
 
 size_t LRUCache::GetCharge(Handle* handle) const {
-  return reinterpret_cast<const LRUHandle*>(handle)->charge;
+  return GetLRUHandle(handle)->charge;
 }
 
 uint32_t LRUCache::GetHash(Handle* handle) const {
-  return reinterpret_cast<const LRUHandle*>(handle)->hash;
+  return GetLRUHandle(handle)->hash;
+}
+
+Status LRUCache::Insert(const Slice& key, void* value, size_t charge,
+                        void (*deleter)(const Slice& key, void* value),
+                        Handle** handle, Priority priority) {
+  if (hot_tables_ == nullptr) {
+    return ShardedCache::Insert(key, value, charge, deleter, handle,
+                                priority);
+  }
+  uint32_t hash = HashSlice(key);
+  Status s;
+  {
+    ReshardGuard::Operation op(reshard_guard());
+    s = GetShard(Shard(hash))
+            ->Insert(key, hash, value, charge, deleter, handle, priority);
+  }
+  // The insert may have replaced a replicated entry.
+  InvalidateHotEntries(hash);
+  return s;
+}
+
+Cache::Handle* LRUCache::Lookup(const Slice& key, Statistics* stats) {
+  if (hot_tables_ == nullptr) {
+    return ShardedCache::Lookup(key, stats);
+  }
+  uint32_t hash = HashSlice(key);
+  size_t slot_index = hash & (kNumHotSlots - 1);
+  HotSlotState* state = &hot_slot_states_[slot_index];
+  HotTable* table = hot_tables_->Access();
+  HotEntry* stale = nullptr;
+  bool promote;
+  {
+    std::lock_guard<SpinMutex> l(table->mutex);
+    HotSlot* slot = &table->slots[slot_index];
+    HotEntry* entry = slot->entry;
+    if (entry != nullptr &&
+        entry->epoch != state->epoch.load(std::memory_order_acquire)) {
+      stale = entry;
+      entry = nullptr;
+      slot->entry = nullptr;
+    }
+    promote = Vote(slot, hash);
+    if (entry != nullptr && entry->handle->hash == hash &&
+        entry->handle->key() == key) {
+      entry->refs.fetch_add(1, std::memory_order_relaxed);
+      return reinterpret_cast<Handle*>(reinterpret_cast<uintptr_t>(entry) | 1);
+    }
+    if (promote && entry != nullptr) {
+      // The replicated key lost the vote of this core.
+      stale = entry;
+      slot->entry = nullptr;
+    }
+  }
+  if (stale != nullptr) {
+    UnrefHotEntry(stale);
+  }
+
+  if (promote && !AddReplica(state, hash)) {
+    // Another key of the slot is replicated. Drop its replicas from all the
+    // cores, so that the slot moves to this key once their users release
+    // them, rather than keeping a key gone cold pinned for good.
+    InvalidateHotEntries(static_cast<uint32_t>(state->replicas.load() >> 32),
+                         true /* reset_votes */);
+    promote = AddReplica(state, hash);
+  }
+  if (!promote) {
+    ReshardGuard::Operation op(reshard_guard());
+    return GetShard(Shard(hash))->Lookup(key, hash);
+  }
+  // Counting the replica before reading the epoch and looking the entry up
+  // ensures that a write replacing the entry after the lookup bumps the
+  // epoch, so that the replica is never served stale.
+  uint64_t epoch = state->epoch.load();
+  Handle* handle;
+  {
+    ReshardGuard::Operation op(reshard_guard());
+    CacheShard* shard = GetShard(Shard(hash));
+    handle = shard->Lookup(key, hash);
+    if (handle != nullptr) {
+      shard->Ref(handle);
+    }
+  }
+  if (handle == nullptr) {
+    state->replicas.fetch_sub(1);
+    return nullptr;
+  }
+  HotEntry* entry = new HotEntry(reinterpret_cast<LRUHandle*>(handle), epoch);
+  {
+    std::lock_guard<SpinMutex> l(table->mutex);
+    HotSlot* slot = &table->slots[slot_index];
+    stale = slot->entry;
+    slot->entry = entry;
+  }
+  if (stale != nullptr) {
+    UnrefHotEntry(stale);
+  }
+  // A write may have bumped the epoch after the lookup, and looked for stale
+  // replicas before this one was in the table.
+  if (state->epoch.load() != epoch) {
+    {
+      std::lock_guard<SpinMutex> l(table->mutex);
+      HotSlot* slot = &table->slots[slot_index];
+      if (slot->entry == entry) {
+        slot->entry = nullptr;
+      } else {
+        entry = nullptr;
+      }
+    }
+    if (entry != nullptr) {
+      UnrefHotEntry(entry);
+    }
+  }
+  return handle;
+}
+
+bool LRUCache::Ref(Handle* handle) {
+  if (IsHotHandle(handle)) {
+    GetHotEntry(handle)->refs.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  return ShardedCache::Ref(handle);
+}
+
+bool LRUCache::Release(Handle* handle, bool force_erase) {
+  if (IsHotHandle(handle)) {
+    HotEntry* entry = GetHotEntry(handle);
+    if (force_erase) {
+      // Invalidates the replicas, the entry goes away with the last of them.
+      Erase(entry->handle->key());
+    }
+    UnrefHotEntry(entry);
+    return false;
+  }
+  return ShardedCache::Release(handle, force_erase);
+}
+
+void LRUCache::Erase(const Slice& key) {
+  if (hot_tables_ == nullptr) {
+    ShardedCache::Erase(key);
+    return;
+  }
+  uint32_t hash = HashSlice(key);
+  {
+    ReshardGuard::Operation op(reshard_guard());
+    GetShard(Shard(hash))->Erase(key, hash);
+  }
+  InvalidateHotEntries(hash);
+}
+
+void LRUCache::EraseUnRefEntries() {
+  if (hot_tables_ != nullptr) {
+    DropHotEntries();
+  }
+  ShardedCache::EraseUnRefEntries();
+}
+
+bool LRUCache::Vote(HotSlot* slot, uint32_t hash) {
+  if (slot->votes == 0) {
+    slot->candidate_hash = hash;
+  }
+  if (slot->candidate_hash != hash) {
+    slot->votes--;
+    return false;
+  }
+  if (slot->votes < kHotEntryVotes) {
+    slot->votes++;
+  }
+  return slot->votes == kHotEntryVotes;
+}
+
+bool LRUCache::AddReplica(HotSlotState* state, uint32_t hash) {
+  uint64_t replicas = state->replicas.load();
+  while (true) {
+    uint32_t num_replicas = static_cast<uint32_t>(replicas);
+    if (num_replicas > 0 && static_cast<uint32_t>(replicas >> 32) != hash) {
+      return false;
+    }
+    if (state->replicas.compare_exchange_weak(
+            replicas, (static_cast<uint64_t>(hash) << 32) | (num_replicas + 1))) {
+      return true;
+    }
+  }
+}
+
+void LRUCache::UnrefHotEntry(HotEntry* entry) {
+  if (entry->refs.fetch_sub(1) == 1) {
+    LRUHandle* handle = entry->handle;
+    HotSlotState* state = &hot_slot_states_[handle->hash & (kNumHotSlots - 1)];
+    ShardedCache::Release(reinterpret_cast<Handle*>(handle));
+    state->replicas.fetch_sub(1);
+    delete entry;
+  }
+}
+
+void LRUCache::InvalidateHotEntries(uint32_t hash, bool reset_votes) {
+  size_t slot_index = hash & (kNumHotSlots - 1);
+  HotSlotState* state = &hot_slot_states_[slot_index];
+  uint64_t replicas = state->replicas.load();
+  if (static_cast<uint32_t>(replicas) == 0 ||
+      static_cast<uint32_t>(replicas >> 32) != hash) {
+    return;
+  }
+  uint64_t epoch = state->epoch.fetch_add(1) + 1;
+  // Release the stale replicas now rather than on the next lookup of the
+  // slot on their core, which may never come.
+  for (size_t i = 0; i < hot_tables_->Size(); i++) {
+    HotTable* table = hot_tables_->AccessAtCore(i);
+    HotEntry* stale = nullptr;
+    {
+      std::lock_guard<SpinMutex> l(table->mutex);
+      HotSlot* slot = &table->slots[slot_index];
+      if (slot->entry != nullptr && slot->entry->epoch != epoch) {
+        stale = slot->entry;
+        slot->entry = nullptr;
+      }
+      if (reset_votes && slot->candidate_hash == hash) {
+        slot->votes = 0;
+      }
+    }
+    if (stale != nullptr) {
+      UnrefHotEntry(stale);
+    }
+  }
+}
+
+void LRUCache::DropHotEntries() {
+  for (size_t i = 0; i < hot_tables_->Size(); i++) {
+    HotTable* table = hot_tables_->AccessAtCore(i);
+    autovector<HotEntry*> entries;
+    {
+      std::lock_guard<SpinMutex> l(table->mutex);
+      for (size_t j = 0; j < kNumHotSlots; j++) {
+        if (table->slots[j].entry != nullptr) {
+          entries.push_back(table->slots[j].entry);
+          table->slots[j].entry = nullptr;
+        }
+      }
+    }
+    for (HotEntry* entry : entries) {
+      UnrefHotEntry(entry);
+    }
+  }
 }
 
 void LRUCache::DisownData() {
@@ -506,7 +825,46 @@ void LRUCache::DisownData() {
 #endif  // __clang__
 }
 
+Status LRUCache::Reshard(int num_shard_bits, size_t capacity,
+                         bool strict_capacity_limit) {
+  int num_shards = 1 << num_shard_bits;
+  double high_pri_pool_ratio = shards_[0].GetHighPriPoolRatio();
+  LRUCacheShard* shards = reinterpret_cast<LRUCacheShard*>(
+      port::cacheline_aligned_alloc(sizeof(LRUCacheShard) * num_shards));
+  size_t per_shard = (capacity + (num_shards - 1)) / num_shards;
+  for (int i = 0; i < num_shards; i++) {
+    // No capacity until the entries are in, so as not to evict them early.
+    new (&shards[i]) LRUCacheShard(std::numeric_limits<size_t>::max(),
+                                   strict_capacity_limit, high_pri_pool_ratio,
+                                   use_adaptive_mutex_);
+  }
+
+  // The entries keep their order within each old shard. Replicated entries
+  // keep their handles, so that the replicas stay valid.
+  std::vector<LRUHandle*> entries;
+  for (int i = 0; i < num_shards_; i++) {
+    shards_[i].DetachAllEntries(&entries);
+  }
+  for (LRUHandle* e : entries) {
+    uint32_t shard =
+        num_shard_bits > 0 ? (e->hash >> (32 - num_shard_bits)) : 0;
+    shards[shard].AttachEntry(e);
+  }
+  for (int i = 0; i < num_shards; i++) {
+    shards[i].SetCapacity(per_shard);
+  }
+
+  for (int i = 0; i < num_shards_; i++) {
+    shards_[i].~LRUCacheShard();
+  }
+  port::cacheline_aligned_free(shards_);
+  shards_ = shards;
+  num_shards_ = num_shards;
+  return Status::OK();
+}
+
 size_t LRUCache::TEST_GetLRUSize() {
+  ReshardGuard::Operation op(reshard_guard());
   size_t lru_size_of_all_shards = 0;
   for (int i = 0; i < num_shards_; i++) {
     lru_size_of_all_shards += shards_[i].TEST_GetLRUSize();
@@ -514,7 +872,24 @@ size_t LRUCache::TEST_GetLRUSize() {
   return lru_size_of_all_shards;
 }
 
+size_t LRUCache::TEST_GetNumHotEntries() {
+  size_t num_hot_entries = 0;
+  if (hot_tables_ != nullptr) {
+    for (size_t i = 0; i < hot_tables_->Size(); i++) {
+      HotTable* table = hot_tables_->AccessAtCore(i);
+      std::lock_guard<SpinMutex> l(table->mutex);
+      for (size_t j = 0; j < kNumHotSlots; j++) {
+        if (table->slots[j].entry != nullptr) {
+          num_hot_entries++;
+        }
+      }
+    }
+  }
+  return num_hot_entries;
+}
+
 double LRUCache::GetHighPriPoolRatio() {
+  ReshardGuard::Operation op(reshard_guard());
   double result = 0.0;
   if (num_shards_ > 0) {
     result = shards_[0].GetHighPriPoolRatio();
@@ -523,32 +898,34 @@ double LRUCache::GetHighPriPoolRatio() {
 }
 
 std::shared_ptr<Cache> NewLRUCache(const LRUCacheOptions& cache_opts) {
-  return NewLRUCache(cache_opts.capacity, cache_opts.num_shard_bits,
-                     cache_opts.strict_capacity_limit,
-                     cache_opts.high_pri_pool_ratio,
-                     cache_opts.memory_allocator,
-                     cache_opts.use_adaptive_mutex);
-}
-
-std::shared_ptr<Cache> NewLRUCache(
-    size_t capacity, int num_shard_bits, bool strict_capacity_limit,
-    double high_pri_pool_ratio,
-    std::shared_ptr<MemoryAllocator> memory_allocator,
-    bool use_adaptive_mutex) {
-  if (num_shard_bits >= 20) {
+  if (cache_opts.num_shard_bits >= 20) {
     return nullptr;  // the cache cannot be sharded into too many fine pieces
   }
-  if (high_pri_pool_ratio < 0.0 || high_pri_pool_ratio > 1.0) {
+  if (cache_opts.high_pri_pool_ratio < 0.0 ||
+      cache_opts.high_pri_pool_ratio > 1.0) {
     // invalid high_pri_pool_ratio
     return nullptr;
   }
+  int num_shard_bits = cache_opts.num_shard_bits;
   if (num_shard_bits < 0) {
-    num_shard_bits = GetDefaultCacheShardBits(capacity);
+    num_shard_bits = GetDefaultCacheShardBits(cache_opts.capacity);
   }
-  return std::make_shared<LRUCache>(capacity, num_shard_bits,
-                                    strict_capacity_limit, high_pri_pool_ratio,
-                                    std::move(memory_allocator),
-                                    use_adaptive_mutex);
+  return std::make_shared<LRUCache>(
+      cache_opts.capacity, num_shard_bits, cache_opts.strict_capacity_limit,
+      cache_opts.high_pri_pool_ratio, cache_opts.memory_allocator,
+      cache_opts.use_adaptive_mutex, cache_opts.replicate_hot_entries,
+      cache_opts.allow_online_resharding);
+}
+
+std::shared_ptr<Cache> NewLRUCache(
+    size_t capacity, int num_shard_bits, bool strict_capacity_limit,
+    double high_pri_pool_ratio,
+    std::shared_ptr<MemoryAllocator> memory_allocator,
+    bool use_adaptive_mutex) {
+  return NewLRUCache(LRUCacheOptions(capacity, num_shard_bits,
+                                     strict_capacity_limit, high_pri_pool_ratio,
+                                     std::move(memory_allocator),
+                                     use_adaptive_mutex));
 }
 
 }  // namespace rocksdb
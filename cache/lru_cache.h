@@ -8,12 +8,17 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "cache/sharded_cache.h"
 
 #include "port/port.h"
 #include "util/autovector.h"
+#include "util/core_local.h"
+#include "util/mutexlock.h"
 
 namespace rocksdb {
 
@@ -68,6 +73,8 @@ struct LRUHandle {
     IN_HIGH_PRI_POOL = (1 << 2),
     // Wwhether this entry has had any lookups (hits).
     HAS_HIT = (1 << 3),
+    // Whether this entry is in the admission window of TinyLFUCache.
+    IN_WINDOW = (1 << 4),
   };
 
   uint8_t flags;
@@ -94,6 +101,7 @@ struct LRUHandle {
   bool IsHighPri() const { return flags & IS_HIGH_PRI; }
   bool InHighPriPool() const { return flags & IN_HIGH_PRI_POOL; }
   bool HasHit() const { return flags & HAS_HIT; }
+  bool InWindow() const { return flags & IN_WINDOW; }
 
   void SetInCache(bool in_cache) {
     if (in_cache) {
@@ -119,8 +127,18 @@ struct LRUHandle {
     }
   }
 
+  void SetInWindow(bool in_window) {
+    if (in_window) {
+      flags |= IN_WINDOW;
+    } else {
+      flags &= ~IN_WINDOW;
+    }
+  }
+
   void SetHit() { flags |= HAS_HIT; }
 
+  void ClearHit() { flags &= ~HAS_HIT; }
+
   void Free() {
     assert(refs == 0);
     if (deleter) {
@@ -225,10 +243,24 @@ class ALIGN_AS(CACHE_LINE_SIZE) LRUCacheShard final : public CacheShard {
   //  Retrives high pri pool ratio
   double GetHighPriPoolRatio();
 
+  // Used for resharding, with no other operation running on the shard.
+  // Appends all of the entries of the shard to `entries`, least recently used
+  // first, and leaves the shard empty. Erased entries that are still
+  // referenced are handed out too, so that their charge moves with them.
+  void DetachAllEntries(std::vector<LRUHandle*>* entries);
+  // Takes an entry detached from another shard. Entries are attached in the
+  // order they were detached in to keep their LRU order.
+  void AttachEntry(LRUHandle* e);
+
  private:
   void LRU_Remove(LRUHandle* e);
   void LRU_Insert(LRUHandle* e);
 
+  // The erased entries still referenced are linked in a list of their own,
+  // through the LRU list pointers that they do not use otherwise.
+  void Detached_Insert(LRUHandle* e);
+  void Detached_Remove(LRUHandle* e);
+
   // Overflow the last entry in high-pri pool to low-pri pool until size of
   // high-pri pool is no larger than the size specify by high_pri_pool_pct.
   void MaintainPoolSize();
@@ -263,6 +295,9 @@ class ALIGN_AS(CACHE_LINE_SIZE) LRUCacheShard final : public CacheShard {
   // Pointer to head of low-pri pool in LRU list.
   LRUHandle* lru_low_pri_;
 
+  // Dummy head of the list of erased entries still referenced.
+  LRUHandle detached_;
+
   // ------------^^^^^^^^^^^^^-----------
   // Not frequently modified data members
   // ------------------------------------
@@ -297,7 +332,9 @@ class LRUCache
   LRUCache(size_t capacity, int num_shard_bits, bool strict_capacity_limit,
            double high_pri_pool_ratio,
            std::shared_ptr<MemoryAllocator> memory_allocator = nullptr,
-           bool use_adaptive_mutex = kDefaultToAdaptiveMutex);
+           bool use_adaptive_mutex = kDefaultToAdaptiveMutex,
+           bool replicate_hot_entries = false,
+           bool allow_online_resharding = false);
   virtual ~LRUCache();
   virtual const char* Name() const override { return "LRUCache"; }
   virtual CacheShard* GetShard(int shard) override;
@@ -307,14 +344,105 @@ class LRUCache
   virtual uint32_t GetHash(Handle* handle) const override;
   virtual void DisownData() override;
 
+  // With replicate_hot_entries, lookups are first served from the replicas
+  // of the core they run on, and writes invalidate the replicas.
+  virtual Status Insert(const Slice& key, void* value, size_t charge,
+                        void (*deleter)(const Slice& key, void* value),
+                        Handle** handle, Priority priority) override;
+  virtual Handle* Lookup(const Slice& key,
+                         Statistics* stats = nullptr) override;
+  virtual bool Ref(Handle* handle) override;
+  virtual bool Release(Handle* handle, bool force_erase = false) override;
+  virtual void Erase(const Slice& key) override;
+  virtual void EraseUnRefEntries() override;
+
   //  Retrieves number of elements in LRU, for unit test purpose only
   size_t TEST_GetLRUSize();
   //  Retrives high pri pool ratio
   double GetHighPriPoolRatio();
+  //  Retrieves number of entries replicated on some core, for unit test
+  //  purpose only
+  size_t TEST_GetNumHotEntries();
 
  private:
+  // A replica of a hot entry. It holds a reference to the entry in its shard,
+  // and counts the references handed out to the users by itself, so that
+  // they are taken and released without locking the shard. The handles of
+  // replicas returned by Lookup() have their lowest bit set.
+  struct HotEntry {
+    HotEntry(LRUHandle* _handle, uint64_t _epoch)
+        : handle(_handle), epoch(_epoch), refs(1) {}
+
+    LRUHandle* handle;
+    // Epoch of the hot slot of the entry when it was replicated.
+    const uint64_t epoch;
+    // One reference for the hot table, plus one per user.
+    std::atomic<uint32_t> refs;
+  };
+
+  // Hot tables are direct mapped by the low bits of the hash, while the
+  // shard is picked by the high bits.
+  static const size_t kNumHotSlots = 256;
+  // Net lookups a key needs in its hot slot to be replicated.
+  static const uint32_t kHotEntryVotes = 16;
+
+  struct HotSlot {
+    HotEntry* entry = nullptr;
+    // Majority vote over the lookups of the slot: the candidate gains a vote
+    // on each of its lookups and loses one on each lookup of another key.
+    uint32_t candidate_hash = 0;
+    uint32_t votes = 0;
+  };
+
+  // The replicas of one core.
+  struct HotTable {
+    SpinMutex mutex;
+    HotSlot slots[kNumHotSlots];
+  };
+
+  // Shared by the hot tables of all the cores. A slot replicates one key at
+  // a time on all the cores.
+  struct HotSlotState {
+    // Bumped by the writes of the replicated key. Replicas of an older epoch
+    // may be stale.
+    std::atomic<uint64_t> epoch{0};
+    // Hash of the replicated key in the high 32 bits, number of replicas in
+    // the low 32 bits.
+    std::atomic<uint64_t> replicas{0};
+  };
+
+  static bool IsHotHandle(Handle* handle) {
+    return (reinterpret_cast<uintptr_t>(handle) & 1) != 0;
+  }
+  static HotEntry* GetHotEntry(Handle* handle) {
+    return reinterpret_cast<HotEntry*>(reinterpret_cast<uintptr_t>(handle) &
+                                       ~static_cast<uintptr_t>(1));
+  }
+  static LRUHandle* GetLRUHandle(Handle* handle) {
+    return IsHotHandle(handle) ? GetHotEntry(handle)->handle
+                               : reinterpret_cast<LRUHandle*>(handle);
+  }
+
+  static bool Vote(HotSlot* slot, uint32_t hash);
+  // Returns false if another key of the slot is replicated.
+  static bool AddReplica(HotSlotState* state, uint32_t hash);
+  void UnrefHotEntry(HotEntry* entry);
+  // Drops the replicas of the key of `hash` from all the cores. With
+  // `reset_votes`, the key also has to win the votes of the cores over again
+  // to be replicated, so that two hot keys of a slot do not take it from
+  // each other on every lookup.
+  void InvalidateHotEntries(uint32_t hash, bool reset_votes = false);
+  void DropHotEntries();
+
+  virtual Status Reshard(int num_shard_bits, size_t capacity,
+                         bool strict_capacity_limit) override;
+
   LRUCacheShard* shards_ = nullptr;
   int num_shards_ = 0;
+  bool use_adaptive_mutex_;
+  // Only allocated with replicate_hot_entries.
+  std::unique_ptr<CoreLocalArray<HotTable>> hot_tables_;
+  std::unique_ptr<HotSlotState[]> hot_slot_states_;
 };
 
 }  // namespace rocksdb
@@ -5,10 +5,14 @@
 
 #include "cache/lru_cache.h"
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include "port/port.h"
 #include "test_util/testharness.h"
+#include "util/hash.h"
+#include "util/random.h"
+#include "util/string_util.h"
 
 namespace rocksdb {
 
@@ -189,6 +193,247 @@ TEST_F(LRUCacheTest, EntriesWithPriority) {
   ValidateLRUList({"e", "f", "g", "Z", "d"}, 2);
 }
 
+namespace {
+int num_deleted = 0;
+void CountDeleter(const Slice& /*key*/, void* /*value*/) { num_deleted++; }
+}  // namespace
+
+TEST(LRUCacheHotEntryTest, ReplicateHotEntries) {
+  LRUCache cache(100, 0, false, 0.0, nullptr, kDefaultToAdaptiveMutex,
+                 true /* replicate_hot_entries */);
+  int value1 = 1;
+  int value2 = 2;
+  num_deleted = 0;
+  ASSERT_OK(cache.Insert("hot", &value1, 1, &CountDeleter, nullptr,
+                         Cache::Priority::LOW));
+  ASSERT_OK(cache.Insert("cold", &value1, 1, &CountDeleter, nullptr,
+                         Cache::Priority::LOW));
+
+  // Lookups of the hot key replicate it. The thread may move to another core
+  // in between, so do not rely on the exact number of lookups.
+  for (int i = 0; i < 1000 && cache.TEST_GetNumHotEntries() == 0; i++) {
+    Cache::Handle* handle = cache.Lookup("hot");
+    ASSERT_NE(nullptr, handle);
+    ASSERT_EQ(&value1, cache.Value(handle));
+    cache.Release(handle);
+  }
+  ASSERT_LT(0, cache.TEST_GetNumHotEntries());
+  // The replica keeps the entry referenced.
+  ASSERT_EQ(1, cache.GetPinnedUsage());
+
+  Cache::Handle* handle = cache.Lookup("hot");
+  ASSERT_NE(nullptr, handle);
+  ASSERT_EQ(&value1, cache.Value(handle));
+  ASSERT_EQ(1, cache.GetCharge(handle));
+  ASSERT_TRUE(cache.Ref(handle));
+  cache.Release(handle);
+
+  // Replacing the entry drops the replicas.
+  ASSERT_OK(cache.Insert("hot", &value2, 1, &CountDeleter, nullptr,
+                         Cache::Priority::LOW));
+  ASSERT_EQ(0, cache.TEST_GetNumHotEntries());
+  for (int i = 0; i < 100; i++) {
+    Cache::Handle* h = cache.Lookup("hot");
+    ASSERT_NE(nullptr, h);
+    ASSERT_EQ(&value2, cache.Value(h));
+    cache.Release(h);
+  }
+  // The old value is still referenced by the user only.
+  ASSERT_EQ(0, num_deleted);
+  ASSERT_EQ(&value1, cache.Value(handle));
+  cache.Release(handle);
+  ASSERT_EQ(1, num_deleted);
+
+  // So does erasing it.
+  cache.Erase("hot");
+  ASSERT_EQ(0, cache.TEST_GetNumHotEntries());
+  ASSERT_EQ(nullptr, cache.Lookup("hot"));
+  handle = cache.Lookup("cold");
+  ASSERT_NE(nullptr, handle);
+  cache.Release(handle);
+
+  cache.EraseUnRefEntries();
+  ASSERT_EQ(0, cache.TEST_GetNumHotEntries());
+  ASSERT_EQ(0, cache.GetUsage());
+  ASSERT_EQ(3, num_deleted);
+}
+
+TEST(LRUCacheHotEntryTest, InvalidateReplicatedKeyOnly) {
+  LRUCache cache(100, 0, false, 0.0, nullptr, kDefaultToAdaptiveMutex,
+                 true /* replicate_hot_entries */);
+  // A key of the same hot slot, which is picked by the low 8 bits of the
+  // hash.
+  const uint32_t hot_hash = static_cast<uint32_t>(GetSliceNPHash64("hot"));
+  std::string other;
+  for (int i = 0; other.empty(); i++) {
+    std::string key = "other" + ToString(i);
+    uint32_t hash = static_cast<uint32_t>(GetSliceNPHash64(key));
+    if (hash != hot_hash && (hash & 255) == (hot_hash & 255)) {
+      other = key;
+    }
+  }
+  int value1 = 1;
+  int value2 = 2;
+  num_deleted = 0;
+  ASSERT_OK(cache.Insert("hot", &value1, 1, &CountDeleter, nullptr,
+                         Cache::Priority::LOW));
+  for (int i = 0; i < 1000 && cache.TEST_GetNumHotEntries() == 0; i++) {
+    Cache::Handle* handle = cache.Lookup("hot");
+    ASSERT_NE(nullptr, handle);
+    cache.Release(handle);
+  }
+  ASSERT_LT(0, cache.TEST_GetNumHotEntries());
+
+  // Writing another key of the slot keeps the replicas.
+  ASSERT_OK(cache.Insert(other, &value1, 1, &CountDeleter, nullptr,
+                         Cache::Priority::LOW));
+  ASSERT_OK(cache.Insert(other, &value2, 1, &CountDeleter, nullptr,
+                         Cache::Priority::LOW));
+  cache.Erase(other);
+  ASSERT_LT(0, cache.TEST_GetNumHotEntries());
+  ASSERT_EQ(2, num_deleted);
+
+  // Writing the key releases the replicas of all the cores at once.
+  ASSERT_OK(cache.Insert("hot", &value2, 1, &CountDeleter, nullptr,
+                         Cache::Priority::LOW));
+  ASSERT_EQ(0, cache.TEST_GetNumHotEntries());
+  ASSERT_EQ(3, num_deleted);
+  ASSERT_EQ(0, cache.GetPinnedUsage());
+}
+
+TEST(LRUCacheHotEntryTest, HotterKeyTakesOverSlot) {
+  LRUCache cache(100, 0, false, 0.0, nullptr, kDefaultToAdaptiveMutex,
+                 true /* replicate_hot_entries */);
+  const uint32_t hot_hash = static_cast<uint32_t>(GetSliceNPHash64("hot"));
+  std::string other;
+  for (int i = 0; other.empty(); i++) {
+    std::string key = "other" + ToString(i);
+    uint32_t hash = static_cast<uint32_t>(GetSliceNPHash64(key));
+    if (hash != hot_hash && (hash & 255) == (hot_hash & 255)) {
+      other = key;
+    }
+  }
+  int value = 1;
+  num_deleted = 0;
+  ASSERT_OK(cache.Insert("hot", &value, 1, &CountDeleter, nullptr,
+                         Cache::Priority::LOW));
+  ASSERT_OK(cache.Insert(other, &value, 1, &CountDeleter, nullptr,
+                         Cache::Priority::LOW));
+  for (int i = 0; i < 1000 && cache.TEST_GetNumHotEntries() == 0; i++) {
+    Cache::Handle* handle = cache.Lookup("hot");
+    ASSERT_NE(nullptr, handle);
+    cache.Release(handle);
+  }
+  ASSERT_LT(0, cache.TEST_GetNumHotEntries());
+
+  // The key goes cold while the other key of its slot gets hot, which takes
+  // the slot over.
+  for (int i = 0; i < 1000; i++) {
+    Cache::Handle* handle = cache.Lookup(other);
+    ASSERT_NE(nullptr, handle);
+    cache.Release(handle);
+  }
+  ASSERT_LT(0, cache.TEST_GetNumHotEntries());
+  ASSERT_EQ(1, cache.GetPinnedUsage());
+  // The cold key is not pinned anymore.
+  cache.Erase("hot");
+  ASSERT_EQ(1, num_deleted);
+  ASSERT_LT(0, cache.TEST_GetNumHotEntries());
+  cache.Erase(other);
+  ASSERT_EQ(0, cache.TEST_GetNumHotEntries());
+  ASSERT_EQ(2, num_deleted);
+}
+
+TEST(LRUCacheReshardTest, Reshard) {
+  ASSERT_TRUE(NewLRUCache(100, 0)->SetNumShardBits(2).IsNotSupported());
+
+  // Room for all of the entries whatever their spread over the shards.
+  LRUCacheOptions opts(1000, 0, false, 0.5);
+  opts.allow_online_resharding = true;
+  std::shared_ptr<Cache> cache = NewLRUCache(opts);
+  ShardedCache* sharded_cache = static_cast<ShardedCache*>(cache.get());
+  int value = 0;
+  num_deleted = 0;
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(cache->Insert("key" + ToString(i), &value, 1, &CountDeleter));
+  }
+  Cache::Handle* pinned = cache->Lookup("key0");
+  ASSERT_NE(nullptr, pinned);
+  Cache::Handle* erased = cache->Lookup("key1");
+  ASSERT_NE(nullptr, erased);
+  cache->Erase("key1");
+
+  // The entries move to their new shards, the referenced ones included.
+  ASSERT_OK(cache->SetNumShardBits(4));
+  ASSERT_EQ(4, sharded_cache->GetNumShardBits());
+  ASSERT_EQ(100, cache->GetUsage());
+  ASSERT_EQ(2, cache->GetPinnedUsage());
+  for (int i = 2; i < 100; i++) {
+    Cache::Handle* handle = cache->Lookup("key" + ToString(i));
+    ASSERT_NE(nullptr, handle);
+    cache->Release(handle);
+  }
+  ASSERT_EQ(nullptr, cache->Lookup("key1"));
+  cache->Release(erased);
+  ASSERT_EQ(1, num_deleted);
+  ASSERT_EQ(99, cache->GetUsage());
+
+  ASSERT_OK(cache->SetNumShardBits(1));
+  ASSERT_EQ(1, sharded_cache->GetNumShardBits());
+  ASSERT_EQ(99, cache->GetUsage());
+  cache->Release(pinned);
+  ASSERT_EQ(0, cache->GetPinnedUsage());
+  ASSERT_EQ(1, num_deleted);
+  ASSERT_TRUE(cache->SetNumShardBits(20).IsInvalidArgument());
+
+  // The capacity is split over the new shards.
+  cache->SetCapacity(10);
+  ASSERT_EQ(10, cache->GetUsage());
+  cache->EraseUnRefEntries();
+  ASSERT_EQ(0, cache->GetUsage());
+  ASSERT_EQ(100, num_deleted);
+}
+
+TEST(LRUCacheReshardTest, ConcurrentReshard) {
+  LRUCacheOptions opts(1000, 2, false, 0.5);
+  opts.allow_online_resharding = true;
+  opts.replicate_hot_entries = true;
+  std::shared_ptr<Cache> cache = NewLRUCache(opts);
+  std::atomic<bool> stop(false);
+  std::vector<port::Thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&cache, &stop, t]() {
+      Random rnd(301 + t);
+      while (!stop.load()) {
+        // A few keys are much hotter than the others.
+        std::string key = "key" + ToString(rnd.OneIn(2) ? rnd.Uniform(4)
+                                                        : rnd.Uniform(2000));
+        if (rnd.OneIn(50)) {
+          cache->Erase(key);
+          continue;
+        }
+        Cache::Handle* handle = cache->Lookup(key);
+        if (handle == nullptr) {
+          cache->Insert(key, nullptr, 1, nullptr, &handle);
+        }
+        if (handle != nullptr) {
+          cache->Release(handle);
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 50; i++) {
+    ASSERT_OK(cache->SetNumShardBits(i % 5));
+  }
+  stop.store(true);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_LE(cache->GetUsage(), 1000);
+  cache->EraseUnRefEntries();
+  ASSERT_EQ(0, cache->GetUsage());
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
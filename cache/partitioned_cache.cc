@@ -0,0 +1,333 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include "cache/partitioned_cache.h"
+
+#include <algorithm>
+#include <inttypes.h>
+
+#include "cache/sharded_cache.h"
+#include "util/mutexlock.h"
+
+namespace rocksdb {
+
+CachePartition::CachePartition(std::shared_ptr<PartitionedCacheImpl> parent,
+                               const std::string& name,
+                               const CachePartitionOptions& opts,
+                               std::shared_ptr<Cache> cache,
+                               std::shared_ptr<MemoryAllocator> allocator)
+    : Cache(std::move(allocator)),
+      parent_(std::move(parent)),
+      name_(name),
+      reserved_capacity_(opts.reserved_capacity),
+      capacity_limit_(opts.capacity_limit),
+      capacity_(0),
+      cache_(std::move(cache)),
+      hits_(0),
+      misses_(0) {}
+
+CachePartition::~CachePartition() { parent_->RemovePartition(this); }
+
+Status CachePartition::Insert(const Slice& key, void* value, size_t charge,
+                              void (*deleter)(const Slice& key, void* value),
+                              Handle** handle, Priority priority) {
+  if (parent_->CapacityFor(cache_->GetUsage() + charge, charge) >
+      capacity_.load(std::memory_order_relaxed)) {
+    parent_->Reserve(this, charge);
+  }
+  return cache_->Insert(key, value, charge, deleter, handle, priority);
+}
+
+Cache::Handle* CachePartition::Lookup(const Slice& key, Statistics* stats) {
+  Handle* handle = cache_->Lookup(key, stats);
+  if (handle != nullptr) {
+    hits_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return handle;
+}
+
+uint64_t CachePartition::NewId() { return parent_->NewId(); }
+
+void CachePartition::SetCapacity(size_t capacity) {
+  parent_->SetCapacityLimit(this, capacity);
+}
+
+std::string CachePartition::GetPrintableOptions() const {
+  const int kBufferSize = 200;
+  char buffer[kBufferSize];
+  std::string ret;
+  snprintf(buffer, kBufferSize, "    partition_name: %s\n", name_.c_str());
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "    reserved_capacity: %" ROCKSDB_PRIszt "\n",
+           reserved_capacity_);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize,
+           "    partitioned_cache_capacity: %" ROCKSDB_PRIszt "\n",
+           parent_->GetCapacity());
+  ret.append(buffer);
+  ret.append(cache_->GetPrintableOptions());
+  return ret;
+}
+
+CachePartitionStats CachePartition::GetStats() const {
+  CachePartitionStats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  stats.usage = cache_->GetUsage();
+  stats.capacity = capacity_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void CachePartition::SetAssignedCapacity(size_t capacity) {
+  capacity_.store(capacity, std::memory_order_relaxed);
+}
+
+void CachePartition::ApplyAssignedCapacity() {
+  cache_->SetCapacity(capacity_.load(std::memory_order_relaxed));
+}
+
+PartitionedCacheImpl::PartitionedCacheImpl(
+    size_t capacity, int num_shard_bits, bool strict_capacity_limit,
+    std::shared_ptr<MemoryAllocator> memory_allocator)
+    : capacity_(capacity),
+      // The partitions start empty, shard them for the whole capacity.
+      num_shard_bits_(num_shard_bits < 0 ? GetDefaultCacheShardBits(capacity)
+                                         : num_shard_bits),
+      strict_capacity_limit_(strict_capacity_limit),
+      memory_allocator_(std::move(memory_allocator)),
+      last_id_(0),
+      assigned_capacity_(0),
+      reserved_capacity_(0),
+      resizing_(false),
+      resized_partition_(nullptr),
+      resize_cv_(&mutex_) {}
+
+PartitionedCacheImpl::~PartitionedCacheImpl() {
+  // Every partition holds a reference to the cache.
+  assert(partitions_.empty());
+}
+
+std::shared_ptr<Cache> PartitionedCacheImpl::GetPartition(
+    const std::string& name, const CachePartitionOptions& opts) {
+  MutexLock l(&mutex_);
+  auto iter = partitions_.find(name);
+  if (iter != partitions_.end()) {
+    std::shared_ptr<CachePartition> partition = iter->second.ref.lock();
+    if (partition != nullptr) {
+      return partition;
+    }
+    // The partition is being destroyed, replace it.
+  }
+  if (reserved_capacity_ + opts.reserved_capacity > capacity_) {
+    return nullptr;
+  }
+  std::shared_ptr<Cache> cache =
+      NewLRUCache(0 /* capacity */, num_shard_bits_, strict_capacity_limit_,
+                  opts.high_pri_pool_ratio, memory_allocator_);
+  if (cache == nullptr) {
+    return nullptr;
+  }
+  auto partition = std::make_shared<CachePartition>(
+      shared_from_this(), name, opts, std::move(cache), memory_allocator_);
+  partitions_[name] = PartitionRef{partition.get(), partition};
+  reserved_capacity_ += opts.reserved_capacity;
+  return partition;
+}
+
+bool PartitionedCacheImpl::GetPartitionStats(const std::string& name,
+                                             CachePartitionStats* stats) const {
+  MutexLock l(&mutex_);
+  auto iter = partitions_.find(name);
+  if (iter == partitions_.end()) {
+    return false;
+  }
+  *stats = iter->second.partition->GetStats();
+  return true;
+}
+
+void PartitionedCacheImpl::GetAllPartitionStats(
+    std::map<std::string, CachePartitionStats>* stats) const {
+  MutexLock l(&mutex_);
+  stats->clear();
+  for (const auto& entry : partitions_) {
+    (*stats)[entry.first] = entry.second.partition->GetStats();
+  }
+}
+
+size_t PartitionedCacheImpl::CapacityLimit(
+    const CachePartition* partition) const {
+  size_t limit = partition->capacity_limit_;
+  if (limit == 0 || limit > capacity_) {
+    limit = capacity_;
+  }
+  return std::max(limit, partition->reserved_capacity_);
+}
+
+void PartitionedCacheImpl::Reserve(CachePartition* partition, size_t charge) {
+  {
+    MutexLock l(&mutex_);
+    size_t capacity = partition->capacity_.load(std::memory_order_relaxed);
+    size_t target =
+        std::min(CapacityFor(partition->cache_->GetUsage() + charge, charge),
+                 CapacityLimit(partition));
+    if (target <= capacity) {
+      return;
+    }
+    size_t need = target - capacity;
+
+    // Capacity that no partition holds.
+    size_t take = std::min(need, capacity_ - assigned_capacity_);
+    assigned_capacity_ += take;
+    capacity += take;
+    need -= take;
+
+    // Capacity that other partitions hold but do not need. Shrinking a
+    // sharded partition down to its usage would evict the entries of its
+    // fuller shards.
+    for (auto& entry : partitions_) {
+      CachePartition* other = entry.second.partition;
+      if (need == 0) {
+        break;
+      }
+      if (other == partition) {
+        continue;
+      }
+      size_t other_capacity = other->capacity_.load(std::memory_order_relaxed);
+      size_t other_needs = std::min(
+          other_capacity, CapacityFor(other->cache_->GetUsage(), 0));
+      if (other_capacity > other_needs) {
+        take = std::min(need, other_capacity - other_needs);
+        other->SetAssignedCapacity(other_capacity - take);
+        QueueResize(other);
+        capacity += take;
+        need -= take;
+      }
+    }
+
+    // Capacity that other partitions borrowed, if this partition needs it to
+    // fill its reservation. Shrinking them evicts their oldest entries.
+    if (need > 0 && capacity < partition->reserved_capacity_) {
+      need = std::min(need, partition->reserved_capacity_ - capacity);
+      for (auto& entry : partitions_) {
+        CachePartition* other = entry.second.partition;
+        if (need == 0) {
+          break;
+        }
+        if (other == partition) {
+          continue;
+        }
+        size_t other_capacity =
+            other->capacity_.load(std::memory_order_relaxed);
+        if (other_capacity > other->reserved_capacity_) {
+          take = std::min(need, other_capacity - other->reserved_capacity_);
+          other->SetAssignedCapacity(other_capacity - take);
+          QueueResize(other);
+          capacity += take;
+          need -= take;
+        }
+      }
+    }
+
+    partition->SetAssignedCapacity(capacity);
+    QueueResize(partition);
+  }
+  ResizePartitions(partition);
+}
+
+void PartitionedCacheImpl::SetCapacityLimit(CachePartition* partition,
+                                            size_t capacity_limit) {
+  {
+    MutexLock l(&mutex_);
+    partition->capacity_limit_ = capacity_limit;
+    size_t capacity = partition->capacity_.load(std::memory_order_relaxed);
+    size_t limit = CapacityLimit(partition);
+    if (capacity <= limit) {
+      return;
+    }
+    assigned_capacity_ -= capacity - limit;
+    partition->SetAssignedCapacity(limit);
+    QueueResize(partition);
+  }
+  ResizePartitions(nullptr /* grown */);
+}
+
+void PartitionedCacheImpl::QueueResize(CachePartition* partition) {
+  mutex_.AssertHeld();
+  auto iter = partitions_.find(partition->name_);
+  if (iter == partitions_.end() || iter->second.partition != partition) {
+    return;
+  }
+  std::shared_ptr<CachePartition> ref = iter->second.ref.lock();
+  // A partition being destroyed takes its cache along.
+  if (ref != nullptr) {
+    resize_queue_.push_back(std::move(ref));
+  }
+}
+
+void PartitionedCacheImpl::ResizePartitions(CachePartition* grown) {
+  mutex_.Lock();
+  if (resizing_ && resizing_thread_ == std::this_thread::get_id()) {
+    // Called from a deleter of an entry evicted by the resizing. Growing a
+    // partition evicts nothing, so it cannot reenter, but the partition
+    // being resized has to wait for its resizing to be done.
+    const bool grow = grown != nullptr && grown != resized_partition_;
+    mutex_.Unlock();
+    if (grow) {
+      grown->ApplyAssignedCapacity();
+    }
+    return;
+  }
+  // The partitions queued by this thread are resized by the thread resizing,
+  // if any, before it is done.
+  while (resizing_) {
+    resize_cv_.Wait();
+  }
+  resizing_ = true;
+  resizing_thread_ = std::this_thread::get_id();
+  while (!resize_queue_.empty()) {
+    std::shared_ptr<CachePartition> partition =
+        std::move(resize_queue_.front());
+    resize_queue_.pop_front();
+    resized_partition_ = partition.get();
+    mutex_.Unlock();
+    partition->ApplyAssignedCapacity();
+    // Dropping the last reference removes the partition, under mutex_.
+    partition.reset();
+    mutex_.Lock();
+  }
+  resized_partition_ = nullptr;
+  resizing_ = false;
+  resize_cv_.SignalAll();
+  mutex_.Unlock();
+}
+
+void PartitionedCacheImpl::RemovePartition(CachePartition* partition) {
+  MutexLock l(&mutex_);
+  assigned_capacity_ -= partition->capacity_.load(std::memory_order_relaxed);
+  reserved_capacity_ -= partition->reserved_capacity_;
+  auto iter = partitions_.find(partition->name_);
+  if (iter != partitions_.end() && iter->second.partition == partition) {
+    partitions_.erase(iter);
+  }
+}
+
+std::shared_ptr<PartitionedCache> NewPartitionedCache(
+    size_t capacity, int num_shard_bits, bool strict_capacity_limit,
+    std::shared_ptr<MemoryAllocator> memory_allocator) {
+  if (num_shard_bits >= 20) {
+    return nullptr;  // the cache cannot be sharded into too many fine pieces
+  }
+  return std::make_shared<PartitionedCacheImpl>(
+      capacity, num_shard_bits, strict_capacity_limit,
+      std::move(memory_allocator));
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,197 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "port/port.h"
+#include "rocksdb/cache.h"
+
+namespace rocksdb {
+
+class PartitionedCacheImpl;
+
+// One partition of a PartitionedCache. It forwards to an LRU cache of its
+// own, whose capacity is assigned by the PartitionedCache: before an insert
+// that does not fit, the partition asks it for more capacity.
+class CachePartition : public Cache {
+ public:
+  CachePartition(std::shared_ptr<PartitionedCacheImpl> parent,
+                 const std::string& name, const CachePartitionOptions& opts,
+                 std::shared_ptr<Cache> cache,
+                 std::shared_ptr<MemoryAllocator> allocator);
+  virtual ~CachePartition();
+
+  virtual const char* Name() const override { return "PartitionedCache"; }
+
+  virtual Status Insert(const Slice& key, void* value, size_t charge,
+                        void (*deleter)(const Slice& key, void* value),
+                        Handle** handle = nullptr,
+                        Priority priority = Priority::LOW) override;
+  virtual Handle* Lookup(const Slice& key, Statistics* stats) override;
+  virtual bool Ref(Handle* handle) override { return cache_->Ref(handle); }
+  virtual bool Release(Handle* handle, bool force_erase = false) override {
+    return cache_->Release(handle, force_erase);
+  }
+  virtual void* Value(Handle* handle) override {
+    return cache_->Value(handle);
+  }
+  virtual void Erase(const Slice& key) override { cache_->Erase(key); }
+
+  // Ids are unique across the partitions of a cache, so that the tables
+  // sharing some partition build distinct cache keys.
+  virtual uint64_t NewId() override;
+
+  // Change the capacity limit of the partition.
+  virtual void SetCapacity(size_t capacity) override;
+  virtual void SetStrictCapacityLimit(bool strict_capacity_limit) override {
+    cache_->SetStrictCapacityLimit(strict_capacity_limit);
+  }
+  virtual bool HasStrictCapacityLimit() const override {
+    return cache_->HasStrictCapacityLimit();
+  }
+
+  // Capacity the partition holds at the moment.
+  virtual size_t GetCapacity() const override {
+    return capacity_.load(std::memory_order_relaxed);
+  }
+  virtual size_t GetUsage() const override { return cache_->GetUsage(); }
+  virtual size_t GetUsage(Handle* handle) const override {
+    return cache_->GetUsage(handle);
+  }
+  virtual size_t GetPinnedUsage() const override {
+    return cache_->GetPinnedUsage();
+  }
+  virtual size_t GetCharge(Handle* handle) const override {
+    return cache_->GetCharge(handle);
+  }
+  virtual void DisownData() override { cache_->DisownData(); }
+  virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                                      bool thread_safe) override {
+    cache_->ApplyToAllCacheEntries(callback, thread_safe);
+  }
+  virtual void EraseUnRefEntries() override { cache_->EraseUnRefEntries(); }
+
+  virtual std::string GetPrintableOptions() const override;
+
+  CachePartitionStats GetStats() const;
+
+ private:
+  friend class PartitionedCacheImpl;
+
+  // Set the capacity of the partition, the underlying cache is resized by
+  // ApplyAssignedCapacity(). Requires the mutex of the parent.
+  void SetAssignedCapacity(size_t capacity);
+  // Resize the underlying cache to the capacity of the partition, evicting
+  // entries if it shrinks. Called without the mutex of the parent since the
+  // deleters of the evicted entries may insert into the cache again.
+  void ApplyAssignedCapacity();
+
+  std::shared_ptr<PartitionedCacheImpl> parent_;
+  const std::string name_;
+  const size_t reserved_capacity_;
+  // Guarded by the mutex of the parent.
+  size_t capacity_limit_;
+  std::atomic<size_t> capacity_;
+  std::shared_ptr<Cache> cache_;
+  std::atomic<uint64_t> hits_;
+  std::atomic<uint64_t> misses_;
+};
+
+class PartitionedCacheImpl
+    : public PartitionedCache,
+      public std::enable_shared_from_this<PartitionedCacheImpl> {
+ public:
+  PartitionedCacheImpl(size_t capacity, int num_shard_bits,
+                       bool strict_capacity_limit,
+                       std::shared_ptr<MemoryAllocator> memory_allocator);
+  virtual ~PartitionedCacheImpl();
+
+  virtual std::shared_ptr<Cache> GetPartition(
+      const std::string& name, const CachePartitionOptions& opts) override;
+  virtual bool GetPartitionStats(const std::string& name,
+                                 CachePartitionStats* stats) const override;
+  virtual void GetAllPartitionStats(
+      std::map<std::string, CachePartitionStats>* stats) const override;
+  virtual size_t GetCapacity() const override { return capacity_; }
+
+  // Make room for `charge` more bytes in the partition, in this order:
+  //   1. capacity that no partition holds,
+  //   2. capacity that other partitions hold beyond what CapacityFor() keeps
+  //      for their usage, evicting nothing,
+  //   3. if the partition is below its reserved capacity, capacity that other
+  //      partitions borrowed beyond their own reservation, evicting their
+  //      entries.
+  // Whatever is still missing is made by the partition evicting its own
+  // entries. The partitions are resized once mutex_ is released.
+  void Reserve(CachePartition* partition, size_t charge);
+
+  // Capacity the partition needs to hold `usage` bytes. An entry is charged
+  // to one shard only, so a sharded partition keeps twice its usage, plus
+  // room for one more entry of `charge` bytes in every shard, for the shards
+  // to have room despite an uneven spread of the entries.
+  size_t CapacityFor(size_t usage, size_t charge) const {
+    if (num_shard_bits_ <= 0) {
+      return usage;
+    }
+    return usage * 2 + (charge << num_shard_bits_);
+  }
+
+  void SetCapacityLimit(CachePartition* partition, size_t capacity_limit);
+
+  uint64_t NewId() {
+    return last_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  // Called by the destructor of the partition.
+  void RemovePartition(CachePartition* partition);
+
+ private:
+  size_t CapacityLimit(const CachePartition* partition) const;
+
+  // Queue the partition, whose capacity changed, for ResizePartitions().
+  // Requires mutex_.
+  void QueueResize(CachePartition* partition);
+  // Resize the queued partitions, one thread at a time. Called without
+  // mutex_. A deleter run by the resizing that inserts into the cache leaves
+  // the partitions it changes to the resizing thread, except `grown`, the
+  // partition it inserts into, which is grown at once.
+  void ResizePartitions(CachePartition* grown);
+
+  const size_t capacity_;
+  const int num_shard_bits_;
+  const bool strict_capacity_limit_;
+  const std::shared_ptr<MemoryAllocator> memory_allocator_;
+  std::atomic<uint64_t> last_id_;
+
+  // mutex_ protects the following state, and the capacity of the partitions.
+  mutable port::Mutex mutex_;
+  // The partitions are owned by their users. A partition removes itself
+  // before anything else in its destructor, so the raw pointers stay valid
+  // while the mutex is held.
+  struct PartitionRef {
+    CachePartition* partition;
+    std::weak_ptr<CachePartition> ref;
+  };
+  std::map<std::string, PartitionRef> partitions_;
+  // Sum of the capacity and of the reserved capacity of the partitions.
+  size_t assigned_capacity_;
+  size_t reserved_capacity_;
+  // Partitions to resize, held so that they outlive their resizing.
+  std::deque<std::shared_ptr<CachePartition>> resize_queue_;
+  // Whether a thread runs ResizePartitions(), which one, and the partition
+  // it resizes. The other threads wait on resize_cv_ for it to be done.
+  bool resizing_;
+  std::thread::id resizing_thread_;
+  CachePartition* resized_partition_;
+  port::CondVar resize_cv_;
+};
+
+}  // namespace rocksdb
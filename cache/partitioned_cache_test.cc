@@ -0,0 +1,219 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "cache/partitioned_cache.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "test_util/testharness.h"
+#include "util/hash.h"
+
+namespace rocksdb {
+
+class PartitionedCacheTest : public testing::Test {
+ public:
+  PartitionedCacheTest() {}
+
+  static void Deleter(const Slice& /*key*/, void* /*value*/) {}
+
+  static void Insert(Cache* cache, const std::string& prefix, int begin,
+                     int end) {
+    for (int i = begin; i < end; i++) {
+      ASSERT_OK(cache->Insert(prefix + std::to_string(i), nullptr, 1,
+                              &Deleter));
+    }
+  }
+
+  static int NumEntries(Cache* cache, const std::string& prefix, int end) {
+    int n = 0;
+    for (int i = 0; i < end; i++) {
+      Cache::Handle* handle = cache->Lookup(prefix + std::to_string(i));
+      if (handle != nullptr) {
+        cache->Release(handle);
+        n++;
+      }
+    }
+    return n;
+  }
+};
+
+TEST_F(PartitionedCacheTest, LendReservedCapacity) {
+  auto cache = NewPartitionedCache(100, 0);
+  CachePartitionOptions critical_opts;
+  critical_opts.reserved_capacity = 60;
+  auto critical = cache->GetPartition("critical", critical_opts);
+  auto batch = cache->GetPartition("batch");
+  ASSERT_NE(nullptr, critical);
+  ASSERT_NE(nullptr, batch);
+
+  // While the critical partition is idle, the batch one uses the whole cache.
+  Insert(batch.get(), "batch", 0, 100);
+  ASSERT_EQ(100, batch->GetUsage());
+  ASSERT_EQ(100, batch->GetCapacity());
+
+  // The critical partition takes its reservation back.
+  Insert(critical.get(), "critical", 0, 60);
+  ASSERT_EQ(60, critical->GetUsage());
+  ASSERT_EQ(40, batch->GetUsage());
+  ASSERT_EQ(60, NumEntries(critical.get(), "critical", 60));
+
+  // But the batch partition cannot take it again.
+  Insert(batch.get(), "batch", 100, 200);
+  ASSERT_EQ(40, batch->GetUsage());
+  ASSERT_EQ(60, NumEntries(critical.get(), "critical", 60));
+
+  // Capacity the critical partition does not use anymore is lent again.
+  critical->EraseUnRefEntries();
+  Insert(batch.get(), "batch", 200, 300);
+  ASSERT_EQ(100, batch->GetUsage());
+  ASSERT_EQ(0, critical->GetCapacity());
+}
+
+TEST_F(PartitionedCacheTest, LendWithoutEvicting) {
+  // Four shards.
+  auto cache = NewPartitionedCache(100, 2);
+  auto lender = cache->GetPartition("lender");
+  auto borrower = cache->GetPartition("borrower");
+  Insert(lender.get(), "lender", 0, 48);
+  ASSERT_EQ(100, lender->GetCapacity());
+  const int num_lender_entries = NumEntries(lender.get(), "lender", 48);
+
+  // The entries of the lender are spread unevenly over its shards, the
+  // fullest shard holds more than a quarter of them.
+  std::vector<int> shard_entries(4);
+  for (int i = 0; i < 48; i++) {
+    const std::string key = "lender" + std::to_string(i);
+    shard_entries[static_cast<uint32_t>(GetSliceNPHash64(key)) >> 30]++;
+  }
+  ASSERT_GT(*std::max_element(shard_entries.begin(), shard_entries.end()),
+            12);
+
+  // The lender keeps twice its usage, the borrower evicts its own entries.
+  Insert(borrower.get(), "borrower", 0, 20);
+  ASSERT_EQ(num_lender_entries, NumEntries(lender.get(), "lender", 48));
+  ASSERT_GE(lender->GetCapacity(), 2 * lender->GetUsage());
+  ASSERT_LT(NumEntries(borrower.get(), "borrower", 20), 20);
+}
+
+namespace {
+Cache* demoted_cache = nullptr;
+
+// Moves the evicted entries to another partition, as the block cache does
+// with the compressed block cache.
+void DemoteOnEviction(const Slice& key, void* /*value*/) {
+  ASSERT_OK(demoted_cache->Insert("demoted" + key.ToString(), nullptr, 1,
+                                  &PartitionedCacheTest::Deleter));
+}
+}  // namespace
+
+TEST_F(PartitionedCacheTest, DeleterInsertsIntoCache) {
+  auto cache = NewPartitionedCache(100, 0);
+  auto data = cache->GetPartition("data");
+  auto demoted = cache->GetPartition("demoted");
+  demoted_cache = demoted.get();
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(data->Insert("data" + std::to_string(i), nullptr, 1,
+                           &DemoteOnEviction));
+  }
+  ASSERT_EQ(100, data->GetUsage());
+
+  // The entries evicted by the shrinking are inserted into the other
+  // partition, which takes the capacity given up.
+  data->SetCapacity(40);
+  ASSERT_EQ(40, data->GetUsage());
+  ASSERT_EQ(60, demoted->GetUsage());
+  ASSERT_EQ(60, NumEntries(demoted.get(), "demoteddata", 100));
+  ASSERT_EQ(40, NumEntries(data.get(), "data", 100));
+
+  // The remaining entries are demoted when the partition is destroyed.
+  data.reset();
+  demoted_cache = nullptr;
+}
+
+TEST_F(PartitionedCacheTest, CapacityLimit) {
+  auto cache = NewPartitionedCache(100, 0);
+  CachePartitionOptions opts;
+  opts.capacity_limit = 10;
+  auto limited = cache->GetPartition("limited", opts);
+  Insert(limited.get(), "limited", 0, 50);
+  ASSERT_EQ(10, limited->GetUsage());
+  ASSERT_EQ(10, NumEntries(limited.get(), "limited", 50));
+
+  // Lowering the limit evicts the oldest entries.
+  limited->SetCapacity(5);
+  ASSERT_EQ(5, limited->GetUsage());
+  ASSERT_EQ(5, NumEntries(limited.get(), "limited", 50));
+
+  auto other = cache->GetPartition("other");
+  Insert(other.get(), "other", 0, 200);
+  ASSERT_EQ(95, other->GetUsage());
+}
+
+TEST_F(PartitionedCacheTest, Partitions) {
+  auto cache = NewPartitionedCache(100, 0);
+  CachePartitionOptions opts;
+  opts.reserved_capacity = 80;
+  auto a = cache->GetPartition("a", opts);
+  ASSERT_NE(nullptr, a);
+  // The same name gives the same partition.
+  ASSERT_EQ(a, cache->GetPartition("a"));
+  // Reservations cannot exceed the capacity.
+  ASSERT_EQ(nullptr, cache->GetPartition("b", opts));
+  opts.reserved_capacity = 20;
+  auto b = cache->GetPartition("b", opts);
+  ASSERT_NE(nullptr, b);
+
+  // Ids are shared by the partitions.
+  ASSERT_NE(a->NewId(), b->NewId());
+
+  Insert(a.get(), "a", 0, 10);
+  ASSERT_EQ(10, NumEntries(a.get(), "a", 20));
+  ASSERT_EQ(0, NumEntries(b.get(), "a", 5));
+
+  CachePartitionStats stats;
+  ASSERT_TRUE(cache->GetPartitionStats("a", &stats));
+  ASSERT_EQ(10, stats.hits);
+  ASSERT_EQ(10, stats.misses);
+  ASSERT_EQ(10, stats.usage);
+  ASSERT_EQ(10, stats.capacity);
+  std::map<std::string, CachePartitionStats> all_stats;
+  cache->GetAllPartitionStats(&all_stats);
+  ASSERT_EQ(2, all_stats.size());
+  ASSERT_EQ(0, all_stats["b"].hits);
+  ASSERT_EQ(5, all_stats["b"].misses);
+
+  // Destroying a partition releases its reservation.
+  a.reset();
+  ASSERT_FALSE(cache->GetPartitionStats("a", &stats));
+  opts.reserved_capacity = 80;
+  ASSERT_NE(nullptr, cache->GetPartition("c", opts));
+}
+
+TEST_F(PartitionedCacheTest, DefaultShardBits) {
+  // The partitions are sharded for the whole capacity but start empty.
+  auto cache = NewPartitionedCache(64 << 20);
+  auto partition = cache->GetPartition("data");
+  const size_t kCharge = 4 << 10;
+  const int kNumEntries = 1000;
+  for (int i = 0; i < kNumEntries; i++) {
+    std::string key = "data" + std::to_string(i);
+    ASSERT_OK(partition->Insert(key, nullptr, kCharge, &Deleter));
+    Cache::Handle* handle = partition->Lookup(key);
+    ASSERT_NE(nullptr, handle);
+    partition->Release(handle);
+  }
+  ASSERT_GT(partition->GetUsage(), kNumEntries * kCharge * 9 / 10);
+  ASSERT_GT(NumEntries(partition.get(), "data", kNumEntries),
+            kNumEntries * 9 / 10);
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -10,11 +10,49 @@
 #include "cache/sharded_cache.h"
 
 #include <string>
+#include <thread>
 
 #include "util/mutexlock.h"
 
 namespace rocksdb {
 
+std::atomic<int>* ReshardGuard::BeginOperation() {
+  while (true) {
+    std::atomic<int>* ops = &counters_.Access()->ops;
+    ops->fetch_add(1);
+    if (!resharding_.load()) {
+      return ops;
+    }
+    ops->fetch_sub(1);
+    MutexLock l(&mutex_);
+    while (resharding_.load()) {
+      cv_.Wait();
+    }
+  }
+}
+
+void ReshardGuard::BeginResharding() {
+  {
+    MutexLock l(&mutex_);
+    while (resharding_.load()) {
+      cv_.Wait();
+    }
+    resharding_.store(true);
+  }
+  // The operations counted from now on see the flag and back off.
+  for (size_t i = 0; i < counters_.Size(); i++) {
+    while (counters_.AccessAtCore(i)->ops.load() != 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void ReshardGuard::EndResharding() {
+  MutexLock l(&mutex_);
+  resharding_.store(false);
+  cv_.SignalAll();
+}
+
 ShardedCache::ShardedCache(size_t capacity, int num_shard_bits,
                            bool strict_capacity_limit,
                            std::shared_ptr<MemoryAllocator> allocator)
@@ -25,7 +63,8 @@ ShardedCache::ShardedCache(size_t capacity, int num_shard_bits,
       last_id_(1) {}
 
 void ShardedCache::SetCapacity(size_t capacity) {
-  int num_shards = 1 << num_shard_bits_;
+  ReshardGuard::Operation op(reshard_guard_.get());
+  int num_shards = 1 << GetNumShardBits();
   const size_t per_shard = (capacity + (num_shards - 1)) / num_shards;
   MutexLock l(&capacity_mutex_);
   for (int s = 0; s < num_shards; s++) {
@@ -35,7 +74,8 @@ void ShardedCache::SetCapacity(size_t capacity) {
 }
 
 void ShardedCache::SetStrictCapacityLimit(bool strict_capacity_limit) {
-  int num_shards = 1 << num_shard_bits_;
+  ReshardGuard::Operation op(reshard_guard_.get());
+  int num_shards = 1 << GetNumShardBits();
   MutexLock l(&capacity_mutex_);
   for (int s = 0; s < num_shards; s++) {
     GetShard(s)->SetStrictCapacityLimit(strict_capacity_limit);
@@ -43,31 +83,56 @@ void ShardedCache::SetStrictCapacityLimit(bool strict_capacity_limit) {
   strict_capacity_limit_ = strict_capacity_limit;
 }
 
+Status ShardedCache::SetNumShardBits(int num_shard_bits) {
+  if (reshard_guard_ == nullptr) {
+    return Status::NotSupported("Resharding is not allowed");
+  }
+  if (num_shard_bits < 0 || num_shard_bits >= 20) {
+    return Status::InvalidArgument("Wrong number of shard bits");
+  }
+  Status s;
+  reshard_guard_->BeginResharding();
+  if (num_shard_bits != GetNumShardBits()) {
+    MutexLock l(&capacity_mutex_);
+    s = Reshard(num_shard_bits, capacity_, strict_capacity_limit_);
+    if (s.ok()) {
+      num_shard_bits_.store(num_shard_bits, std::memory_order_relaxed);
+    }
+  }
+  reshard_guard_->EndResharding();
+  return s;
+}
+
 Status ShardedCache::Insert(const Slice& key, void* value, size_t charge,
                             void (*deleter)(const Slice& key, void* value),
                             Handle** handle, Priority priority) {
   uint32_t hash = HashSlice(key);
+  ReshardGuard::Operation op(reshard_guard_.get());
   return GetShard(Shard(hash))
       ->Insert(key, hash, value, charge, deleter, handle, priority);
 }
 
 Cache::Handle* ShardedCache::Lookup(const Slice& key, Statistics* /*stats*/) {
   uint32_t hash = HashSlice(key);
+  ReshardGuard::Operation op(reshard_guard_.get());
   return GetShard(Shard(hash))->Lookup(key, hash);
 }
 
 bool ShardedCache::Ref(Handle* handle) {
   uint32_t hash = GetHash(handle);
+  ReshardGuard::Operation op(reshard_guard_.get());
   return GetShard(Shard(hash))->Ref(handle);
 }
 
 bool ShardedCache::Release(Handle* handle, bool force_erase) {
   uint32_t hash = GetHash(handle);
+  ReshardGuard::Operation op(reshard_guard_.get());
   return GetShard(Shard(hash))->Release(handle, force_erase);
 }
 
 void ShardedCache::Erase(const Slice& key) {
   uint32_t hash = HashSlice(key);
+  ReshardGuard::Operation op(reshard_guard_.get());
   GetShard(Shard(hash))->Erase(key, hash);
 }
 
@@ -87,7 +152,8 @@ bool ShardedCache::HasStrictCapacityLimit() const {
 
 size_t ShardedCache::GetUsage() const {
   // We will not lock the cache when getting the usage from shards.
-  int num_shards = 1 << num_shard_bits_;
+  ReshardGuard::Operation op(reshard_guard_.get());
+  int num_shards = 1 << GetNumShardBits();
   size_t usage = 0;
   for (int s = 0; s < num_shards; s++) {
     usage += GetShard(s)->GetUsage();
@@ -101,7 +167,8 @@ size_t ShardedCache::GetUsage(Handle* handle) const {
 
 size_t ShardedCache::GetPinnedUsage() const {
   // We will not lock the cache when getting the usage from shards.
-  int num_shards = 1 << num_shard_bits_;
+  ReshardGuard::Operation op(reshard_guard_.get());
+  int num_shards = 1 << GetNumShardBits();
   size_t usage = 0;
   for (int s = 0; s < num_shards; s++) {
     usage += GetShard(s)->GetPinnedUsage();
@@ -111,14 +178,16 @@ size_t ShardedCache::GetPinnedUsage() const {
 
 void ShardedCache::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
                                           bool thread_safe) {
-  int num_shards = 1 << num_shard_bits_;
+  ReshardGuard::Operation op(reshard_guard_.get());
+  int num_shards = 1 << GetNumShardBits();
   for (int s = 0; s < num_shards; s++) {
     GetShard(s)->ApplyToAllCacheEntries(callback, thread_safe);
   }
 }
 
 void ShardedCache::EraseUnRefEntries() {
-  int num_shards = 1 << num_shard_bits_;
+  ReshardGuard::Operation op(reshard_guard_.get());
+  int num_shards = 1 << GetNumShardBits();
   for (int s = 0; s < num_shards; s++) {
     GetShard(s)->EraseUnRefEntries();
   }
@@ -134,7 +203,8 @@ std::string ShardedCache::GetPrintableOptions() const {
     snprintf(buffer, kBufferSize, "    capacity : %" ROCKSDB_PRIszt "\n",
              capacity_);
     ret.append(buffer);
-    snprintf(buffer, kBufferSize, "    num_shard_bits : %d\n", num_shard_bits_);
+    snprintf(buffer, kBufferSize, "    num_shard_bits : %d\n",
+             GetNumShardBits());
     ret.append(buffer);
     snprintf(buffer, kBufferSize, "    strict_capacity_limit : %d\n",
              strict_capacity_limit_);
@@ -143,6 +213,7 @@ std::string ShardedCache::GetPrintableOptions() const {
   snprintf(buffer, kBufferSize, "    memory_allocator : %s\n",
            memory_allocator() ? memory_allocator()->Name() : "None");
   ret.append(buffer);
+  ReshardGuard::Operation op(reshard_guard_.get());
   ret.append(GetShard(0)->GetPrintableOptions());
   return ret;
 }
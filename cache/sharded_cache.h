@@ -14,6 +14,7 @@
 
 #include "port/port.h"
 #include "rocksdb/cache.h"
+#include "util/core_local.h"
 #include "util/hash.h"
 
 namespace rocksdb {
@@ -42,6 +43,49 @@ class CacheShard {
   virtual std::string GetPrintableOptions() const { return ""; }
 };
 
+// Lets the operations on a sharded cache run concurrently with each other but
+// not with a resharding. The operations in flight are counted per core, so
+// that they do not contend on a shared counter, and must not nest.
+class ReshardGuard {
+ public:
+  ReshardGuard() : resharding_(false), cv_(&mutex_) {}
+
+  // Counts an operation in flight for its scope, once no resharding runs.
+  class Operation {
+   public:
+    // `guard` may be nullptr for a cache that is never resharded.
+    explicit Operation(ReshardGuard* guard)
+        : ops_(guard != nullptr ? guard->BeginOperation() : nullptr) {}
+    ~Operation() {
+      if (ops_ != nullptr) {
+        ops_->fetch_sub(1);
+      }
+    }
+
+   private:
+    std::atomic<int>* ops_;
+  };
+
+  // Waits for the operations in flight, and holds the new ones off until
+  // EndResharding().
+  void BeginResharding();
+  void EndResharding();
+
+ private:
+  struct OpsCounter {
+    std::atomic<int> ops{0};
+    char padding[CACHE_LINE_SIZE - sizeof(std::atomic<int>)];
+  };
+
+  // Returns the counter to decrement once the operation is done.
+  std::atomic<int>* BeginOperation();
+
+  CoreLocalArray<OpsCounter> counters_;
+  std::atomic<bool> resharding_;
+  port::Mutex mutex_;
+  port::CondVar cv_;
+};
+
 // Generic cache interface which shards cache by hash of keys. 2^num_shard_bits
 // shards will be created, with capacity split evenly to each of the shards.
 // Keys are sharded by the highest num_shard_bits bits of hash value.
@@ -61,6 +105,7 @@ class ShardedCache : public Cache {
 
   virtual void SetCapacity(size_t capacity) override;
   virtual void SetStrictCapacityLimit(bool strict_capacity_limit) override;
+  virtual Status SetNumShardBits(int num_shard_bits) override;
 
   virtual Status Insert(const Slice& key, void* value, size_t charge,
                         void (*deleter)(const Slice& key, void* value),
@@ -80,19 +125,38 @@ class ShardedCache : public Cache {
   virtual void EraseUnRefEntries() override;
   virtual std::string GetPrintableOptions() const override;
 
-  int GetNumShardBits() const { return num_shard_bits_; }
+  int GetNumShardBits() const {
+    return num_shard_bits_.load(std::memory_order_relaxed);
+  }
 
- private:
+ protected:
   static inline uint32_t HashSlice(const Slice& s) {
     return static_cast<uint32_t>(GetSliceNPHash64(s));
   }
 
+  // Only stable within a ReshardGuard::Operation when resharding is allowed.
   uint32_t Shard(uint32_t hash) {
+    int num_shard_bits = num_shard_bits_.load(std::memory_order_relaxed);
     // Note, hash >> 32 yields hash in gcc, not the zero we expect!
-    return (num_shard_bits_ > 0) ? (hash >> (32 - num_shard_bits_)) : 0;
+    return (num_shard_bits > 0) ? (hash >> (32 - num_shard_bits)) : 0;
   }
 
-  int num_shard_bits_;
+  // Lets SetNumShardBits() call Reshard(), to be done before the cache is
+  // used.
+  void AllowResharding() { reshard_guard_.reset(new ReshardGuard()); }
+  ReshardGuard* reshard_guard() const { return reshard_guard_.get(); }
+
+  // Moves the entries to 2^num_shard_bits new shards sharing `capacity`.
+  // Called with no other operation running on the cache.
+  virtual Status Reshard(int /*num_shard_bits*/, size_t /*capacity*/,
+                         bool /*strict_capacity_limit*/) {
+    return Status::NotSupported("Resharding is not supported");
+  }
+
+ private:
+  std::atomic<int> num_shard_bits_;
+  // Only allocated once resharding is allowed.
+  std::unique_ptr<ReshardGuard> reshard_guard_;
   mutable port::Mutex capacity_mutex_;
   size_t capacity_;
   bool strict_capacity_limit_;
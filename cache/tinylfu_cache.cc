@@ -0,0 +1,591 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "cache/tinylfu_cache.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "util/mutexlock.h"
+
+namespace rocksdb {
+
+namespace {
+const uint64_t kSketchSeeds[] = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL,
+                                 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+const int kSketchDepth = 4;
+}  // namespace
+
+FrequencySketch::FrequencySketch() : mask_(0), sample_size_(0), additions_(0) {
+  EnsureCapacity(0);
+}
+
+void FrequencySketch::EnsureCapacity(size_t num_entries) {
+  size_t num_words = kMinWords;
+  while (num_words < num_entries) {
+    num_words *= 2;
+  }
+  if (table_ != nullptr && num_words <= mask_ + 1) {
+    return;
+  }
+  table_.reset(new uint64_t[num_words]);
+  memset(table_.get(), 0, sizeof(table_[0]) * num_words);
+  mask_ = num_words - 1;
+  sample_size_ = 10 * num_words;
+  additions_ = 0;
+}
+
+void FrequencySketch::Locate(uint32_t hash, int i, size_t* word,
+                             int* shift) const {
+  uint64_t h = (static_cast<uint64_t>(hash) + kSketchSeeds[i]) *
+               kSketchSeeds[i];
+  h ^= h >> 32;
+  *word = static_cast<size_t>(h) & mask_;
+  // Each word has 16 counters, 4 for each row.
+  *shift = ((i << 2) | static_cast<int>(h >> 62)) << 2;
+}
+
+void FrequencySketch::Increment(uint32_t hash) {
+  bool added = false;
+  for (int i = 0; i < kSketchDepth; i++) {
+    size_t word;
+    int shift;
+    Locate(hash, i, &word, &shift);
+    const uint64_t mask = uint64_t{0xf} << shift;
+    if ((table_[word] & mask) != mask) {
+      table_[word] += uint64_t{1} << shift;
+      added = true;
+    }
+  }
+  if (added && ++additions_ >= sample_size_) {
+    Reset();
+  }
+}
+
+uint32_t FrequencySketch::Frequency(uint32_t hash) const {
+  uint32_t frequency = 0xf;
+  for (int i = 0; i < kSketchDepth; i++) {
+    size_t word;
+    int shift;
+    Locate(hash, i, &word, &shift);
+    uint32_t count = static_cast<uint32_t>((table_[word] >> shift) & 0xf);
+    if (count < frequency) {
+      frequency = count;
+    }
+  }
+  return frequency;
+}
+
+void FrequencySketch::Reset() {
+  for (size_t i = 0; i <= mask_; i++) {
+    table_[i] = (table_[i] >> 1) & 0x7777777777777777ULL;
+  }
+  additions_ /= 2;
+}
+
+TinyLFUCacheShard::TinyLFUCacheShard(size_t capacity,
+                                     bool strict_capacity_limit,
+                                     double window_ratio,
+                                     double protected_ratio,
+                                     bool use_adaptive_mutex)
+    : capacity_(0),
+      strict_capacity_limit_(strict_capacity_limit),
+      window_ratio_(window_ratio),
+      protected_ratio_(protected_ratio),
+      window_capacity_(0),
+      protected_capacity_(0),
+      num_entries_(0),
+      usage_(0),
+      lru_usage_(0),
+      window_usage_(0),
+      protected_usage_(0),
+      mutex_(use_adaptive_mutex) {
+  // Make empty circular linked lists
+  for (LRUHandle* list : {&window_, &probation_, &protected_}) {
+    list->next = list;
+    list->prev = list;
+  }
+  SetCapacity(capacity);
+}
+
+void TinyLFUCacheShard::EraseUnRefEntries() {
+  autovector<LRUHandle*> last_reference_list;
+  {
+    MutexLock l(&mutex_);
+    for (LRUHandle* list : {&window_, &probation_, &protected_}) {
+      while (list->next != list) {
+        Evict(list->next, &last_reference_list);
+      }
+    }
+  }
+
+  for (auto entry : last_reference_list) {
+    entry->Free();
+  }
+}
+
+void TinyLFUCacheShard::ApplyToAllCacheEntries(
+    void (*callback)(void*, size_t), bool thread_safe) {
+  const auto applyCallback = [&]() {
+    table_.ApplyToAllCacheEntries(
+        [callback](LRUHandle* h) { callback(h->value, h->charge); });
+  };
+
+  if (thread_safe) {
+    MutexLock l(&mutex_);
+    applyCallback();
+  } else {
+    applyCallback();
+  }
+}
+
+size_t TinyLFUCacheShard::TEST_GetWindowUsage() {
+  MutexLock l(&mutex_);
+  return window_usage_;
+}
+
+size_t TinyLFUCacheShard::TEST_GetProtectedUsage() {
+  MutexLock l(&mutex_);
+  return protected_usage_;
+}
+
+void TinyLFUCacheShard::List_Remove(LRUHandle* e) {
+  assert(e->next != nullptr);
+  assert(e->prev != nullptr);
+  e->next->prev = e->prev;
+  e->prev->next = e->next;
+  e->prev = e->next = nullptr;
+  lru_usage_ -= e->charge;
+  if (e->InWindow()) {
+    assert(window_usage_ >= e->charge);
+    window_usage_ -= e->charge;
+  } else if (e->InHighPriPool()) {
+    assert(protected_usage_ >= e->charge);
+    protected_usage_ -= e->charge;
+  }
+}
+
+void TinyLFUCacheShard::List_Append(LRUHandle* list, LRUHandle* e) {
+  assert(e->next == nullptr);
+  assert(e->prev == nullptr);
+  e->next = list;
+  e->prev = list->prev;
+  e->prev->next = e;
+  e->next->prev = e;
+  lru_usage_ += e->charge;
+  if (e->InWindow()) {
+    window_usage_ += e->charge;
+  } else if (e->InHighPriPool()) {
+    protected_usage_ += e->charge;
+  }
+}
+
+void TinyLFUCacheShard::List_Insert(LRUHandle* e) {
+  if (e->InWindow()) {
+    List_Append(&window_, e);
+    MaintainWindowSize();
+  } else if (e->InHighPriPool() || e->IsHighPri() || e->HasHit()) {
+    e->SetInHighPriPool(true);
+    List_Append(&protected_, e);
+    MaintainProtectedSize();
+  } else {
+    List_Append(&probation_, e);
+  }
+}
+
+void TinyLFUCacheShard::MaintainProtectedSize() {
+  while (protected_usage_ > protected_capacity_ &&
+         protected_.next != &protected_) {
+    LRUHandle* e = protected_.next;
+    List_Remove(e);
+    e->SetInHighPriPool(false);
+    e->ClearHit();
+    List_Append(&probation_, e);
+  }
+}
+
+void TinyLFUCacheShard::MaintainWindowSize() {
+  while (window_usage_ > window_capacity_ && window_.next != &window_) {
+    LRUHandle* e = window_.next;
+    // Entries referenced from the window are counted in the main segments.
+    const size_t main_usage = usage_ - window_usage_;
+    if (main_usage + e->charge > capacity_ - window_capacity_) {
+      break;
+    }
+    List_Remove(e);
+    e->SetInWindow(false);
+    e->ClearHit();
+    List_Append(&probation_, e);
+  }
+}
+
+void TinyLFUCacheShard::Evict(LRUHandle* e, autovector<LRUHandle*>* deleted) {
+  // LRU lists contain only elements which can be evicted
+  assert(e->InCache() && !e->HasRefs());
+  List_Remove(e);
+  table_.Remove(e->key(), e->hash);
+  e->SetInCache(false);
+  usage_ -= e->charge;
+  num_entries_--;
+  deleted->push_back(e);
+}
+
+void TinyLFUCacheShard::EvictFromCache(size_t charge, size_t window_charge,
+                                       autovector<LRUHandle*>* deleted) {
+  while ((usage_ + charge) > capacity_) {
+    // The oldest window entry has to leave the window to make room for the
+    // new one, it becomes the candidate for admission.
+    LRUHandle* candidate = nullptr;
+    if (window_usage_ + window_charge > window_capacity_ &&
+        window_.next != &window_) {
+      candidate = window_.next;
+    }
+    LRUHandle* victim = nullptr;
+    if (probation_.next != &probation_) {
+      victim = probation_.next;
+    } else if (protected_.next != &protected_) {
+      victim = protected_.next;
+    }
+
+    if (candidate != nullptr && victim != nullptr) {
+      // Admission test: the window entry in excess replaces the main victim
+      // only if it is accessed more often.
+      if (sketch_.Frequency(candidate->hash) >
+          sketch_.Frequency(victim->hash)) {
+        List_Remove(candidate);
+        candidate->SetInWindow(false);
+        candidate->ClearHit();
+        List_Append(&probation_, candidate);
+      } else {
+        victim = candidate;
+      }
+    } else if (candidate != nullptr) {
+      victim = candidate;
+    } else if (victim == nullptr && window_.next != &window_) {
+      victim = window_.next;
+    }
+
+    if (victim == nullptr) {
+      break;
+    }
+    Evict(victim, deleted);
+  }
+}
+
+void TinyLFUCacheShard::UpdateSegmentCapacities() {
+  window_capacity_ = static_cast<size_t>(capacity_ * window_ratio_);
+  protected_capacity_ =
+      static_cast<size_t>((capacity_ - window_capacity_) * protected_ratio_);
+}
+
+void TinyLFUCacheShard::SetCapacity(size_t capacity) {
+  autovector<LRUHandle*> last_reference_list;
+  {
+    MutexLock l(&mutex_);
+    capacity_ = capacity;
+    UpdateSegmentCapacities();
+    MaintainProtectedSize();
+    EvictFromCache(0, 0, &last_reference_list);
+  }
+
+  // Free the entries outside of mutex for performance reasons
+  for (auto entry : last_reference_list) {
+    entry->Free();
+  }
+}
+
+void TinyLFUCacheShard::SetStrictCapacityLimit(bool strict_capacity_limit) {
+  MutexLock l(&mutex_);
+  strict_capacity_limit_ = strict_capacity_limit;
+}
+
+Cache::Handle* TinyLFUCacheShard::Lookup(const Slice& key, uint32_t hash) {
+  MutexLock l(&mutex_);
+  // Misses count too, they are what lets a new entry win its admission.
+  sketch_.Increment(hash);
+  LRUHandle* e = table_.Lookup(key, hash);
+  if (e != nullptr) {
+    assert(e->InCache());
+    if (!e->HasRefs()) {
+      // The entry is in a LRU list since it's in hash and has no external
+      // references
+      List_Remove(e);
+    }
+    e->Ref();
+    e->SetHit();
+  }
+  return reinterpret_cast<Cache::Handle*>(e);
+}
+
+bool TinyLFUCacheShard::Ref(Cache::Handle* h) {
+  LRUHandle* e = reinterpret_cast<LRUHandle*>(h);
+  MutexLock l(&mutex_);
+  // To create another reference - entry must be already externally referenced
+  assert(e->HasRefs());
+  e->Ref();
+  return true;
+}
+
+bool TinyLFUCacheShard::Release(Cache::Handle* handle, bool force_erase) {
+  if (handle == nullptr) {
+    return false;
+  }
+  LRUHandle* e = reinterpret_cast<LRUHandle*>(handle);
+  bool last_reference = false;
+  {
+    MutexLock l(&mutex_);
+    last_reference = e->Unref();
+    if (last_reference && e->InCache()) {
+      // The item is still in cache, and nobody else holds a reference to it
+      if (usage_ > capacity_ || force_erase) {
+        // The LRU lists must be empty since the cache is full
+        assert(lru_usage_ == 0 || force_erase);
+        // Take this opportunity and remove the item
+        table_.Remove(e->key(), e->hash);
+        e->SetInCache(false);
+        num_entries_--;
+      } else {
+        // Put the item back on its LRU list, and don't free it
+        List_Insert(e);
+        last_reference = false;
+      }
+    }
+    if (last_reference) {
+      usage_ -= e->charge;
+    }
+  }
+
+  // Free the entry here outside of mutex for performance reasons
+  if (last_reference) {
+    e->Free();
+  }
+  return last_reference;
+}
+
+Status TinyLFUCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
+                                 size_t charge,
+                                 void (*deleter)(const Slice& key, void* value),
+                                 Cache::Handle** handle,
+                                 Cache::Priority priority) {
+  // Allocate the memory here outside of the mutex
+  // If the cache is full, we'll have to release it
+  // It shouldn't happen very often though.
+  LRUHandle* e = reinterpret_cast<LRUHandle*>(
+      new char[sizeof(LRUHandle) - 1 + key.size()]);
+  Status s = Status::OK();
+  autovector<LRUHandle*> last_reference_list;
+
+  e->value = value;
+  e->deleter = deleter;
+  e->charge = charge;
+  e->key_length = key.size();
+  e->flags = 0;
+  e->hash = hash;
+  e->refs = 0;
+  e->next = e->prev = nullptr;
+  e->SetInCache(true);
+  e->SetPriority(priority);
+  // High priority entries skip the window and the admission test.
+  e->SetInWindow(priority != Cache::Priority::HIGH);
+  memcpy(e->key_data, key.data(), key.size());
+
+  {
+    MutexLock l(&mutex_);
+    sketch_.Increment(hash);
+
+    EvictFromCache(charge, e->InWindow() ? charge : 0, &last_reference_list);
+
+    if ((usage_ + charge) > capacity_ &&
+        (strict_capacity_limit_ || handle == nullptr)) {
+      if (handle == nullptr) {
+        // Don't insert the entry but still return ok, as if the entry inserted
+        // into cache and get evicted immediately.
+        e->SetInCache(false);
+        last_reference_list.push_back(e);
+      } else {
+        delete[] reinterpret_cast<char*>(e);
+        *handle = nullptr;
+        s = Status::Incomplete("Insert failed due to LRU cache being full.");
+      }
+    } else {
+      // Insert into the cache. Note that the cache might get larger than its
+      // capacity if not enough space was freed up.
+      LRUHandle* old = table_.Insert(e);
+      usage_ += e->charge;
+      if (old != nullptr) {
+        assert(old->InCache());
+        old->SetInCache(false);
+        if (!old->HasRefs()) {
+          // old is on a LRU list because it's in cache and its reference
+          // count is 0
+          List_Remove(old);
+          usage_ -= old->charge;
+          last_reference_list.push_back(old);
+        }
+      } else {
+        num_entries_++;
+        sketch_.EnsureCapacity(num_entries_);
+      }
+      if (handle == nullptr) {
+        List_Insert(e);
+      } else {
+        e->Ref();
+        *handle = reinterpret_cast<Cache::Handle*>(e);
+      }
+    }
+  }
+
+  // Free the entries here outside of mutex for performance reasons
+  for (auto entry : last_reference_list) {
+    entry->Free();
+  }
+
+  return s;
+}
+
+void TinyLFUCacheShard::Erase(const Slice& key, uint32_t hash) {
+  LRUHandle* e;
+  bool last_reference = false;
+  {
+    MutexLock l(&mutex_);
+    e = table_.Remove(key, hash);
+    if (e != nullptr) {
+      assert(e->InCache());
+      e->SetInCache(false);
+      num_entries_--;
+      if (!e->HasRefs()) {
+        // The entry is in a LRU list since it's in hash and has no external
+        // references
+        List_Remove(e);
+        usage_ -= e->charge;
+        last_reference = true;
+      }
+    }
+  }
+
+  // Free the entry here outside of mutex for performance reasons
+  // last_reference will only be true if e != nullptr
+  if (last_reference) {
+    e->Free();
+  }
+}
+
+size_t TinyLFUCacheShard::GetUsage() const {
+  MutexLock l(&mutex_);
+  return usage_;
+}
+
+size_t TinyLFUCacheShard::GetPinnedUsage() const {
+  MutexLock l(&mutex_);
+  assert(usage_ >= lru_usage_);
+  return usage_ - lru_usage_;
+}
+
+std::string TinyLFUCacheShard::GetPrintableOptions() const {
+  const int kBufferSize = 200;
+  char buffer[kBufferSize];
+  {
+    MutexLock l(&mutex_);
+    snprintf(buffer, kBufferSize,
+             "    window_ratio: %.3lf\n    protected_ratio: %.3lf\n",
+             window_ratio_, protected_ratio_);
+  }
+  return std::string(buffer);
+}
+
+TinyLFUCache::TinyLFUCache(size_t capacity, int num_shard_bits,
+                           bool strict_capacity_limit, double window_ratio,
+                           double protected_ratio,
+                           std::shared_ptr<MemoryAllocator> allocator,
+                           bool use_adaptive_mutex)
+    : ShardedCache(capacity, num_shard_bits, strict_capacity_limit,
+                   std::move(allocator)) {
+  num_shards_ = 1 << num_shard_bits;
+  shards_ = reinterpret_cast<TinyLFUCacheShard*>(
+      port::cacheline_aligned_alloc(sizeof(TinyLFUCacheShard) * num_shards_));
+  size_t per_shard = (capacity + (num_shards_ - 1)) / num_shards_;
+  for (int i = 0; i < num_shards_; i++) {
+    new (&shards_[i])
+        TinyLFUCacheShard(per_shard, strict_capacity_limit, window_ratio,
+                          protected_ratio, use_adaptive_mutex);
+  }
+}
+
+TinyLFUCache::~TinyLFUCache() {
+  if (shards_ != nullptr) {
+    assert(num_shards_ > 0);
+    for (int i = 0; i < num_shards_; i++) {
+      shards_[i].~TinyLFUCacheShard();
+    }
+    port::cacheline_aligned_free(shards_);
+  }
+}
+
+CacheShard* TinyLFUCache::GetShard(int shard) {
+  return reinterpret_cast<CacheShard*>(&shards_[shard]);
+}
+
+const CacheShard* TinyLFUCache::GetShard(int shard) const {
+  return reinterpret_cast<CacheShard*>(&shards_[shard]);
+}
+
+void* TinyLFUCache::Value(Handle* handle) {
+  return reinterpret_cast<const LRUHandle*>(handle)->value;
+}
+
+size_t TinyLFUCache::GetCharge(Handle* handle) const {
+  return reinterpret_cast<const LRUHandle*>(handle)->charge;
+}
+
+uint32_t TinyLFUCache::GetHash(Handle* handle) const {
+  return reinterpret_cast<const LRUHandle*>(handle)->hash;
+}
+
+void TinyLFUCache::DisownData() {
+// Do not drop data if compile with ASAN to suppress leak warning.
+#if defined(__clang__)
+#if !defined(__has_feature) || !__has_feature(address_sanitizer)
+  shards_ = nullptr;
+  num_shards_ = 0;
+#endif
+#else  // __clang__
+#ifndef __SANITIZE_ADDRESS__
+  shards_ = nullptr;
+  num_shards_ = 0;
+#endif  // !__SANITIZE_ADDRESS__
+#endif  // __clang__
+}
+
+std::shared_ptr<Cache> NewTinyLFUCache(const TinyLFUCacheOptions& cache_opts) {
+  if (cache_opts.num_shard_bits >= 20) {
+    return nullptr;  // the cache cannot be sharded into too many fine pieces
+  }
+  if (cache_opts.window_ratio < 0.0 || cache_opts.window_ratio > 1.0 ||
+      cache_opts.protected_ratio < 0.0 || cache_opts.protected_ratio > 1.0) {
+    // invalid ratios
+    return nullptr;
+  }
+  int num_shard_bits = cache_opts.num_shard_bits;
+  if (num_shard_bits < 0) {
+    num_shard_bits = GetDefaultCacheShardBits(cache_opts.capacity);
+  }
+  return std::make_shared<TinyLFUCache>(
+      cache_opts.capacity, num_shard_bits, cache_opts.strict_capacity_limit,
+      cache_opts.window_ratio, cache_opts.protected_ratio,
+      cache_opts.memory_allocator, cache_opts.use_adaptive_mutex);
+}
+
+std::shared_ptr<Cache> NewTinyLFUCache(size_t capacity, int num_shard_bits,
+                                       bool strict_capacity_limit) {
+  TinyLFUCacheOptions cache_opts;
+  cache_opts.capacity = capacity;
+  cache_opts.num_shard_bits = num_shard_bits;
+  cache_opts.strict_capacity_limit = strict_capacity_limit;
+  return NewTinyLFUCache(cache_opts);
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,212 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "cache/lru_cache.h"
+#include "cache/sharded_cache.h"
+
+#include "port/port.h"
+#include "util/autovector.h"
+
+namespace rocksdb {
+
+// Count-min sketch estimating how often each key hash has been seen
+// recently. Every hash maps to four 4-bit counters, one per row; the
+// estimate is the smallest of them. Once the number of increments reaches
+// ten times the number of entries the sketch is sized for, all counters are
+// halved so that old popularity fades away.
+class FrequencySketch {
+ public:
+  FrequencySketch();
+
+  // Resize the sketch for `num_entries` distinct entries, forgetting every
+  // recorded frequency if it has to grow.
+  void EnsureCapacity(size_t num_entries);
+
+  void Increment(uint32_t hash);
+
+  // Estimated number of times the hash was seen recently, at most 15.
+  uint32_t Frequency(uint32_t hash) const;
+
+ private:
+  static const size_t kMinWords = 8;
+
+  // Index of the word holding the counter of the hash in the i-th row, and
+  // the offset of the counter in the word.
+  void Locate(uint32_t hash, int i, size_t* word, int* shift) const;
+
+  void Reset();
+
+  std::unique_ptr<uint64_t[]> table_;
+  // Number of words minus one, the number of words is a power of two.
+  size_t mask_;
+  size_t sample_size_;
+  size_t additions_;
+};
+
+// A single shard of TinyLFUCache, following the W-TinyLFU policy:
+//
+//   * New entries go through a small LRU admission window, which lets
+//     bursts of fresh entries get their first hits.
+//   * The rest of the capacity is a segmented LRU: entries enter its
+//     probation segment, and move to its protected segment when they get a
+//     hit there. The protected segment overflows back to probation.
+//   * When the cache is full, the entry leaving the window is only admitted
+//     into probation if the sketch rates it more frequent than the probation
+//     entry it would evict. A one-off scan thus churns through the window
+//     without flushing the entries that are read over and over.
+//
+// High priority entries skip the window and the admission test, and enter
+// the protected segment directly.
+//
+// The entries use the LRUHandle of LRUCache: IN_HIGH_PRI_POOL marks the
+// entries of the protected segment and IN_WINDOW those of the window. As in
+// LRUCacheShard, only the entries without external references are in the
+// LRU lists, and everything is guarded by mutex_.
+class ALIGN_AS(CACHE_LINE_SIZE) TinyLFUCacheShard final : public CacheShard {
+ public:
+  TinyLFUCacheShard(size_t capacity, bool strict_capacity_limit,
+                    double window_ratio, double protected_ratio,
+                    bool use_adaptive_mutex);
+  virtual ~TinyLFUCacheShard() override = default;
+
+  virtual void SetCapacity(size_t capacity) override;
+  virtual void SetStrictCapacityLimit(bool strict_capacity_limit) override;
+
+  // Like Cache methods, but with an extra "hash" parameter.
+  virtual Status Insert(const Slice& key, uint32_t hash, void* value,
+                        size_t charge,
+                        void (*deleter)(const Slice& key, void* value),
+                        Cache::Handle** handle,
+                        Cache::Priority priority) override;
+  virtual Cache::Handle* Lookup(const Slice& key, uint32_t hash) override;
+  virtual bool Ref(Cache::Handle* handle) override;
+  virtual bool Release(Cache::Handle* handle,
+                       bool force_erase = false) override;
+  virtual void Erase(const Slice& key, uint32_t hash) override;
+
+  virtual size_t GetUsage() const override;
+  virtual size_t GetPinnedUsage() const override;
+
+  virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                                      bool thread_safe) override;
+
+  virtual void EraseUnRefEntries() override;
+
+  virtual std::string GetPrintableOptions() const override;
+
+  // Memory size of the unreferenced entries of the window and the protected
+  // segment, for unit tests.
+  size_t TEST_GetWindowUsage();
+  size_t TEST_GetProtectedUsage();
+
+ private:
+  void List_Remove(LRUHandle* e);
+  // Append the entry to the list of its segment, promoting it to the
+  // protected segment if it was hit in probation.
+  void List_Insert(LRUHandle* e);
+  void List_Append(LRUHandle* list, LRUHandle* e);
+
+  // Demote the oldest protected entries until the segment fits its capacity.
+  void MaintainProtectedSize();
+
+  // Move the oldest window entries to probation while the window is over
+  // its capacity and the main segments have room for them. Once the cache
+  // is full, they are admitted or evicted by EvictFromCache() instead.
+  void MaintainWindowSize();
+
+  // Remove the entry from the cache and queue it in `deleted`.
+  void Evict(LRUHandle* e, autovector<LRUHandle*>* deleted);
+
+  // Free some space until enough space to hold (usage_ + charge) is freed or
+  // there is no unreferenced entry left. While the window cannot take
+  // `window_charge` more, its oldest entry runs the admission test against
+  // the oldest probation entry, and the loser is evicted.
+  // This function is not thread safe - it needs to be executed while
+  // holding the mutex_
+  void EvictFromCache(size_t charge, size_t window_charge,
+                      autovector<LRUHandle*>* deleted);
+
+  void UpdateSegmentCapacities();
+
+  // Initialized before use.
+  size_t capacity_;
+
+  // Whether to reject insertion if cache reaches its full capacity.
+  bool strict_capacity_limit_;
+
+  // Ratio of capacity taken by the window, and ratio of the rest taken by
+  // the protected segment.
+  double window_ratio_;
+  double protected_ratio_;
+
+  size_t window_capacity_;
+  size_t protected_capacity_;
+
+  // Dummy heads of the LRU lists of the segments.
+  // list.prev is newest entry, list.next is oldest entry.
+  LRUHandle window_;
+  LRUHandle probation_;
+  LRUHandle protected_;
+
+  // ------------^^^^^^^^^^^^^-----------
+  // Not frequently modified data members
+  // ------------------------------------
+  //
+  // We separate data members that are updated frequently from the ones that
+  // are not frequently updated so that they don't share the same cache line
+  // which will lead into false cache sharing
+  //
+  // ------------------------------------
+  // Frequently modified data members
+  // ------------vvvvvvvvvvvvv-----------
+  LRUHandleTable table_;
+
+  FrequencySketch sketch_;
+
+  // Number of entries in table_.
+  size_t num_entries_;
+
+  // Memory size for entries residing in the cache
+  size_t usage_;
+
+  // Memory size for entries residing only in the LRU lists, in total and in
+  // each of the window and the protected segment.
+  size_t lru_usage_;
+  size_t window_usage_;
+  size_t protected_usage_;
+
+  // mutex_ protects the following state.
+  mutable port::Mutex mutex_;
+};
+
+class TinyLFUCache
+#ifdef NDEBUG
+    final
+#endif
+    : public ShardedCache {
+ public:
+  TinyLFUCache(size_t capacity, int num_shard_bits, bool strict_capacity_limit,
+               double window_ratio, double protected_ratio,
+               std::shared_ptr<MemoryAllocator> memory_allocator = nullptr,
+               bool use_adaptive_mutex = kDefaultToAdaptiveMutex);
+  virtual ~TinyLFUCache();
+  virtual const char* Name() const override { return "TinyLFUCache"; }
+  virtual CacheShard* GetShard(int shard) override;
+  virtual const CacheShard* GetShard(int shard) const override;
+  virtual void* Value(Handle* handle) override;
+  virtual size_t GetCharge(Handle* handle) const override;
+  virtual uint32_t GetHash(Handle* handle) const override;
+  virtual void DisownData() override;
+
+ private:
+  TinyLFUCacheShard* shards_ = nullptr;
+  int num_shards_ = 0;
+};
+
+}  // namespace rocksdb
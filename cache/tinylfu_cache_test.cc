@@ -0,0 +1,185 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "cache/tinylfu_cache.h"
+
+#include <string>
+#include <vector>
+#include "port/port.h"
+#include "test_util/testharness.h"
+#include "util/hash.h"
+
+namespace rocksdb {
+
+class TinyLFUCacheTest : public testing::Test {
+ public:
+  TinyLFUCacheTest() {}
+  ~TinyLFUCacheTest() override { DeleteCache(); }
+
+  void DeleteCache() {
+    if (cache_ != nullptr) {
+      cache_->~TinyLFUCacheShard();
+      port::cacheline_aligned_free(cache_);
+      cache_ = nullptr;
+    }
+  }
+
+  void NewCache(size_t capacity, double window_ratio = 0.01,
+                double protected_ratio = 0.8) {
+    DeleteCache();
+    cache_ = reinterpret_cast<TinyLFUCacheShard*>(
+        port::cacheline_aligned_alloc(sizeof(TinyLFUCacheShard)));
+    new (cache_) TinyLFUCacheShard(capacity, false /*strict_capcity_limit*/,
+                                   window_ratio, protected_ratio,
+                                   kDefaultToAdaptiveMutex);
+  }
+
+  static uint32_t Hash(const std::string& key) {
+    return static_cast<uint32_t>(GetSliceNPHash64(key));
+  }
+
+  void Insert(const std::string& key,
+              Cache::Priority priority = Cache::Priority::LOW) {
+    cache_->Insert(key, Hash(key), nullptr /*value*/, 1 /*charge*/,
+                   nullptr /*deleter*/, nullptr /*handle*/, priority);
+  }
+
+  bool Lookup(const std::string& key) {
+    auto handle = cache_->Lookup(key, Hash(key));
+    if (handle) {
+      cache_->Release(handle);
+      return true;
+    }
+    return false;
+  }
+
+  // Read the key the way a table reader does: insert it on a miss.
+  void Read(const std::string& key) {
+    if (!Lookup(key)) {
+      Insert(key);
+    }
+  }
+
+  static std::string Key(const std::string& prefix, int i) {
+    return prefix + std::to_string(i);
+  }
+
+  TinyLFUCacheShard* cache() { return cache_; }
+
+ private:
+  TinyLFUCacheShard* cache_ = nullptr;
+};
+
+TEST_F(TinyLFUCacheTest, FrequencySketch) {
+  FrequencySketch sketch;
+  sketch.EnsureCapacity(64);
+  const uint32_t hot = Hash("hot");
+  const uint32_t cold = Hash("cold");
+  for (int i = 0; i < 5; i++) {
+    sketch.Increment(hot);
+  }
+  sketch.Increment(cold);
+  ASSERT_GE(sketch.Frequency(hot), 5);
+  ASSERT_GE(sketch.Frequency(cold), 1);
+  ASSERT_LT(sketch.Frequency(cold), sketch.Frequency(hot));
+
+  // Counters saturate.
+  for (int i = 0; i < 20; i++) {
+    sketch.Increment(hot);
+  }
+  ASSERT_EQ(15, sketch.Frequency(hot));
+
+  // Past the sample size, old frequencies fade.
+  for (int i = 0; i < 10 * 64; i++) {
+    sketch.Increment(Hash(Key("other", i)));
+  }
+  ASSERT_LT(sketch.Frequency(hot), 15);
+}
+
+TEST_F(TinyLFUCacheTest, BasicSegments) {
+  NewCache(100);
+  Insert("a");
+  Insert("b");
+  // The newest entry stays in the window, older ones move to probation.
+  ASSERT_EQ(1, cache()->TEST_GetWindowUsage());
+  ASSERT_EQ(0, cache()->TEST_GetProtectedUsage());
+
+  // A hit in probation promotes to protected.
+  ASSERT_TRUE(Lookup("a"));
+  ASSERT_EQ(1, cache()->TEST_GetProtectedUsage());
+
+  // High priority entries go straight to protected.
+  Insert("c", Cache::Priority::HIGH);
+  ASSERT_EQ(2, cache()->TEST_GetProtectedUsage());
+  ASSERT_EQ(3, cache()->GetUsage());
+  ASSERT_EQ(0, cache()->GetPinnedUsage());
+
+  cache()->Erase("a", Hash("a"));
+  ASSERT_FALSE(Lookup("a"));
+  ASSERT_EQ(1, cache()->TEST_GetProtectedUsage());
+  cache()->EraseUnRefEntries();
+  ASSERT_EQ(0, cache()->GetUsage());
+}
+
+TEST_F(TinyLFUCacheTest, ScanResistance) {
+  NewCache(100);
+  const int kNumHot = 50;
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < kNumHot; i++) {
+      Read(Key("hot", i));
+    }
+    // Push the last hot entry out of the window so that it gets hit too.
+    Read(Key("warmup", round));
+  }
+  ASSERT_EQ(kNumHot, cache()->TEST_GetProtectedUsage());
+
+  // A scan reads far more blocks than the cache holds, each of them once.
+  for (int i = 0; i < 1000; i++) {
+    Read(Key("scan", i));
+  }
+  for (int i = 0; i < kNumHot; i++) {
+    ASSERT_TRUE(Lookup(Key("hot", i))) << i;
+  }
+  ASSERT_LE(cache()->GetUsage(), 100);
+
+  // An entry read often enough is still admitted during the scan.
+  for (int i = 0; i < 5; i++) {
+    ASSERT_FALSE(Lookup("new"));
+  }
+  Insert("new");
+  for (int i = 1000; i < 1010; i++) {
+    Read(Key("scan", i));
+  }
+  ASSERT_TRUE(Lookup("new"));
+}
+
+TEST_F(TinyLFUCacheTest, PinnedEntries) {
+  NewCache(10);
+  std::vector<Cache::Handle*> handles;
+  for (int i = 0; i < 10; i++) {
+    std::string key = Key("pinned", i);
+    Cache::Handle* handle = nullptr;
+    ASSERT_OK(cache()->Insert(key, Hash(key), nullptr, 1, nullptr, &handle,
+                              Cache::Priority::LOW));
+    handles.push_back(handle);
+  }
+  ASSERT_EQ(10, cache()->GetPinnedUsage());
+
+  // Nothing can be evicted, the cache goes over its capacity.
+  Insert("overflow");
+  ASSERT_FALSE(Lookup("overflow"));
+  for (auto handle : handles) {
+    cache()->Release(handle);
+  }
+  ASSERT_EQ(0, cache()->GetPinnedUsage());
+  ASSERT_LE(cache()->GetUsage(), 10);
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,21 @@
+# - Find liburing
+# Find the liburing library and includes
+#
+# uring_INCLUDE_DIR - where to find liburing.h, etc.
+# uring_LIBRARIES - List of libraries when using liburing.
+# uring_FOUND - True if liburing found.
+
+find_path(uring_INCLUDE_DIR
+  NAMES liburing.h
+  HINTS ${uring_ROOT_DIR}/include)
+
+find_library(uring_LIBRARIES
+  NAMES uring
+  HINTS ${uring_ROOT_DIR}/lib)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(uring DEFAULT_MSG uring_LIBRARIES uring_INCLUDE_DIR)
+
+mark_as_advanced(
+  uring_LIBRARIES
+  uring_INCLUDE_DIR)
@@ -284,6 +284,132 @@ TEST_F(DBBlockCacheTest, TestWithCompressedBlockCache) {
 }
 #endif  // SNAPPY
 
+TEST_F(DBBlockCacheTest, CompressedBlockCacheOfUncompressedFile) {
+  CompressionType compression = kNoCompression;
+  for (CompressionType type : GetSupportedCompressions()) {
+    if (type != kNoCompression) {
+      compression = type;
+      break;
+    }
+  }
+  if (compression == kNoCompression) {
+    return;
+  }
+  auto table_options = GetTableOptions();
+  auto options = GetOptions(table_options);
+  options.compression = kNoCompression;
+  InitTable(options);
+
+  std::shared_ptr<Cache> cache = NewLRUCache(1 << 25, 0, false);
+  std::shared_ptr<Cache> compressed_cache = NewLRUCache(1 << 25, 0, false);
+  table_options.block_cache = cache;
+  table_options.block_cache_compressed = compressed_cache;
+  table_options.block_cache_compressed_compression = compression;
+  options.table_factory.reset(new BlockBasedTableFactory(table_options));
+  Reopen(options);
+  RecordCacheCounters(options);
+
+  // Blocks read from the file only go to the block cache.
+  const std::string value(kValueSize, 'a');
+  for (size_t i = 0; i < kNumBlocks; i++) {
+    ASSERT_EQ(value, Get(ToString(i)));
+    CheckCacheCounters(options, 1, 0, 1, 0);
+    CheckCompressedCacheCounters(options, 1, 0, 0, 0);
+  }
+  ASSERT_EQ(0, compressed_cache->GetUsage());
+
+  // Blocks evicted from the block cache are demoted, compressed, to the
+  // compressed block cache.
+  const size_t usage = cache->GetUsage();
+  cache->EraseUnRefEntries();
+  ASSERT_GT(compressed_cache->GetUsage(), 0);
+  ASSERT_LT(compressed_cache->GetUsage(), usage);
+
+  // They are promoted back from it instead of being read again.
+  for (size_t i = 0; i < kNumBlocks; i++) {
+    ASSERT_EQ(value, Get(ToString(i)));
+    CheckCacheCounters(options, 1, 0, 1, 0);
+    CheckCompressedCacheCounters(options, 0, 1, 0, 0);
+  }
+  ASSERT_EQ(0, compressed_cache->GetUsage());
+
+  // Blocks of closed tables are not demoted.
+  Close();
+  cache->EraseUnRefEntries();
+  ASSERT_EQ(0, compressed_cache->GetUsage());
+}
+
+TEST_F(DBBlockCacheTest, PartitionedCacheByBlockType) {
+  auto cache = NewPartitionedCache(1 << 25, 0);
+  BlockBasedTableOptions table_options;
+  table_options.cache_index_and_filter_blocks = true;
+  table_options.filter_policy.reset(NewBloomFilterPolicy(10, false));
+  table_options.block_cache = cache->GetPartition("default/data");
+  table_options.index_block_cache = cache->GetPartition("default/index");
+  table_options.filter_block_cache = cache->GetPartition("default/filter");
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.table_factory.reset(new BlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  ASSERT_OK(Put("key", "value"));
+  ASSERT_OK(Flush());
+  ASSERT_EQ("value", Get("key"));
+
+  std::map<std::string, CachePartitionStats> stats;
+  cache->GetAllPartitionStats(&stats);
+  ASSERT_EQ(3, stats.size());
+  ASSERT_LT(0, stats["default/data"].usage);
+  ASSERT_LT(0, stats["default/data"].misses);
+}
+
+TEST_F(DBBlockCacheTest, PartitionedCacheIndexAndFilterBlocks) {
+  // Sharded for the whole capacity, the partitions grow from nothing.
+  auto cache = NewPartitionedCache(1 << 25);
+  BlockBasedTableOptions table_options;
+  // The partitions of partitioned index and filters are always read through
+  // the block cache.
+  table_options.index_type = BlockBasedTableOptions::kTwoLevelIndexSearch;
+  table_options.partition_filters = true;
+  table_options.use_pdt = false;
+  table_options.metadata_block_size = 128;
+  table_options.filter_policy.reset(NewLexPdtFilterPolicy());
+  table_options.block_cache = cache->GetPartition("default/data");
+  table_options.index_block_cache = cache->GetPartition("default/index");
+  table_options.filter_block_cache = cache->GetPartition("default/filter");
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.statistics = rocksdb::CreateDBStatistics();
+  options.table_factory.reset(new BlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(Put(Key(i), "value"));
+  }
+  ASSERT_OK(Flush());
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < 100; i++) {
+      ASSERT_EQ("value", Get(Key(i)));
+    }
+    ASSERT_EQ("NOT_FOUND", Get(Key(1000)));
+  }
+
+  // Each kind of block is cached in its own partition, and found there again.
+  std::map<std::string, CachePartitionStats> stats;
+  cache->GetAllPartitionStats(&stats);
+  ASSERT_EQ(3, stats.size());
+  for (const auto& entry : stats) {
+    ASSERT_LT(0, entry.second.usage) << entry.first;
+    ASSERT_LT(0, entry.second.hits) << entry.first;
+  }
+  ASSERT_EQ(stats["default/index"].hits,
+            TestGetTickerCount(options, BLOCK_CACHE_INDEX_HIT));
+  ASSERT_EQ(stats["default/filter"].hits,
+            TestGetTickerCount(options, BLOCK_CACHE_FILTER_HIT));
+  ASSERT_EQ(stats["default/data"].hits,
+            TestGetTickerCount(options, BLOCK_CACHE_DATA_HIT));
+}
+
 #ifndef ROCKSDB_LITE
 
 // Make sure that when options.block_cache is set, after a new table is
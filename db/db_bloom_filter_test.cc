@@ -635,6 +635,166 @@ TEST_F(DBBloomFilterTest, BloomFilterReverseCompatibility) {
   }
 }
 
+TEST_F(DBBloomFilterTest, FilterPolicySelector) {
+  Options options = CurrentOptions();
+  options.statistics = rocksdb::CreateDBStatistics();
+  BlockBasedTableOptions table_options;
+  // Exact pdt filters on L0, block based bloom filters below.
+  table_options.filter_policy_selector.reset(NewLevelFilterPolicySelector(
+      std::shared_ptr<const FilterPolicy>(NewOtLexPdtFilterPolicy()),
+      std::shared_ptr<const FilterPolicy>(NewBloomFilterPolicy(10, true)),
+      1 /* num_upper_levels */));
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  // Two overlapping files, so that compacting them is not a trivial move.
+  const int maxKey = 1000;
+  for (int i = 0; i < maxKey; i += 4) {
+    ASSERT_OK(Put(Key(i), Key(i)));
+  }
+  Flush();
+  for (int i = 2; i < maxKey; i += 4) {
+    ASSERT_OK(Put(Key(i), Key(i)));
+  }
+  Flush();
+
+  auto check_filter_policy = [&](const std::string& expected_name) {
+    TablePropertiesCollection props;
+    ASSERT_OK(db_->GetPropertiesOfAllTables(&props));
+    for (const auto& item : props) {
+      ASSERT_EQ(expected_name, item.second->filter_policy_name);
+    }
+  };
+  auto check_reads = [&]() {
+    for (int i = 0; i < maxKey; i += 2) {
+      ASSERT_EQ(Key(i), Get(Key(i)));
+    }
+    const uint64_t useful = TestGetTickerCount(options, BLOOM_FILTER_USEFUL);
+    for (int i = 1; i < maxKey; i += 2) {
+      ASSERT_EQ("NOT_FOUND", Get(Key(i)));
+    }
+    ASSERT_GT(TestGetTickerCount(options, BLOOM_FILTER_USEFUL), useful);
+  };
+
+  ASSERT_EQ(2, NumTableFilesAtLevel(0));
+  check_filter_policy("rocksdb.OtLexPdtFilter");
+  check_reads();
+
+  CompactRangeOptions cro;
+  cro.bottommost_level_compaction = BottommostLevelCompaction::kForce;
+  ASSERT_OK(db_->CompactRange(cro, nullptr, nullptr));
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+  ASSERT_EQ(1, NumTableFilesAtLevel(1));
+  check_filter_policy("rocksdb.BuiltinBloomFilter");
+  check_reads();
+
+  // Readers find the filter without the selector when filter_policy names it.
+  table_options.filter_policy_selector.reset();
+  table_options.filter_policy.reset(NewBloomFilterPolicy(10, true));
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  Reopen(options);
+  check_reads();
+}
+
+TEST_F(DBBloomFilterTest, FilterPolicySelectorNames) {
+  std::shared_ptr<const FilterPolicy> lex_pdt(NewLexPdtFilterPolicy());
+  std::shared_ptr<const FilterPolicy> centroid_pdt(
+      NewCentriodPdtFilterPolicy());
+  ASSERT_STRNE(lex_pdt->Name(), centroid_pdt->Name());
+  std::unique_ptr<FilterPolicySelector> selector(
+      NewLevelFilterPolicySelector(lex_pdt, centroid_pdt, 1));
+  ASSERT_NE(nullptr, selector);
+  selector.reset(NewLevelFilterPolicySelector(lex_pdt, lex_pdt, 1));
+  ASSERT_NE(nullptr, selector);
+  // The filters of the two policies would be looked up under the same name.
+  selector.reset(NewLevelFilterPolicySelector(
+      std::shared_ptr<const FilterPolicy>(NewBloomFilterPolicy(10, true)),
+      std::shared_ptr<const FilterPolicy>(NewBloomFilterPolicy(20, true)),
+      1));
+  ASSERT_EQ(nullptr, selector);
+}
+
+namespace {
+// The lexicographic pdt policy under "rocksdb.PdtFilter", the name both pdt
+// policies wrote their filters under before they were told apart.
+class OldNamePdtFilterPolicy : public FilterPolicy {
+ public:
+  OldNamePdtFilterPolicy() : policy_(NewLexPdtFilterPolicy()) {}
+
+  const char* Name() const override { return "rocksdb.PdtFilter"; }
+
+  void CreateFilter(const Slice* keys, int n, std::string* dst) const override {
+    policy_->CreateFilter(keys, n, dst);
+  }
+
+  bool KeyMayMatch(const Slice& key, const Slice& filter) const override {
+    return policy_->KeyMayMatch(key, filter);
+  }
+
+  FilterBitsBuilder* GetFilterBitsBuilder() const override {
+    return policy_->GetFilterBitsBuilder();
+  }
+
+  FilterBitsReader* GetFilterBitsReader(const Slice& contents) const override {
+    return policy_->GetFilterBitsReader(contents);
+  }
+
+ private:
+  std::unique_ptr<const FilterPolicy> policy_;
+};
+}  // namespace
+
+TEST_F(DBBloomFilterTest, PdtFilterOldPolicyName) {
+  Options options = CurrentOptions();
+  options.statistics = rocksdb::CreateDBStatistics();
+  BlockBasedTableOptions table_options;
+  table_options.filter_policy.reset(new OldNamePdtFilterPolicy());
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  // Two overlapping files, so that compacting them is not a trivial move.
+  const int maxKey = 1000;
+  for (int i = 0; i < maxKey; i += 4) {
+    ASSERT_OK(Put(Key(i), Key(i)));
+  }
+  Flush();
+  for (int i = 2; i < maxKey; i += 4) {
+    ASSERT_OK(Put(Key(i), Key(i)));
+  }
+  Flush();
+
+  auto check_reads = [&]() {
+    for (int i = 0; i < maxKey; i += 2) {
+      ASSERT_EQ(Key(i), Get(Key(i)));
+    }
+    for (int i = 1; i < maxKey; i += 2) {
+      ASSERT_EQ("NOT_FOUND", Get(Key(i)));
+    }
+  };
+
+  // The filters of the old tables are not found under the new name, reads
+  // still return the right results without them.
+  table_options.filter_policy.reset(NewLexPdtFilterPolicy());
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  Reopen(options);
+  ASSERT_EQ(2, NumTableFilesAtLevel(0));
+  check_reads();
+  ASSERT_EQ(0, TestGetTickerCount(options, BLOOM_FILTER_USEFUL));
+
+  // Compaction rewrites the tables with the filter under the new name.
+  CompactRangeOptions cro;
+  cro.bottommost_level_compaction = BottommostLevelCompaction::kForce;
+  ASSERT_OK(db_->CompactRange(cro, nullptr, nullptr));
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+  TablePropertiesCollection props;
+  ASSERT_OK(db_->GetPropertiesOfAllTables(&props));
+  for (const auto& item : props) {
+    ASSERT_EQ("rocksdb.LexPdtFilter", item.second->filter_policy_name);
+  }
+  check_reads();
+  ASSERT_GT(TestGetTickerCount(options, BLOOM_FILTER_USEFUL), 0);
+}
+
 namespace {
 // A wrapped bloom over default FilterPolicy
 class WrappedBloom : public FilterPolicy {
@@ -724,6 +884,47 @@ class SliceTransformLimitedDomain : public SliceTransform {
   }
 };
 
+TEST_F(DBBloomFilterTest, SeekSkipsTablesByRangeFilter) {
+  for (bool lex_pdt : {true, false}) {
+    Options options = CurrentOptions();
+    options.disable_auto_compactions = true;
+    options.statistics = CreateDBStatistics();
+    BlockBasedTableOptions table_options;
+    table_options.filter_policy.reset(lex_pdt ? NewLexPdtFilterPolicy()
+                                              : NewBloomFilterPolicy(10));
+    options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+    DestroyAndReopen(options);
+
+    ASSERT_OK(Put("a1", "v"));
+    ASSERT_OK(Put("a5", "v"));
+    ASSERT_OK(Flush());
+    ASSERT_OK(Put("c1", "v"));
+    ASSERT_OK(Put("c5", "v"));
+    ASSERT_OK(Flush());
+
+    Slice upper_bound("a4");
+    ReadOptions read_options;
+    read_options.iterate_upper_bound = &upper_bound;
+    std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+    const uint64_t data_reads =
+        TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS) +
+        TestGetTickerCount(options, BLOCK_CACHE_DATA_HIT);
+    iter->Seek("a2");
+    ASSERT_FALSE(iter->Valid());
+    ASSERT_OK(iter->status());
+    const uint64_t new_data_reads =
+        TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS) +
+        TestGetTickerCount(options, BLOCK_CACHE_DATA_HIT);
+    if (lex_pdt) {
+      // No key of either table is in [a2, a4), no data block is read.
+      ASSERT_EQ(new_data_reads, data_reads);
+    } else {
+      // A bloom filter can't tell, the first table is searched.
+      ASSERT_GT(new_data_reads, data_reads);
+    }
+  }
+}
+
 TEST_F(DBBloomFilterTest, PrefixExtractorFullFilter) {
   BlockBasedTableOptions bbto;
   // Full Filter Block
@@ -1778,8 +1778,8 @@ class MockPersistentCache : public PersistentCache {
     return PersistentCache::StatsType();
   }
 
-  Status Insert(const Slice& page_key, const char* data,
-                const size_t size) override {
+  Status Insert(const Slice& page_key, const char* data, const size_t size,
+                bool /*is_meta_block*/) override {
     MutexLock _(&lock_);
 
     if (size_ > max_size_) {
@@ -3025,6 +3025,100 @@ TEST_F(DBTest2, TraceAndReplay) {
   ASSERT_OK(DestroyDB(dbname2, options));
 }
 
+TEST_F(DBTest2, TraceAndMultiThreadReplay) {
+  Options options = CurrentOptions();
+  options.merge_operator = MergeOperators::CreatePutOperator();
+  ReadOptions ro;
+  WriteOptions wo;
+  TraceOptions trace_opts;
+  EnvOptions env_opts;
+  CreateAndReopenWithCF({"pikachu"}, options);
+
+  std::string trace_filename = dbname_ + "/rocksdb.trace";
+  std::unique_ptr<TraceWriter> trace_writer;
+  ASSERT_OK(NewFileTraceWriter(env_, env_opts, trace_filename, &trace_writer));
+  ASSERT_OK(db_->StartTrace(trace_opts, std::move(trace_writer)));
+
+  // Overwrite the same keys, alone and in batches spanning the keys of
+  // several replay threads, so that the result depends on the order of the
+  // writes of each key.
+  for (int round = 0; round < 20; round++) {
+    std::string value = ToString(round);
+    WriteBatch batch;
+    for (int i = round % 3; i < 30; i += 3) {
+      ASSERT_OK(batch.Put("key" + ToString(i), value));
+    }
+    ASSERT_OK(batch.Merge("merged", value));
+    ASSERT_OK(db_->Write(wo, &batch));
+    ASSERT_OK(Put(0, "key" + ToString(round), value + "single"));
+    ASSERT_OK(Put(1, "key" + ToString(round), value));
+    Get(0, "key" + ToString(round));
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ro));
+    iter->Seek("key");
+  }
+  ASSERT_OK(db_->DeleteRange(wo, dbfull()->DefaultColumnFamily(), "key28",
+                             "key29"));
+  ASSERT_OK(Put(0, "key29", "last"));
+  ASSERT_OK(db_->EndTrace());
+
+  std::string dbname2 = test::TmpDir(env_) + "/db_multi_thread_replay";
+  ASSERT_OK(DestroyDB(dbname2, options));
+  DB* db2_init = nullptr;
+  options.create_if_missing = true;
+  ASSERT_OK(DB::Open(options, dbname2, &db2_init));
+  ColumnFamilyHandle* cf;
+  ASSERT_OK(
+      db2_init->CreateColumnFamily(ColumnFamilyOptions(), "pikachu", &cf));
+  delete cf;
+  delete db2_init;
+
+  DB* db2 = nullptr;
+  std::vector<ColumnFamilyDescriptor> column_families;
+  ColumnFamilyOptions cf_options;
+  cf_options.merge_operator = MergeOperators::CreatePutOperator();
+  column_families.push_back(ColumnFamilyDescriptor("default", cf_options));
+  column_families.push_back(
+      ColumnFamilyDescriptor("pikachu", ColumnFamilyOptions()));
+  std::vector<ColumnFamilyHandle*> handles;
+  ASSERT_OK(
+      DB::Open(CurrentOptions(), dbname2, column_families, &handles, &db2));
+
+  std::unique_ptr<TraceReader> trace_reader;
+  ASSERT_OK(NewFileTraceReader(env_, env_opts, trace_filename, &trace_reader));
+  Replayer replayer(db2, handles, std::move(trace_reader));
+  ASSERT_TRUE(replayer.MultiThreadReplay(0).IsInvalidArgument());
+  ASSERT_OK(replayer.MultiThreadReplay(4));
+
+  std::string value;
+  for (int i = 0; i < 30; i++) {
+    std::string key = "key" + ToString(i);
+    for (int cf_index = 0; cf_index < 2; cf_index++) {
+      std::string expected = Get(cf_index, key);
+      Status s = db2->Get(ro, handles[cf_index], key, &value);
+      if (expected == "NOT_FOUND") {
+        ASSERT_TRUE(s.IsNotFound());
+      } else {
+        ASSERT_OK(s);
+        ASSERT_EQ(expected, value);
+      }
+    }
+  }
+  ASSERT_OK(db2->Get(ro, handles[0], "merged", &value));
+  ASSERT_EQ("19", value);
+  ASSERT_TRUE(db2->Get(ro, handles[0], "key28", &value).IsNotFound());
+
+  ASSERT_EQ(20 + 40 + 2,
+            replayer.GetLatencyHistogram(kTraceWrite).num());
+  ASSERT_EQ(20, replayer.GetLatencyHistogram(kTraceGet).num());
+  ASSERT_EQ(20, replayer.GetLatencyHistogram(kTraceIteratorSeek).num());
+
+  for (auto handle : handles) {
+    delete handle;
+  }
+  delete db2;
+  ASSERT_OK(DestroyDB(dbname2, options));
+}
+
 TEST_F(DBTest2, TraceWithLimit) {
   Options options = CurrentOptions();
   options.merge_operator = MergeOperators::CreatePutOperator();
@@ -1158,6 +1158,60 @@ TEST_P(EnvPosixTestWithParam, MultiRead) {
   }
 }
 
+TEST_P(EnvPosixTestWithParam, MultiReadBatch) {
+  EnvOptions soptions;
+  std::string fname = test::PerThreadDBPath(env_, "testfile");
+
+  const size_t kSectorSize = 4096;
+  const size_t kNumSectors = 64;
+  // More requests than a single io_uring submission takes.
+  const size_t kNumReqs = 300;
+
+  {
+    std::unique_ptr<WritableFile> wfile;
+    ASSERT_OK(env_->NewWritableFile(fname, &wfile, soptions));
+    for (size_t i = 0; i < kNumSectors; ++i) {
+      ASSERT_OK(wfile->Append(std::string(kSectorSize, static_cast<char>(i))));
+    }
+    // Dirty pages cannot be dropped from the page cache.
+    ASSERT_OK(wfile->Fsync());
+    ASSERT_OK(wfile->Close());
+  }
+
+  std::unique_ptr<RandomAccessFile> file;
+  ASSERT_OK(env_->NewRandomAccessFile(fname, &file, soptions));
+  Random rnd(301);
+  // Once with the file in the page cache, once after dropping it.
+  for (int iter = 0; iter < 2; ++iter) {
+    if (iter == 1) {
+      ASSERT_OK(file->InvalidateCache(0, 0));
+    }
+    std::vector<ReadRequest> reqs(kNumReqs);
+    std::vector<std::string> bufs(kNumReqs);
+    for (size_t i = 0; i < kNumReqs; ++i) {
+      reqs[i].offset = rnd.Uniform(kNumSectors) * kSectorSize;
+      reqs[i].len = kSectorSize;
+      bufs[i].resize(kSectorSize);
+      reqs[i].scratch = &bufs[i][0];
+    }
+    // A read across the end of the file, and one beyond it.
+    reqs[0].offset = (kNumSectors - 1) * kSectorSize;
+    reqs[0].len = 2 * kSectorSize;
+    bufs[0].resize(2 * kSectorSize);
+    reqs[0].scratch = &bufs[0][0];
+    reqs[1].offset = kNumSectors * kSectorSize;
+
+    ASSERT_OK(file->MultiRead(reqs.data(), reqs.size()));
+    for (size_t i = 0; i < kNumReqs; ++i) {
+      ASSERT_OK(reqs[i].status);
+      size_t expected_len = i == 1 ? 0 : kSectorSize;
+      ASSERT_EQ(expected_len, reqs[i].result.size());
+      char c = static_cast<char>(reqs[i].offset / kSectorSize);
+      ASSERT_EQ(std::string(expected_len, c), reqs[i].result.ToString());
+    }
+  }
+}
+
 // Only works in linux platforms
 #ifdef OS_WIN
 TEST_P(EnvPosixTestWithParam, DISABLED_InvalidateCache) {
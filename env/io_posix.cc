@@ -12,6 +12,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <algorithm>
+#include <vector>
 #if defined(OS_LINUX)
 #include <linux/fs.h>
 #include <linux/falloc.h>
@@ -27,19 +28,30 @@
 #include <sys/statfs.h>
 #include <sys/syscall.h>
 #include <sys/sysmacros.h>
+#include <sys/uio.h>
 #endif
 #include "monitoring/iostats_context_imp.h"
 #include "port/port.h"
 #include "rocksdb/slice.h"
 #include "test_util/sync_point.h"
 #include "util/coding.h"
+#include "util/mutexlock.h"
 #include "util/string_util.h"
+#include "util/thread_local.h"
+#include "util/threadpool_imp.h"
 
 #if defined(OS_LINUX) && !defined(F_SET_RW_HINT)
 #define F_LINUX_SPECIFIC_BASE 1024
 #define F_SET_RW_HINT (F_LINUX_SPECIFIC_BASE + 12)
 #endif
 
+// preadv2() came with glibc 2.26.
+#if defined(OS_LINUX) && defined(RWF_NOWAIT) && defined(__GLIBC_PREREQ)
+#if __GLIBC_PREREQ(2, 26)
+#define ROCKSDB_PREADV2_NOWAIT
+#endif
+#endif
+
 namespace rocksdb {
 
 // A wrapper for fadvise, if the platform doesn't support fadvise,
@@ -458,6 +470,229 @@ Status PosixRandomAccessFile::Read(uint64_t offset, size_t n, Slice* result,
   return s;
 }
 
+namespace {
+
+#if defined(ROCKSDB_IOURING_PRESENT)
+void DeleteIOUring(void* p) {
+  struct io_uring* iu = static_cast<struct io_uring*>(p);
+  io_uring_queue_exit(iu);
+  delete iu;
+}
+
+// Set once the kernel refused to create a ring, in which case MultiRead()
+// does not try again.
+std::atomic<bool> io_uring_unsupported(false);
+
+// Returns the io_uring of the calling thread, or nullptr if io_uring is not
+// supported by the kernel.
+struct io_uring* GetThreadIOUring(ThreadLocalPtr* thread_local_io_urings) {
+  struct io_uring* iu =
+      static_cast<struct io_uring*>(thread_local_io_urings->Get());
+  if (iu == nullptr && !io_uring_unsupported.load(std::memory_order_relaxed)) {
+    iu = new struct io_uring;
+    int ret = io_uring_queue_init(kIoUringDepth, iu, 0);
+    if (ret != 0) {
+      delete iu;
+      io_uring_unsupported.store(true, std::memory_order_relaxed);
+      return nullptr;
+    }
+    thread_local_io_urings->Reset(iu);
+  }
+  return iu;
+}
+#endif
+
+#ifdef ROCKSDB_PREADV2_NOWAIT
+// Set once preadv2() turned out not to support RWF_NOWAIT, either because of
+// the kernel or of the file system. Then all the requests go to the threads.
+std::atomic<bool> nowait_read_unsupported(false);
+#endif
+
+// Reads the request only if its data is in the page cache. Returns false if
+// the read would block, and then the request still has to be read.
+bool TryReadNoWait(int fd, ReadRequest* req) {
+#ifdef ROCKSDB_PREADV2_NOWAIT
+  if (nowait_read_unsupported.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  struct iovec iov;
+  iov.iov_base = req->scratch;
+  iov.iov_len = req->len;
+  ssize_t r;
+  do {
+    r = preadv2(fd, &iov, 1, static_cast<off_t>(req->offset), RWF_NOWAIT);
+  } while (r == -1 && errno == EINTR);
+  if (r == -1) {
+    if (errno == EOPNOTSUPP || errno == EINVAL || errno == ENOSYS) {
+      nowait_read_unsupported.store(true, std::memory_order_relaxed);
+    }
+    return false;
+  }
+  if (static_cast<size_t>(r) < req->len && r > 0) {
+    // Only part of the data is cached, read the whole request again.
+    return false;
+  }
+  // r == 0 is the end of the file.
+  req->result = Slice(req->scratch, static_cast<size_t>(r));
+  req->status = Status::OK();
+  return true;
+#else
+  (void)fd;
+  (void)req;
+  return false;
+#endif
+}
+
+// Threads shared by all the files to read the requests of MultiRead() that
+// would block. The pool is never destroyed, as files may still be read while
+// the static objects of the process are destroyed.
+ThreadPoolImpl* GetMultiReadThreadPool() {
+  static ThreadPoolImpl* thread_pool = []() {
+    ThreadPoolImpl* pool = new ThreadPoolImpl();
+    pool->SetHostEnv(Env::Default());
+    pool->SetThreadPriority(Env::Priority::USER);
+    pool->SetBackgroundThreads(kMultiReadThreads);
+    return pool;
+  }();
+  return thread_pool;
+}
+
+}  // namespace
+
+Status PosixRandomAccessFile::MultiRead(ReadRequest* reqs, size_t num_reqs) {
+  assert(reqs != nullptr);
+  if (use_direct_io() || num_reqs <= 1) {
+    return RandomAccessFile::MultiRead(reqs, num_reqs);
+  }
+
+#if defined(ROCKSDB_IOURING_PRESENT)
+  static ThreadLocalPtr thread_local_io_urings(&DeleteIOUring);
+  struct io_uring* iu = GetThreadIOUring(&thread_local_io_urings);
+  if (iu != nullptr) {
+    size_t done = 0;
+    while (done < num_reqs) {
+      size_t n = std::min(num_reqs - done, kIoUringDepth);
+      size_t num_read = MultiReadIOUring(iu, reqs + done, n);
+      done += num_read;
+      if (num_read < n) {
+        // The ring still holds the entries that were not submitted. The next
+        // MultiRead() of this thread creates another one.
+        thread_local_io_urings.Reset(nullptr);
+        DeleteIOUring(iu);
+        break;
+      }
+    }
+    for (size_t i = done; i < num_reqs; i++) {
+      reqs[i].status =
+          Read(reqs[i].offset, reqs[i].len, &reqs[i].result, reqs[i].scratch);
+    }
+    return Status::OK();
+  }
+#endif
+
+  MultiReadThreadPool(reqs, num_reqs);
+  return Status::OK();
+}
+
+#if defined(ROCKSDB_IOURING_PRESENT)
+size_t PosixRandomAccessFile::MultiReadIOUring(struct io_uring* iu,
+                                               ReadRequest* reqs,
+                                               size_t num_reqs) {
+  assert(num_reqs <= kIoUringDepth);
+  struct iovec iovs[kIoUringDepth];
+  for (size_t i = 0; i < num_reqs; i++) {
+    iovs[i].iov_base = reqs[i].scratch;
+    iovs[i].iov_len = reqs[i].len;
+    struct io_uring_sqe* sqe = io_uring_get_sqe(iu);
+    assert(sqe != nullptr);
+    io_uring_prep_readv(sqe, fd_, &iovs[i], 1,
+                        static_cast<off_t>(reqs[i].offset));
+    io_uring_sqe_set_data(sqe, &reqs[i]);
+  }
+
+  int submitted;
+  do {
+    submitted = io_uring_submit_and_wait(iu, static_cast<unsigned>(num_reqs));
+  } while (submitted == -EINTR);
+  if (submitted < 0) {
+    return 0;
+  }
+
+  // The kernel consumes the entries in order, so the first `submitted`
+  // requests are in flight. Their completions have to be reaped even when
+  // some requests were not submitted: the kernel still writes to their
+  // buffers.
+  for (int i = 0; i < submitted; i++) {
+    struct io_uring_cqe* cqe;
+    int ret;
+    do {
+      ret = io_uring_wait_cqe(iu, &cqe);
+    } while (ret == -EINTR);
+    if (ret != 0) {
+      // The completions left cannot be reaped, so neither can the ring be
+      // used again nor the buffers of the requests be given back.
+      fprintf(stderr, "io_uring_wait_cqe failed: %d\n", ret);
+      abort();
+    }
+    ReadRequest* req = static_cast<ReadRequest*>(io_uring_cqe_get_data(cqe));
+    if (cqe->res < 0) {
+      req->result = Slice(req->scratch, 0);
+      req->status = IOError("While reading offset " + ToString(req->offset) +
+                                " len " + ToString(req->len) + " with io_uring",
+                            filename_, -cqe->res);
+    } else if (static_cast<size_t>(cqe->res) < req->len && cqe->res > 0) {
+      // A short read: finish it with pread(), which also tells the end of
+      // the file apart from a partial read.
+      req->status = Read(req->offset, req->len, &req->result, req->scratch);
+    } else {
+      req->result = Slice(req->scratch, static_cast<size_t>(cqe->res));
+      req->status = Status::OK();
+    }
+    io_uring_cqe_seen(iu, cqe);
+  }
+  return static_cast<size_t>(submitted);
+}
+#endif
+
+void PosixRandomAccessFile::MultiReadThreadPool(ReadRequest* reqs,
+                                                size_t num_reqs) {
+  // The requests cached in memory are read right away, and only those that
+  // would block are handed to the threads.
+  std::vector<ReadRequest*> blocking_reqs;
+  for (size_t i = 0; i < num_reqs; i++) {
+    if (!TryReadNoWait(fd_, &reqs[i])) {
+      blocking_reqs.push_back(&reqs[i]);
+    }
+  }
+  if (blocking_reqs.empty()) {
+    return;
+  }
+
+  port::Mutex mu;
+  port::CondVar cv(&mu);
+  // The calling thread reads the last request itself.
+  const size_t num_jobs = blocking_reqs.size() - 1;
+  size_t pending = num_jobs;
+  ThreadPoolImpl* thread_pool = GetMultiReadThreadPool();
+  for (size_t i = 0; i < num_jobs; i++) {
+    ReadRequest* req = blocking_reqs[i];
+    thread_pool->SubmitJob([this, req, &mu, &cv, &pending]() {
+      req->status = Read(req->offset, req->len, &req->result, req->scratch);
+      MutexLock l(&mu);
+      if (--pending == 0) {
+        cv.Signal();
+      }
+    });
+  }
+  ReadRequest* last = blocking_reqs.back();
+  last->status = Read(last->offset, last->len, &last->result, last->scratch);
+
+  MutexLock l(&mu);
+  while (pending > 0) {
+    cv.Wait();
+  }
+}
+
 Status PosixRandomAccessFile::Prefetch(uint64_t offset, size_t n) {
   Status s;
   if (!use_direct_io()) {
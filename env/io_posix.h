@@ -13,6 +13,10 @@
 #include <string>
 #include "rocksdb/env.h"
 
+#if defined(ROCKSDB_IOURING_PRESENT)
+#include <liburing.h>
+#endif
+
 // For non linux platform, the following macros are used only as place
 // holder.
 #if !(defined OS_LINUX) && !(defined CYGWIN) && !(defined OS_AIX)
@@ -50,6 +54,14 @@ static Status IOError(const std::string& context, const std::string& file_name,
   }
 }
 
+// Maximum number of reads submitted at once by MultiRead() to the io_uring
+// of a thread.
+const size_t kIoUringDepth = 256;
+
+// Number of threads shared by all the files to read the requests of
+// MultiRead() concurrently when io_uring is not available.
+const int kMultiReadThreads = 16;
+
 class PosixHelper {
  public:
   static size_t GetUniqueIdFromFile(int fd, char* id, size_t max_size);
@@ -94,6 +106,11 @@ class PosixRandomAccessFile : public RandomAccessFile {
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const override;
 
+  // Submits all the requests at once to the io_uring of the calling thread
+  // if io_uring is available. Otherwise the requests that would block are
+  // read concurrently by a pool of threads.
+  virtual Status MultiRead(ReadRequest* reqs, size_t num_reqs) override;
+
   virtual Status Prefetch(uint64_t offset, size_t n) override;
 
 #if defined(OS_LINUX) || defined(OS_MACOSX) || defined(OS_AIX)
@@ -105,6 +122,15 @@ class PosixRandomAccessFile : public RandomAccessFile {
   virtual size_t GetRequiredBufferAlignment() const override {
     return logical_sector_size_;
   }
+
+ private:
+#if defined(ROCKSDB_IOURING_PRESENT)
+  // Returns the number of requests read, which is less than num_reqs if the
+  // io_uring could not take all of them.
+  size_t MultiReadIOUring(struct io_uring* iu, ReadRequest* reqs,
+                          size_t num_reqs);
+#endif
+  void MultiReadThreadPool(ReadRequest* reqs, size_t num_reqs);
 };
 
 class PosixWritableFile : public WritableFile {
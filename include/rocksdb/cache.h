@@ -23,6 +23,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <map>
 #include <memory>
 #include <string>
 #include "rocksdb/memory_allocator.h"
@@ -76,6 +77,22 @@ struct LRUCacheOptions {
   // -DROCKSDB_DEFAULT_TO_ADAPTIVE_MUTEX, false otherwise.
   bool use_adaptive_mutex = kDefaultToAdaptiveMutex;
 
+  // If true, entries looked up much more often than the others, such as
+  // the index and filter blocks of a hot file, are replicated on each CPU
+  // core that looks them up, so that their lookups and releases do not
+  // contend on the mutex of their shard. At most 256 keys are replicated at
+  // a time, one per hot slot picked by their hash. Replicated entries stay
+  // referenced, and so are counted in GetPinnedUsage(), until a key of the
+  // same slot gets hotter on some core and takes the slot over, or until
+  // they are written or erased.
+  bool replicate_hot_entries = false;
+
+  // If true, Cache::SetNumShardBits() changes the number of shards while the
+  // cache is in use. Each operation on the cache then also counts itself in
+  // a per-core counter, for the resharding to wait for the operations in
+  // flight. The deleters of the entries must not call into the cache.
+  bool allow_online_resharding = false;
+
   LRUCacheOptions() {}
   LRUCacheOptions(size_t _capacity, int _num_shard_bits,
                   bool _strict_capacity_limit, double _high_pri_pool_ratio,
@@ -106,14 +123,57 @@ extern std::shared_ptr<Cache> NewLRUCache(
 extern std::shared_ptr<Cache> NewLRUCache(const LRUCacheOptions& cache_opts);
 
 // Similar to NewLRUCache, but create a cache based on CLOCK algorithm with
-// better concurrent performance in some cases. See util/clock_cache.cc for
-// more detail.
+// better concurrent performance in some cases: lookups that hit do not take
+// any lock. See cache/clock_cache.cc for more detail.
 //
-// Return nullptr if it is not supported.
+// Return nullptr if it is not supported (ROCKSDB_LITE).
 extern std::shared_ptr<Cache> NewClockCache(size_t capacity,
                                             int num_shard_bits = -1,
                                             bool strict_capacity_limit = false);
 
+struct TinyLFUCacheOptions {
+  // Capacity of the cache.
+  size_t capacity = 0;
+
+  // Cache is sharded into 2^num_shard_bits shards, by hash of key. -1 means
+  // it is automatically determined, as for NewLRUCache.
+  int num_shard_bits = -1;
+
+  // If strict_capacity_limit is set,
+  // insert to the cache will fail when cache is full.
+  bool strict_capacity_limit = false;
+
+  // Percentage of cache taken by the admission window, the small LRU list
+  // that new entries go through before competing with the entries of the
+  // main segments. A larger window favors recency over frequency.
+  double window_ratio = 0.01;
+
+  // Percentage of the main segments reserved for the protected segment, the
+  // entries hit again after they were admitted.
+  double protected_ratio = 0.8;
+
+  // If non-nullptr will use this allocator instead of system allocator when
+  // allocating memory for cache blocks. See LRUCacheOptions.
+  std::shared_ptr<MemoryAllocator> memory_allocator;
+
+  // Whether to use adaptive mutexes for cache shards.
+  bool use_adaptive_mutex = kDefaultToAdaptiveMutex;
+};
+
+// Create a new cache with a fixed size capacity, evicting with the W-TinyLFU
+// policy: a segmented LRU whose entries are only replaced by new ones that a
+// frequency sketch estimates to be accessed more often. Unlike LRUCache, a
+// one-off scan of many blocks does not flush the frequently read ones. High
+// priority entries are admitted unconditionally.
+// Return nullptr if the options are invalid. See cache/tinylfu_cache.h for
+// more detail.
+extern std::shared_ptr<Cache> NewTinyLFUCache(
+    const TinyLFUCacheOptions& cache_opts);
+
+extern std::shared_ptr<Cache> NewTinyLFUCache(
+    size_t capacity, int num_shard_bits = -1,
+    bool strict_capacity_limit = false);
+
 class Cache {
  public:
   // Depending on implementation, cache entries with high priority could be less
@@ -214,6 +274,14 @@ class Cache {
   // full capacity.
   virtual bool HasStrictCapacityLimit() const = 0;
 
+  // Splits the cache into 2^num_shard_bits shards while it is in use, moving
+  // the entries to their new shards. Operations on the cache wait for the
+  // resharding to finish. Returns NotSupported if the cache cannot be
+  // resharded.
+  virtual Status SetNumShardBits(int /*num_shard_bits*/) {
+    return Status::NotSupported("Resharding is not supported");
+  }
+
   // returns the maximum configured capacity of the cache
   virtual size_t GetCapacity() const = 0;
 
@@ -260,4 +328,70 @@ class Cache {
   std::shared_ptr<MemoryAllocator> memory_allocator_;
 };
 
+struct CachePartitionOptions {
+  // Capacity guaranteed to the partition. While the partition does not use
+  // it, other partitions may borrow it, but they give it back as soon as the
+  // partition needs it.
+  size_t reserved_capacity = 0;
+
+  // Maximum capacity of the partition, including what it borrows from the
+  // other partitions. 0 means the capacity of the whole cache.
+  size_t capacity_limit = 0;
+
+  // Percentage of the partition reserved for high priority entries, as for
+  // LRUCacheOptions::high_pri_pool_ratio.
+  double high_pri_pool_ratio = 0.0;
+};
+
+struct CachePartitionStats {
+  // Number of lookups that found, or did not find, their entry.
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+
+  // Memory size of the entries of the partition, and capacity the partition
+  // holds at the moment.
+  size_t usage = 0;
+  size_t capacity = 0;
+};
+
+// A cache split into named partitions that share its capacity, so that a
+// workload filling one partition cannot evict the entries of the others
+// beyond their reserved capacity. Typically there is one partition per
+// column family and block type, set as BlockBasedTableOptions::block_cache,
+// index_block_cache and filter_block_cache of the column family.
+//
+// Each partition is an LRU cache of its own. A partition grows into the
+// capacity that no partition uses, up to its limit; a partition below its
+// reserved capacity takes back what the others borrowed by evicting their
+// least recently used entries.
+class PartitionedCache {
+ public:
+  virtual ~PartitionedCache() {}
+
+  // Return the partition named `name`, creating it with `opts` if it does not
+  // exist yet. Return nullptr if the reserved capacity of all the partitions
+  // would exceed the capacity of the cache.
+  virtual std::shared_ptr<Cache> GetPartition(
+      const std::string& name,
+      const CachePartitionOptions& opts = CachePartitionOptions()) = 0;
+
+  // Return false if there is no partition named `name`.
+  virtual bool GetPartitionStats(const std::string& name,
+                                 CachePartitionStats* stats) const = 0;
+
+  // Stats of every partition, by name.
+  virtual void GetAllPartitionStats(
+      std::map<std::string, CachePartitionStats>* stats) const = 0;
+
+  // Capacity shared by all the partitions.
+  virtual size_t GetCapacity() const = 0;
+};
+
+// Create a PartitionedCache with a fixed size capacity. num_shard_bits and
+// strict_capacity_limit apply to each partition, as for NewLRUCache.
+extern std::shared_ptr<PartitionedCache> NewPartitionedCache(
+    size_t capacity, int num_shard_bits = -1,
+    bool strict_capacity_limit = false,
+    std::shared_ptr<MemoryAllocator> memory_allocator = nullptr);
+
 }  // namespace rocksdb
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <memory>
 #include <stdexcept>
@@ -77,6 +78,22 @@ class FilterBitsReader {
       may_match[i] = MayMatch(*keys[i]);
     }
   }
+
+  // Check if any entry in [lo, hi) may be in the filter, entries ordered
+  // bytewise. Only filters keeping the order of their entries can answer it.
+  virtual bool RangeMayMatch(const Slice& /*lo*/, const Slice& /*hi*/) {
+    return true;
+  }
+
+  // Check if any entry starting with `prefix` may be in the filter. Only
+  // filters keeping whole entries can answer it for prefixes of any length.
+  virtual bool PrefixMayMatch(const Slice& /*prefix*/) { return true; }
+
+  // Memory taken by the reader, not counting the filter contents it reads.
+  // The reader is cached with its filter and charged to the block cache
+  // along with it, so readers building auxiliary structures should count
+  // them here.
+  virtual size_t ApproximateMemoryUsage() const { return sizeof(*this); }
 };
 
 // We add a new format of filter block called full filter block
@@ -130,6 +147,23 @@ class FilterPolicy {
       const Slice& /*contents*/) const {
     return nullptr;
   }
+
+  // Whether the FilterBitsReaders of this policy answer RangeMayMatch().
+  // Range queries skip the filters of other policies rather than read them
+  // for nothing.
+  virtual bool SupportsRangeMayMatch() const { return false; }
+
+  // Get a reader of a filter appended by CreateFilter(), which is ONLY used
+  // for block based filter block. The readers of a filter block are built
+  // once when the block is loaded and cached along with it, instead of
+  // KeyMayMatch() decoding the filter on every call. Return nullptr (the
+  // default) to be probed with KeyMayMatch(). Policies whose CreateFilter()
+  // lays a filter out like the full filter of GetFilterBitsBuilder() can
+  // return their FilterBitsReader.
+  // The input slice should NOT be deleted by FilterPolicy
+  virtual FilterBitsReader* DecodeFilter(const Slice& /*filter*/) const {
+    return nullptr;
+  }
 };
 
 // Return a new filter policy that uses a bloom filter with approximately
@@ -158,4 +192,56 @@ extern const FilterPolicy* NewLexPdtFilterPolicy(bool use_block_based_builer = f
 
 extern const FilterPolicy* NewCentriodPdtFilterPolicy(bool use_block_based_builder = false);
 
+// Lexicographic pdt whose labels are Re-Pair compressed, smaller than
+// NewLexPdtFilterPolicy() on keys sharing long substrings at the cost of a
+// slower build. The filter is probed in place, without being decoded.
+extern const FilterPolicy* NewOtLexPdtFilterPolicy(bool use_block_based_builder = false);
+
+// What the filter policy of a new table file is selected from.
+struct FilterPolicySelectionContext {
+  // Level the file is built for, -1 if unknown. Flushes build level 0 files.
+  int level;
+  // Size the builder cuts the file at, 0 if unknown (e.g. for flushes).
+  uint64_t target_file_size;
+};
+
+// Picks the filter policy of each table file from the level and size it is
+// built for, so that filter memory and probe cost can follow how often each
+// level is probed. The filter of a file is stored under the name of the
+// policy it was built with; readers look it up under the name of every
+// policy in Policies().
+class FilterPolicySelector {
+ public:
+  virtual ~FilterPolicySelector() {}
+
+  // Return the name of this selector.
+  virtual const char* Name() const = 0;
+
+  // Return the policy to build the filter of a file with, nullptr to build
+  // no filter. The policy must be one of Policies().
+  virtual std::shared_ptr<const FilterPolicy> Select(
+      const FilterPolicySelectionContext& context) const = 0;
+
+  // Return every policy Select() may return. Their names must be distinct.
+  virtual std::vector<std::shared_ptr<const FilterPolicy>> Policies()
+      const = 0;
+};
+
+// Return a new selector building the filters of files of levels below
+// num_upper_levels, and of files whose target size is known and at most
+// max_upper_file_size, with upper_policy, and the other filters with
+// lower_policy. Files of an unknown level get upper_policy. Return nullptr
+// if two distinct policies have the same name, since readers could not tell
+// their filters apart.
+//
+// For example, exact pdt filters on L0-L2 and bloom filters below:
+//   NewLevelFilterPolicySelector(
+//       std::shared_ptr<const FilterPolicy>(NewOtLexPdtFilterPolicy()),
+//       std::shared_ptr<const FilterPolicy>(NewBloomFilterPolicy(10, true)),
+//       3 /* num_upper_levels */);
+extern FilterPolicySelector* NewLevelFilterPolicySelector(
+    std::shared_ptr<const FilterPolicy> upper_policy,
+    std::shared_ptr<const FilterPolicy> lower_policy, int num_upper_levels,
+    uint64_t max_upper_file_size = 0);
+
 }  // namespace rocksdb
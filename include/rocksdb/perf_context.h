@@ -187,6 +187,12 @@ struct PerfContext {
   uint64_t bloom_sst_hit_count;
   // total number of SST table bloom misses
   uint64_t bloom_sst_miss_count;
+  // total number of keys probed in SST table PDT filters
+  uint64_t pdt_filter_probe_count;
+  // total number of bytes of SST table PDT filter blocks read from files
+  uint64_t pdt_filter_bytes_loaded;
+  // total CPU time spent probing SST table PDT filters
+  uint64_t pdt_filter_probe_cpu_nanos;
 
   // Time spent waiting on key locks in transaction lock manager.
   uint64_t key_lock_wait_time;
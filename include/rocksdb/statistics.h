@@ -338,6 +338,15 @@ enum Tickers : uint32_t {
   BLOCK_CACHE_COMPRESSION_DICT_ADD,
   BLOCK_CACHE_COMPRESSION_DICT_BYTES_INSERT,
   BLOCK_CACHE_COMPRESSION_DICT_BYTES_EVICT,
+
+  // # of keys probed in PDT filters. A batched (MultiGet) probe counts
+  // every key of the batch.
+  PDT_FILTER_PROBES,
+  // # of bytes of PDT filter blocks read from files.
+  PDT_FILTER_BYTES_LOADED,
+  // CPU time spent probing PDT filters, in nanoseconds. Only recorded when
+  // the stats level is above kExceptDetailedTimers.
+  PDT_FILTER_PROBE_CPU_NANOS,
   TICKER_ENUM_MAX
 };
 
@@ -31,6 +31,7 @@
 namespace rocksdb {
 
 // -- Block-based Table
+class FilterPolicySelector;
 class FlushBlockPolicyFactory;
 class PersistentCache;
 class RandomAccessFile;
@@ -119,6 +120,13 @@ struct BlockBasedTableOptions {
     // slice, and you need to call Valid()/status() afterwards.
     // TODO(kolmike): Fix it.
     kBinarySearchWithFirstKey = 0x03,
+
+    // The separators are kept in a path-decomposed trie and the block
+    // handles in an Elias-Fano sequence, so the index is several times
+    // smaller than kBinarySearch for long keys sharing prefixes, and an index
+    // seek is a trie walk.
+    // Only works with BytewiseComparator.
+    kPdtSearch = 0x04,
   };
 
   IndexType index_type = kBinarySearch;
@@ -153,6 +161,18 @@ struct BlockBasedTableOptions {
   // If NULL, rocksdb will automatically create and use an 8MB internal cache.
   std::shared_ptr<Cache> block_cache = nullptr;
 
+  // If non-NULL, the index and filter blocks cached because of
+  // cache_index_and_filter_blocks go to these caches instead of block_cache,
+  // e.g. to partitions of a PartitionedCache so that they are not evicted by
+  // the data blocks of other column families. They are ignored if there is
+  // no block_cache.
+  // Note: the cache keys of a table are only unique among the tables whose
+  // block_cache hands out the same ids (Cache::NewId()). Either share these
+  // caches only between tables with the same block_cache, or use partitions
+  // of a single PartitionedCache everywhere.
+  std::shared_ptr<Cache> index_block_cache = nullptr;
+  std::shared_ptr<Cache> filter_block_cache = nullptr;
+
   // If non-NULL use the specified cache for pages read from device
   // IF NULL, no page cache is used
   std::shared_ptr<PersistentCache> persistent_cache = nullptr;
@@ -163,6 +183,19 @@ struct BlockBasedTableOptions {
   //       same type of object there.
   std::shared_ptr<Cache> block_cache_compressed = nullptr;
 
+  // Compression applied to the data blocks that are stored uncompressed in
+  // the file before they are inserted into block_cache_compressed. With the
+  // default kNoCompression, only the blocks compressed in the file are kept
+  // in block_cache_compressed. Otherwise block_cache_compressed also serves
+  // as an in-memory compressed tier under block_cache for the blocks of
+  // files written without compression: such a block is demoted, compressed,
+  // into block_cache_compressed when it is evicted from block_cache, and
+  // promoted back into block_cache, leaving block_cache_compressed, when it
+  // is found there. Blocks that do not compress by at least 12.5% and blocks
+  // of files with a compression dictionary are not demoted, and neither are
+  // the blocks of tables that were closed in the meantime.
+  CompressionType block_cache_compressed_compression = kNoCompression;
+
   // Approximate size of user data packed per block.  Note that the
   // block size specified here corresponds to uncompressed data.  The
   // actual size of the unit read from disk may be smaller if
@@ -214,12 +247,28 @@ struct BlockBasedTableOptions {
   // NewBloomFilterPolicy() here.
   std::shared_ptr<const FilterPolicy> filter_policy = nullptr;
 
+  // If non-nullptr, the filter of each new file is built with the policy the
+  // selector picks for the file's level and target size, rather than with
+  // filter_policy. Readers find the filter of a file built with any of the
+  // selector's policies, as well as of one built with filter_policy.
+  std::shared_ptr<const FilterPolicySelector> filter_policy_selector = nullptr;
 
   //xp
   // If true, use ot lex pdt as the filter rather than FullFilter
   bool use_pdt = true;
 //  bool use_pdt = false;
 
+  // If true, every table gets a key locator meta block: a monotone minimal
+  // perfect hash over the user keys mapping a key to its data block in a few
+  // bits per key. A point lookup that passed the filter then reads the
+  // located block without searching the index. Tables where the versions
+  // of a user key span data blocks are written without the locator.
+  // The memory of the locator is charged to block_cache, if any.
+  // Only works with BytewiseComparator and without user timestamps.
+  //
+  // Default: false
+  bool key_locator = false;
+
   // If true, place whole keys in the filter (not just prefixes).
   // This must generally be true for gets to be efficient.
   bool whole_key_filtering = true;
@@ -489,6 +538,35 @@ struct CuckooTableOptions {
 extern TableFactory* NewCuckooTableFactory(
     const CuckooTableOptions& table_options = CuckooTableOptions());
 
+struct PdtTablePropertyNames {
+  // Offset and size of the lexicographic path-decomposed trie holding every
+  // user key of the file once.
+  static const std::string kTrieOffset;
+  static const std::string kTrieSize;
+  // Offset of the entry offsets sampled every kSampleInterval entries.
+  static const std::string kSamplesOffset;
+  static const std::string kSampleInterval;
+};
+
+struct PdtTableOptions {
+  // The offset of every sample_interval-th entry is stored. Reaching the
+  // value of a key decodes at most sample_interval - 1 entries before it, a
+  // larger interval makes the file smaller and point lookups slower.
+  uint32_t sample_interval = 16;
+};
+
+// PDT Table Factory for read-only SST files whose user keys are stored once
+// in a succinct trie, and whose values are addressed by the rank of their key
+// in the trie. The file is served from mmap, no block cache is involved.
+//
+// Some assumptions:
+// - The comparator is bytewise.
+// - A user key appears once in a file, so snapshots are not supported.
+// - Does not support Merge operations.
+// - allow_mmap_reads is set.
+extern TableFactory* NewPdtTableFactory(
+    const PdtTableOptions& table_options = PdtTableOptions());
+
 #endif  // ROCKSDB_LITE
 
 class RandomAccessFileReader;
@@ -92,6 +92,9 @@ PerfContext::PerfContext(const PerfContext& other) {
   bloom_memtable_miss_count = other.bloom_memtable_miss_count;
   bloom_sst_hit_count = other.bloom_sst_hit_count;
   bloom_sst_miss_count = other.bloom_sst_miss_count;
+  pdt_filter_probe_count = other.pdt_filter_probe_count;
+  pdt_filter_bytes_loaded = other.pdt_filter_bytes_loaded;
+  pdt_filter_probe_cpu_nanos = other.pdt_filter_probe_cpu_nanos;
   key_lock_wait_time = other.key_lock_wait_time;
   key_lock_wait_count = other.key_lock_wait_count;
 
@@ -187,6 +190,9 @@ PerfContext::PerfContext(PerfContext&& other) noexcept {
   bloom_memtable_miss_count = other.bloom_memtable_miss_count;
   bloom_sst_hit_count = other.bloom_sst_hit_count;
   bloom_sst_miss_count = other.bloom_sst_miss_count;
+  pdt_filter_probe_count = other.pdt_filter_probe_count;
+  pdt_filter_bytes_loaded = other.pdt_filter_bytes_loaded;
+  pdt_filter_probe_cpu_nanos = other.pdt_filter_probe_cpu_nanos;
   key_lock_wait_time = other.key_lock_wait_time;
   key_lock_wait_count = other.key_lock_wait_count;
 
@@ -284,6 +290,9 @@ PerfContext& PerfContext::operator=(const PerfContext& other) {
   bloom_memtable_miss_count = other.bloom_memtable_miss_count;
   bloom_sst_hit_count = other.bloom_sst_hit_count;
   bloom_sst_miss_count = other.bloom_sst_miss_count;
+  pdt_filter_probe_count = other.pdt_filter_probe_count;
+  pdt_filter_bytes_loaded = other.pdt_filter_bytes_loaded;
+  pdt_filter_probe_cpu_nanos = other.pdt_filter_probe_cpu_nanos;
   key_lock_wait_time = other.key_lock_wait_time;
   key_lock_wait_count = other.key_lock_wait_count;
 
@@ -380,6 +389,9 @@ void PerfContext::Reset() {
   bloom_memtable_miss_count = 0;
   bloom_sst_hit_count = 0;
   bloom_sst_miss_count = 0;
+  pdt_filter_probe_count = 0;
+  pdt_filter_bytes_loaded = 0;
+  pdt_filter_probe_cpu_nanos = 0;
   key_lock_wait_time = 0;
   key_lock_wait_count = 0;
 
@@ -498,6 +510,9 @@ std::string PerfContext::ToString(bool exclude_zero_counters) const {
   PERF_CONTEXT_OUTPUT(bloom_memtable_miss_count);
   PERF_CONTEXT_OUTPUT(bloom_sst_hit_count);
   PERF_CONTEXT_OUTPUT(bloom_sst_miss_count);
+  PERF_CONTEXT_OUTPUT(pdt_filter_probe_count);
+  PERF_CONTEXT_OUTPUT(pdt_filter_bytes_loaded);
+  PERF_CONTEXT_OUTPUT(pdt_filter_probe_cpu_nanos);
   PERF_CONTEXT_OUTPUT(key_lock_wait_time);
   PERF_CONTEXT_OUTPUT(key_lock_wait_count);
   PERF_CONTEXT_OUTPUT(env_new_sequential_file_nanos);
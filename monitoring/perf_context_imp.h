@@ -27,6 +27,7 @@ extern thread_local PerfContext perf_context;
 #define PERF_TIMER_MEASURE(metric)
 #define PERF_TIMER_STOP(metric)
 #define PERF_TIMER_START(metric)
+#define PERF_CPU_TIMER_GUARD_WITH_STATS(metric, env, stats, ticker_type)
 #define PERF_COUNTER_ADD(metric, value)
 
 #else
@@ -53,6 +54,14 @@ extern thread_local PerfContext perf_context;
       PerfLevel::kEnableTimeAndCPUTimeExceptForMutex); \
   perf_step_timer_##metric.Start();
 
+// Declare and set start time of the timer, the CPU time is also added to
+// the ticker if stats is not null
+#define PERF_CPU_TIMER_GUARD_WITH_STATS(metric, env, stats, ticker_type) \
+  PerfStepTimer perf_step_timer_##metric(                                \
+      &(perf_context.metric), env, true,                                 \
+      PerfLevel::kEnableTimeAndCPUTimeExceptForMutex, stats, ticker_type); \
+  perf_step_timer_##metric.Start();
+
 #define PERF_CONDITIONAL_TIMER_FOR_MUTEX_GUARD(metric, condition, stats,       \
                                                ticker_type)                    \
   PerfStepTimer perf_step_timer_##metric(&(perf_context.metric), nullptr,      \
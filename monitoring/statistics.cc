@@ -174,6 +174,9 @@ const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
      "rocksdb.block.cache.compression.dict.bytes.insert"},
     {BLOCK_CACHE_COMPRESSION_DICT_BYTES_EVICT,
      "rocksdb.block.cache.compression.dict.bytes.evict"},
+    {PDT_FILTER_PROBES, "rocksdb.pdt.filter.probes"},
+    {PDT_FILTER_BYTES_LOADED, "rocksdb.pdt.filter.bytes.loaded"},
+    {PDT_FILTER_PROBE_CPU_NANOS, "rocksdb.pdt.filter.probe.cpu.nanos"},
 };
 
 const std::vector<std::pair<Histograms, std::string>> HistogramsNameMap = {
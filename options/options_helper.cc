@@ -1684,7 +1684,8 @@ std::unordered_map<std::string, BlockBasedTableOptions::IndexType>
         {"kTwoLevelIndexSearch",
          BlockBasedTableOptions::IndexType::kTwoLevelIndexSearch},
         {"kBinarySearchWithFirstKey",
-         BlockBasedTableOptions::IndexType::kBinarySearchWithFirstKey}};
+         BlockBasedTableOptions::IndexType::kBinarySearchWithFirstKey},
+        {"kPdtSearch", BlockBasedTableOptions::IndexType::kPdtSearch}};
 
 std::unordered_map<std::string, BlockBasedTableOptions::DataBlockIndexType>
     OptionsHelper::block_base_table_data_block_index_type_string_map = {
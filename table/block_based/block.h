@@ -36,6 +36,7 @@
 namespace rocksdb {
 
 struct BlockContents;
+class BlockDemoter;
 class Comparator;
 template <class TValue>
 class BlockIter;
@@ -210,6 +211,13 @@ class Block {
 
   SequenceNumber global_seqno() const { return global_seqno_; }
 
+  // Set while the block is in the block cache of a table that demotes the
+  // blocks evicted from it to the compressed block cache.
+  void set_demoter(std::shared_ptr<const BlockDemoter> demoter) {
+    demoter_ = std::move(demoter);
+  }
+  const BlockDemoter* demoter() const { return demoter_.get(); }
+
  private:
   BlockContents contents_;
   const char* data_;         // contents_.data.data()
@@ -217,6 +225,7 @@ class Block {
   uint32_t restart_offset_;  // Offset in data_ of restart array
   uint32_t num_restarts_;
   std::unique_ptr<BlockReadAmpBitmap> read_amp_bitmap_;
+  std::shared_ptr<const BlockDemoter> demoter_;
   // All keys in the block will have seqno = global_seqno_, regardless of
   // the encoded value (kDisableGlobalSequenceNumber means disabled)
   const SequenceNumber global_seqno_;
@@ -162,8 +162,79 @@ void BlockBasedFilterBlockBuilder::GenerateFilter() {
   prev_prefix_size_ = 0;
 }
 
+ParsedBlockBasedFilterBlock::ParsedBlockBasedFilterBlock(
+    const FilterPolicy* filter_policy, BlockContents&& contents)
+    : contents_(std::move(contents)) {
+  const size_t n = contents_.data.size();
+  if (n < 5) {  // 1 byte for base_lg and 4 for start of offset array
+    return;
+  }
+
+  const uint32_t last_word = DecodeFixed32(contents_.data.data() + n - 5);
+  if (last_word > n - 5) {
+    return;
+  }
+
+  data_ = contents_.data.data();
+  offset_ = data_ + last_word;
+  num_ = (n - 5 - last_word) / 4;
+  base_lg_ = contents_.data[n - 1];
+
+  if (filter_policy == nullptr) {
+    return;
+  }
+  for (size_t index = 0; index < num_; index++) {
+    Slice filter;
+    uint32_t start = 0;
+    if (!GetFilter(index, &filter, &start) || filter.empty()) {
+      continue;
+    }
+    std::unique_ptr<FilterBitsReader> reader(
+        filter_policy->DecodeFilter(filter));
+    if (reader == nullptr) {
+      // The policy probes raw filters, there is nothing to decode.
+      filter_readers_.clear();
+      break;
+    }
+    filter_readers_.resize(num_);
+    filter_readers_[index] = std::move(reader);
+  }
+}
+
+ParsedBlockBasedFilterBlock::~ParsedBlockBasedFilterBlock() {}
+
+bool ParsedBlockBasedFilterBlock::GetFilter(size_t index, Slice* filter,
+                                            uint32_t* start) const {
+  assert(ok());
+  assert(index < num_);
+  *start = DecodeFixed32(offset_ + index * 4);
+  const uint32_t limit = DecodeFixed32(offset_ + index * 4 + 4);
+  if (*start == limit) {
+    // Empty filters do not match any entries
+    *filter = Slice();
+    return true;
+  }
+  if (*start > limit || limit > static_cast<uint32_t>(offset_ - data_)) {
+    return false;
+  }
+  *filter = Slice(data_ + *start, limit - *start);
+  return true;
+}
+
+size_t ParsedBlockBasedFilterBlock::ApproximateMemoryUsage() const {
+  size_t usage = contents_.ApproximateMemoryUsage() + sizeof(*this);
+  usage += filter_readers_.capacity() * sizeof(filter_readers_[0]);
+  for (const auto& reader : filter_readers_) {
+    if (reader != nullptr) {
+      usage += reader->ApproximateMemoryUsage();
+    }
+  }
+  return usage;
+}
+
 BlockBasedFilterBlockReader::BlockBasedFilterBlockReader(
-    const BlockBasedTable* t, CachableEntry<BlockContents>&& filter_block)
+    const BlockBasedTable* t,
+    CachableEntry<ParsedBlockBasedFilterBlock>&& filter_block)
     : FilterBlockReaderCommon(t, std::move(filter_block)) {
   assert(table());
   assert(table()->get_rep());
@@ -178,7 +249,7 @@ std::unique_ptr<FilterBlockReader> BlockBasedFilterBlockReader::Create(
   assert(table->get_rep());
   assert(!pin || prefetch);
 
-  CachableEntry<BlockContents> filter_block;
+  CachableEntry<ParsedBlockBasedFilterBlock> filter_block;
   if (prefetch || !use_cache) {
     const Status s = ReadFilterBlock(table, prefetch_buffer, ReadOptions(),
                                      use_cache, nullptr /* get_context */,
@@ -217,36 +288,10 @@ bool BlockBasedFilterBlockReader::PrefixMayMatch(
   return MayMatch(prefix, block_offset, no_io, get_context, lookup_context);
 }
 
-bool BlockBasedFilterBlockReader::ParseFieldsFromBlock(
-    const BlockContents& contents, const char** data, const char** offset,
-    size_t* num, size_t* base_lg) {
-  assert(data);
-  assert(offset);
-  assert(num);
-  assert(base_lg);
-
-  const size_t n = contents.data.size();
-  if (n < 5) {  // 1 byte for base_lg and 4 for start of offset array
-    return false;
-  }
-
-  const uint32_t last_word = DecodeFixed32(contents.data.data() + n - 5);
-  if (last_word > n - 5) {
-    return false;
-  }
-
-  *data = contents.data.data();
-  *offset = (*data) + last_word;
-  *num = (n - 5 - last_word) / 4;
-  *base_lg = contents.data[n - 1];
-
-  return true;
-}
-
 bool BlockBasedFilterBlockReader::MayMatch(
     const Slice& entry, uint64_t block_offset, bool no_io,
     GetContext* get_context, BlockCacheLookupContext* lookup_context) const {
-  CachableEntry<BlockContents> filter_block;
+  CachableEntry<ParsedBlockBasedFilterBlock> filter_block;
 
   const Status s =
       GetOrReadFilterBlock(no_io, get_context, lookup_context, &filter_block);
@@ -254,29 +299,29 @@ bool BlockBasedFilterBlockReader::MayMatch(
     return true;
   }
 
-  assert(filter_block.GetValue());
-
-  const char* data = nullptr;
-  const char* offset = nullptr;
-  size_t num = 0;
-  size_t base_lg = 0;
-  if (!ParseFieldsFromBlock(*filter_block.GetValue(), &data, &offset, &num,
-                            &base_lg)) {
+  const ParsedBlockBasedFilterBlock* const parsed = filter_block.GetValue();
+  assert(parsed);
+  if (!parsed->ok()) {
     return true;  // Errors are treated as potential matches
   }
 
-  const uint64_t index = block_offset >> base_lg;
-  if (index < num) {
-    const uint32_t start = DecodeFixed32(offset + index * 4);
-    const uint32_t limit = DecodeFixed32(offset + index * 4 + 4);
-    if (start <= limit && limit <= (uint32_t)(offset - data)) {
-      const Slice filter = Slice(data + start, limit - start);
-
-      assert(table());
-      assert(table()->get_rep());
-      const FilterPolicy* const policy = table()->get_rep()->filter_policy;
-
-      const bool may_match = policy->KeyMayMatch(entry, filter);
+  const uint64_t index = block_offset >> parsed->base_lg();
+  if (index < parsed->num_filters()) {
+    Slice filter;
+    uint32_t start = 0;
+    if (parsed->GetFilter(index, &filter, &start)) {
+      bool may_match = false;
+      if (!filter.empty()) {
+        FilterBitsReader* const reader = parsed->filter_reader(index);
+        if (reader != nullptr) {
+          may_match = reader->MayMatch(entry);
+        } else {
+          assert(table());
+          assert(table()->get_rep());
+          const FilterPolicy* const policy = table()->get_rep()->filter_policy;
+          may_match = policy->KeyMayMatch(entry, filter);
+        }
+      }
       if (may_match) {
         PERF_COUNTER_ADD(bloom_sst_hit_count, 1);
         return true;
@@ -284,9 +329,6 @@ bool BlockBasedFilterBlockReader::MayMatch(
         PERF_COUNTER_ADD(bloom_sst_miss_count, 1);
         return false;
       }
-    } else if (start == limit) {
-      // Empty filters do not match any entries
-      return false;
     }
   }
   return true;  // Errors are treated as potential matches
@@ -303,7 +345,7 @@ size_t BlockBasedFilterBlockReader::ApproximateMemoryUsage() const {
 }
 
 std::string BlockBasedFilterBlockReader::ToString() const {
-  CachableEntry<BlockContents> filter_block;
+  CachableEntry<ParsedBlockBasedFilterBlock> filter_block;
 
   const Status s =
       GetOrReadFilterBlock(false /* no_io */, nullptr /* get_context */,
@@ -312,14 +354,9 @@ std::string BlockBasedFilterBlockReader::ToString() const {
     return std::string("Unable to retrieve filter block");
   }
 
-  assert(filter_block.GetValue());
-
-  const char* data = nullptr;
-  const char* offset = nullptr;
-  size_t num = 0;
-  size_t base_lg = 0;
-  if (!ParseFieldsFromBlock(*filter_block.GetValue(), &data, &offset, &num,
-                            &base_lg)) {
+  const ParsedBlockBasedFilterBlock* const parsed = filter_block.GetValue();
+  assert(parsed);
+  if (!parsed->ok()) {
     return std::string("Error parsing filter block");
   }
 
@@ -327,16 +364,14 @@ std::string BlockBasedFilterBlockReader::ToString() const {
   result.reserve(1024);
 
   std::string s_bo("Block offset"), s_hd("Hex dump"), s_fb("# filter blocks");
-  AppendItem(&result, s_fb, rocksdb::ToString(num));
+  AppendItem(&result, s_fb, rocksdb::ToString(parsed->num_filters()));
   AppendItem(&result, s_bo, s_hd);
 
-  for (size_t index = 0; index < num; index++) {
-    uint32_t start = DecodeFixed32(offset + index * 4);
-    uint32_t limit = DecodeFixed32(offset + index * 4 + 4);
-
-    if (start != limit) {
+  for (size_t index = 0; index < parsed->num_filters(); index++) {
+    Slice filter;
+    uint32_t start = 0;
+    if (parsed->GetFilter(index, &filter, &start) && !filter.empty()) {
       result.append(" filter block # " + rocksdb::ToString(index + 1) + "\n");
-      Slice filter = Slice(data + start, limit - start);
       AppendItem(&result, start, filter.ToString(true));
     }
   }
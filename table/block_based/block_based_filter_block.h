@@ -74,13 +74,61 @@ class BlockBasedFilterBlockBuilder : public FilterBlockBuilder {
   void operator=(const BlockBasedFilterBlockBuilder&);
 };
 
+// The sharable/cachable part of the block based filter. The block is parsed
+// once, and the filter of every range of data blocks is decoded upfront when
+// the policy supports it (FilterPolicy::DecodeFilter), so that the setup
+// cost is paid once per cache residency rather than once per lookup.
+class ParsedBlockBasedFilterBlock {
+ public:
+  ParsedBlockBasedFilterBlock(const FilterPolicy* filter_policy,
+                              BlockContents&& contents);
+  ~ParsedBlockBasedFilterBlock();
+
+  // No copying allowed
+  ParsedBlockBasedFilterBlock(const ParsedBlockBasedFilterBlock&) = delete;
+  void operator=(const ParsedBlockBasedFilterBlock&) = delete;
+
+  // False if the block could not be parsed.
+  bool ok() const { return offset_ != nullptr; }
+
+  // Number of filters, the i-th one covers the data blocks starting in
+  // [i << base_lg(), (i + 1) << base_lg()).
+  size_t num_filters() const { return num_; }
+  size_t base_lg() const { return base_lg_; }
+
+  // Set `*filter` to the `index`-th filter, and return its offset in the
+  // block. Return false if the filter is out of the block.
+  // REQUIRES: ok() && index < num_filters()
+  bool GetFilter(size_t index, Slice* filter, uint32_t* start) const;
+
+  // The decoded `index`-th filter, nullptr if it is probed through the
+  // policy's KeyMayMatch().
+  FilterBitsReader* filter_reader(size_t index) const {
+    return index < filter_readers_.size() ? filter_readers_[index].get()
+                                          : nullptr;
+  }
+
+  size_t ApproximateMemoryUsage() const;
+
+  bool own_bytes() const { return contents_.own_bytes(); }
+
+ private:
+  BlockContents contents_;
+  const char* data_ = nullptr;
+  const char* offset_ = nullptr;
+  size_t num_ = 0;
+  size_t base_lg_ = 0;
+  std::vector<std::unique_ptr<FilterBitsReader>> filter_readers_;
+};
+
 // A FilterBlockReader is used to parse filter from SST table.
 // KeyMayMatch and PrefixMayMatch would trigger filter checking
 class BlockBasedFilterBlockReader
-    : public FilterBlockReaderCommon<BlockContents> {
+    : public FilterBlockReaderCommon<ParsedBlockBasedFilterBlock> {
  public:
-  BlockBasedFilterBlockReader(const BlockBasedTable* t,
-                              CachableEntry<BlockContents>&& filter_block);
+  BlockBasedFilterBlockReader(
+      const BlockBasedTable* t,
+      CachableEntry<ParsedBlockBasedFilterBlock>&& filter_block);
 
   static std::unique_ptr<FilterBlockReader> Create(
       const BlockBasedTable* table, FilePrefetchBuffer* prefetch_buffer,
@@ -105,10 +153,6 @@ class BlockBasedFilterBlockReader
   std::string ToString() const override;
 
  private:
-  static bool ParseFieldsFromBlock(const BlockContents& contents,
-                                   const char** data, const char** offset,
-                                   size_t* num, size_t* base_lg);
-
   bool MayMatch(const Slice& entry, uint64_t block_offset, bool no_io,
                 GetContext* get_context,
                 BlockCacheLookupContext* lookup_context) const;
@@ -77,9 +77,10 @@ TEST_F(FilterBlockTest, EmptyBuilder) {
   Slice slice(builder.Finish());
   ASSERT_EQ("\\x00\\x00\\x00\\x00\\x0b", EscapeString(slice));
 
-  CachableEntry<BlockContents> block(
-      new BlockContents(slice), nullptr /* cache */, nullptr /* cache_handle */,
-      true /* own_value */);
+  CachableEntry<ParsedBlockBasedFilterBlock> block(
+      new ParsedBlockBasedFilterBlock(table_options_.filter_policy.get(),
+                                      BlockContents(slice)),
+      nullptr /* cache */, nullptr /* cache_handle */, true /* own_value */);
 
   BlockBasedFilterBlockReader reader(table_.get(), std::move(block));
   ASSERT_TRUE(reader.KeyMayMatch(
@@ -106,9 +107,10 @@ TEST_F(FilterBlockTest, SingleChunk) {
   ASSERT_EQ(5, builder.NumAdded());
   Slice slice(builder.Finish());
 
-  CachableEntry<BlockContents> block(
-      new BlockContents(slice), nullptr /* cache */, nullptr /* cache_handle */,
-      true /* own_value */);
+  CachableEntry<ParsedBlockBasedFilterBlock> block(
+      new ParsedBlockBasedFilterBlock(table_options_.filter_policy.get(),
+                                      BlockContents(slice)),
+      nullptr /* cache */, nullptr /* cache_handle */, true /* own_value */);
 
   BlockBasedFilterBlockReader reader(table_.get(), std::move(block));
   ASSERT_TRUE(reader.KeyMayMatch("foo", /*prefix_extractor=*/nullptr,
@@ -168,9 +170,10 @@ TEST_F(FilterBlockTest, MultiChunk) {
 
   Slice slice(builder.Finish());
 
-  CachableEntry<BlockContents> block(
-      new BlockContents(slice), nullptr /* cache */, nullptr /* cache_handle */,
-      true /* own_value */);
+  CachableEntry<ParsedBlockBasedFilterBlock> block(
+      new ParsedBlockBasedFilterBlock(table_options_.filter_policy.get(),
+                                      BlockContents(slice)),
+      nullptr /* cache */, nullptr /* cache_handle */, true /* own_value */);
 
   BlockBasedFilterBlockReader reader(table_.get(), std::move(block));
 
@@ -284,9 +287,10 @@ TEST_F(BlockBasedFilterBlockTest, BlockBasedEmptyBuilder) {
   Slice slice(builder->Finish());
   ASSERT_EQ("\\x00\\x00\\x00\\x00\\x0b", EscapeString(slice));
 
-  CachableEntry<BlockContents> block(
-      new BlockContents(slice), nullptr /* cache */, nullptr /* cache_handle */,
-      true /* own_value */);
+  CachableEntry<ParsedBlockBasedFilterBlock> block(
+      new ParsedBlockBasedFilterBlock(table_options_.filter_policy.get(),
+                                      BlockContents(slice)),
+      nullptr /* cache */, nullptr /* cache_handle */, true /* own_value */);
 
   FilterBlockReader* reader =
       new BlockBasedFilterBlockReader(table_.get(), std::move(block));
@@ -316,9 +320,10 @@ TEST_F(BlockBasedFilterBlockTest, BlockBasedSingleChunk) {
   builder->Add("hello");
   Slice slice(builder->Finish());
 
-  CachableEntry<BlockContents> block(
-      new BlockContents(slice), nullptr /* cache */, nullptr /* cache_handle */,
-      true /* own_value */);
+  CachableEntry<ParsedBlockBasedFilterBlock> block(
+      new ParsedBlockBasedFilterBlock(table_options_.filter_policy.get(),
+                                      BlockContents(slice)),
+      nullptr /* cache */, nullptr /* cache_handle */, true /* own_value */);
 
   FilterBlockReader* reader =
       new BlockBasedFilterBlockReader(table_.get(), std::move(block));
@@ -378,9 +383,10 @@ TEST_F(BlockBasedFilterBlockTest, BlockBasedMultiChunk) {
 
   Slice slice(builder->Finish());
 
-  CachableEntry<BlockContents> block(
-      new BlockContents(slice), nullptr /* cache */, nullptr /* cache_handle */,
-      true /* own_value */);
+  CachableEntry<ParsedBlockBasedFilterBlock> block(
+      new ParsedBlockBasedFilterBlock(table_options_.filter_policy.get(),
+                                      BlockContents(slice)),
+      nullptr /* cache */, nullptr /* cache_handle */, true /* own_value */);
 
   FilterBlockReader* reader =
       new BlockBasedFilterBlockReader(table_.get(), std::move(block));
@@ -461,6 +467,67 @@ TEST_F(BlockBasedFilterBlockTest, BlockBasedMultiChunk) {
   delete reader;
 }
 
+
+TEST_F(BlockBasedFilterBlockTest, DecodedFilters) {
+  BlockBasedTableOptions table_options;
+  table_options.filter_policy.reset(NewLexPdtFilterPolicy(true));
+  BlockBasedFilterBlockBuilder builder(nullptr, table_options);
+
+  // First filter
+  builder.StartBlock(0);
+  builder.Add("foo");
+  builder.Add("bar");
+
+  // Second filter is empty
+
+  // Last filter
+  builder.StartBlock(4100);
+  builder.Add("box");
+  builder.Add("hello");
+
+  Slice slice(builder.Finish());
+
+  CachableEntry<ParsedBlockBasedFilterBlock> block(
+      new ParsedBlockBasedFilterBlock(table_options.filter_policy.get(),
+                                      BlockContents(slice)),
+      nullptr /* cache */, nullptr /* cache_handle */, true /* own_value */);
+
+  // The non-empty filters are decoded once, and charged with the block.
+  const ParsedBlockBasedFilterBlock* parsed = block.GetValue();
+  ASSERT_TRUE(parsed->ok());
+  ASSERT_EQ(3, parsed->num_filters());
+  ASSERT_NE(nullptr, parsed->filter_reader(0));
+  ASSERT_EQ(nullptr, parsed->filter_reader(1));
+  ASSERT_NE(nullptr, parsed->filter_reader(2));
+  ASSERT_GT(parsed->ApproximateMemoryUsage(),
+            parsed->filter_reader(0)->ApproximateMemoryUsage() +
+                parsed->filter_reader(2)->ApproximateMemoryUsage());
+  ASSERT_GT(parsed->filter_reader(0)->ApproximateMemoryUsage(),
+            sizeof(FilterBitsReader));
+
+  BlockBasedFilterBlockReader reader(table_.get(), std::move(block));
+  ASSERT_TRUE(reader.KeyMayMatch(
+      "foo", /*prefix_extractor=*/nullptr, /*block_offset=*/uint64_t{0},
+      /*no_io=*/false, /*const_ikey_ptr=*/nullptr, /*get_context=*/nullptr,
+      /*lookup_context=*/nullptr));
+  ASSERT_TRUE(!reader.KeyMayMatch(
+      "box", /*prefix_extractor=*/nullptr, /*block_offset=*/uint64_t{0},
+      /*no_io=*/false, /*const_ikey_ptr=*/nullptr, /*get_context=*/nullptr,
+      /*lookup_context=*/nullptr));
+  ASSERT_TRUE(!reader.KeyMayMatch(
+      "foo", /*prefix_extractor=*/nullptr, /*block_offset=*/2100,
+      /*no_io=*/false, /*const_ikey_ptr=*/nullptr, /*get_context=*/nullptr,
+      /*lookup_context=*/nullptr));
+  ASSERT_TRUE(reader.KeyMayMatch(
+      "hello", /*prefix_extractor=*/nullptr, /*block_offset=*/4100,
+      /*no_io=*/false, /*const_ikey_ptr=*/nullptr, /*get_context=*/nullptr,
+      /*lookup_context=*/nullptr));
+  ASSERT_TRUE(!reader.KeyMayMatch(
+      "bar", /*prefix_extractor=*/nullptr, /*block_offset=*/4100,
+      /*no_io=*/false, /*const_ikey_ptr=*/nullptr, /*get_context=*/nullptr,
+      /*lookup_context=*/nullptr));
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
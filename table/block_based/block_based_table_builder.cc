@@ -37,6 +37,7 @@
 #include "table/block_based/block_builder.h"
 #include "table/block_based/filter_block.h"
 #include "table/block_based/full_filter_block.h"
+#include "table/block_based/key_locator_block.h"
 #include "table/block_based/partitioned_filter_block.h"
 #include "table/format.h"
 #include "table/table_builder.h"
@@ -347,6 +348,8 @@ struct BlockBasedTableBuilder::Rep {
 
   const bool use_delta_encoding_for_index_values;
   std::unique_ptr<FilterBlockBuilder> filter_builder;
+  // Null unless BlockBasedTableOptions::key_locator.
+  std::unique_ptr<KeyLocatorBuilder> key_locator_builder;
   char compressed_cache_key_prefix[BlockBasedTable::kMaxCacheKeyPrefixSize];
   size_t compressed_cache_key_prefix_size;
 
@@ -434,6 +437,13 @@ struct BlockBasedTableBuilder::Rep {
           use_delta_encoding_for_index_values, p_index_builder_));
     }
 
+    if (table_options.key_locator &&
+        icomparator.user_comparator()->timestamp_size() == 0 &&
+        strcmp(icomparator.user_comparator()->Name(),
+               BytewiseComparator()->Name()) == 0) {
+      key_locator_builder.reset(new KeyLocatorBuilder());
+    }
+
     for (auto& collector_factories : *int_tbl_prop_collector_factories) {
       table_properties_collectors.emplace_back(
           collector_factories->CreateIntTblPropCollector(column_family_id));
@@ -466,7 +476,7 @@ BlockBasedTableBuilder::BlockBasedTableBuilder(
     const CompressionOptions& compression_opts, const bool skip_filters,
     const std::string& column_family_name, const uint64_t creation_time,
     const uint64_t oldest_key_time, const uint64_t target_file_size,
-    const uint64_t file_creation_time) {
+    const uint64_t file_creation_time, const int level) {
   BlockBasedTableOptions sanitized_table_options(table_options);
   if (sanitized_table_options.format_version == 0 &&
       sanitized_table_options.checksum != kCRC32c) {
@@ -478,6 +488,14 @@ BlockBasedTableBuilder::BlockBasedTableBuilder(
     // behavior
     sanitized_table_options.format_version = 1;
   }
+  // The filter of this file is built, and named, after the selected policy.
+  if (sanitized_table_options.filter_policy_selector != nullptr) {
+    FilterPolicySelectionContext context;
+    context.level = level;
+    context.target_file_size = target_file_size;
+    sanitized_table_options.filter_policy =
+        sanitized_table_options.filter_policy_selector->Select(context);
+  }
 
   rep_ =
       new Rep(ioptions, moptions, sanitized_table_options, internal_comparator,
@@ -535,6 +553,9 @@ void BlockBasedTableBuilder::Add(const Slice& key, const Slice& value) {
       // blocks.
       if (ok() && r->state == Rep::State::kUnbuffered) {
         r->index_builder->AddIndexEntry(&r->last_key, &key, r->pending_handle);
+        if (r->key_locator_builder != nullptr) {
+          r->key_locator_builder->AddBlock(r->pending_handle);
+        }
       }
     }
 
@@ -556,6 +577,9 @@ void BlockBasedTableBuilder::Add(const Slice& key, const Slice& value) {
       r->data_block_and_keys_buffers.back().second.emplace_back(key.ToString());
     } else {
       r->index_builder->OnKeyAdded(key);
+      if (r->key_locator_builder != nullptr) {
+        r->key_locator_builder->OnKeyAdded(key);
+      }
     }
     NotifyCollectTableCollectorsOnAdd(key, value, r->offset,
                                       r->table_properties_collectors,
@@ -1040,6 +1064,19 @@ void BlockBasedTableBuilder::WriteRangeDelBlock(
   }
 }
 
+void BlockBasedTableBuilder::WriteKeyLocatorBlock(
+    MetaIndexBuilder* meta_index_builder) {
+  if (ok() && rep_->key_locator_builder != nullptr) {
+    std::string key_locator_block;
+    if (rep_->key_locator_builder->Finish(&key_locator_block)) {
+      BlockHandle key_locator_block_handle;
+      WriteRawBlock(key_locator_block, kNoCompression,
+                    &key_locator_block_handle);
+      meta_index_builder->Add(kKeyLocatorBlock, key_locator_block_handle);
+    }
+  }
+}
+
 void BlockBasedTableBuilder::WriteFooter(BlockHandle& metaindex_block_handle,
                                          BlockHandle& index_block_handle) {
   Rep* r = rep_;
@@ -1120,6 +1157,9 @@ void BlockBasedTableBuilder::EnterUnbuffered() {
         r->filter_builder->Add(ExtractUserKey(key));
       }
       r->index_builder->OnKeyAdded(key);
+      if (r->key_locator_builder != nullptr) {
+        r->key_locator_builder->OnKeyAdded(key);
+      }
     }
     WriteBlock(Slice(data_block), &r->pending_handle, true /* is_data_block */);
     if (ok() && i + 1 < r->data_block_and_keys_buffers.size()) {
@@ -1128,6 +1168,9 @@ void BlockBasedTableBuilder::EnterUnbuffered() {
       Slice* first_key_in_next_block_ptr = &first_key_in_next_block;
       r->index_builder->AddIndexEntry(&keys.back(), first_key_in_next_block_ptr,
                                       r->pending_handle);
+      if (r->key_locator_builder != nullptr) {
+        r->key_locator_builder->AddBlock(r->pending_handle);
+      }
     }
   }
   r->data_block_and_keys_buffers.clear();
@@ -1146,6 +1189,9 @@ Status BlockBasedTableBuilder::Finish() {
   if (ok() && !empty_data_block) {
     r->index_builder->AddIndexEntry(
         &r->last_key, nullptr /* no next data block */, r->pending_handle);
+    if (r->key_locator_builder != nullptr) {
+      r->key_locator_builder->AddBlock(r->pending_handle);
+    }
   }
 
   // Write meta blocks, metaindex block and footer in the following order.
@@ -1153,15 +1199,17 @@ Status BlockBasedTableBuilder::Finish() {
   //    2. [meta block: index]
   //    3. [meta block: compression dictionary]
   //    4. [meta block: range deletion tombstone]
-  //    5. [meta block: properties]
-  //    6. [metaindex block]
-  //    7. Footer
+  //    5. [meta block: key locator]
+  //    6. [meta block: properties]
+  //    7. [metaindex block]
+  //    8. Footer
   BlockHandle metaindex_block_handle, index_block_handle;
   MetaIndexBuilder meta_index_builder;
   WriteFilterBlock(&meta_index_builder);
   WriteIndexBlock(&meta_index_builder, &index_block_handle);
   WriteCompressionDictBlock(&meta_index_builder);
   WriteRangeDelBlock(&meta_index_builder);
+  WriteKeyLocatorBlock(&meta_index_builder);
   WritePropertiesBlock(&meta_index_builder);
   if (ok()) {
     // flush the meta index block
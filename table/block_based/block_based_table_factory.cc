@@ -22,6 +22,7 @@
 #include "table/block_based/block_based_table_factory.h"
 #include "table/block_based/block_based_table_reader.h"
 #include "table/format.h"
+#include "util/compression.h"
 #include "util/mutexlock.h"
 #include "util/string_util.h"
 
@@ -228,7 +229,7 @@ TableBuilder* BlockBasedTableFactory::NewTableBuilder(
       table_builder_options.creation_time,
       table_builder_options.oldest_key_time,
       table_builder_options.target_file_size,
-      table_builder_options.file_creation_time);
+      table_builder_options.file_creation_time, table_builder_options.level);
 
   return table_builder;
 }
@@ -241,6 +242,19 @@ Status BlockBasedTableFactory::SanitizeOptions(
         "Hash index is specified for block-based "
         "table, but prefix_extractor is not given");
   }
+  if (table_options_.index_type == BlockBasedTableOptions::kPdtSearch &&
+      cf_opts.comparator != nullptr &&
+      strcmp(cf_opts.comparator->Name(), BytewiseComparator()->Name()) != 0) {
+    return Status::InvalidArgument(
+        "Pdt index is specified for block-based "
+        "table, but comparator is not bytewise");
+  }
+  if (table_options_.key_locator && cf_opts.comparator != nullptr &&
+      strcmp(cf_opts.comparator->Name(), BytewiseComparator()->Name()) != 0) {
+    return Status::InvalidArgument(
+        "Key locator is specified for block-based "
+        "table, but comparator is not bytewise");
+  }
   if (table_options_.cache_index_and_filter_blocks &&
       table_options_.no_block_cache) {
     return Status::InvalidArgument(
@@ -345,6 +359,20 @@ std::string BlockBasedTableFactory::GetPrintableTableOptions() const {
     ret.append("  block_cache_options:\n");
     ret.append(table_options_.block_cache->GetPrintableOptions());
   }
+  snprintf(buffer, kBufferSize, "  index_block_cache: %p\n",
+           static_cast<void*>(table_options_.index_block_cache.get()));
+  ret.append(buffer);
+  if (table_options_.index_block_cache) {
+    ret.append("  index_block_cache_options:\n");
+    ret.append(table_options_.index_block_cache->GetPrintableOptions());
+  }
+  snprintf(buffer, kBufferSize, "  filter_block_cache: %p\n",
+           static_cast<void*>(table_options_.filter_block_cache.get()));
+  ret.append(buffer);
+  if (table_options_.filter_block_cache) {
+    ret.append("  filter_block_cache_options:\n");
+    ret.append(table_options_.filter_block_cache->GetPrintableOptions());
+  }
   snprintf(buffer, kBufferSize, "  block_cache_compressed: %p\n",
            static_cast<void*>(table_options_.block_cache_compressed.get()));
   ret.append(buffer);
@@ -359,6 +387,11 @@ std::string BlockBasedTableFactory::GetPrintableTableOptions() const {
     ret.append("  block_cache_compressed_options:\n");
     ret.append(table_options_.block_cache_compressed->GetPrintableOptions());
   }
+  snprintf(buffer, kBufferSize, "  block_cache_compressed_compression: %s\n",
+           CompressionTypeToString(
+               table_options_.block_cache_compressed_compression)
+               .c_str());
+  ret.append(buffer);
   snprintf(buffer, kBufferSize, "  persistent_cache: %p\n",
            static_cast<void*>(table_options_.persistent_cache.get()));
   ret.append(buffer);
@@ -393,6 +426,16 @@ std::string BlockBasedTableFactory::GetPrintableTableOptions() const {
                ? "nullptr"
                : table_options_.filter_policy->Name());
   ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  filter_policy_selector: %s\n",
+           table_options_.filter_policy_selector == nullptr
+               ? "nullptr"
+               : table_options_.filter_policy_selector->Name());
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  use_pdt: %d\n", table_options_.use_pdt);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  key_locator: %d\n",
+           table_options_.key_locator);
+  ret.append(buffer);
   snprintf(buffer, kBufferSize, "  whole_key_filtering: %d\n",
            table_options_.whole_key_filtering);
   ret.append(buffer);
@@ -643,6 +686,7 @@ const std::string BlockBasedTablePropertyNames::kPrefixFiltering =
 const std::string kHashIndexPrefixesBlock = "rocksdb.hashindex.prefixes";
 const std::string kHashIndexPrefixesMetadataBlock =
     "rocksdb.hashindex.metadata";
+const std::string kKeyLocatorBlock = "rocksdb.key.locator";
 const std::string kPropTrue = "1";
 const std::string kPropFalse = "0";
 
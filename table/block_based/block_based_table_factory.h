@@ -84,6 +84,7 @@ class BlockBasedTableFactory : public TableFactory {
 
 extern const std::string kHashIndexPrefixesBlock;
 extern const std::string kHashIndexPrefixesMetadataBlock;
+extern const std::string kKeyLocatorBlock;
 extern const std::string kPropTrue;
 extern const std::string kPropFalse;
 
@@ -97,6 +98,8 @@ static std::unordered_map<std::string, OptionTypeInfo>
     block_based_table_type_info = {
         /* currently not supported
           std::shared_ptr<Cache> block_cache = nullptr;
+          std::shared_ptr<Cache> index_block_cache = nullptr;
+          std::shared_ptr<Cache> filter_block_cache = nullptr;
           std::shared_ptr<Cache> block_cache_compressed = nullptr;
          */
         {"flush_block_policy_factory",
@@ -138,6 +141,11 @@ static std::unordered_map<std::string, OptionTypeInfo>
          {offsetof(struct BlockBasedTableOptions, checksum),
           OptionType::kChecksumType, OptionVerificationType::kNormal, false,
           0}},
+        {"block_cache_compressed_compression",
+         {offsetof(struct BlockBasedTableOptions,
+                   block_cache_compressed_compression),
+          OptionType::kCompressionType, OptionVerificationType::kNormal, false,
+          0}},
         {"no_block_cache",
          {offsetof(struct BlockBasedTableOptions, no_block_cache),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
@@ -166,6 +174,12 @@ static std::unordered_map<std::string, OptionTypeInfo>
          {offsetof(struct BlockBasedTableOptions, filter_policy),
           OptionType::kFilterPolicy, OptionVerificationType::kByName, false,
           0}},
+        {"use_pdt",
+         {offsetof(struct BlockBasedTableOptions, use_pdt),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"key_locator",
+         {offsetof(struct BlockBasedTableOptions, key_locator),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
         {"whole_key_filtering",
          {offsetof(struct BlockBasedTableOptions, whole_key_filtering),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
@@ -30,11 +30,13 @@
 
 #include "table/block_based/block.h"
 #include "table/block_based/block_based_filter_block.h"
+#include "table/block_based/block_based_table_builder.h"
 #include "table/block_based/block_based_table_factory.h"
 #include "table/block_based/block_prefix_index.h"
 #include "table/block_based/filter_block.h"
 #include "table/block_based/full_filter_block.h"
 #include "table/block_based/partitioned_filter_block.h"
+#include "table/block_based/pdt_index_block.h"
 #include "table/block_fetcher.h"
 #include "table/format.h"
 #include "table/get_context.h"
@@ -50,6 +52,7 @@
 #include "util/coding.h"
 #include "util/crc32c.h"
 #include "util/file_reader_writer.h"
+#include "util/pdt.h"
 #include "util/stop_watch.h"
 #include "util/string_util.h"
 #include "util/xxhash.h"
@@ -63,6 +66,13 @@ extern const std::string kHashIndexPrefixesMetadataBlock;
 typedef BlockBasedTable::IndexReader IndexReader;
 
 BlockBasedTable::~BlockBasedTable() {
+  if (rep_->block_demoter != nullptr) {
+    rep_->block_demoter->Disable();
+  }
+  if (rep_->key_locator_cache_handle != nullptr) {
+    rep_->table_options.block_cache->Release(rep_->key_locator_cache_handle,
+                                             true /* force_erase */);
+  }
   delete rep_;
 }
 
@@ -91,6 +101,39 @@ class BlocklikeTraits<BlockContents> {
   }
 };
 
+template <>
+class BlocklikeTraits<ParsedBlockBasedFilterBlock> {
+ public:
+  static ParsedBlockBasedFilterBlock* Create(
+      BlockContents&& contents, SequenceNumber /* global_seqno */,
+      size_t /* read_amp_bytes_per_bit */, Statistics* /* statistics */,
+      bool /* using_zstd */, const FilterPolicy* filter_policy) {
+    return new ParsedBlockBasedFilterBlock(filter_policy, std::move(contents));
+  }
+
+  static uint32_t GetNumRestarts(
+      const ParsedBlockBasedFilterBlock& /* block */) {
+    return 0;
+  }
+};
+
+template <>
+class BlocklikeTraits<ParsedPdtIndexBlock> {
+ public:
+  static ParsedPdtIndexBlock* Create(BlockContents&& contents,
+                                     SequenceNumber /* global_seqno */,
+                                     size_t /* read_amp_bytes_per_bit */,
+                                     Statistics* /* statistics */,
+                                     bool /* using_zstd */,
+                                     const FilterPolicy* /* filter_policy */) {
+    return new ParsedPdtIndexBlock(std::move(contents));
+  }
+
+  static uint32_t GetNumRestarts(const ParsedPdtIndexBlock& /* block */) {
+    return 0;
+  }
+};
+
 //wp
 template <>
 class BlocklikeTraits<ParsedFullFilterBlock> {
@@ -184,6 +227,24 @@ inline MemoryAllocator* GetMemoryAllocator(
              : nullptr;
 }
 
+// Cache holding the blocks of the given type. Index and filter blocks may
+// have caches of their own, used only along with block_cache.
+inline Cache* GetBlockCache(const BlockBasedTableOptions& table_options,
+                            BlockType block_type) {
+  if (table_options.block_cache == nullptr) {
+    return nullptr;
+  }
+  if (block_type == BlockType::kIndex &&
+      table_options.index_block_cache != nullptr) {
+    return table_options.index_block_cache.get();
+  }
+  if (block_type == BlockType::kFilter &&
+      table_options.filter_block_cache != nullptr) {
+    return table_options.filter_block_cache.get();
+  }
+  return table_options.block_cache.get();
+}
+
 inline MemoryAllocator* GetMemoryAllocatorForCompressedBlock(
     const BlockBasedTableOptions& table_options) {
   return table_options.block_cache_compressed.get()
@@ -191,6 +252,40 @@ inline MemoryAllocator* GetMemoryAllocatorForCompressedBlock(
              : nullptr;
 }
 
+// Compress a block stored uncompressed in the file for the compressed block
+// cache. The result has the layout of a raw block read from the file: the
+// compressed data followed by the compression type byte. Return false if
+// the block does not compress well enough to be worth caching.
+bool CompressBlockForCache(const Slice& raw, CompressionType type,
+                           uint32_t format_version,
+                           MemoryAllocator* memory_allocator,
+                           BlockContents* compressed_block) {
+  CompressionOptions compression_opts;
+  CompressionContext context(type);
+  CompressionInfo info(compression_opts, context,
+                       CompressionDict::GetEmptyDict(), type,
+                       0 /* sample_for_compression */);
+  std::string compressed_output;
+  CompressionType compressed_type;
+  Slice compressed =
+      CompressBlock(raw, info, &compressed_type, format_version,
+                    false /* do_sample */, &compressed_output,
+                    nullptr /* sampled_output_fast */,
+                    nullptr /* sampled_output_slow */);
+  if (compressed_type == kNoCompression) {
+    return false;
+  }
+  CacheAllocationPtr allocation =
+      AllocateBlock(compressed.size() + 1, memory_allocator);
+  memcpy(allocation.get(), compressed.data(), compressed.size());
+  allocation.get()[compressed.size()] = static_cast<char>(compressed_type);
+  *compressed_block = BlockContents(std::move(allocation), compressed.size());
+#ifndef NDEBUG
+  compressed_block->is_raw_block = true;
+#endif  // NDEBUG
+  return true;
+}
+
 // Delete the entry resided in the cache.
 template <class Entry>
 void DeleteCachedEntry(const Slice& /*key*/, void* value) {
@@ -244,6 +339,74 @@ CacheAllocationPtr CopyBufferToHeap(MemoryAllocator* allocator, Slice& buf) {
 
 }  // namespace
 
+BlockDemoter::BlockDemoter(const BlockBasedTable::Rep& rep)
+    : compressed_cache_(rep.table_options.block_cache_compressed),
+      compression_type_(rep.table_options.block_cache_compressed_compression),
+      format_version_(rep.table_options.format_version),
+      cache_key_prefix_size_(rep.cache_key_prefix_size),
+      compressed_cache_key_prefix_(rep.compressed_cache_key_prefix,
+                                   rep.compressed_cache_key_prefix_size),
+      enabled_(true) {}
+
+void BlockDemoter::Demote(const Slice& block_cache_key,
+                          const Block& block) const {
+  if (!enabled_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  BlockContents compressed;
+  if (!CompressBlockForCache(Slice(block.data(), block.size()),
+                             compression_type_, format_version_,
+                             compressed_cache_->memory_allocator(),
+                             &compressed)) {
+    return;
+  }
+  // Both keys end with the offset of the block in the file.
+  char key[BlockBasedTable::kMaxCacheKeyPrefixSize + kMaxVarint64Length];
+  const size_t offset_size = block_cache_key.size() - cache_key_prefix_size_;
+  assert(offset_size <= kMaxVarint64Length);
+  memcpy(key, compressed_cache_key_prefix_.data(),
+         compressed_cache_key_prefix_.size());
+  memcpy(key + compressed_cache_key_prefix_.size(),
+         block_cache_key.data() + cache_key_prefix_size_, offset_size);
+  BlockContents* value = new BlockContents(std::move(compressed));
+  Status s = compressed_cache_->Insert(
+      Slice(key, compressed_cache_key_prefix_.size() + offset_size), value,
+      value->ApproximateMemoryUsage(), &DeleteCachedEntry<BlockContents>);
+  if (!s.ok()) {
+    delete value;
+  }
+}
+
+namespace {
+// Deleter of the data blocks of tables with a BlockDemoter.
+void DemoteCachedBlock(const Slice& key, void* value) {
+  Block* block = reinterpret_cast<Block*>(value);
+  if (block->demoter() != nullptr) {
+    block->demoter()->Demote(key, *block);
+  }
+  delete block;
+}
+
+typedef void (*CacheDeleter)(const Slice& key, void* value);
+
+// Deleter of an entry inserted into the block cache, which demotes data
+// blocks when `demoter` is set.
+template <typename TBlocklike>
+CacheDeleter PrepareForBlockCache(
+    TBlocklike* /*entry*/, const std::shared_ptr<BlockDemoter>& /*demoter*/) {
+  return &DeleteCachedEntry<TBlocklike>;
+}
+
+CacheDeleter PrepareForBlockCache(Block* block,
+                                  const std::shared_ptr<BlockDemoter>& demoter) {
+  if (demoter == nullptr) {
+    return &DeleteCachedEntry<Block>;
+  }
+  block->set_demoter(demoter);
+  return &DemoteCachedBlock;
+}
+}  // namespace
+
 // Encapsulates common functionality for the various index reader
 // implementations. Provides access to the index block regardless of whether
 // it is owned by the reader or stored in the cache, or whether it is pinned
@@ -784,6 +947,134 @@ class HashIndexReader : public BlockBasedTable::IndexReaderCommon {
   std::unique_ptr<BlockPrefixIndex> prefix_index_;
 };
 
+// Index that walks a path-decomposed trie over the separators to find the
+// block. What gets cached is the parsed block, the trie and the handles are
+// mapped from it, see pdt_index_block.h.
+class PdtIndexReader : public BlockBasedTable::IndexReader {
+ public:
+  // Read index from the file and create an intance for `PdtIndexReader`.
+  // On success, index_reader will be populated; otherwise it will remain
+  // unmodified.
+  static Status Create(const BlockBasedTable* table,
+                       FilePrefetchBuffer* prefetch_buffer, bool use_cache,
+                       bool prefetch, bool pin,
+                       BlockCacheLookupContext* lookup_context,
+                       std::unique_ptr<IndexReader>* index_reader) {
+    assert(table != nullptr);
+    assert(table->get_rep());
+    assert(!pin || prefetch);
+    assert(index_reader != nullptr);
+
+    CachableEntry<ParsedPdtIndexBlock> index_block;
+    if (prefetch || !use_cache) {
+      const Status s =
+          ReadIndexBlock(table, prefetch_buffer, ReadOptions(), use_cache,
+                         /*get_context=*/nullptr, lookup_context, &index_block);
+      if (!s.ok()) {
+        return s;
+      }
+
+      if (use_cache && !pin) {
+        index_block.Reset();
+      }
+    }
+
+    index_reader->reset(new PdtIndexReader(table, std::move(index_block)));
+
+    return Status::OK();
+  }
+
+  InternalIteratorBase<IndexValue>* NewIterator(
+      const ReadOptions& read_options, bool /* disable_prefix_seek */,
+      IndexBlockIter* iter, GetContext* get_context,
+      BlockCacheLookupContext* lookup_context) override {
+    const bool no_io = (read_options.read_tier == kBlockCacheTier);
+    CachableEntry<ParsedPdtIndexBlock> index_block;
+    Status s =
+        GetOrReadIndexBlock(no_io, get_context, lookup_context, &index_block);
+    if (s.ok() && !index_block.GetValue()->ok()) {
+      s = Status::Corruption("bad pdt index block");
+    }
+    if (!s.ok()) {
+      if (iter != nullptr) {
+        iter->Invalidate(s);
+        return iter;
+      }
+
+      return NewErrorInternalIterator<IndexValue>(s);
+    }
+
+    auto it = index_block.GetValue()->NewIterator(
+        table_->get_rep()->index_key_includes_seq);
+    index_block.TransferTo(it);
+
+    return it;
+  }
+
+  size_t ApproximateMemoryUsage() const override {
+    size_t usage = index_block_.GetOwnValue()
+                       ? index_block_.GetValue()->ApproximateMemoryUsage()
+                       : 0;
+#ifdef ROCKSDB_MALLOC_USABLE_SIZE
+    usage += malloc_usable_size(const_cast<PdtIndexReader*>(this));
+#else
+    usage += sizeof(*this);
+#endif  // ROCKSDB_MALLOC_USABLE_SIZE
+    return usage;
+  }
+
+ private:
+  PdtIndexReader(const BlockBasedTable* t,
+                 CachableEntry<ParsedPdtIndexBlock>&& index_block)
+      : table_(t), index_block_(std::move(index_block)) {
+    assert(table_ != nullptr);
+  }
+
+  static Status ReadIndexBlock(const BlockBasedTable* table,
+                               FilePrefetchBuffer* prefetch_buffer,
+                               const ReadOptions& read_options, bool use_cache,
+                               GetContext* get_context,
+                               BlockCacheLookupContext* lookup_context,
+                               CachableEntry<ParsedPdtIndexBlock>* index_block) {
+    PERF_TIMER_GUARD(read_index_block_nanos);
+
+    assert(index_block != nullptr);
+    assert(index_block->IsEmpty());
+
+    const BlockBasedTable::Rep* const rep = table->get_rep();
+    return table->RetrieveBlock(
+        prefetch_buffer, read_options, rep->footer.index_handle(),
+        UncompressionDict::GetEmptyDict(), index_block, BlockType::kIndex,
+        get_context, lookup_context, /* for_compaction */ false, use_cache,
+        true);
+  }
+
+  Status GetOrReadIndexBlock(
+      bool no_io, GetContext* get_context,
+      BlockCacheLookupContext* lookup_context,
+      CachableEntry<ParsedPdtIndexBlock>* index_block) const {
+    assert(index_block != nullptr);
+
+    if (!index_block_.IsEmpty()) {
+      index_block->SetUnownedValue(index_block_.GetValue());
+      return Status::OK();
+    }
+
+    ReadOptions read_options;
+    if (no_io) {
+      read_options.read_tier = kBlockCacheTier;
+    }
+
+    return ReadIndexBlock(
+        table_, /*prefetch_buffer=*/nullptr, read_options,
+        table_->get_rep()->table_options.cache_index_and_filter_blocks,
+        get_context, lookup_context, index_block);
+  }
+
+  const BlockBasedTable* table_;
+  CachableEntry<ParsedPdtIndexBlock> index_block_;
+};
+
 void BlockBasedTable::UpdateCacheHitMetrics(BlockType block_type,
                                             GetContext* get_context,
                                             size_t usage) const {
@@ -956,6 +1247,19 @@ void BlockBasedTable::UpdateCacheInsertionMetrics(BlockType block_type,
   }
 }
 
+void BlockBasedTable::UpdatePdtFilterLoadMetrics(
+    BlockType block_type, const BlockHandle& handle) const {
+  // The top level index of partitioned filters is not a PDT.
+  if (block_type != BlockType::kFilter || !rep_->pdt_filter ||
+      (rep_->filter_type == Rep::FilterType::kPartitionedFilter &&
+       handle.offset() == rep_->filter_handle.offset())) {
+    return;
+  }
+  RecordTick(rep_->ioptions.statistics, PDT_FILTER_BYTES_LOADED,
+             handle.size());
+  PERF_COUNTER_ADD(pdt_filter_bytes_loaded, handle.size());
+}
+
 Cache::Handle* BlockBasedTable::GetEntryFromCache(
     Cache* block_cache, const Slice& key, BlockType block_type,
     GetContext* get_context) const {
@@ -1218,6 +1522,7 @@ Status BlockBasedTable::Open(
   if (!s.ok()) {
     return s;
   }
+  new_table->ReadKeyLocatorBlock(prefetch_buffer.get(), meta_iter.get());
   s = new_table->PrefetchIndexAndFilterBlocks(
       prefetch_buffer.get(), meta_iter.get(), new_table.get(), prefetch_all,
       table_options, level, &lookup_context);
@@ -1474,6 +1779,61 @@ Status BlockBasedTable::ReadRangeDelBlock(
   return s;
 }
 
+// The key locator is an optimization only, a table whose locator can't be
+// read is still usable through the index.
+void BlockBasedTable::ReadKeyLocatorBlock(FilePrefetchBuffer* prefetch_buffer,
+                                          InternalIterator* meta_iter) {
+  const Comparator* user_comparator =
+      rep_->internal_comparator.user_comparator();
+  if (user_comparator->timestamp_size() != 0 ||
+      strcmp(user_comparator->Name(), BytewiseComparator()->Name()) != 0) {
+    return;
+  }
+  BlockHandle key_locator_handle;
+  if (!FindMetaBlock(meta_iter, kKeyLocatorBlock, &key_locator_handle).ok()) {
+    return;
+  }
+  BlockContents contents;
+  BlockFetcher block_fetcher(
+      rep_->file.get(), prefetch_buffer, rep_->footer, ReadOptions(),
+      key_locator_handle, &contents, rep_->ioptions, true /*decompress*/,
+      true /*maybe_compressed*/, BlockType::kKeyLocator,
+      UncompressionDict::GetEmptyDict(), rep_->persistent_cache_options,
+      GetMemoryAllocator(rep_->table_options));
+  Status s = block_fetcher.ReadBlockContents();
+  if (!s.ok()) {
+    ROCKS_LOG_WARN(rep_->ioptions.info_log,
+                   "Encountered error while reading key locator block %s",
+                   s.ToString().c_str());
+    return;
+  }
+  std::unique_ptr<ParsedKeyLocatorBlock> key_locator(
+      new ParsedKeyLocatorBlock(std::move(contents)));
+  if (!key_locator->ok()) {
+    ROCKS_LOG_WARN(rep_->ioptions.info_log, "Corrupted key locator block");
+    return;
+  }
+  Cache* const block_cache = rep_->table_options.block_cache.get();
+  if (block_cache != nullptr) {
+    // The locator lives as long as the table, so its charge stays pinned in
+    // the block cache until the table is closed.
+    char cache_key[kMaxCacheKeyPrefixSize + kMaxVarint64Length];
+    const Slice key = GetCacheKey(rep_->cache_key_prefix,
+                                  rep_->cache_key_prefix_size,
+                                  key_locator_handle, cache_key);
+    s = block_cache->Insert(key, nullptr /* value */,
+                            key_locator->ApproximateMemoryUsage(),
+                            nullptr /* deleter */,
+                            &rep_->key_locator_cache_handle);
+    if (!s.ok()) {
+      // The cache is full and has a strict capacity limit, lookups go
+      // through the index.
+      return;
+    }
+  }
+  rep_->key_locator = std::move(key_locator);
+}
+
 Status BlockBasedTable::PrefetchIndexAndFilterBlocks(
     FilePrefetchBuffer* prefetch_buffer, InternalIterator* meta_iter,
     BlockBasedTable* new_table, bool prefetch_all,
@@ -1481,8 +1841,22 @@ Status BlockBasedTable::PrefetchIndexAndFilterBlocks(
     BlockCacheLookupContext* lookup_context) {
   Status s;
 
-  // Find filter handle and filter type
+  // Find filter handle and filter type. With a selector the filter may have
+  // been built with any of its policies, it is named after that one.
+  std::vector<const FilterPolicy*> filter_policies;
   if (rep_->filter_policy) {
+    filter_policies.push_back(rep_->filter_policy);
+  }
+  std::vector<std::shared_ptr<const FilterPolicy>> selectable_policies;
+  if (rep_->filter_policy_selector) {
+    selectable_policies = rep_->filter_policy_selector->Policies();
+    for (const auto& policy : selectable_policies) {
+      if (policy != nullptr && policy.get() != rep_->filter_policy) {
+        filter_policies.push_back(policy.get());
+      }
+    }
+  }
+  for (const FilterPolicy* filter_policy : filter_policies) {
     for (auto filter_type :
          {Rep::FilterType::kOtLexPdtFilter, Rep::FilterType::kFullFilter,
           Rep::FilterType::kPartitionedFilter, Rep::FilterType::kBlockFilter}) {
@@ -1508,14 +1882,20 @@ Status BlockBasedTable::PrefetchIndexAndFilterBlocks(
           assert(0);
       }
       std::string filter_block_key = prefix;
-      filter_block_key.append(rep_->filter_policy->Name());
+      filter_block_key.append(filter_policy->Name());
       if (FindMetaBlock(meta_iter, filter_block_key, &rep_->filter_handle)
               .ok()) {
+        rep_->filter_policy = filter_policy;
         rep_->filter_type = filter_type;
+        rep_->pdt_filter = filter_type == Rep::FilterType::kOtLexPdtFilter ||
+                           IsPdtFilterPolicy(filter_policy);
         //fprintf(stderr, "DEBUG nq0zgh filter_block_key.append(Name()): %s, type: %d\n", rep_->filter_policy->Name(), static_cast<int>(filter_type));
         break;
       }
     }
+    if (rep_->filter_type != Rep::FilterType::kNoFilter) {
+      break;
+    }
   }
 
   // Find compression dictionary handle
@@ -1526,6 +1906,15 @@ Status BlockBasedTable::PrefetchIndexAndFilterBlocks(
     return s;
   }
 
+  // A dictionary uncompresses every block found in the compressed block
+  // cache, the demoted blocks are compressed without it.
+  if (table_options.block_cache != nullptr &&
+      table_options.block_cache_compressed != nullptr &&
+      table_options.block_cache_compressed_compression != kNoCompression &&
+      !found_compression_dict) {
+    rep_->block_demoter = std::make_shared<BlockDemoter>(*rep_);
+  }
+
   BlockBasedTableOptions::IndexType index_type = rep_->index_type;
 
   const bool use_cache = table_options.cache_index_and_filter_blocks;
@@ -1658,6 +2047,9 @@ size_t BlockBasedTable::ApproximateMemoryUsage() const {
   if (rep_->uncompression_dict_reader) {
     usage += rep_->uncompression_dict_reader->ApproximateMemoryUsage();
   }
+  if (rep_->key_locator && rep_->key_locator_cache_handle == nullptr) {
+    usage += rep_->key_locator->ApproximateMemoryUsage();
+  }
   return usage;
 }
 
@@ -1754,6 +2146,7 @@ Status BlockBasedTable::GetDataBlockFromCache(
   BlockContents contents;
   UncompressionContext context(compression_type);
   UncompressionInfo info(context, uncompression_dict, compression_type);
+  bool promoted = false;
   s = UncompressBlockContents(
       info, compressed_block->data.data(), compressed_block->data.size(),
       &contents, rep_->table_options.format_version, rep_->ioptions,
@@ -1766,18 +2159,24 @@ Status BlockBasedTable::GetDataBlockFromCache(
             std::move(contents), rep_->get_global_seqno(block_type),
             read_amp_bytes_per_bit, statistics,
             rep_->blocks_definitely_zstd_compressed,
-            rep_->table_options.filter_policy.get()));  // uncompressed block
+            rep_->filter_policy));  // uncompressed block
 
     if (block_cache != nullptr && block_holder->own_bytes() &&
         read_options.fill_cache) {
       size_t charge = block_holder->ApproximateMemoryUsage();
       Cache::Handle* cache_handle = nullptr;
+      const std::shared_ptr<BlockDemoter>& demoter =
+          block_type == BlockType::kData ? rep_->block_demoter : nullptr;
       s = block_cache->Insert(block_cache_key, block_holder.get(), charge,
-                              &DeleteCachedEntry<TBlocklike>, &cache_handle);
+                              PrepareForBlockCache(block_holder.get(), demoter),
+                              &cache_handle);
       if (s.ok()) {
         assert(cache_handle != nullptr);
         block->SetCachedValue(block_holder.release(), block_cache,
                               cache_handle);
+        // The block goes back to the compressed block cache when it is
+        // evicted again.
+        promoted = demoter != nullptr;
 
         UpdateCacheInsertionMetrics(block_type, get_context, charge);
       } else {
@@ -1789,7 +2188,8 @@ Status BlockBasedTable::GetDataBlockFromCache(
   }
 
   // Release hold on compressed cache entry
-  block_cache_compressed->Release(block_cache_compressed_handle);
+  block_cache_compressed->Release(block_cache_compressed_handle,
+                                  promoted /* force_erase */);
   return s;
 }
 
@@ -1821,6 +2221,13 @@ Status BlockBasedTable::PutDataBlockToCache(
   Status s;
   Statistics* statistics = ioptions.statistics;
 
+  // Data blocks stored uncompressed in the file only go to the compressed
+  // block cache once they are evicted from the block cache.
+  const std::shared_ptr<BlockDemoter>& demoter =
+      block_type == BlockType::kData && raw_block_comp_type == kNoCompression
+          ? rep_->block_demoter
+          : nullptr;
+
   std::unique_ptr<TBlocklike> block_holder;
   if (raw_block_comp_type != kNoCompression) {
     // Retrieve the uncompressed contents into a new buffer
@@ -1838,12 +2245,12 @@ Status BlockBasedTable::PutDataBlockToCache(
     block_holder.reset(BlocklikeTraits<TBlocklike>::Create(
         std::move(uncompressed_block_contents), seq_no, read_amp_bytes_per_bit,
         statistics, rep_->blocks_definitely_zstd_compressed,
-        rep_->table_options.filter_policy.get()));
+        rep_->filter_policy));
   } else {
     block_holder.reset(BlocklikeTraits<TBlocklike>::Create(
         std::move(*raw_block_contents), seq_no, read_amp_bytes_per_bit,
         statistics, rep_->blocks_definitely_zstd_compressed,
-        rep_->table_options.filter_policy.get()));
+        rep_->filter_policy));
   }
 
   // Insert compressed block into compressed block cache.
@@ -1877,8 +2284,8 @@ Status BlockBasedTable::PutDataBlockToCache(
     size_t charge = block_holder->ApproximateMemoryUsage();
     Cache::Handle* cache_handle = nullptr;
     s = block_cache->Insert(block_cache_key, block_holder.get(), charge,
-                            &DeleteCachedEntry<TBlocklike>, &cache_handle,
-                            priority);
+                            PrepareForBlockCache(block_holder.get(), demoter),
+                            &cache_handle, priority);
     if (s.ok()) {
       assert(cache_handle != nullptr);
       cached_block->SetCachedValue(block_holder.release(), block_cache,
@@ -2011,7 +2418,7 @@ TBlockIter* BlockBasedTable::NewDataBlockIterator(
   if (!block.IsCached()) {
     if (!ro.fill_cache && rep_->cache_key_prefix_size != 0) {
       // insert a dummy record to block cache to track the memory usage
-      Cache* const block_cache = rep_->table_options.block_cache.get();
+      Cache* const block_cache = GetBlockCache(rep_->table_options, block_type);
       Cache::Handle* cache_handle = nullptr;
       // There are two other types of cache keys: 1) SST cache key added in
       // `MaybeReadBlockAndLoadToCache` 2) dummy cache key added in
@@ -2173,7 +2580,7 @@ Status BlockBasedTable::MaybeReadBlockAndLoadToCache(
     BlockContents* contents,bool is_meta_block) const {
   assert(block_entry != nullptr);
   const bool no_io = (ro.read_tier == kBlockCacheTier);
-  Cache* block_cache = rep_->table_options.block_cache.get();
+  Cache* block_cache = GetBlockCache(rep_->table_options, block_type);
   // No point to cache compressed blocks if it never goes away
   Cache* block_cache_compressed =
       rep_->immortal_table ? nullptr
@@ -2235,6 +2642,9 @@ Status BlockBasedTable::MaybeReadBlockAndLoadToCache(
         s = block_fetcher.ReadBlockContents(is_meta_block);
         raw_block_comp_type = block_fetcher.get_compression_type();
         contents = &raw_block_contents;
+        if (s.ok()) {
+          UpdatePdtFilterLoadMetrics(block_type, handle);
+        }
       } else {
         raw_block_comp_type = contents->get_compression_type();
       }
@@ -2536,12 +2946,13 @@ Status BlockBasedTable::RetrieveBlock(
             : 0,
         GetMemoryAllocator(rep_->table_options), for_compaction,
         rep_->blocks_definitely_zstd_compressed,
-        rep_->table_options.filter_policy.get());
+        rep_->filter_policy);
   }
 
   if (!s.ok()) {
     return s;
   }
+  UpdatePdtFilterLoadMetrics(block_type, handle);
 
   block_entry->SetOwnedValue(block.release());
 
@@ -2558,6 +2969,14 @@ template Status BlockBasedTable::RetrieveBlock<BlockContents>(
     GetContext* get_context, BlockCacheLookupContext* lookup_context,
     bool for_compaction, bool use_cache,bool is_meta_block=false) const;
 
+template Status BlockBasedTable::RetrieveBlock<ParsedBlockBasedFilterBlock>(
+    FilePrefetchBuffer* prefetch_buffer, const ReadOptions& ro,
+    const BlockHandle& handle, const UncompressionDict& uncompression_dict,
+    CachableEntry<ParsedBlockBasedFilterBlock>* block_entry,
+    BlockType block_type, GetContext* get_context,
+    BlockCacheLookupContext* lookup_context, bool for_compaction,
+    bool use_cache, bool is_meta_block = false) const;
+
 template Status BlockBasedTable::RetrieveBlock<ParsedFullFilterBlock>(
     FilePrefetchBuffer* prefetch_buffer, const ReadOptions& ro,
     const BlockHandle& handle, const UncompressionDict& uncompression_dict,
@@ -2565,6 +2984,13 @@ template Status BlockBasedTable::RetrieveBlock<ParsedFullFilterBlock>(
     GetContext* get_context, BlockCacheLookupContext* lookup_context,
     bool for_compaction, bool use_cache,bool is_meta_block=false) const;
 
+template Status BlockBasedTable::RetrieveBlock<ParsedPdtIndexBlock>(
+    FilePrefetchBuffer* prefetch_buffer, const ReadOptions& ro,
+    const BlockHandle& handle, const UncompressionDict& uncompression_dict,
+    CachableEntry<ParsedPdtIndexBlock>* block_entry, BlockType block_type,
+    GetContext* get_context, BlockCacheLookupContext* lookup_context,
+    bool for_compaction, bool use_cache,bool is_meta_block=false) const;
+
 template Status BlockBasedTable::RetrieveBlock<Block>(
     FilePrefetchBuffer* prefetch_buffer, const ReadOptions& ro,
     const BlockHandle& handle, const UncompressionDict& uncompression_dict,
@@ -2628,9 +3054,14 @@ bool BlockBasedTable::PrefixMayMatch(
     return true;
   }
 
+  FilterBlockReader* const filter = rep_->filter.get();
   const SliceTransform* prefix_extractor;
 
-  if (rep_->table_prefix_extractor == nullptr) {
+  if (filter != nullptr && filter->PrefixExtractorIndependent()) {
+    // The prefix the iterator stops at is the one of the current extractor,
+    // whatever the table was built with.
+    prefix_extractor = options_prefix_extractor;
+  } else if (rep_->table_prefix_extractor == nullptr) {
     if (need_upper_bound_check) {
       return true;
     }
@@ -2647,7 +3078,6 @@ bool BlockBasedTable::PrefixMayMatch(
   Status s;
 
   // First, try check with full filter
-  FilterBlockReader* const filter = rep_->filter.get();
   bool filter_checked = true;
   if (filter != nullptr) {
     if (!filter->IsBlockBased()) {
@@ -2725,6 +3155,33 @@ bool BlockBasedTable::PrefixMayMatch(
   return may_match;
 }
 
+bool BlockBasedTable::KeyRangeMayMatch(
+    const Slice* internal_key, const Slice& upper_bound,
+    BlockCacheLookupContext* lookup_context) const {
+  FilterBlockReader* const filter = rep_->filter.get();
+  if (filter == nullptr || filter->IsBlockBased()) {
+    return true;
+  }
+  // Don't read a filter that would say "may match" whatever the range.
+  if (rep_->filter_policy == nullptr ||
+      !rep_->filter_policy->SupportsRangeMayMatch()) {
+    return true;
+  }
+  // Filters can only keep keys in bytewise order.
+  const Comparator* const user_comparator =
+      rep_->internal_comparator.user_comparator();
+  if (strcmp(user_comparator->Name(), BytewiseComparator()->Name()) != 0) {
+    return true;
+  }
+  const Slice lower_bound =
+      internal_key != nullptr ? ExtractUserKey(*internal_key) : Slice();
+  if (user_comparator->Compare(lower_bound, upper_bound) >= 0) {
+    return true;
+  }
+  return filter->KeyRangeMayMatch(lower_bound, upper_bound, internal_key,
+                                  /*no_io=*/false, lookup_context);
+}
+
 template <class TBlockIter, typename TValue>
 void BlockBasedTableIterator<TBlockIter, TValue>::Seek(const Slice& target) {
   SeekImpl(&target);
@@ -2744,6 +3201,9 @@ void BlockBasedTableIterator<TBlockIter, TValue>::SeekImpl(
     ResetDataIter();
     return;
   }
+  if (!CheckRangeMayMatch(target)) {
+    return;
+  }
 
   bool need_seek_index = true;
   if (block_iter_points_to_real_block_ && block_iter_.Valid()) {
@@ -3161,7 +3621,7 @@ InternalIterator* BlockBasedTable::NewIterator(
         !skip_filters && !read_options.total_order_seek &&
             prefix_extractor != nullptr,
         need_upper_bound_check, prefix_extractor, BlockType::kData, caller,
-        compaction_readahead_size);
+        compaction_readahead_size, !skip_filters);
   } else {
     auto* mem =
         arena->AllocateAligned(sizeof(BlockBasedTableIterator<DataBlockIter>));
@@ -3173,7 +3633,7 @@ InternalIterator* BlockBasedTable::NewIterator(
         !skip_filters && !read_options.total_order_seek &&
             prefix_extractor != nullptr,
         need_upper_bound_check, prefix_extractor, BlockType::kData, caller,
-        compaction_readahead_size);
+        compaction_readahead_size, !skip_filters);
   }
 }
 
@@ -3211,8 +3671,9 @@ bool BlockBasedTable::FullFilterKeyMayMatch(
                             no_io, const_ikey_ptr, get_context, lookup_context);
     //fprintf(stderr,"after filter->KeyMayMatch\n");
   } else if (!read_options.total_order_seek && prefix_extractor &&
-             rep_->table_properties->prefix_extractor_name.compare(
-                 prefix_extractor->Name()) == 0 &&
+             (filter->PrefixExtractorIndependent() ||
+              rep_->table_properties->prefix_extractor_name.compare(
+                  prefix_extractor->Name()) == 0) &&
              prefix_extractor->InDomain(user_key) &&
              !filter->PrefixMayMatch(prefix_extractor->Transform(user_key),
                                      prefix_extractor, kNotValid, no_io,
@@ -3239,8 +3700,9 @@ void BlockBasedTable::FullFilterKeysMayMatch(
     filter->KeysMayMatch(range, prefix_extractor, kNotValid, no_io,
                          lookup_context);
   } else if (!read_options.total_order_seek && prefix_extractor &&
-             rep_->table_properties->prefix_extractor_name.compare(
-                 prefix_extractor->Name()) == 0) {
+             (filter->PrefixExtractorIndependent() ||
+              rep_->table_properties->prefix_extractor_name.compare(
+                  prefix_extractor->Name()) == 0)) {
     for (auto iter = range->begin(); iter != range->end(); ++iter) {
       Slice user_key = iter->lkey->user_key();
 
@@ -3294,9 +3756,16 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
       need_upper_bound_check = PrefixExtractorChanged(
           rep_->table_properties.get(), prefix_extractor);
     }
-    auto iiter =
-        NewIndexIterator(read_options, need_upper_bound_check, &iiter_on_stack,
-                         get_context, &lookup_context);
+    // With a key locator the versions of the key are all in the located
+    // block, which is the only entry of the iterator.
+    InternalIteratorBase<IndexValue>* iiter;
+    if (rep_->key_locator != nullptr) {
+      iiter = rep_->key_locator->NewIterator(ExtractUserKey(key));
+    } else {
+      TEST_SYNC_POINT("BlockBasedTable::Get:SearchIndex");
+      iiter = NewIndexIterator(read_options, need_upper_bound_check,
+                               &iiter_on_stack, get_context, &lookup_context);
+    }
     std::unique_ptr<InternalIteratorBase<IndexValue>> iiter_unique_ptr;
     if (iiter != &iiter_on_stack) {
       iiter_unique_ptr.reset(iiter);
@@ -3881,6 +4350,10 @@ BlockType BlockBasedTable::GetBlockTypeForMetaBlockByName(
     return BlockType::kHashIndexMetadata;
   }
 
+  if (meta_block_name == kKeyLocatorBlock) {
+    return BlockType::kKeyLocator;
+  }
+
   assert(false);
   return BlockType::kInvalid;
 }
@@ -3982,6 +4455,10 @@ Status BlockBasedTable::CreateIndexReader(
                                              prefetch, pin, lookup_context,
                                              index_reader);
     }
+    case BlockBasedTableOptions::kPdtSearch: {
+      return PdtIndexReader::Create(this, prefetch_buffer, use_cache, prefetch,
+                                    pin, lookup_context, index_reader);
+    }
     case BlockBasedTableOptions::kHashSearch: {
       std::unique_ptr<Block> meta_guard;
       std::unique_ptr<InternalIterator> meta_iter_guard;
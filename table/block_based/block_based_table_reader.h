@@ -10,6 +10,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <atomic>
 #include <memory>
 #include <set>
 #include <string>
@@ -29,6 +30,7 @@
 #include "table/block_based/block_type.h"
 #include "table/block_based/cachable_entry.h"
 #include "table/block_based/filter_block.h"
+#include "table/block_based/key_locator_block.h"
 #include "table/block_based/uncompression_dict_reader.h"
 #include "table/format.h"
 #include "table/get_context.h"
@@ -122,6 +124,12 @@ class BlockBasedTable : public TableReader {
                       const bool need_upper_bound_check,
                       BlockCacheLookupContext* lookup_context) const;
 
+  // Check if the table may contain a user key in [user key of
+  // `internal_key`, `upper_bound`), or below `upper_bound` if `internal_key`
+  // is nullptr. Returns true if the filter can't tell.
+  bool KeyRangeMayMatch(const Slice* internal_key, const Slice& upper_bound,
+                        BlockCacheLookupContext* lookup_context) const;
+
   // Returns a new iterator over the table contents.
   // The result of NewIterator() is initially invalid (caller must
   // call one of the Seek methods on the iterator before using it).
@@ -247,6 +255,8 @@ class BlockBasedTable : public TableReader {
 
   friend class PartitionIndexReader;
 
+  friend class PdtIndexReader;
+
   friend class UncompressionDictReader;
 
  protected:
@@ -265,6 +275,9 @@ class BlockBasedTable : public TableReader {
                               GetContext* get_context) const;
   void UpdateCacheInsertionMetrics(BlockType block_type,
                                    GetContext* get_context, size_t usage) const;
+  // Counts the bytes of a block read from the file if it is a PDT filter.
+  void UpdatePdtFilterLoadMetrics(BlockType block_type,
+                                  const BlockHandle& handle) const;
   Cache::Handle* GetEntryFromCache(Cache* block_cache, const Slice& key,
                                    BlockType block_type,
                                    GetContext* get_context) const;
@@ -417,6 +430,8 @@ class BlockBasedTable : public TableReader {
                            InternalIterator* meta_iter,
                            const InternalKeyComparator& internal_comparator,
                            BlockCacheLookupContext* lookup_context);
+  void ReadKeyLocatorBlock(FilePrefetchBuffer* prefetch_buffer,
+                           InternalIterator* meta_iter);
   Status PrefetchIndexAndFilterBlocks(
       FilePrefetchBuffer* prefetch_buffer, InternalIterator* meta_iter,
       BlockBasedTable* new_table, bool prefetch_all,
@@ -482,6 +497,8 @@ struct BlockBasedTable::Rep {
         env_options(_env_options),
         table_options(_table_opt),
         filter_policy(skip_filters ? nullptr : _table_opt.filter_policy.get()),
+        filter_policy_selector(
+            skip_filters ? nullptr : _table_opt.filter_policy_selector.get()),
         internal_comparator(_internal_comparator),
         filter_type(FilterType::kNoFilter),
         index_type(BlockBasedTableOptions::IndexType::kBinarySearch),
@@ -495,7 +512,10 @@ struct BlockBasedTable::Rep {
   const ImmutableCFOptions& ioptions;
   const EnvOptions& env_options;
   const BlockBasedTableOptions table_options;
-  const FilterPolicy* const filter_policy;
+  // The policy the filter of the file was built with once it is found, the
+  // configured one until then.
+  const FilterPolicy* filter_policy;
+  const FilterPolicySelector* const filter_policy_selector;
   const InternalKeyComparator& internal_comparator;
   Status status;
   std::unique_ptr<RandomAccessFileReader> file;
@@ -522,6 +542,9 @@ struct BlockBasedTable::Rep {
     kPartitionedFilter,
   };
   FilterType filter_type;
+  // Whether the filter is a PDT, whose loads and probes are counted in the
+  // PDT filter metrics.
+  bool pdt_filter = false;
   BlockHandle filter_handle;
   BlockHandle compression_dict_handle;
 
@@ -539,6 +562,16 @@ struct BlockBasedTable::Rep {
 
   std::shared_ptr<const FragmentedRangeTombstoneList> fragmented_range_dels;
 
+  // Locates the data block of a key for point lookups, null if the table
+  // has no (usable) key locator. Loaded on open and never cached, but its
+  // memory is charged to the block cache through a dummy entry, held in
+  // key_locator_cache_handle, when the table has a block cache.
+  std::unique_ptr<const ParsedKeyLocatorBlock> key_locator;
+  Cache::Handle* key_locator_cache_handle = nullptr;
+  // Demotes the data blocks evicted from the block cache to the compressed
+  // block cache, null unless block_cache_compressed_compression applies.
+  std::shared_ptr<BlockDemoter> block_demoter;
+
   // If global_seqno is used, all Keys in this file will have the same
   // seqno with value `global_seqno`.
   //
@@ -592,6 +625,29 @@ struct BlockBasedTable::Rep {
   }
 };
 
+// Demotes the data blocks of a table, stored uncompressed in the file, into
+// the compressed block cache when they are evicted from the block cache.
+class BlockDemoter {
+ public:
+  explicit BlockDemoter(const BlockBasedTable::Rep& rep);
+
+  // Blocks evicted after the table is closed are dropped: their file is
+  // likely obsolete, or the DB is shutting down.
+  void Disable() { enabled_.store(false, std::memory_order_relaxed); }
+
+  // Insert `block`, cached under `block_cache_key` in the block cache, into
+  // the compressed block cache.
+  void Demote(const Slice& block_cache_key, const Block& block) const;
+
+ private:
+  const std::shared_ptr<Cache> compressed_cache_;
+  const CompressionType compression_type_;
+  const uint32_t format_version_;
+  const size_t cache_key_prefix_size_;
+  const std::string compressed_cache_key_prefix_;
+  std::atomic<bool> enabled_;
+};
+
 // Iterates over the contents of BlockBasedTable.
 template <class TBlockIter, typename TValue = Slice>
 class BlockBasedTableIterator : public InternalIteratorBase<TValue> {
@@ -605,7 +661,8 @@ class BlockBasedTableIterator : public InternalIteratorBase<TValue> {
                           bool check_filter, bool need_upper_bound_check,
                           const SliceTransform* prefix_extractor,
                           BlockType block_type, TableReaderCaller caller,
-                          size_t compaction_readahead_size = 0)
+                          size_t compaction_readahead_size = 0,
+                          bool check_range_filter = false)
       : table_(table),
         read_options_(read_options),
         icomp_(icomp),
@@ -618,7 +675,8 @@ class BlockBasedTableIterator : public InternalIteratorBase<TValue> {
         prefix_extractor_(prefix_extractor),
         block_type_(block_type),
         lookup_context_(caller),
-        compaction_readahead_size_(compaction_readahead_size) {}
+        compaction_readahead_size_(compaction_readahead_size),
+        check_range_filter_(check_range_filter) {}
 
   ~BlockBasedTableIterator() { delete index_iter_; }
 
@@ -716,6 +774,19 @@ class BlockBasedTableIterator : public InternalIteratorBase<TValue> {
     return true;
   }
 
+  // Skip the table if the filter rules out every key between the seek
+  // target (or the first key) and `iterate_upper_bound`. The iterator is
+  // left invalid, as if the table was exhausted.
+  bool CheckRangeMayMatch(const Slice* ikey) {
+    if (check_range_filter_ && read_options_.iterate_upper_bound != nullptr &&
+        !table_->KeyRangeMayMatch(ikey, *read_options_.iterate_upper_bound,
+                                  &lookup_context_)) {
+      ResetDataIter();
+      return false;
+    }
+    return true;
+  }
+
   void ResetDataIter() {
     if (block_iter_points_to_real_block_) {
       if (pinned_iters_mgr_ != nullptr && pinned_iters_mgr_->PinningEnabled()) {
@@ -763,6 +834,8 @@ class BlockBasedTableIterator : public InternalIteratorBase<TValue> {
   // Readahead size used in compaction, its value is used only if
   // lookup_context_.caller = kCompaction.
   size_t compaction_readahead_size_;
+  // Whether whole-key filters are checked for keys below the upper bound.
+  bool check_range_filter_;
 
   // All the below fields control iterator readahead
   static const size_t kInitAutoReadaheadSize = 8 * 1024;
@@ -155,6 +155,10 @@ class FilterBlockReader {
 
   virtual void CacheDependencies(bool /*pin*/) {}
 
+  // True if PrefixMayMatch() answers for prefixes of any length, i.e. the
+  // filter does not depend on the prefix extractor the table was built with.
+  virtual bool PrefixExtractorIndependent() const { return false; }
+
   virtual bool RangeMayExist(const Slice* /*iterate_upper_bound*/,
                              const Slice& user_key,
                              const SliceTransform* prefix_extractor,
@@ -169,6 +173,18 @@ class FilterBlockReader {
                           const_ikey_ptr, /* get_context */ nullptr,
                           lookup_context);
   }
+
+  // Check if the table may contain a user key in [lower_bound, upper_bound)
+  // under the bytewise order. `const_ikey_ptr` is the internal key of
+  // `lower_bound` or nullptr if the range starts at the first key. Only
+  // filters keeping the order of whole keys can answer it.
+  virtual bool KeyRangeMayMatch(const Slice& /*lower_bound*/,
+                                const Slice& /*upper_bound*/,
+                                const Slice* const /*const_ikey_ptr*/,
+                                bool /*no_io*/,
+                                BlockCacheLookupContext* /*lookup_context*/) {
+    return true;
+  }
 };
 
 }  // namespace rocksdb
@@ -6,6 +6,7 @@
 
 #include "table/block_based/filter_block_reader_common.h"
 #include "monitoring/perf_context_imp.h"
+#include "table/block_based/block_based_filter_block.h"
 #include "table/block_based/block_based_table_reader.h"
 
 namespace rocksdb {
@@ -95,6 +96,7 @@ size_t FilterBlockReaderCommon<TBlocklike>::ApproximateFilterBlockMemoryUsage()
 // Explicitly instantiate templates for both "blocklike" types we use.
 // This makes it possible to keep the template definitions in the .cc file.
 template class FilterBlockReaderCommon<BlockContents>;
+template class FilterBlockReaderCommon<ParsedBlockBasedFilterBlock>;
 template class FilterBlockReaderCommon<Block>;
 template class FilterBlockReaderCommon<ParsedFullFilterBlock>;
 
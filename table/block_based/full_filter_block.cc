@@ -5,6 +5,8 @@
 
 #include "table/block_based/full_filter_block.h"
 
+#include <array>
+
 #ifdef ROCKSDB_MALLOC_USABLE_SIZE
 #ifdef OS_FREEBSD
 #include <malloc_np.h>
@@ -14,6 +16,7 @@
 #endif
 
 #include "monitoring/perf_context_imp.h"
+#include "monitoring/statistics.h"
 #include "port/port.h"
 #include "rocksdb/filter_policy.h"
 #include "table/block_based/block_based_table_reader.h"
@@ -21,6 +24,29 @@
 
 namespace rocksdb {
 
+namespace {
+// Reading the thread CPU clock costs a system call per probe, so the probe
+// time only goes to the statistics when detailed timers are asked for.
+Statistics* ProbeTimeStatistics(const ImmutableCFOptions& ioptions) {
+  return ShouldReportDetailedTime(ioptions.env, ioptions.statistics)
+             ? ioptions.statistics
+             : nullptr;
+}
+
+// Run `probe`, which does `num_probes` lookups in a PDT filter, counting them
+// and their CPU time in the PDT filter metrics.
+template <typename Probe>
+void ProbePdt(const ImmutableCFOptions& ioptions, int num_probes,
+              const Probe& probe) {
+  RecordTick(ioptions.statistics, PDT_FILTER_PROBES, num_probes);
+  PERF_COUNTER_ADD(pdt_filter_probe_count, num_probes);
+  PERF_CPU_TIMER_GUARD_WITH_STATS(
+      pdt_filter_probe_cpu_nanos, ioptions.env, ProbeTimeStatistics(ioptions),
+      PDT_FILTER_PROBE_CPU_NANOS);
+  probe();
+}
+}  // namespace
+
 // DO NOT support prefix
 void OtLexPdtFilterBlockBuilder::Add(const Slice& key) {
   AddKey(key);
@@ -131,13 +157,7 @@ Slice FullFilterBlockBuilder::Finish(const BlockHandle& /*tmp*/,
 //xp
 OtLexPdtFilterBlockReader::OtLexPdtFilterBlockReader(const BlockBasedTable* t,
     CachableEntry<ParsedFullFilterBlock>&& filter_block)
-    : FilterBlockReaderCommon(t, std::move(filter_block)) {
-  const SliceTransform* const prefix_extractor = table_prefix_extractor();
-  if (prefix_extractor) {
-    full_length_enabled_ =
-        prefix_extractor->FullLengthEnabled(&prefix_extractor_full_length_);
-  }
-}
+    : FilterBlockReaderCommon(t, std::move(filter_block)) {}
 
 bool OtLexPdtFilterBlockReader::KeyMayMatch(
     const Slice& key, const SliceTransform* /*prefix_extractor*/,
@@ -152,7 +172,8 @@ bool OtLexPdtFilterBlockReader::KeyMayMatch(
   if (!whole_key_filtering()) {
     return true;
   }
-  return MayMatch(key, no_io, get_context, lookup_context);
+  return MayMatch(key, false /* is_prefix */, no_io, get_context,
+                  lookup_context);
 }
 
 std::unique_ptr<FilterBlockReader> OtLexPdtFilterBlockReader::Create(
@@ -193,11 +214,14 @@ bool OtLexPdtFilterBlockReader::PrefixMayMatch(
   (void)block_offset;
 #endif
   assert(block_offset == kNotValid);
-  return MayMatch(prefix, no_io, get_context, lookup_context);
+  // The trie is built from whole keys, the prefix is walked down instead of
+  // being looked up as a key.
+  return MayMatch(prefix, true /* is_prefix */, no_io, get_context,
+                  lookup_context);
 }
 
 bool OtLexPdtFilterBlockReader::MayMatch(
-    const Slice& entry, bool no_io, GetContext* get_context,
+    const Slice& entry, bool is_prefix, bool no_io, GetContext* get_context,
     BlockCacheLookupContext* lookup_context) const {
       //fprintf(stderr,"in OtLexPdtFilterBlockReader::MayMatch\n");
   CachableEntry<ParsedFullFilterBlock> filter_block;
@@ -223,7 +247,12 @@ bool OtLexPdtFilterBlockReader::MayMatch(
 //fprintf(stderr,"in OtLexPdtFilterBlockReader::MayMatch3\n");
   if (filter_bits_reader) {
     //fprintf(stderr, "DEBUG b9qicb filter_bits_reader is NOT nullptr\n");
-    if (filter_bits_reader->MayMatch(entry)) {
+    bool may_match = true;
+    ProbePdt(table()->get_rep()->ioptions, 1, [&]() {
+      may_match = is_prefix ? filter_bits_reader->PrefixMayMatch(entry)
+                            : filter_bits_reader->MayMatch(entry);
+    });
+    if (may_match) {
       PERF_COUNTER_ADD(bloom_sst_hit_count, 1);
       return true;
     } else {
@@ -252,17 +281,22 @@ void OtLexPdtFilterBlockReader::KeysMayMatch(
   MayMatch(range, no_io, nullptr, lookup_context);
 }
 
-//void OtLexPdtFilterBlockReader::PrefixesMayMatch(
-//    MultiGetRange* range, const SliceTransform* prefix_extractor,
-//    uint64_t block_offset, const bool no_io,
-//    BlockCacheLookupContext* lookup_context) {
-//#ifdef NDEBUG
-//  (void)range;
-//  (void)block_offset;
-//#endif
-//  assert(block_offset == kNotValid);
-//  MayMatch(range, no_io, prefix_extractor, lookup_context); xxxxx
-//}
+void OtLexPdtFilterBlockReader::PrefixesMayMatch(
+    MultiGetRange* range, const SliceTransform* prefix_extractor,
+    uint64_t block_offset, const bool no_io,
+    BlockCacheLookupContext* lookup_context) {
+#ifdef NDEBUG
+  (void)block_offset;
+#endif
+  assert(block_offset == kNotValid);
+  for (auto iter = range->begin(); iter != range->end(); ++iter) {
+    const Slice ukey = iter->ukey;
+    if (!MayMatch(prefix_extractor->Transform(ukey), true /* is_prefix */,
+                  no_io, iter->get_context, lookup_context)) {
+      range->SkipKey(iter);
+    }
+  }
+}
 
 void OtLexPdtFilterBlockReader::MayMatch(
     MultiGetRange* range, bool no_io, const SliceTransform* prefix_extractor,
@@ -309,7 +343,9 @@ void OtLexPdtFilterBlockReader::MayMatch(
     }
   }
 
-  filter_bits_reader->MayMatch(num_keys, &keys[0], &may_match[0]);
+  ProbePdt(table()->get_rep()->ioptions, num_keys, [&]() {
+    filter_bits_reader->MayMatch(num_keys, &keys[0], &may_match[0]);
+  });
 
   int i = 0;
   for (auto iter = filter_range.begin(); iter != filter_range.end(); ++iter) {
@@ -338,71 +374,64 @@ size_t OtLexPdtFilterBlockReader::ApproximateMemoryUsage() const {
 }
 
 bool OtLexPdtFilterBlockReader::RangeMayExist(
-    const Slice* iterate_upper_bound, const Slice& user_key,
-    const SliceTransform* prefix_extractor, const Comparator* comparator,
+    const Slice* /*iterate_upper_bound*/, const Slice& user_key,
+    const SliceTransform* prefix_extractor, const Comparator* /*comparator*/,
     const Slice* const const_ikey_ptr, bool* filter_checked,
-    bool need_upper_bound_check, BlockCacheLookupContext* lookup_context) {
-
-//  return true;
+    bool /*need_upper_bound_check*/,
+    BlockCacheLookupContext* lookup_context) {
+  // Unlike a filter on prefixes, the trie does not care whether the prefix
+  // extractor changed since the table was built.
   if (!prefix_extractor || !prefix_extractor->InDomain(user_key)) {
     *filter_checked = false;
     return true;
   }
-  Slice prefix = prefix_extractor->Transform(user_key);
-  if (need_upper_bound_check &&
-      !IsFilterCompatible(iterate_upper_bound, prefix, comparator)) {
-    *filter_checked = false;
+  *filter_checked = true;
+  return PrefixMayMatch(prefix_extractor->Transform(user_key),
+                        prefix_extractor, kNotValid, false, const_ikey_ptr,
+                        /* get_context */ nullptr, lookup_context);
+}
+
+
+bool OtLexPdtFilterBlockReader::KeyRangeMayMatch(
+    const Slice& lower_bound, const Slice& upper_bound,
+    const Slice* const /*const_ikey_ptr*/, bool no_io,
+    BlockCacheLookupContext* lookup_context) {
+  // A filter on prefixes only can't tell whether keys of the range exist
+  if (!whole_key_filtering()) {
     return true;
-  } else {
-    *filter_checked = true;
-    return PrefixMayMatch(prefix, prefix_extractor, kNotValid, false,
-                          const_ikey_ptr, /* get_context */ nullptr,
-                          lookup_context);
   }
-}
+  CachableEntry<ParsedFullFilterBlock> filter_block;
 
+  const Status s = GetOrReadFilterBlock(no_io, nullptr /* get_context */,
+                                        lookup_context, &filter_block);
+  if (!s.ok()) {
+    return true;
+  }
 
-bool OtLexPdtFilterBlockReader::IsFilterCompatible(
-    const Slice* iterate_upper_bound, const Slice& prefix,
-    const Comparator* comparator) const {
-  // Try to reuse the bloom filter in the SST table if prefix_extractor in
-  // mutable_cf_options has changed. If range [user_key, upper_bound) all
-  // share the same prefix then we may still be able to use the bloom filter.
-  const SliceTransform* const prefix_extractor = table_prefix_extractor();
-  if (iterate_upper_bound != nullptr && prefix_extractor) {
-    if (!prefix_extractor->InDomain(*iterate_upper_bound)) {
-      return false;
-    }
-    Slice upper_bound_xform = prefix_extractor->Transform(*iterate_upper_bound);
-    // first check if user_key and upper_bound all share the same prefix
-    if (!comparator->Equal(prefix, upper_bound_xform)) {
-      // second check if user_key's prefix is the immediate predecessor of
-      // upper_bound and have the same length. If so, we know for sure all
-      // keys in the range [user_key, upper_bound) share the same prefix.
-      // Also need to make sure upper_bound are full length to ensure
-      // correctness
-      if (!full_length_enabled_ ||
-          iterate_upper_bound->size() != prefix_extractor_full_length_ ||
-          !comparator->IsSameLengthImmediateSuccessor(prefix,
-                                                      *iterate_upper_bound)) {
-        return false;
-      }
-    }
+  assert(filter_block.GetValue());
+
+  FilterBitsReader* const filter_bits_reader =
+      filter_block.GetValue()->filter_bits_reader();
+  if (!filter_bits_reader) {
     return true;
-  } else {
-    return false;
   }
+  bool may_match = true;
+  ProbePdt(table()->get_rep()->ioptions, 1, [&]() {
+    may_match = filter_bits_reader->RangeMayMatch(lower_bound, upper_bound);
+  });
+  return may_match;
 }
 
 
 
+
 // ==============
 
 
 
 
 FullFilterBlockReader::FullFilterBlockReader(
-    const BlockBasedTable* t, CachableEntry<BlockContents>&& filter_block)
+    const BlockBasedTable* t, CachableEntry<ParsedFullFilterBlock>&& filter_block)
     : FilterBlockReaderCommon(t, std::move(filter_block)) {
   const SliceTransform* const prefix_extractor = table_prefix_extractor();
   if (prefix_extractor) {
@@ -434,7 +463,7 @@ std::unique_ptr<FilterBlockReader> FullFilterBlockReader::Create(
   assert(table->get_rep());
   assert(!pin || prefetch);
 
-  CachableEntry<BlockContents> filter_block;
+  CachableEntry<ParsedFullFilterBlock> filter_block;
   if (prefetch || !use_cache) {
     const Status s = ReadFilterBlock(table, prefetch_buffer, ReadOptions(),
                                      use_cache, nullptr /* get_context */,
@@ -467,7 +496,7 @@ bool FullFilterBlockReader::PrefixMayMatch(
 bool FullFilterBlockReader::MayMatch(
     const Slice& entry, bool no_io, GetContext* get_context,
     BlockCacheLookupContext* lookup_context) const {
-  CachableEntry<BlockContents> filter_block;
+  CachableEntry<ParsedFullFilterBlock> filter_block;
 
   const Status s =
       GetOrReadFilterBlock(no_io, get_context, lookup_context, &filter_block);
@@ -477,16 +506,22 @@ bool FullFilterBlockReader::MayMatch(
 
   assert(filter_block.GetValue());
 
-  if (filter_block.GetValue()->data.size() != 0) {
-    assert(table());
-    assert(table()->get_rep());
-
-    std::unique_ptr<FilterBitsReader> filter_bits_reader(
-        table()->get_rep()->filter_policy->GetFilterBitsReader(
-            filter_block.GetValue()->data));
-    assert(filter_bits_reader != nullptr);
+  // The bits reader is parsed once with the block and lives as long as the
+  // block stays in the block cache (or pinned by this reader).
+  FilterBitsReader* const filter_bits_reader =
+      filter_block.GetValue()->filter_bits_reader();
 
-    if (filter_bits_reader->MayMatch(entry)) {
+  if (filter_bits_reader) {
+    bool may_match = true;
+    const auto probe = [&]() {
+      may_match = filter_bits_reader->MayMatch(entry);
+    };
+    if (table()->get_rep()->pdt_filter) {
+      ProbePdt(table()->get_rep()->ioptions, 1, probe);
+    } else {
+      probe();
+    }
+    if (may_match) {
       PERF_COUNTER_ADD(bloom_sst_hit_count, 1);
       return true;
     } else {
@@ -529,7 +564,7 @@ void FullFilterBlockReader::PrefixesMayMatch(
 void FullFilterBlockReader::MayMatch(
     MultiGetRange* range, bool no_io,
     BlockCacheLookupContext* lookup_context) const {
-  CachableEntry<BlockContents> filter_block;
+  CachableEntry<ParsedFullFilterBlock> filter_block;
 
   const Status s = GetOrReadFilterBlock(no_io, range->begin()->get_context,
                                         lookup_context, &filter_block);
@@ -539,18 +574,13 @@ void FullFilterBlockReader::MayMatch(
 
   assert(filter_block.GetValue());
 
-  if (filter_block.GetValue()->data.size() == 0) {
+  FilterBitsReader* const filter_bits_reader =
+      filter_block.GetValue()->filter_bits_reader();
+
+  if (!filter_bits_reader) {
     return;
   }
 
-  assert(table());
-  assert(table()->get_rep());
-
-  std::unique_ptr<FilterBitsReader> filter_bits_reader(
-      table()->get_rep()->filter_policy->GetFilterBitsReader(
-          filter_block.GetValue()->data));
-  assert(filter_bits_reader != nullptr);
-
   // We need to use an array instead of autovector for may_match since
   // &may_match[0] doesn't work for autovector<bool> (compiler error). So
   // declare both keys and may_match as arrays, which is also slightly less
@@ -561,7 +591,14 @@ void FullFilterBlockReader::MayMatch(
   for (auto iter = range->begin(); iter != range->end(); ++iter) {
     keys[num_keys++] = &iter->ukey;
   }
-  filter_bits_reader->MayMatch(num_keys, &keys[0], &may_match[0]);
+  const auto probe = [&]() {
+    filter_bits_reader->MayMatch(num_keys, &keys[0], &may_match[0]);
+  };
+  if (table()->get_rep()->pdt_filter) {
+    ProbePdt(table()->get_rep()->ioptions, num_keys, probe);
+  } else {
+    probe();
+  }
 
   int i = 0;
   for (auto iter = range->begin(); iter != range->end(); ++iter) {
@@ -604,6 +641,41 @@ bool FullFilterBlockReader::RangeMayExist(
   }
 }
 
+bool FullFilterBlockReader::KeyRangeMayMatch(
+    const Slice& lower_bound, const Slice& upper_bound,
+    const Slice* const /*const_ikey_ptr*/, bool no_io,
+    BlockCacheLookupContext* lookup_context) {
+  // A filter on prefixes only can't tell whether keys of the range exist
+  if (!whole_key_filtering()) {
+    return true;
+  }
+  CachableEntry<ParsedFullFilterBlock> filter_block;
+
+  const Status s = GetOrReadFilterBlock(no_io, nullptr /* get_context */,
+                                        lookup_context, &filter_block);
+  if (!s.ok()) {
+    return true;
+  }
+
+  assert(filter_block.GetValue());
+
+  FilterBitsReader* const filter_bits_reader =
+      filter_block.GetValue()->filter_bits_reader();
+  if (!filter_bits_reader) {
+    return true;
+  }
+  bool may_match = true;
+  const auto probe = [&]() {
+    may_match = filter_bits_reader->RangeMayMatch(lower_bound, upper_bound);
+  };
+  if (table()->get_rep()->pdt_filter) {
+    ProbePdt(table()->get_rep()->ioptions, 1, probe);
+  } else {
+    probe();
+  }
+  return may_match;
+}
+
 bool FullFilterBlockReader::IsFilterCompatible(
     const Slice* iterate_upper_bound, const Slice& prefix,
     const Comparator* comparator) const {
@@ -120,9 +120,21 @@ class OtLexPdtFilterBlockReader
                       GetContext* get_context,
                       BlockCacheLookupContext* lookup_context) override;
 
+  void PrefixesMayMatch(MultiGetRange* range,
+                        const SliceTransform* prefix_extractor,
+                        uint64_t block_offset, const bool no_io,
+                        BlockCacheLookupContext* lookup_context) override;
+
   size_t ApproximateMemoryUsage() const override;
 
-  //TODO
+  bool KeyRangeMayMatch(const Slice& lower_bound, const Slice& upper_bound,
+                        const Slice* const const_ikey_ptr, bool no_io,
+                        BlockCacheLookupContext* lookup_context) override;
+
+  // The trie keeps whole keys, so the prefix of any extractor can be looked
+  // up, even one the table was not built with.
+  bool PrefixExtractorIndependent() const override { return true; }
+
   bool RangeMayExist(const Slice* iterate_upper_bound, const Slice& user_key,
                      const SliceTransform* prefix_extractor,
                      const Comparator* comparator,
@@ -131,19 +143,15 @@ class OtLexPdtFilterBlockReader
                      BlockCacheLookupContext* lookup_context) override;
 
 // private:
-  bool MayMatch(const Slice& entry, bool no_io, GetContext* get_context,
+  // Whole key lookup of `entry`, or whether some key starts with `entry` if
+  // `is_prefix`.
+  bool MayMatch(const Slice& entry, bool is_prefix, bool no_io,
+                GetContext* get_context,
                 BlockCacheLookupContext* lookup_context) const;
   //TODO
   void MayMatch(MultiGetRange* range, bool no_io,
                 const SliceTransform* prefix_extractor,
                 BlockCacheLookupContext* lookup_context) const;
-
-  bool IsFilterCompatible(const Slice* iterate_upper_bound, const Slice& prefix,
-                          const Comparator* comparator) const;
-
-// private:
-  bool full_length_enabled_;
-  size_t prefix_extractor_full_length_;
 };
 
 
@@ -201,10 +209,11 @@ class FullFilterBlockBuilder : public FilterBlockBuilder {
 
 // A FilterBlockReader is used to parse filter from SST table.
 // KeyMayMatch and PrefixMayMatch would trigger filter checking
-class FullFilterBlockReader : public FilterBlockReaderCommon<BlockContents> {
+class FullFilterBlockReader
+    : public FilterBlockReaderCommon<ParsedFullFilterBlock> {
  public:
   FullFilterBlockReader(const BlockBasedTable* t,
-                        CachableEntry<BlockContents>&& filter_block);
+                        CachableEntry<ParsedFullFilterBlock>&& filter_block);
 
   static std::unique_ptr<FilterBlockReader> Create(
       const BlockBasedTable* table, FilePrefetchBuffer* prefetch_buffer,
@@ -234,6 +243,9 @@ class FullFilterBlockReader : public FilterBlockReaderCommon<BlockContents> {
                         const SliceTransform* prefix_extractor,
                         uint64_t block_offset, const bool no_io,
                         BlockCacheLookupContext* lookup_context) override;
+  bool KeyRangeMayMatch(const Slice& lower_bound, const Slice& upper_bound,
+                        const Slice* const const_ikey_ptr, bool no_io,
+                        BlockCacheLookupContext* lookup_context) override;
   size_t ApproximateMemoryUsage() const override;
   bool RangeMayExist(const Slice* iterate_upper_bound, const Slice& user_key,
                      const SliceTransform* prefix_extractor,
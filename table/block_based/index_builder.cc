@@ -18,6 +18,7 @@
 #include "rocksdb/comparator.h"
 #include "rocksdb/flush_block_policy.h"
 #include "table/block_based/partitioned_filter_block.h"
+#include "table/block_based/pdt_index_block.h"
 #include "table/format.h"
 
 // Without anonymous namespace here, we fail the warning -Wmissing-prototypes
@@ -54,6 +55,10 @@ IndexBuilder* IndexBuilder::CreateIndexBuilder(
           table_opt.format_version, use_value_delta_encoding,
           table_opt.index_shortening, /* include_first_key */ true);
     } break;
+    case BlockBasedTableOptions::kPdtSearch: {
+      result = new PdtIndexBuilder(comparator, table_opt.format_version,
+                                   table_opt.index_shortening);
+    } break;
     default: {
       assert(!"Do not recognize the index type ");
     } break;
@@ -61,6 +66,17 @@ IndexBuilder* IndexBuilder::CreateIndexBuilder(
   return result;
 }
 
+Status PdtIndexBuilder::Finish(
+    IndexBlocks* index_blocks,
+    const BlockHandle& /*last_partition_block_handle*/) {
+  index_block_.clear();
+  BuildPdtIndexBlock(separators_, handles_, seperator_is_key_plus_seq_,
+                     &index_block_);
+  index_blocks->index_block_contents = index_block_;
+  index_size_ = index_block_.size();
+  return Status::OK();
+}
+
 PartitionedIndexBuilder* PartitionedIndexBuilder::CreateIndexBuilder(
     const InternalKeyComparator* comparator,
     const bool use_value_delta_encoding,
@@ -15,6 +15,7 @@
 #include <list>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "rocksdb/comparator.h"
 #include "table/block_based/block_based_table_factory.h"
@@ -352,6 +353,65 @@ class HashIndexBuilder : public IndexBuilder {
   uint64_t current_restart_index_ = 0;
 };
 
+// PdtIndexBuilder keeps the separators in a path-decomposed trie and the
+// block handles in an Elias-Fano sequence, see pdt_index_block.h for the
+// format. The separators are shortened like in ShortenedIndexBuilder and
+// kept until Finish(), when it is known whether they need the sequence
+// number.
+class PdtIndexBuilder : public IndexBuilder {
+ public:
+  explicit PdtIndexBuilder(
+      const InternalKeyComparator* comparator, const uint32_t format_version,
+      BlockBasedTableOptions::IndexShorteningMode shortening_mode)
+      : IndexBuilder(comparator), shortening_mode_(shortening_mode) {
+    // Making the default true will disable the feature for old versions
+    seperator_is_key_plus_seq_ = (format_version <= 2);
+  }
+
+  virtual void AddIndexEntry(std::string* last_key_in_current_block,
+                             const Slice* first_key_in_next_block,
+                             const BlockHandle& block_handle) override {
+    if (first_key_in_next_block != nullptr) {
+      if (shortening_mode_ !=
+          BlockBasedTableOptions::IndexShorteningMode::kNoShortening) {
+        comparator_->FindShortestSeparator(last_key_in_current_block,
+                                           *first_key_in_next_block);
+      }
+      if (!seperator_is_key_plus_seq_ &&
+          comparator_->user_comparator()->Compare(
+              ExtractUserKey(*last_key_in_current_block),
+              ExtractUserKey(*first_key_in_next_block)) == 0) {
+        seperator_is_key_plus_seq_ = true;
+      }
+    } else {
+      if (shortening_mode_ == BlockBasedTableOptions::IndexShorteningMode::
+                                  kShortenSeparatorsAndSuccessor) {
+        comparator_->FindShortSuccessor(last_key_in_current_block);
+      }
+    }
+    separators_.push_back(*last_key_in_current_block);
+    handles_.push_back(block_handle);
+  }
+
+  using IndexBuilder::Finish;
+  virtual Status Finish(
+      IndexBlocks* index_blocks,
+      const BlockHandle& last_partition_block_handle) override;
+
+  virtual size_t IndexSize() const override { return index_size_; }
+
+  virtual bool seperator_is_key_plus_seq() override {
+    return seperator_is_key_plus_seq_;
+  }
+
+ private:
+  BlockBasedTableOptions::IndexShorteningMode shortening_mode_;
+  bool seperator_is_key_plus_seq_;
+  std::vector<std::string> separators_;
+  std::vector<BlockHandle> handles_;
+  std::string index_block_;
+};
+
 /**
  * IndexBuilder for two-level indexing. Internally it creates a new index for
  * each partition and Finish then in order when Finish is called on it
@@ -0,0 +1,278 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "table/block_based/key_locator_block.h"
+
+#include <sstream>
+
+#include <boost/range/counting_range.hpp>
+
+#include "db/dbformat.h"
+#include "port/port.h"
+#include "util/coding.h"
+
+#include "mapper.hpp"
+
+namespace rocksdb {
+namespace {
+// The trie takes null-terminated strings, so 0x00 and 0x01 are escaped as
+// 0x01 0x01 and 0x01 0x02. The escaping keeps the order of the keys, so the
+// rank of an escaped key is the rank of the key.
+void EscapeKey(const Slice& key, std::string* dst) {
+  for (size_t i = 0; i < key.size(); i++) {
+    const char c = key[i];
+    if (c == '\0' || c == '\x01') {
+      dst->push_back('\x01');
+      dst->push_back(static_cast<char>(c + 1));
+    } else {
+      dst->push_back(c);
+    }
+  }
+}
+
+// Gives the trie builder the i-th key of the builder buffer.
+struct BufferedKeyAdaptor {
+  BufferedKeyAdaptor(const std::string& keys,
+                     const std::vector<size_t>& offsets)
+      : keys_(keys), offsets_(offsets) {}
+
+  succinct::tries::char_range operator()(size_t i) const {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(keys_.data());
+    return succinct::tries::char_range(data + offsets_[i],
+                                       data + offsets_[i + 1]);
+  }
+
+  const std::string& keys_;
+  const std::vector<size_t>& offsets_;
+};
+
+template <typename T>
+void AppendFrozen(T& value, std::string* dst) {
+  std::ostringstream frozen;
+  succinct::mapper::freeze(value, frozen);
+  dst->append(frozen.str());
+  dst->append((8 - dst->size() % 8) % 8, '\0');
+}
+}  // namespace
+
+void KeyLocatorBuilder::OnKeyAdded(const Slice& ikey) {
+  if (spans_blocks_) {
+    return;
+  }
+  const Slice user_key = ExtractUserKey(ikey);
+  const bool first_in_block = block_ranks_.size() == handles_.size();
+  if (!key_offsets_.empty() && user_key == Slice(last_user_key_)) {
+    if (first_in_block) {
+      // An older version of the last key of the previous block.
+      spans_blocks_ = true;
+      std::string().swap(keys_);
+      std::vector<size_t>().swap(key_offsets_);
+    }
+    return;
+  }
+  if (first_in_block) {
+    block_ranks_.push_back(key_offsets_.size());
+  }
+  key_offsets_.push_back(keys_.size());
+  EscapeKey(user_key, &keys_);
+  keys_.push_back('\0');
+  last_user_key_.assign(user_key.data(), user_key.size());
+}
+
+void KeyLocatorBuilder::AddBlock(const BlockHandle& handle) {
+  handles_.push_back(handle);
+  assert(spans_blocks_ || block_ranks_.size() == handles_.size());
+}
+
+bool KeyLocatorBuilder::Finish(std::string* dst) {
+  const size_t num_keys = key_offsets_.size();
+  const size_t num_blocks = handles_.size();
+  if (spans_blocks_ || num_keys == 0 || num_keys > port::kMaxUint32 ||
+      block_ranks_.size() != num_blocks) {
+    return false;
+  }
+  key_offsets_.push_back(keys_.size());
+
+  std::string trie_data;
+  {
+    succinct::tries::centroid_hollow_trie trie(
+        boost::counting_range(size_t(0), num_keys),
+        BufferedKeyAdaptor(keys_, key_offsets_));
+    AppendFrozen(trie, &trie_data);
+  }
+  std::string().swap(keys_);
+  std::vector<size_t>().swap(key_offsets_);
+
+  // The ranks are ascending and distinct since every block starts with a new
+  // user key.
+  succinct::elias_fano::elias_fano_builder ranks_builder(num_keys, num_blocks);
+  for (uint64_t rank : block_ranks_) {
+    ranks_builder.push_back(rank);
+  }
+  succinct::elias_fano ranks(&ranks_builder, /* with_rank_index */ true);
+  std::string ranks_data;
+  AppendFrozen(ranks, &ranks_data);
+
+  const uint64_t universe = handles_.back().offset() + handles_.back().size();
+  succinct::elias_fano::elias_fano_builder offsets(universe, 2 * num_blocks);
+  for (const auto& handle : handles_) {
+    offsets.push_back(handle.offset());
+    offsets.push_back(handle.offset() + handle.size());
+  }
+  succinct::elias_fano handles(&offsets, /* with_rank_index */ false);
+  std::string handles_data;
+  AppendFrozen(handles, &handles_data);
+
+  const size_t init_size = dst->size();
+  PutVarint32(dst, static_cast<uint32_t>(num_keys));
+  PutVarint32(dst, static_cast<uint32_t>(num_blocks));
+  PutVarint64(dst, trie_data.size());
+  PutVarint64(dst, ranks_data.size());
+  PutVarint64(dst, handles_data.size());
+  dst->append((8 - (dst->size() - init_size) % 8) % 8, '\0');
+  dst->append(trie_data);
+  dst->append(ranks_data);
+  dst->append(handles_data);
+  return true;
+}
+
+namespace {
+// Holds the only block a key can be in, see
+// ParsedKeyLocatorBlock::NewIterator.
+class KeyLocatorIter : public InternalIteratorBase<IndexValue> {
+ public:
+  KeyLocatorIter(const BlockHandle& handle, bool located)
+      : handle_(handle), located_(located), valid_(located) {}
+
+  bool Valid() const override { return valid_; }
+
+  void SeekToFirst() override { valid_ = located_; }
+
+  void SeekToLast() override { valid_ = located_; }
+
+  void Seek(const Slice&) override { valid_ = located_; }
+
+  void SeekForPrev(const Slice&) override {
+    assert(false);
+    valid_ = false;
+    status_ = Status::InvalidArgument(
+        "RocksDB internal error: should never call SeekForPrev() on index "
+        "blocks");
+  }
+
+  void Next() override {
+    assert(Valid());
+    valid_ = false;
+  }
+
+  void Prev() override {
+    assert(Valid());
+    valid_ = false;
+  }
+
+  Slice key() const override {
+    assert(false);
+    return Slice();
+  }
+
+  IndexValue value() const override {
+    assert(Valid());
+    return IndexValue(handle_, Slice());
+  }
+
+  Status status() const override { return status_; }
+
+ private:
+  const BlockHandle handle_;
+  const bool located_;
+  bool valid_;
+  Status status_;
+};
+}  // namespace
+
+ParsedKeyLocatorBlock::ParsedKeyLocatorBlock(BlockContents&& contents)
+    : contents_(std::move(contents)) {
+  Slice input = contents_.data;
+  uint32_t num_keys = 0;
+  uint32_t num_blocks = 0;
+  uint64_t trie_size = 0;
+  uint64_t ranks_size = 0;
+  uint64_t handles_size = 0;
+  if (!GetVarint32(&input, &num_keys) || !GetVarint32(&input, &num_blocks) ||
+      !GetVarint64(&input, &trie_size) || !GetVarint64(&input, &ranks_size) ||
+      !GetVarint64(&input, &handles_size)) {
+    return;
+  }
+  const size_t header_size = contents_.data.size() - input.size();
+  const size_t padding = (8 - header_size % 8) % 8;
+  if (num_keys == 0 || num_blocks == 0 || padding > input.size() ||
+      trie_size > input.size() - padding ||
+      ranks_size > input.size() - padding - trie_size ||
+      handles_size != input.size() - padding - trie_size - ranks_size) {
+    return;
+  }
+  input.remove_prefix(padding);
+  const char* data = input.data();
+  if (reinterpret_cast<uintptr_t>(data) % sizeof(uint64_t) != 0) {
+    aligned_.reset(new uint64_t[(input.size() + 7) / 8]);
+    memcpy(aligned_.get(), data, input.size());
+    data = reinterpret_cast<const char*>(aligned_.get());
+  }
+  if (succinct::mapper::map(trie_, data) > trie_size ||
+      succinct::mapper::map(ranks_, data + trie_size) > ranks_size ||
+      succinct::mapper::map(handles_, data + trie_size + ranks_size) >
+          handles_size) {
+    return;
+  }
+  if (ranks_.num_ones() != num_blocks || ranks_.size() != num_keys ||
+      handles_.num_ones() != 2 * static_cast<uint64_t>(num_blocks)) {
+    return;
+  }
+  num_keys_ = num_keys;
+  num_blocks_ = num_blocks;
+  ok_ = true;
+}
+
+ParsedKeyLocatorBlock::~ParsedKeyLocatorBlock() {}
+
+bool ParsedKeyLocatorBlock::Locate(const Slice& user_key,
+                                   BlockHandle* handle) const {
+  assert(ok_);
+  std::string escaped;
+  escaped.reserve(user_key.size() + 1);
+  EscapeKey(user_key, &escaped);
+  const size_t rank = trie_.index(escaped);
+  if (rank >= num_keys_) {
+    return false;
+  }
+  // The block holding the key is the last one starting at or before it.
+  const uint64_t block = ranks_.rank(rank + 1) - 1;
+  assert(block < num_blocks_);
+  std::pair<uint64_t, uint64_t> range = handles_.select_range(2 * block);
+  *handle = BlockHandle(range.first, range.second - range.first);
+  return true;
+}
+
+InternalIteratorBase<IndexValue>* ParsedKeyLocatorBlock::NewIterator(
+    const Slice& user_key) const {
+  BlockHandle handle;
+  const bool located = Locate(user_key, &handle);
+  return new KeyLocatorIter(handle, located);
+}
+
+size_t ParsedKeyLocatorBlock::ApproximateMemoryUsage() const {
+  size_t usage = contents_.ApproximateMemoryUsage();
+  if (aligned_ != nullptr) {
+    usage += contents_.data.size();
+  }
+#ifdef ROCKSDB_MALLOC_USABLE_SIZE
+  usage += malloc_usable_size((void*)this);
+#else
+  usage += sizeof(*this);
+#endif  // ROCKSDB_MALLOC_USABLE_SIZE
+  return usage;
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,122 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rocksdb/slice.h"
+#include "table/format.h"
+#include "table/internal_iterator.h"
+
+#include "elias_fano.hpp"
+#include "tries/centroid_hollow_trie.hpp"
+
+namespace rocksdb {
+// Key locator meta block of BlockBasedTableOptions::key_locator. It maps a
+// user key of the table to the data block holding it without going through
+// the index: a hollow trie over the (distinct, ascending) user keys is a
+// monotone minimal perfect hash, so the i-th smallest key is hashed to i in
+// a few bits per key. The rank of the first key of every block and the
+// block handles are kept in Elias-Fano sequences:
+//
+// +-------------------------------------------------------------+
+// | varint32 number of keys | varint32 number of blocks         |
+// | varint64 trie size | varint64 ranks size                    |
+// | varint64 handles size                                       |
+// | padding to 8 bytes                                          |
+// +-------------------------------------------------------------+
+// | trie: frozen centroid_hollow_trie, padded to 8 bytes        |
+// +-------------------------------------------------------------+
+// | ranks: frozen elias_fano of the rank of the first key of    |
+// |   every block, padded to 8 bytes                            |
+// +-------------------------------------------------------------+
+// | handles: frozen elias_fano of                               |
+// |   offset(0), offset(0) + size(0), offset(1), ...            |
+// +-------------------------------------------------------------+
+//
+// A key that is not in the table is hashed to some arbitrary block (or to
+// none), so the locator only makes sense behind a filter. The versions of a
+// user key must not span blocks, the block is then all a point lookup has
+// to read. Tables where they do have no locator.
+//
+// Only bytewise user comparators are supported.
+
+// Collects the keys of a table as the data blocks are cut.
+class KeyLocatorBuilder {
+ public:
+  KeyLocatorBuilder() {}
+
+  // No copying allowed
+  KeyLocatorBuilder(const KeyLocatorBuilder&) = delete;
+  void operator=(const KeyLocatorBuilder&) = delete;
+
+  // Called with every internal key added to the current data block, in
+  // order.
+  void OnKeyAdded(const Slice& ikey);
+
+  // Called once the data block of the keys added so far is written.
+  void AddBlock(const BlockHandle& handle);
+
+  // Append the locator block to `dst`. Returns false, leaving `dst` as is,
+  // if the table can't have a locator.
+  bool Finish(std::string* dst);
+
+ private:
+  // Escaped, null-terminated user keys, one after the other.
+  std::string keys_;
+  std::vector<size_t> key_offsets_;
+  std::string last_user_key_;
+  // Rank of the first key of every block, and the block handles.
+  std::vector<uint64_t> block_ranks_;
+  std::vector<BlockHandle> handles_;
+  // True if the versions of a user key span blocks.
+  bool spans_blocks_ = false;
+};
+
+// Maps the structures of the locator from the block contents, nothing is
+// decoded.
+class ParsedKeyLocatorBlock {
+ public:
+  explicit ParsedKeyLocatorBlock(BlockContents&& contents);
+  ~ParsedKeyLocatorBlock();
+
+  // No copying allowed
+  ParsedKeyLocatorBlock(const ParsedKeyLocatorBlock&) = delete;
+  void operator=(const ParsedKeyLocatorBlock&) = delete;
+
+  // False if the block could not be decoded.
+  bool ok() const { return ok_; }
+
+  size_t num_keys() const { return num_keys_; }
+
+  size_t num_blocks() const { return num_blocks_; }
+
+  // Handle of the data block holding `user_key` if the key is in the table.
+  // Returns false if the key is hashed to no block, i.e. is not in the
+  // table.
+  bool Locate(const Slice& user_key, BlockHandle* handle) const;
+
+  // Returns a new index iterator holding at most one entry, the block
+  // `user_key` is hashed to. Seek() keeps the iterator on that entry.
+  InternalIteratorBase<IndexValue>* NewIterator(const Slice& user_key) const;
+
+  size_t ApproximateMemoryUsage() const;
+
+ private:
+  BlockContents contents_;
+  // Copy of the contents if they are not 8 bytes aligned.
+  std::unique_ptr<uint64_t[]> aligned_;
+  bool ok_ = false;
+  size_t num_keys_ = 0;
+  size_t num_blocks_ = 0;
+  succinct::tries::centroid_hollow_trie trie_;
+  succinct::elias_fano ranks_;
+  succinct::elias_fano handles_;
+};
+
+}  // namespace rocksdb
@@ -181,6 +181,66 @@ bool PartitionedFilterBlockReader::PrefixMayMatch(
                   &FullFilterBlockReader::PrefixMayMatch);
 }
 
+bool PartitionedFilterBlockReader::KeyRangeMayMatch(
+    const Slice& lower_bound, const Slice& upper_bound,
+    const Slice* const const_ikey_ptr, bool no_io,
+    BlockCacheLookupContext* lookup_context) {
+  if (!whole_key_filtering()) {
+    return true;
+  }
+
+  CachableEntry<Block> filter_block;
+  Status s = GetOrReadFilterBlock(no_io, nullptr /* get_context */,
+                                  lookup_context, &filter_block);
+  if (UNLIKELY(!s.ok())) {
+    return true;
+  }
+
+  if (UNLIKELY(filter_block.GetValue()->size() == 0)) {
+    return true;
+  }
+
+  IndexBlockIter iter;
+  const InternalKeyComparator* const comparator = internal_comparator();
+  Statistics* kNullStats = nullptr;
+  filter_block.GetValue()->NewIndexIterator(
+      comparator, comparator->user_comparator(), &iter, kNullStats,
+      true /* total_order_seek */, false /* have_first_key */,
+      index_key_includes_seq(), index_value_is_full());
+  if (const_ikey_ptr != nullptr) {
+    iter.Seek(*const_ikey_ptr);
+  } else {
+    iter.SeekToFirst();
+  }
+  // Visit partitions until one whose keys reach `upper_bound`. Every key of
+  // a partition is no greater than its separator, and every key of the next
+  // partitions is greater.
+  for (; iter.Valid(); iter.Next()) {
+    CachableEntry<ParsedFullFilterBlock> filter_partition_block;
+    s = GetFilterPartitionBlock(nullptr /* prefetch_buffer */,
+                                iter.value().handle, no_io,
+                                nullptr /* get_context */, lookup_context,
+                                &filter_partition_block);
+    if (UNLIKELY(!s.ok())) {
+      return true;
+    }
+
+    FullFilterBlockReader filter_partition(table(),
+                                           std::move(filter_partition_block));
+    if (filter_partition.KeyRangeMayMatch(lower_bound, upper_bound,
+                                          const_ikey_ptr, no_io,
+                                          lookup_context)) {
+      return true;
+    }
+    const Slice separator =
+        index_key_includes_seq() ? ExtractUserKey(iter.key()) : iter.key();
+    if (separator.compare(upper_bound) >= 0) {
+      break;
+    }
+  }
+  return false;
+}
+
 BlockHandle PartitionedFilterBlockReader::GetFilterPartitionHandle(
     const CachableEntry<Block>& filter_block, const Slice& entry) const {
   IndexBlockIter iter;
@@ -208,7 +268,7 @@ Status PartitionedFilterBlockReader::GetFilterPartitionBlock(
     FilePrefetchBuffer* prefetch_buffer, const BlockHandle& fltr_blk_handle,
     bool no_io, GetContext* get_context,
     BlockCacheLookupContext* lookup_context,
-    CachableEntry<BlockContents>* filter_block) const {
+    CachableEntry<ParsedFullFilterBlock>* filter_block) const {
   assert(table());
   assert(filter_block);
   assert(filter_block->IsEmpty());
@@ -258,7 +318,7 @@ bool PartitionedFilterBlockReader::MayMatch(
     return false;
   }
 
-  CachableEntry<BlockContents> filter_partition_block;
+  CachableEntry<ParsedFullFilterBlock> filter_partition_block;
   s = GetFilterPartitionBlock(nullptr /* prefetch_buffer */, filter_handle,
                               no_io, get_context, lookup_context,
                               &filter_partition_block);
@@ -337,7 +397,7 @@ void PartitionedFilterBlockReader::CacheDependencies(bool pin) {
   for (biter.SeekToFirst(); biter.Valid(); biter.Next()) {
     handle = biter.value().handle;
 
-    CachableEntry<BlockContents> block;
+    CachableEntry<ParsedFullFilterBlock> block;
     // TODO: Support counter batch update for partitioned index and
     // filter blocks
     s = table()->MaybeReadBlockAndLoadToCache(
@@ -90,6 +90,10 @@ class PartitionedFilterBlockReader : public FilterBlockReaderCommon<Block> {
                       GetContext* get_context,
                       BlockCacheLookupContext* lookup_context) override;
 
+  bool KeyRangeMayMatch(const Slice& lower_bound, const Slice& upper_bound,
+                        const Slice* const const_ikey_ptr, bool no_io,
+                        BlockCacheLookupContext* lookup_context) override;
+
   size_t ApproximateMemoryUsage() const override;
 
  private:
@@ -99,7 +103,7 @@ class PartitionedFilterBlockReader : public FilterBlockReaderCommon<Block> {
       FilePrefetchBuffer* prefetch_buffer, const BlockHandle& handle,
       bool no_io, GetContext* get_context,
       BlockCacheLookupContext* lookup_context,
-      CachableEntry<BlockContents>* filter_block) const;
+      CachableEntry<ParsedFullFilterBlock>* filter_block) const;
 
   using FilterFunction = bool (FullFilterBlockReader::*)(
       const Slice& slice, const SliceTransform* prefix_extractor,
@@ -118,7 +122,8 @@ class PartitionedFilterBlockReader : public FilterBlockReaderCommon<Block> {
   bool index_value_is_full() const;
 
  protected:
-  std::unordered_map<uint64_t, CachableEntry<BlockContents>> filter_map_;
+  std::unordered_map<uint64_t, CachableEntry<ParsedFullFilterBlock>>
+      filter_map_;
 };
 
 }  // namespace rocksdb
@@ -41,9 +41,10 @@ class MyPartitionedFilterBlockReader : public PartitionedFilterBlockReader {
       const uint64_t offset = pair.first;
       const Slice& slice = pair.second;
 
-      CachableEntry<BlockContents> block(
-          new BlockContents(slice), nullptr /* cache */,
-          nullptr /* cache_handle */, true /* own_value */);
+      CachableEntry<ParsedFullFilterBlock> block(
+          new ParsedFullFilterBlock(t->get_rep()->filter_policy,
+                                    BlockContents(slice)),
+          nullptr /* cache */, nullptr /* cache_handle */, true /* own_value */);
       filter_map_[offset] = std::move(block);
     }
   }
@@ -376,6 +377,18 @@ TEST_P(PartitionedFilterBlockTest, PartitionCount) {
   ASSERT_EQ(partitions, num_keys - 1 /* last two keys make one flush */);
 }
 
+// Every partition is a separate trie cut along the index partitions.
+TEST_P(PartitionedFilterBlockTest, PdtPartitions) {
+  table_options_.filter_policy.reset(NewLexPdtFilterPolicy(false));
+  int num_keys = sizeof(keys) / sizeof(*keys);
+  table_options_.metadata_block_size = 1;
+  ASSERT_EQ(TestBlockPerKey(), num_keys - 1 /* last two keys make one flush */);
+  table_options_.metadata_block_size = 4096;
+  ASSERT_EQ(TestBlockPerKey(), 1);
+  TestBlockPerTwoKeys();
+  TestBlockPerAllKeys();
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
@@ -0,0 +1,280 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "table/block_based/pdt_index_block.h"
+
+#include <sstream>
+
+#include "db/dbformat.h"
+#include "port/port.h"
+#include "util/coding.h"
+#include "util/pdt.h"
+
+#include "mapper.hpp"
+
+namespace rocksdb {
+
+void EncodePdtIndexKey(const Slice& ikey, std::string* dst) {
+  const Slice user_key = ExtractUserKey(ikey);
+  for (size_t i = 0; i < user_key.size(); i++) {
+    dst->push_back(user_key[i]);
+    if (user_key[i] == '\0') {
+      dst->push_back('\xff');
+    }
+  }
+  dst->append(2, '\0');
+  const uint64_t packed = ~ExtractInternalKeyFooter(ikey);
+  for (int shift = 56; shift >= 0; shift -= 8) {
+    dst->push_back(static_cast<char>(packed >> shift));
+  }
+}
+
+bool DecodePdtIndexKey(const Slice& encoded, std::string* dst) {
+  size_t i = 0;
+  while (true) {
+    if (i + 1 >= encoded.size()) {
+      return false;
+    }
+    const char c = encoded[i++];
+    if (c != '\0') {
+      dst->push_back(c);
+      continue;
+    }
+    const char escaped = encoded[i++];
+    if (escaped == '\0') {
+      break;
+    }
+    if (escaped != '\xff') {
+      return false;
+    }
+    dst->push_back('\0');
+  }
+  if (encoded.size() - i != sizeof(uint64_t)) {
+    return false;
+  }
+  uint64_t packed = 0;
+  for (; i < encoded.size(); i++) {
+    packed = (packed << 8) | static_cast<uint8_t>(encoded[i]);
+  }
+  PutFixed64(dst, ~packed);
+  return true;
+}
+
+void BuildPdtIndexBlock(const std::vector<std::string>& separators,
+                        const std::vector<BlockHandle>& handles,
+                        bool key_includes_seq, std::string* dst) {
+  assert(separators.size() == handles.size());
+  const size_t num_entries = separators.size();
+
+  std::string trie;
+  if (num_entries > 0) {
+    std::vector<std::string> encoded;
+    std::vector<Slice> keys;
+    keys.reserve(num_entries);
+    if (key_includes_seq) {
+      encoded.resize(num_entries);
+      for (size_t i = 0; i < num_entries; i++) {
+        EncodePdtIndexKey(separators[i], &encoded[i]);
+        keys.emplace_back(encoded[i]);
+      }
+    } else {
+      for (const auto& separator : separators) {
+        keys.push_back(ExtractUserKey(separator));
+      }
+    }
+    BuildPdt<true>(&keys, &trie);
+    // Separators are ascending and distinct, so the i-th key of the trie
+    // is the separator of the i-th block.
+    assert(keys.size() == num_entries);
+    trie.append((8 - trie.size() % 8) % 8, '\0');
+  }
+
+  // Blocks are laid out in order, so begin and end offsets are ascending.
+  const uint64_t universe =
+      num_entries > 0 ? handles.back().offset() + handles.back().size() : 0;
+  succinct::elias_fano::elias_fano_builder offsets(universe, 2 * num_entries);
+  for (const auto& handle : handles) {
+    offsets.push_back(handle.offset());
+    offsets.push_back(handle.offset() + handle.size());
+  }
+  succinct::elias_fano ef(&offsets, /* with_rank_index */ false);
+  std::ostringstream frozen;
+  succinct::mapper::freeze(ef, frozen);
+  const std::string handles_data = frozen.str();
+
+  const size_t init_size = dst->size();
+  PutVarint32(dst, static_cast<uint32_t>(num_entries));
+  PutVarint64(dst, trie.size());
+  PutVarint64(dst, handles_data.size());
+  dst->append((8 - (dst->size() - init_size) % 8) % 8, '\0');
+  dst->append(trie);
+  dst->append(handles_data);
+}
+
+namespace {
+// Iterates over the index entries by their position in the trie. A key is
+// only rebuilt from the trie when it's asked for, most seeks only need the
+// block handle.
+class PdtIndexIter : public InternalIteratorBase<IndexValue> {
+ public:
+  PdtIndexIter(const ParsedPdtIndexBlock* block, bool key_includes_seq)
+      : block_(block),
+        key_includes_seq_(key_includes_seq),
+        current_(block->num_entries()),
+        key_pos_(port::kMaxSizet) {}
+
+  bool Valid() const override { return current_ < block_->num_entries(); }
+
+  void SeekToFirst() override { current_ = 0; }
+
+  void SeekToLast() override {
+    current_ = block_->num_entries() > 0 ? block_->num_entries() - 1 : 0;
+  }
+
+  void Seek(const Slice& target) override {
+    if (key_includes_seq_) {
+      seek_key_.clear();
+      EncodePdtIndexKey(target, &seek_key_);
+      current_ = block_->Seek(seek_key_);
+    } else {
+      current_ = block_->Seek(ExtractUserKey(target));
+    }
+  }
+
+  void SeekForPrev(const Slice&) override {
+    assert(false);
+    current_ = block_->num_entries();
+    status_ = Status::InvalidArgument(
+        "RocksDB internal error: should never call SeekForPrev() on index "
+        "blocks");
+  }
+
+  void Next() override {
+    assert(Valid());
+    current_++;
+  }
+
+  void Prev() override {
+    assert(Valid());
+    current_ = current_ > 0 ? current_ - 1 : block_->num_entries();
+  }
+
+  Slice key() const override {
+    assert(Valid());
+    if (key_pos_ != current_) {
+      key_.clear();
+      if (key_includes_seq_) {
+        encoded_key_.clear();
+        block_->GetKey(current_, &encoded_key_);
+        bool decoded = DecodePdtIndexKey(encoded_key_, &key_);
+        assert(decoded);
+        (void)decoded;
+      } else {
+        block_->GetKey(current_, &key_);
+      }
+      key_pos_ = current_;
+    }
+    return key_;
+  }
+
+  Slice user_key() const override {
+    return key_includes_seq_ ? ExtractUserKey(key()) : key();
+  }
+
+  IndexValue value() const override {
+    assert(Valid());
+    return IndexValue(block_->GetHandle(current_), Slice());
+  }
+
+  Status status() const override { return status_; }
+
+ private:
+  const ParsedPdtIndexBlock* block_;
+  const bool key_includes_seq_;
+  size_t current_;
+  Status status_;
+  std::string seek_key_;
+  // Key of the entry at `key_pos_`, rebuilt lazily.
+  mutable size_t key_pos_;
+  mutable std::string key_;
+  mutable std::string encoded_key_;
+};
+}  // namespace
+
+ParsedPdtIndexBlock::ParsedPdtIndexBlock(BlockContents&& contents)
+    : contents_(std::move(contents)) {
+  Slice input = contents_.data;
+  uint32_t num_entries = 0;
+  uint64_t trie_size = 0;
+  uint64_t handles_size = 0;
+  if (!GetVarint32(&input, &num_entries) || !GetVarint64(&input, &trie_size) ||
+      !GetVarint64(&input, &handles_size)) {
+    return;
+  }
+  const size_t header_size = contents_.data.size() - input.size();
+  const size_t padding = (8 - header_size % 8) % 8;
+  if (padding > input.size() || trie_size > input.size() - padding ||
+      handles_size != input.size() - padding - trie_size ||
+      handles_size < sizeof(uint64_t)) {
+    return;
+  }
+  input.remove_prefix(padding);
+  if (num_entries > 0) {
+    trie_.reset(MapPdt<true>(Slice(input.data(), trie_size)));
+    if (trie_ == nullptr || trie_->num_keys() != num_entries) {
+      return;
+    }
+  }
+  input.remove_prefix(trie_size);
+  if (succinct::mapper::map(handles_, input.data()) > handles_size ||
+      handles_.num_ones() != 2 * static_cast<uint64_t>(num_entries)) {
+    return;
+  }
+  num_entries_ = num_entries;
+  ok_ = true;
+}
+
+ParsedPdtIndexBlock::~ParsedPdtIndexBlock() {}
+
+size_t ParsedPdtIndexBlock::Seek(const Slice& key) const {
+  return trie_ != nullptr ? trie_->lower_bound(key) : num_entries_;
+}
+
+void ParsedPdtIndexBlock::GetKey(size_t i, std::string* key) const {
+  assert(i < num_entries_);
+  trie_->get_key(i, key);
+}
+
+BlockHandle ParsedPdtIndexBlock::GetHandle(size_t i) const {
+  assert(i < num_entries_);
+  std::pair<uint64_t, uint64_t> range = handles_.select_range(2 * i);
+  return BlockHandle(range.first, range.second - range.first);
+}
+
+InternalIteratorBase<IndexValue>* ParsedPdtIndexBlock::NewIterator(
+    bool key_includes_seq) const {
+  return new PdtIndexIter(this, key_includes_seq);
+}
+
+size_t ParsedPdtIndexBlock::ApproximateMemoryUsage() const {
+  size_t usage = contents_.ApproximateMemoryUsage();
+#ifdef ROCKSDB_MALLOC_USABLE_SIZE
+  usage += malloc_usable_size((void*)this);
+  if (trie_ != nullptr) {
+    usage += malloc_usable_size((void*)trie_.get());
+  }
+#else
+  usage += sizeof(*this);
+  if (trie_ != nullptr) {
+    usage += sizeof(*trie_);
+  }
+#endif  // ROCKSDB_MALLOC_USABLE_SIZE
+  if (trie_ != nullptr) {
+    usage += trie_->owned_bytes();
+  }
+  return usage;
+}
+
+}  // namespace rocksdb
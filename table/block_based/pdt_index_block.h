@@ -0,0 +1,102 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rocksdb/slice.h"
+#include "table/format.h"
+#include "table/internal_iterator.h"
+#include "utilities/pdt/path_decomposed_trie.h"
+
+#include "elias_fano.hpp"
+
+namespace rocksdb {
+// Index block of BlockBasedTableOptions::kPdtSearch. The separators are the
+// keys of a lexicographic path-decomposed trie, so the i-th smallest
+// separator is the i-th node of the trie and an index seek is a trie walk
+// (lower_bound). The handle of the i-th data block is kept at the same
+// position of an Elias-Fano sequence holding the begin and end offsets of
+// every block:
+//
+// +-------------------------------------------------------------+
+// | varint32 number of entries                                  |
+// | varint64 trie size | varint64 handles size                  |
+// | padding to 8 bytes                                          |
+// +-------------------------------------------------------------+
+// | trie, in the layout of pdt filters, padded to 8 bytes       |
+// +-------------------------------------------------------------+
+// | handles: frozen elias_fano of                               |
+// |   offset(0), offset(0) + size(0), offset(1), ...            |
+// +-------------------------------------------------------------+
+//
+// Separators are user keys. If two adjacent blocks share a user key the
+// sequence number is needed to tell them apart, then every separator is an
+// internal key encoded by `EncodePdtIndexKey`, whose bytewise order is the
+// order of InternalKeyComparator over a bytewise user comparator.
+//
+// Only bytewise user comparators are supported.
+
+// Encode the internal key `ikey` so that it can be ordered bytewise: the
+// user key with 0x00 escaped as 0x00 0xff and terminated by 0x00 0x00,
+// followed by the bitwise complement of the packed sequence and type in
+// big-endian.
+extern void EncodePdtIndexKey(const Slice& ikey, std::string* dst);
+
+// Inverse of `EncodePdtIndexKey`, appends the internal key to `dst`.
+extern bool DecodePdtIndexKey(const Slice& encoded, std::string* dst);
+
+// Append an index block over `separators` to `dst`. `separators` are
+// ascending internal keys with distinct user keys unless `key_includes_seq`,
+// `handles[i]` is the data block ending at `separators[i]`.
+extern void BuildPdtIndexBlock(const std::vector<std::string>& separators,
+                               const std::vector<BlockHandle>& handles,
+                               bool key_includes_seq, std::string* dst);
+
+// The sharable/cachable part of the pdt index. The trie and the handles are
+// mapped from the block contents, nothing is decoded upfront.
+class ParsedPdtIndexBlock {
+ public:
+  explicit ParsedPdtIndexBlock(BlockContents&& contents);
+  ~ParsedPdtIndexBlock();
+
+  // No copying allowed
+  ParsedPdtIndexBlock(const ParsedPdtIndexBlock&) = delete;
+  void operator=(const ParsedPdtIndexBlock&) = delete;
+
+  // False if the block could not be decoded.
+  bool ok() const { return ok_; }
+
+  size_t num_entries() const { return num_entries_; }
+
+  // Position of the first separator not less than `key`, `num_entries()` if
+  // there is none. `key` is a user key or an encoded internal key, like the
+  // separators.
+  size_t Seek(const Slice& key) const;
+
+  // Append the `i`-th separator as stored in the trie to `key`.
+  void GetKey(size_t i, std::string* key) const;
+
+  BlockHandle GetHandle(size_t i) const;
+
+  // Returns a new iterator over the index, which does not own the block.
+  InternalIteratorBase<IndexValue>* NewIterator(bool key_includes_seq) const;
+
+  size_t ApproximateMemoryUsage() const;
+
+  bool own_bytes() const { return contents_.own_bytes(); }
+
+ private:
+  BlockContents contents_;
+  bool ok_ = false;
+  size_t num_entries_ = 0;
+  std::unique_ptr<succinct::trie::DefaultPathDecomposedTrie<true>> trie_;
+  succinct::elias_fano handles_;
+};
+
+}  // namespace rocksdb
@@ -323,9 +323,14 @@ class ParsedFullFilterBlock {
     return filter_bits_reader_.get();
   }
 
-  // TODO: consider memory usage of the FilterBitsReader
+  // The reader is built once per cache residency, along with any auxiliary
+  // structure it needs to probe the filter, and charged with it.
   size_t ApproximateMemoryUsage() const {
-    return block_contents_.ApproximateMemoryUsage();
+    size_t usage = block_contents_.ApproximateMemoryUsage();
+    if (filter_bits_reader_ != nullptr) {
+      usage += filter_bits_reader_->ApproximateMemoryUsage();
+    }
+    return usage;
   }
 
   bool own_bytes() const { return block_contents_.own_bytes(); }
@@ -28,7 +28,6 @@ class OtLexPdtBloomBitsBuilder : public FilterBitsBuilder {
  public:
   explicit OtLexPdtBloomBitsBuilder()
       :ot_pdt() {
-//    fprintf(stderr, "constructing OtLexPdtBloomBitsBuilder()\n");
   }
 
   // No Copy allowed
@@ -38,7 +37,6 @@ class OtLexPdtBloomBitsBuilder : public FilterBitsBuilder {
   ~OtLexPdtBloomBitsBuilder() override {}
 
   virtual void AddKey(const Slice& key) override {
-//    fprintf(stderr, "in OtLexPdtBloomBitsBuilder::AddKey() idpaeq\n");
     std::string key_string(key.data(), key.data()+key.size());
     key_strings_.push_back(key_string);
   }
@@ -48,27 +46,18 @@ class OtLexPdtBloomBitsBuilder : public FilterBitsBuilder {
   }
 
   virtual Slice Finish(std::unique_ptr<const char[]>* buf) override {
-//    fprintf(stderr, "in OtLexPdtBloomBitsBuilder::Finish() 8qpeye\n");
     // generate a compacted trie and get essential data
     assert(key_strings_.size() > 0);
     key_strings_.erase(unique(key_strings_.begin(),
                               key_strings_.end()),
                        key_strings_.end()); //xp, for now simply dedup keys
 
-    //fprintf(stderr, "DEBUG w7zvbg key_strings_.size: %lu\n", key_strings_.size());
-
-    auto chrono_start = std::chrono::system_clock::now();
     ot_pdt.construct_compacted_trie(key_strings_, false); // ot_pdt.pub_ are inited
-    auto chrono_end = std::chrono::system_clock::now();
-    std::chrono::microseconds elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(chrono_end-chrono_start);
-    // std::cout << "DEBUG 3yb6fo Finis() ot_pdt use " << key_strings_.size() << " keys build raw trie takes(us) " <<
-    //           elapsed_us.count() << std::endl;
 
     // get the byte size of key_strings_
     uint64_t ot_lex_pdt_byte_size = CalculateByteSpace();
     assert(ot_lex_pdt_byte_size > 0);
     uint64_t buf_byte_size = ot_lex_pdt_byte_size + 5;
-//    fprintf(stderr, "DEBUG 10dk3 compacted trie byte size: %lu\n", buf_byte_size);
 
     char* contents = new char[buf_byte_size];
     memset(contents, 0, buf_byte_size);
@@ -100,14 +89,6 @@ class OtLexPdtBloomBitsBuilder : public FilterBitsBuilder {
     // char
     // & ot lex pdt byte size
     // target buffer
-//    fprintf(stdout, "DEBUG a3gcn6 in otFinish sizes for string,label,branch,char,bit,size:%ld,%ld,%ld,%ld,%ld,%ld\n",
-//            ot_pdt.pub_m_centroid_path_string.size(),
-//            ot_pdt.pub_m_labels.size(),
-//            ot_pdt.pub_m_centroid_path_branches.size(),
-//            ot_pdt.pub_m_branching_chars.size(),
-//            ot_pdt.pub_m_bp_m_bits.size(),
-//            ot_pdt.pub_m_bp_m_size);
-
 //ot_pdt.instance();
     PutIntoCharArray(ot_pdt.pub_m_centroid_path_string,
                      ot_pdt.pub_m_labels,
@@ -121,22 +102,6 @@ class OtLexPdtBloomBitsBuilder : public FilterBitsBuilder {
                      buf_byte_size,
                      contents);
 
-//    for (size_t i = 0; i < ot_pdt.pub_m_centroid_path_string.size(); i++) {
-//      fprintf(stdout, "Pstring:%ld,%d\n", i, ot_pdt.pub_m_centroid_path_string[i]);
-//    }
-//    for (size_t i = 0; i < ot_pdt.pub_m_labels.size(); i++) {
-//      fprintf(stdout, "Plabel:%ld,%d\n", i, ot_pdt.pub_m_labels[i]);
-//    }
-//    for (size_t i = 0; i < ot_pdt.pub_m_centroid_path_branches.size(); i++) {
-//      fprintf(stdout, "Pbranch:%ld,%d\n", i, ot_pdt.pub_m_centroid_path_branches[i]);
-//    }
-//    for (size_t i = 0; i < ot_pdt.pub_m_branching_chars.size(); i++) {
-//      fprintf(stdout, "Pchar:%ld,%d\n", i, ot_pdt.pub_m_branching_chars[i]);
-//    }
-//    for (size_t i = 0; i < ot_pdt.pub_m_bp_m_bits.size(); i++) {
-//      fprintf(stdout, "Pbit:%ld,%ld\n", i, ot_pdt.pub_m_bp_m_bits[i]);
-//    }
-
     assert(sizeof(ot_pdt.pub_m_bp_m_size) != 0);
 
     // return a Slice with data and its byte length
@@ -195,7 +160,6 @@ class OtLexPdtBloomBitsBuilder : public FilterBitsBuilder {
 //        (v1.size() + v2.size()) * 2 + v3.size() + v4.size() + v5.size() * 8 + 8;
 //    byte_size += 5 * 4 + 5;  //指明4个vector的size + 5 padding chars
 //
-    fprintf(stderr,"in Put buf size=%ld\n\n\n",byte_size);
     buf = new char[byte_size];
     memset(buf, 0, byte_size);
 
@@ -236,7 +200,6 @@ class OtLexPdtBloomBitsBuilder : public FilterBitsBuilder {
     p = (uint32_t*)(buf + 4 + v1.size() * 2 + 4 + v2.size() * 2 + 4 +
                     v3.size() + 4 + v4.size());
     *p = v5.size();
-//    fprintf(stderr, "DEBUG h8qd8z PutIntoCharArray m_bits.size(): %u\n", *p);
     uint64_t* p4 = (uint64_t*)(buf + 4 + v1.size() * 2 + 4 + v2.size() * 2 + 4 +
                                v3.size() + 4 + v4.size() + 4);
     for (uint32_t i = 0; i < v5.size(); i++) {
@@ -247,7 +210,6 @@ class OtLexPdtBloomBitsBuilder : public FilterBitsBuilder {
     uint64_t* p3 = (uint64_t*)(buf + 4 + v1.size() * 2 + 4 + v2.size() * 2 + 4 +
                                v3.size() + 4 + v4.size() + 4 + v5.size() * 8);
     *p3 = num;
-//    fprintf(stderr, "DEBUG yz92dt PutIntoCharArray num: %lu, *p3:%lu\n", num, *p3);
 
     // new bloom filter implementation indicators for GetBloomBitsReader
     char* pc1 = (char*)(buf + 4 + v1.size() * 2 + 4 + v2.size() * 2 + 4 +
@@ -266,13 +228,6 @@ class OtLexPdtBloomBitsBuilder : public FilterBitsBuilder {
 //                        v3.size() + 4 + v4.size() + 4 + v5.size() * 8 + 8 + 1 + 1 + 1 + 1);
 //    *pc5 = static_cast<char>(0);
 
-
-// fprintf(stderr,"/n/n/n/n/nbuf contents/n");
-//     for(uint64_t i=0;i<byte_size;i++)
-//     {
-//       fprintf(stderr,"%d",buf[i]);
-//     }
-// fprintf(stderr,"\n");
     return buf;
   }
 
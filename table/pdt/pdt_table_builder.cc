@@ -0,0 +1,229 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+#include "table/pdt/pdt_table_builder.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "rocksdb/table.h"
+#include "table/format.h"
+#include "table/meta_blocks.h"
+#include "util/coding.h"
+#include "util/file_reader_writer.h"
+#include "util/pdt.h"
+#include "util/string_util.h"
+
+namespace rocksdb {
+const std::string PdtTablePropertyNames::kTrieOffset =
+    "rocksdb.pdt.trie.offset";
+const std::string PdtTablePropertyNames::kTrieSize = "rocksdb.pdt.trie.size";
+const std::string PdtTablePropertyNames::kSamplesOffset =
+    "rocksdb.pdt.samples.offset";
+const std::string PdtTablePropertyNames::kSampleInterval =
+    "rocksdb.pdt.sample.interval";
+
+// Obtained by running echo rocksdb.table.pdt | sha1sum
+extern const uint64_t kPdtTableMagicNumber = 0x3f5e498800c3080dull;
+
+namespace {
+std::string EncodeFixed64Property(uint64_t value) {
+  std::string dst;
+  PutFixed64(&dst, value);
+  return dst;
+}
+}  // namespace
+
+PdtTableBuilder::PdtTableBuilder(WritableFileWriter* file,
+                                 uint32_t sample_interval,
+                                 uint32_t column_family_id,
+                                 const std::string& column_family_name)
+    : file_(file),
+      sample_interval_(std::max(1U, sample_interval)),
+      offset_(0),
+      closed_(false) {
+  // Data is in a huge block.
+  properties_.num_data_blocks = 1;
+  properties_.filter_size = 0;
+  properties_.column_family_id = column_family_id;
+  properties_.column_family_name = column_family_name;
+}
+
+void PdtTableBuilder::Add(const Slice& key, const Slice& value) {
+  assert(!closed_);
+  if (!status_.ok()) {
+    return;
+  }
+  if (key_ends_.size() >= port::kMaxInt32) {
+    status_ = Status::NotSupported("Number of keys in a file must be < 2^31");
+    return;
+  }
+  ParsedInternalKey ikey;
+  if (!ParseInternalKey(key, &ikey)) {
+    status_ = Status::Corruption("Unable to parse key into internal key.");
+    return;
+  }
+  if (ikey.type != kTypeDeletion && ikey.type != kTypeValue) {
+    status_ = Status::NotSupported("Unsupported key type " +
+                                   ToString(ikey.type));
+    return;
+  }
+  // Keys come in order, a repeated user key can only follow itself.
+  if (!key_ends_.empty() && ikey.user_key == LastUserKey()) {
+    status_ = Status::NotSupported("Same key is being inserted again.");
+    return;
+  }
+
+  if (key_ends_.size() % sample_interval_ == 0) {
+    PutFixed64(&samples_, offset_);
+  }
+  std::string entry;
+  PutVarint64(&entry, PackSequenceAndType(ikey.sequence, ikey.type));
+  PutVarint32(&entry, static_cast<uint32_t>(value.size()));
+  status_ = file_->Append(entry);
+  if (status_.ok()) {
+    status_ = file_->Append(value);
+  }
+  if (!status_.ok()) {
+    return;
+  }
+  offset_ += entry.size() + value.size();
+
+  keys_.append(ikey.user_key.data(), ikey.user_key.size());
+  key_ends_.push_back(keys_.size());
+  properties_.num_entries++;
+  properties_.raw_key_size += key.size();
+  properties_.raw_value_size += value.size();
+  if (ikey.type == kTypeDeletion) {
+    properties_.num_deletions++;
+  }
+}
+
+Slice PdtTableBuilder::LastUserKey() const {
+  assert(!key_ends_.empty());
+  const size_t begin =
+      key_ends_.size() > 1 ? key_ends_[key_ends_.size() - 2] : 0;
+  return Slice(keys_.data() + begin, keys_.size() - begin);
+}
+
+Status PdtTableBuilder::AppendPadding() {
+  static const char kZeros[8] = {0};
+  const size_t padding = static_cast<size_t>((8 - offset_ % 8) % 8);
+  offset_ += padding;
+  return padding > 0 ? file_->Append(Slice(kZeros, padding)) : Status::OK();
+}
+
+Status PdtTableBuilder::Finish() {
+  assert(!closed_);
+  closed_ = true;
+  if (!status_.ok()) {
+    return status_;
+  }
+  properties_.data_size = offset_;
+  Status s = AppendPadding();
+  if (!s.ok()) {
+    return s;
+  }
+
+  // Entries are in key order, which is the order of the lexicographic trie.
+  std::string trie;
+  if (!key_ends_.empty()) {
+    std::vector<Slice> keys;
+    keys.reserve(key_ends_.size());
+    size_t begin = 0;
+    for (size_t end : key_ends_) {
+      keys.emplace_back(keys_.data() + begin, end - begin);
+      begin = end;
+    }
+    BuildPdt<true>(&keys, &trie);
+    if (keys.size() != key_ends_.size()) {
+      return Status::NotSupported("Keys are not unique");
+    }
+  }
+  const uint64_t trie_offset = offset_;
+  s = file_->Append(trie);
+  if (!s.ok()) {
+    return s;
+  }
+  offset_ += trie.size();
+  s = AppendPadding();
+  if (!s.ok()) {
+    return s;
+  }
+  const uint64_t samples_offset = offset_;
+  s = file_->Append(samples_);
+  if (!s.ok()) {
+    return s;
+  }
+  offset_ += samples_.size();
+
+  properties_.index_size = trie.size() + samples_.size();
+  auto& user_props = properties_.user_collected_properties;
+  user_props[PdtTablePropertyNames::kTrieOffset] =
+      EncodeFixed64Property(trie_offset);
+  user_props[PdtTablePropertyNames::kTrieSize] =
+      EncodeFixed64Property(trie.size());
+  user_props[PdtTablePropertyNames::kSamplesOffset] =
+      EncodeFixed64Property(samples_offset);
+  user_props[PdtTablePropertyNames::kSampleInterval] =
+      EncodeFixed64Property(sample_interval_);
+
+  // Write meta blocks.
+  MetaIndexBuilder meta_index_builder;
+  PropertyBlockBuilder property_block_builder;
+
+  property_block_builder.AddTableProperty(properties_);
+  property_block_builder.Add(properties_.user_collected_properties);
+  Slice property_block = property_block_builder.Finish();
+  BlockHandle property_block_handle;
+  property_block_handle.set_offset(offset_);
+  property_block_handle.set_size(property_block.size());
+  s = file_->Append(property_block);
+  offset_ += property_block.size();
+  if (!s.ok()) {
+    return s;
+  }
+
+  meta_index_builder.Add(kPropertiesBlock, property_block_handle);
+  Slice meta_index_block = meta_index_builder.Finish();
+
+  BlockHandle meta_index_block_handle;
+  meta_index_block_handle.set_offset(offset_);
+  meta_index_block_handle.set_size(meta_index_block.size());
+  s = file_->Append(meta_index_block);
+  if (!s.ok()) {
+    return s;
+  }
+
+  Footer footer(kPdtTableMagicNumber, 1);
+  footer.set_metaindex_handle(meta_index_block_handle);
+  footer.set_index_handle(BlockHandle::NullBlockHandle());
+  std::string footer_encoding;
+  footer.EncodeTo(&footer_encoding);
+  s = file_->Append(footer_encoding);
+  return s;
+}
+
+void PdtTableBuilder::Abandon() {
+  assert(!closed_);
+  closed_ = true;
+}
+
+uint64_t PdtTableBuilder::NumEntries() const { return key_ends_.size(); }
+
+uint64_t PdtTableBuilder::FileSize() const {
+  if (closed_) {
+    return file_->GetFileSize();
+  }
+  // The trie is not built yet, the raw keys bound its size.
+  return offset_ + keys_.size() + samples_.size();
+}
+
+}  // namespace rocksdb
+#endif  // ROCKSDB_LITE
@@ -0,0 +1,84 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+#ifndef ROCKSDB_LITE
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "rocksdb/status.h"
+#include "rocksdb/table.h"
+#include "rocksdb/table_properties.h"
+#include "table/table_builder.h"
+
+namespace rocksdb {
+
+class WritableFileWriter;
+
+// Entries are written to the file as they are added, only the user keys are
+// kept in memory until Finish() builds the trie.
+class PdtTableBuilder : public TableBuilder {
+ public:
+  PdtTableBuilder(WritableFileWriter* file, uint32_t sample_interval,
+                  uint32_t column_family_id,
+                  const std::string& column_family_name);
+
+  // REQUIRES: Either Finish() or Abandon() has been called.
+  ~PdtTableBuilder() {}
+
+  // Add key,value to the table being constructed.
+  // REQUIRES: key is after any previously added key according to comparator.
+  // REQUIRES: Finish(), Abandon() have not been called
+  void Add(const Slice& key, const Slice& value) override;
+
+  // Return non-ok iff some error has been detected.
+  Status status() const override { return status_; }
+
+  // Finish building the table.  Stops using the file passed to the
+  // constructor after this function returns.
+  // REQUIRES: Finish(), Abandon() have not been called
+  Status Finish() override;
+
+  // Indicate that the contents of this builder should be abandoned.  Stops
+  // using the file passed to the constructor after this function returns.
+  // If the caller is not going to call Finish(), it must call Abandon()
+  // before destroying this builder.
+  // REQUIRES: Finish(), Abandon() have not been called
+  void Abandon() override;
+
+  // Number of calls to Add() so far.
+  uint64_t NumEntries() const override;
+
+  // Size of the file generated so far.  If invoked after a successful
+  // Finish() call, returns the size of the final generated file.
+  uint64_t FileSize() const override;
+
+  TableProperties GetTableProperties() const override { return properties_; }
+
+ private:
+  Slice LastUserKey() const;
+  // Pads the file to the next multiple of 8 bytes.
+  Status AppendPadding();
+
+  WritableFileWriter* file_;
+  const uint32_t sample_interval_;
+  uint64_t offset_;
+  // User keys concatenated, key i ends at key_ends_[i].
+  std::string keys_;
+  std::vector<size_t> key_ends_;
+  std::string samples_;
+  Status status_;
+  TableProperties properties_;
+
+  bool closed_;  // Either Finish() or Abandon() has been called.
+
+  // No copying allowed
+  PdtTableBuilder(const PdtTableBuilder&) = delete;
+  void operator=(const PdtTableBuilder&) = delete;
+};
+
+}  // namespace rocksdb
+
+#endif  // ROCKSDB_LITE
@@ -0,0 +1,74 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+#include "table/pdt/pdt_table_factory.h"
+
+#include <string.h>
+
+#include "db/dbformat.h"
+#include "rocksdb/comparator.h"
+#include "table/pdt/pdt_table_builder.h"
+#include "table/pdt/pdt_table_reader.h"
+
+namespace rocksdb {
+
+Status PdtTableFactory::NewTableReader(
+    const TableReaderOptions& table_reader_options,
+    std::unique_ptr<RandomAccessFileReader>&& file, uint64_t file_size,
+    std::unique_ptr<TableReader>* table,
+    bool /*prefetch_index_and_filter_in_cache*/) const {
+  std::unique_ptr<PdtTableReader> new_reader(new PdtTableReader(
+      table_reader_options.ioptions, std::move(file), file_size,
+      table_reader_options.internal_comparator));
+  Status s = new_reader->status();
+  if (s.ok()) {
+    *table = std::move(new_reader);
+  }
+  return s;
+}
+
+TableBuilder* PdtTableFactory::NewTableBuilder(
+    const TableBuilderOptions& table_builder_options, uint32_t column_family_id,
+    WritableFileWriter* file) const {
+  // Ignore the skip_filters flag. Does not apply to this file format
+  return new PdtTableBuilder(file, table_options_.sample_interval,
+                             column_family_id,
+                             table_builder_options.column_family_name);
+}
+
+Status PdtTableFactory::SanitizeOptions(
+    const DBOptions& db_opts, const ColumnFamilyOptions& cf_opts) const {
+  if (!db_opts.allow_mmap_reads) {
+    return Status::InvalidArgument(
+        "PdtTable is only served from mmap, allow_mmap_reads must be set");
+  }
+  // The trie orders keys bytewise.
+  if (cf_opts.comparator == nullptr ||
+      strcmp(cf_opts.comparator->Name(), BytewiseComparator()->Name()) != 0) {
+    return Status::InvalidArgument(
+        "PdtTable only supports the bytewise comparator");
+  }
+  return Status::OK();
+}
+
+std::string PdtTableFactory::GetPrintableTableOptions() const {
+  std::string ret;
+  ret.reserve(200);
+  const int kBufferSize = 200;
+  char buffer[kBufferSize];
+
+  snprintf(buffer, kBufferSize, "  sample_interval: %u\n",
+           table_options_.sample_interval);
+  ret.append(buffer);
+  return ret;
+}
+
+TableFactory* NewPdtTableFactory(const PdtTableOptions& table_options) {
+  return new PdtTableFactory(table_options);
+}
+
+}  // namespace rocksdb
+#endif  // ROCKSDB_LITE
@@ -0,0 +1,73 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+#ifndef ROCKSDB_LITE
+
+#include <string>
+#include "rocksdb/options.h"
+#include "rocksdb/table.h"
+
+namespace rocksdb {
+
+// PDT Table is designed for immutable files of the last level, which are
+// read much more than they are written and are too large to be all cached.
+//
+// The file layout is:
+// +--------------------------------------------------------------+
+// | entry 0 | entry 1 | ... | entry n-1                          |
+// | padding to 8 bytes                                           |
+// +--------------------------------------------------------------+
+// | lexicographic path-decomposed trie of the user keys          |
+// | padding to 8 bytes                                           |
+// +--------------------------------------------------------------+
+// | fixed64 offset of entry 0, of entry sample_interval, ...     |
+// +--------------------------------------------------------------+
+// | properties block | metaindex block | footer                  |
+// +--------------------------------------------------------------+
+//
+// where an entry is
+//   varint64 packed sequence and type | varint32 value size | value
+//
+// Entries are in key order, which is the order of the node ids of the trie,
+// so the value of a key is found from its rank. Keys are only stored in the
+// trie, they are rebuilt from the rank when iterating.
+class PdtTableFactory : public TableFactory {
+ public:
+  explicit PdtTableFactory(const PdtTableOptions& table_options)
+      : table_options_(table_options) {}
+  ~PdtTableFactory() {}
+
+  const char* Name() const override { return "PdtTable"; }
+
+  Status NewTableReader(
+      const TableReaderOptions& table_reader_options,
+      std::unique_ptr<RandomAccessFileReader>&& file, uint64_t file_size,
+      std::unique_ptr<TableReader>* table,
+      bool prefetch_index_and_filter_in_cache = true) const override;
+
+  TableBuilder* NewTableBuilder(
+      const TableBuilderOptions& table_builder_options,
+      uint32_t column_family_id, WritableFileWriter* file) const override;
+
+  // Sanitizes the specified DB Options.
+  Status SanitizeOptions(const DBOptions& db_opts,
+                         const ColumnFamilyOptions& cf_opts) const override;
+
+  std::string GetPrintableTableOptions() const override;
+
+  void* GetOptions() override { return &table_options_; }
+
+  Status GetOptionString(std::string* /*opt_string*/,
+                         const std::string& /*delimiter*/) const override {
+    return Status::OK();
+  }
+
+ private:
+  PdtTableOptions table_options_;
+};
+
+}  // namespace rocksdb
+#endif  // ROCKSDB_LITE
@@ -0,0 +1,282 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+#include "table/pdt/pdt_table_reader.h"
+
+#include <string>
+
+#include "memory/arena.h"
+#include "rocksdb/table.h"
+#include "table/get_context.h"
+#include "table/internal_iterator.h"
+#include "table/meta_blocks.h"
+#include "util/coding.h"
+#include "util/pdt.h"
+
+namespace rocksdb {
+
+extern const uint64_t kPdtTableMagicNumber;
+
+namespace {
+bool GetFixed64Property(const UserCollectedProperties& props,
+                        const std::string& name, uint64_t* value) {
+  auto it = props.find(name);
+  if (it == props.end() || it->second.size() != sizeof(uint64_t)) {
+    return false;
+  }
+  *value = DecodeFixed64(it->second.data());
+  return true;
+}
+}  // namespace
+
+PdtTableReader::PdtTableReader(const ImmutableCFOptions& ioptions,
+                               std::unique_ptr<RandomAccessFileReader>&& file,
+                               uint64_t file_size,
+                               const InternalKeyComparator& internal_comparator)
+    : internal_comparator_(internal_comparator),
+      file_(std::move(file)),
+      num_keys_(0),
+      data_size_(0),
+      samples_(nullptr),
+      sample_interval_(1) {
+  if (!ioptions.allow_mmap_reads) {
+    status_ = Status::InvalidArgument("File is not mmaped");
+    return;
+  }
+  TableProperties* props = nullptr;
+  status_ = ReadTableProperties(file_.get(), file_size, kPdtTableMagicNumber,
+                                ioptions, &props,
+                                true /* compression_type_missing */);
+  if (!status_.ok()) {
+    return;
+  }
+  table_props_.reset(props);
+  const auto& user_props = props->user_collected_properties;
+  uint64_t trie_offset = 0;
+  uint64_t trie_size = 0;
+  uint64_t samples_offset = 0;
+  if (!GetFixed64Property(user_props, PdtTablePropertyNames::kTrieOffset,
+                          &trie_offset) ||
+      !GetFixed64Property(user_props, PdtTablePropertyNames::kTrieSize,
+                          &trie_size) ||
+      !GetFixed64Property(user_props, PdtTablePropertyNames::kSamplesOffset,
+                          &samples_offset) ||
+      !GetFixed64Property(user_props, PdtTablePropertyNames::kSampleInterval,
+                          &sample_interval_) ||
+      sample_interval_ == 0) {
+    status_ = Status::Corruption("PDT table layout properties not found");
+    return;
+  }
+  num_keys_ = static_cast<size_t>(props->num_entries);
+  data_size_ = props->data_size;
+  const uint64_t num_samples =
+      (num_keys_ + sample_interval_ - 1) / sample_interval_;
+  if (data_size_ > trie_offset || trie_offset + trie_size > samples_offset ||
+      samples_offset + num_samples * sizeof(uint64_t) > file_size) {
+    status_ = Status::Corruption("PDT table sections out of the file");
+    return;
+  }
+  status_ = file_->Read(0, static_cast<size_t>(file_size), &file_data_,
+                        nullptr);
+  if (!status_.ok()) {
+    return;
+  }
+  samples_ = file_data_.data() + samples_offset;
+  if (num_keys_ > 0) {
+    trie_.reset(MapPdt<true>(Slice(file_data_.data() + trie_offset,
+                                   static_cast<size_t>(trie_size))));
+    if (trie_ == nullptr || trie_->num_keys() != num_keys_) {
+      status_ = Status::Corruption("Unable to map the key trie");
+    }
+  }
+}
+
+uint64_t PdtTableReader::EntryOffset(size_t idx) const {
+  const size_t sample = static_cast<size_t>(idx / sample_interval_);
+  uint64_t offset = DecodeFixed64(samples_ + sample * sizeof(uint64_t));
+  Entry entry;
+  for (size_t i = static_cast<size_t>(sample * sample_interval_); i < idx;
+       i++) {
+    if (!DecodeEntry(&offset, &entry)) {
+      break;
+    }
+  }
+  return offset;
+}
+
+bool PdtTableReader::DecodeEntry(uint64_t* offset, Entry* entry) const {
+  Slice input(file_data_.data() + *offset,
+              static_cast<size_t>(data_size_ - *offset));
+  const size_t size = input.size();
+  uint64_t packed = 0;
+  uint32_t value_size = 0;
+  if (!GetVarint64(&input, &packed) || !GetVarint32(&input, &value_size) ||
+      value_size > input.size()) {
+    return false;
+  }
+  UnPackSequenceAndType(packed, &entry->sequence, &entry->type);
+  entry->value = Slice(input.data(), value_size);
+  *offset += size - input.size() + value_size;
+  return true;
+}
+
+Status PdtTableReader::Get(const ReadOptions& /*readOptions*/,
+                           const Slice& key, GetContext* get_context,
+                           const SliceTransform* /* prefix_extractor */,
+                           bool /*skip_filters*/) {
+  if (trie_ == nullptr) {
+    return Status::OK();
+  }
+  ParsedInternalKey lookup_key;
+  if (!ParseInternalKey(key, &lookup_key)) {
+    return Status::Corruption("Unable to parse key into internal key.");
+  }
+  const int idx = trie_->index(lookup_key.user_key);
+  if (idx < 0) {
+    return Status::OK();
+  }
+  uint64_t offset = EntryOffset(static_cast<size_t>(idx));
+  Entry entry;
+  if (!DecodeEntry(&offset, &entry)) {
+    return Status::Corruption("Bad entry in PDT table");
+  }
+  // A user key appears once, a version newer than the snapshot hides
+  // nothing older in this file.
+  if (entry.sequence > lookup_key.sequence) {
+    return Status::OK();
+  }
+  bool matched = false;
+  get_context->SaveValue(
+      ParsedInternalKey(lookup_key.user_key, entry.sequence, entry.type),
+      entry.value, &matched);
+  return Status::OK();
+}
+
+uint64_t PdtTableReader::ApproximateOffsetOf(const Slice& key,
+                                             TableReaderCaller /*caller*/) {
+  if (trie_ == nullptr) {
+    return 0;
+  }
+  const size_t idx = trie_->lower_bound(ExtractUserKey(key));
+  return idx < num_keys_ ? EntryOffset(idx) : data_size_;
+}
+
+size_t PdtTableReader::ApproximateMemoryUsage() const { return 0; }
+
+class PdtTableIterator : public InternalIterator {
+ public:
+  explicit PdtTableIterator(const PdtTableReader* reader)
+      : reader_(reader), idx_(reader->num_keys_), offset_(0) {}
+  ~PdtTableIterator() override {}
+
+  bool Valid() const override { return idx_ < reader_->num_keys_; }
+  void SeekToFirst() override { SeekToIndex(0); }
+  void SeekToLast() override {
+    SeekToIndex(reader_->num_keys_ > 0 ? reader_->num_keys_ - 1
+                                       : reader_->num_keys_);
+  }
+  void Seek(const Slice& target) override;
+  void SeekForPrev(const Slice& target) override {
+    SeekForPrevImpl(target, &reader_->internal_comparator_);
+  }
+  void Next() override;
+  void Prev() override {
+    assert(Valid());
+    SeekToIndex(idx_ > 0 ? idx_ - 1 : reader_->num_keys_);
+  }
+  Slice key() const override {
+    assert(Valid());
+    return key_.GetInternalKey();
+  }
+  Slice value() const override {
+    assert(Valid());
+    return entry_.value;
+  }
+  Status status() const override { return status_; }
+
+ private:
+  void SeekToIndex(size_t idx);
+  // Decodes the entry at `offset_` as the one of `idx_`.
+  void LoadCurrent();
+
+  const PdtTableReader* reader_;
+  size_t idx_;
+  // Offset of the entry after the current one.
+  uint64_t offset_;
+  PdtTableReader::Entry entry_;
+  std::string user_key_;
+  IterKey key_;
+  Status status_;
+
+  // No copying allowed
+  PdtTableIterator(const PdtTableIterator&) = delete;
+  void operator=(const Iterator&) = delete;
+};
+
+void PdtTableIterator::SeekToIndex(size_t idx) {
+  idx_ = idx;
+  if (Valid()) {
+    offset_ = reader_->EntryOffset(idx_);
+    LoadCurrent();
+  }
+}
+
+void PdtTableIterator::LoadCurrent() {
+  if (!reader_->DecodeEntry(&offset_, &entry_)) {
+    status_ = Status::Corruption("Bad entry in PDT table");
+    idx_ = reader_->num_keys_;
+    return;
+  }
+  user_key_.clear();
+  reader_->trie_->get_key(idx_, &user_key_);
+  key_.SetInternalKey(user_key_, entry_.sequence, entry_.type);
+}
+
+void PdtTableIterator::Seek(const Slice& target) {
+  if (reader_->trie_ == nullptr) {
+    idx_ = reader_->num_keys_;
+    return;
+  }
+  ParsedInternalKey seek_key;
+  if (!ParseInternalKey(target, &seek_key)) {
+    status_ = Status::Corruption("Unable to parse key into internal key.");
+    idx_ = reader_->num_keys_;
+    return;
+  }
+  SeekToIndex(reader_->trie_->lower_bound(seek_key.user_key));
+  // The version of the user key is before the target if it is newer.
+  if (Valid() && user_key_ == seek_key.user_key &&
+      entry_.sequence > seek_key.sequence) {
+    Next();
+  }
+}
+
+void PdtTableIterator::Next() {
+  assert(Valid());
+  idx_++;
+  if (Valid()) {
+    LoadCurrent();
+  }
+}
+
+InternalIterator* PdtTableReader::NewIterator(
+    const ReadOptions& /*read_options*/,
+    const SliceTransform* /* prefix_extractor */, Arena* arena,
+    bool /*skip_filters*/, TableReaderCaller /*caller*/,
+    size_t /*compaction_readahead_size*/) {
+  if (!status().ok()) {
+    return NewErrorInternalIterator<Slice>(
+        Status::Corruption("PdtTableReader status is not okay."), arena);
+  }
+  if (arena == nullptr) {
+    return new PdtTableIterator(this);
+  }
+  auto iter_mem = arena->AllocateAligned(sizeof(PdtTableIterator));
+  return new (iter_mem) PdtTableIterator(this);
+}
+
+}  // namespace rocksdb
+#endif  // ROCKSDB_LITE
@@ -0,0 +1,87 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+#ifndef ROCKSDB_LITE
+#include <memory>
+#include <string>
+
+#include "db/dbformat.h"
+#include "options/cf_options.h"
+#include "rocksdb/options.h"
+#include "table/table_reader.h"
+#include "util/file_reader_writer.h"
+#include "utilities/pdt/path_decomposed_trie.h"
+
+namespace rocksdb {
+
+class Arena;
+
+class PdtTableReader : public TableReader {
+ public:
+  PdtTableReader(const ImmutableCFOptions& ioptions,
+                 std::unique_ptr<RandomAccessFileReader>&& file,
+                 uint64_t file_size,
+                 const InternalKeyComparator& internal_comparator);
+  ~PdtTableReader() {}
+
+  std::shared_ptr<const TableProperties> GetTableProperties() const override {
+    return table_props_;
+  }
+
+  Status status() const { return status_; }
+
+  Status Get(const ReadOptions& readOptions, const Slice& key,
+             GetContext* get_context, const SliceTransform* prefix_extractor,
+             bool skip_filters = false) override;
+
+  // Returns a new iterator over table contents
+  // compaction_readahead_size: its value will only be used if for_compaction =
+  // true
+  InternalIterator* NewIterator(const ReadOptions&,
+                                const SliceTransform* prefix_extractor,
+                                Arena* arena, bool skip_filters,
+                                TableReaderCaller caller,
+                                size_t compaction_readahead_size = 0) override;
+
+  // Report an approximation of how much memory has been used.
+  size_t ApproximateMemoryUsage() const override;
+
+  // Entries are laid out in key order, so the offset of the entry of the
+  // first key not less than `key` is the offset of `key`.
+  uint64_t ApproximateOffsetOf(const Slice& key,
+                               TableReaderCaller caller) override;
+
+  void SetupForCompaction() override {}
+
+ private:
+  friend class PdtTableIterator;
+
+  // One decoded entry, `value` points into the mmaped file.
+  struct Entry {
+    SequenceNumber sequence;
+    ValueType type;
+    Slice value;
+  };
+
+  // Offset of the `idx`-th entry, found from the closest sample before it.
+  uint64_t EntryOffset(size_t idx) const;
+  // Decodes the entry at `*offset` and moves `*offset` past it.
+  bool DecodeEntry(uint64_t* offset, Entry* entry) const;
+
+  const InternalKeyComparator internal_comparator_;
+  std::unique_ptr<RandomAccessFileReader> file_;
+  Slice file_data_;
+  std::shared_ptr<const TableProperties> table_props_;
+  Status status_;
+  std::unique_ptr<succinct::trie::DefaultPathDecomposedTrie<true>> trie_;
+  size_t num_keys_;
+  uint64_t data_size_;
+  const char* samples_;
+  uint64_t sample_interval_;
+};
+
+}  // namespace rocksdb
+#endif  // ROCKSDB_LITE
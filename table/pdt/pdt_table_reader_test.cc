@@ -0,0 +1,294 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "memory/arena.h"
+#include "rocksdb/db.h"
+#include "table/get_context.h"
+#include "table/pdt/pdt_table_builder.h"
+#include "table/pdt/pdt_table_factory.h"
+#include "table/pdt/pdt_table_reader.h"
+#include "test_util/testharness.h"
+#include "test_util/testutil.h"
+#include "util/string_util.h"
+
+namespace rocksdb {
+
+class PdtTableReaderTest : public testing::Test {
+ public:
+  PdtTableReaderTest() {
+    options_.allow_mmap_reads = true;
+    env_ = options_.env;
+    env_options_ = EnvOptions(options_);
+    fname_ = test::PerThreadDBPath("PdtTableReaderTest");
+  }
+
+  // Keys sharing long prefixes, with values of varying sizes. Every 7th key
+  // is a deletion.
+  void AddEntries(int num) {
+    for (int i = 0; i < num; i++) {
+      char user_key[32];
+      snprintf(user_key, sizeof(user_key), "tenant%d/row%06d", i % 3, i);
+      const ValueType type = i % 7 == 3 ? kTypeDeletion : kTypeValue;
+      const std::string value =
+          type == kTypeValue ? std::string(i % 50, 'a' + i % 26) : "";
+      entries_[InternalKey(user_key, 100 + i, type).Encode().ToString()] =
+          value;
+    }
+  }
+
+  void BuildFile(uint32_t sample_interval) {
+    std::unique_ptr<WritableFile> writable_file;
+    ASSERT_OK(env_->NewWritableFile(fname_, &writable_file, env_options_));
+    std::unique_ptr<WritableFileWriter> file_writer(new WritableFileWriter(
+        std::move(writable_file), fname_, env_options_));
+    PdtTableBuilder builder(file_writer.get(), sample_interval,
+                            0 /* column_family_id */,
+                            kDefaultColumnFamilyName);
+    ASSERT_OK(builder.status());
+    for (const auto& kv : SortedEntries()) {
+      builder.Add(kv.first, kv.second);
+      ASSERT_OK(builder.status());
+    }
+    ASSERT_OK(builder.Finish());
+    ASSERT_EQ(entries_.size(), builder.NumEntries());
+    file_size_ = builder.FileSize();
+    ASSERT_OK(file_writer->Close());
+  }
+
+  std::unique_ptr<PdtTableReader> OpenReader() {
+    std::unique_ptr<RandomAccessFile> read_file;
+    EXPECT_OK(env_->NewRandomAccessFile(fname_, &read_file, env_options_));
+    std::unique_ptr<RandomAccessFileReader> file_reader(
+        new RandomAccessFileReader(std::move(read_file), fname_));
+    const ImmutableCFOptions ioptions(options_);
+    return std::unique_ptr<PdtTableReader>(
+        new PdtTableReader(ioptions, std::move(file_reader), file_size_,
+                           InternalKeyComparator(BytewiseComparator())));
+  }
+
+  // Entries in internal key order.
+  std::vector<std::pair<std::string, std::string>> SortedEntries() const {
+    std::vector<std::pair<std::string, std::string>> sorted(entries_.begin(),
+                                                            entries_.end());
+    InternalKeyComparator icomp(BytewiseComparator());
+    std::sort(sorted.begin(), sorted.end(),
+              [&icomp](const std::pair<std::string, std::string>& a,
+                       const std::pair<std::string, std::string>& b) {
+                return icomp.Compare(a.first, b.first) < 0;
+              });
+    return sorted;
+  }
+
+  GetContext::GetState Get(PdtTableReader* reader, const Slice& user_key,
+                           SequenceNumber seq, std::string* value) {
+    PinnableSlice pinnable;
+    GetContext get_context(BytewiseComparator(), nullptr, nullptr, nullptr,
+                           GetContext::kNotFound, user_key, &pinnable, nullptr,
+                           nullptr, nullptr, nullptr);
+    EXPECT_OK(reader->Get(ReadOptions(),
+                          InternalKey(user_key, seq, kValueTypeForSeek).Encode(),
+                          &get_context, nullptr));
+    value->assign(pinnable.data(), pinnable.size());
+    return get_context.State();
+  }
+
+  Options options_;
+  Env* env_;
+  EnvOptions env_options_;
+  std::string fname_;
+  uint64_t file_size_ = 0;
+  std::map<std::string, std::string> entries_;
+};
+
+TEST_F(PdtTableReaderTest, Get) {
+  AddEntries(1000);
+  for (uint32_t sample_interval : {1, 16, 1000}) {
+    BuildFile(sample_interval);
+    std::unique_ptr<PdtTableReader> reader = OpenReader();
+    ASSERT_OK(reader->status());
+    std::string value;
+    for (const auto& kv : entries_) {
+      ParsedInternalKey ikey;
+      ASSERT_TRUE(ParseInternalKey(kv.first, &ikey));
+      const auto state = Get(reader.get(), ikey.user_key, kMaxSequenceNumber,
+                             &value);
+      if (ikey.type == kTypeValue) {
+        ASSERT_EQ(GetContext::kFound, state);
+        ASSERT_EQ(kv.second, value);
+      } else {
+        ASSERT_EQ(GetContext::kDeleted, state);
+      }
+      // Not visible to an older snapshot.
+      ASSERT_EQ(GetContext::kNotFound,
+                Get(reader.get(), ikey.user_key, ikey.sequence - 1, &value));
+    }
+    ASSERT_EQ(GetContext::kNotFound,
+              Get(reader.get(), "tenant0/row", kMaxSequenceNumber, &value));
+    ASSERT_EQ(GetContext::kNotFound,
+              Get(reader.get(), "tenant0/row0000000", kMaxSequenceNumber,
+                  &value));
+    ASSERT_EQ(GetContext::kNotFound,
+              Get(reader.get(), "zzz", kMaxSequenceNumber, &value));
+  }
+}
+
+TEST_F(PdtTableReaderTest, Iterator) {
+  AddEntries(500);
+  BuildFile(16);
+  std::unique_ptr<PdtTableReader> reader = OpenReader();
+  ASSERT_OK(reader->status());
+  const auto sorted = SortedEntries();
+  std::unique_ptr<InternalIterator> iter(
+      reader->NewIterator(ReadOptions(), nullptr, /*arena=*/nullptr,
+                          /*skip_filters=*/false,
+                          TableReaderCaller::kUncategorized));
+
+  iter->SeekToFirst();
+  for (const auto& kv : sorted) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(kv.first, iter->key().ToString());
+    ASSERT_EQ(kv.second, iter->value().ToString());
+    iter->Next();
+  }
+  ASSERT_FALSE(iter->Valid());
+
+  iter->SeekToLast();
+  for (auto it = sorted.rbegin(); it != sorted.rend(); ++it) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(it->first, iter->key().ToString());
+    iter->Prev();
+  }
+  ASSERT_FALSE(iter->Valid());
+  ASSERT_OK(iter->status());
+
+  InternalKeyComparator icomp(BytewiseComparator());
+  for (size_t i = 0; i < sorted.size(); i += 7) {
+    ParsedInternalKey ikey;
+    ASSERT_TRUE(ParseInternalKey(sorted[i].first, &ikey));
+    // The entry itself, and targets right before and after it.
+    for (SequenceNumber seq :
+         {ikey.sequence, ikey.sequence + 1, ikey.sequence - 1}) {
+      const std::string target =
+          InternalKey(ikey.user_key, seq, kValueTypeForSeek).Encode().ToString();
+      auto expected = std::lower_bound(
+          sorted.begin(), sorted.end(), target,
+          [&icomp](const std::pair<std::string, std::string>& kv,
+                   const std::string& t) {
+            return icomp.Compare(kv.first, t) < 0;
+          });
+      iter->Seek(target);
+      ASSERT_EQ(expected != sorted.end(), iter->Valid());
+      if (iter->Valid()) {
+        ASSERT_EQ(expected->first, iter->key().ToString());
+      }
+      iter->SeekForPrev(target);
+      if (expected != sorted.end() && expected->first == target) {
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(target, iter->key().ToString());
+      } else if (expected == sorted.begin()) {
+        ASSERT_FALSE(iter->Valid());
+      } else {
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ((expected - 1)->first, iter->key().ToString());
+      }
+    }
+  }
+  iter->Seek(InternalKey("zzz", kMaxSequenceNumber, kValueTypeForSeek)
+                 .Encode());
+  ASSERT_FALSE(iter->Valid());
+}
+
+TEST_F(PdtTableReaderTest, DuplicateUserKey) {
+  std::unique_ptr<WritableFile> writable_file;
+  ASSERT_OK(env_->NewWritableFile(fname_, &writable_file, env_options_));
+  std::unique_ptr<WritableFileWriter> file_writer(new WritableFileWriter(
+      std::move(writable_file), fname_, env_options_));
+  PdtTableBuilder builder(file_writer.get(), 16, 0 /* column_family_id */,
+                          kDefaultColumnFamilyName);
+  builder.Add(InternalKey("key", 2, kTypeValue).Encode(), "v2");
+  ASSERT_OK(builder.status());
+  builder.Add(InternalKey("key", 1, kTypeValue).Encode(), "v1");
+  ASSERT_TRUE(builder.status().IsNotSupported());
+  builder.Abandon();
+}
+
+TEST_F(PdtTableReaderTest, EmptyFile) {
+  BuildFile(16);
+  std::unique_ptr<PdtTableReader> reader = OpenReader();
+  ASSERT_OK(reader->status());
+  std::string value;
+  ASSERT_EQ(GetContext::kNotFound,
+            Get(reader.get(), "key", kMaxSequenceNumber, &value));
+  std::unique_ptr<InternalIterator> iter(
+      reader->NewIterator(ReadOptions(), nullptr, /*arena=*/nullptr,
+                          /*skip_filters=*/false,
+                          TableReaderCaller::kUncategorized));
+  iter->SeekToFirst();
+  ASSERT_FALSE(iter->Valid());
+}
+
+TEST_F(PdtTableReaderTest, DB) {
+  Options options;
+  options.create_if_missing = true;
+  options.allow_mmap_reads = true;
+  options.table_factory.reset(NewPdtTableFactory());
+  const std::string dbname = test::PerThreadDBPath("pdt_table_db");
+  ASSERT_OK(DestroyDB(dbname, options));
+
+  DB* db = nullptr;
+  Options no_mmap = options;
+  no_mmap.allow_mmap_reads = false;
+  ASSERT_TRUE(DB::Open(no_mmap, dbname, &db).IsInvalidArgument());
+
+  ASSERT_OK(DB::Open(options, dbname, &db));
+  for (int i = 0; i < 100; i++) {
+    ASSERT_OK(db->Put(WriteOptions(), "key" + ToString(1000 + i),
+                      "value" + ToString(i)));
+  }
+  ASSERT_OK(db->Delete(WriteOptions(), "key1050"));
+  ASSERT_OK(db->Flush(FlushOptions()));
+  ASSERT_OK(db->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+
+  std::string value;
+  ASSERT_OK(db->Get(ReadOptions(), "key1007", &value));
+  ASSERT_EQ("value7", value);
+  ASSERT_TRUE(db->Get(ReadOptions(), "key1050", &value).IsNotFound());
+  ASSERT_TRUE(db->Get(ReadOptions(), "key2000", &value).IsNotFound());
+
+  std::unique_ptr<Iterator> iter(db->NewIterator(ReadOptions()));
+  int count = 0;
+  for (iter->Seek("key1048"); iter->Valid(); iter->Next()) {
+    count++;
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(51, count);
+  iter.reset();
+  delete db;
+  ASSERT_OK(DestroyDB(dbname, options));
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+#include <stdio.h>
+
+int main(int /*argc*/, char** /*argv*/) {
+  fprintf(stderr, "SKIPPED as PdtTable is not supported in ROCKSDB_LITE\n");
+  return 0;
+}
+
+#endif  // ROCKSDB_LITE
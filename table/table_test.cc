@@ -10,6 +10,7 @@
 #include <stdio.h>
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -1910,6 +1911,12 @@ TEST_P(BlockBasedTableTest, PartitionIndexTest) {
   }
 }
 
+TEST_P(BlockBasedTableTest, PdtIndexTest) {
+  BlockBasedTableOptions table_options = GetBlockBasedTableOptions();
+  table_options.index_type = BlockBasedTableOptions::kPdtSearch;
+  IndexTest(table_options);
+}
+
 TEST_P(BlockBasedTableTest, IndexSeekOptimizationIncomplete) {
   std::unique_ptr<InternalKeyComparator> comparator(
       new InternalKeyComparator(BytewiseComparator()));
@@ -1984,6 +1991,325 @@ class CustomFlushBlockPolicy : public FlushBlockPolicyFactory,
   int keys_in_current_block_ = 0;
 };
 
+// Versions of a user key spanning several blocks need the sequence number in
+// the separators, which are then kept in the trie as escaped internal keys.
+TEST_P(BlockBasedTableTest, PdtIndexKeyIncludesSeq) {
+  BlockBasedTableOptions table_options = GetBlockBasedTableOptions();
+  table_options.index_type = BlockBasedTableOptions::kPdtSearch;
+  table_options.flush_block_policy_factory =
+      std::make_shared<CustomFlushBlockPolicy>(std::vector<int>(12, 1));
+  Options options;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  const ImmutableCFOptions ioptions(options);
+  const MutableCFOptions moptions(options);
+
+  InternalKeyComparator comparator(BytewiseComparator());
+  TableConstructor c(&comparator);
+  const std::vector<std::string> user_keys = {"a", std::string("a\0", 2),
+                                              std::string("a\0\0b", 4), "ab"};
+  for (const auto& user_key : user_keys) {
+    for (SequenceNumber seq : {9, 5, 1}) {
+      c.Add(InternalKey(user_key, seq, kTypeValue).Encode().ToString(),
+            user_key + ToString(seq));
+    }
+  }
+  std::vector<std::string> keys;
+  stl_wrappers::KVMap kvmap;
+  c.Finish(options, ioptions, moptions, table_options, comparator, &keys,
+           &kvmap);
+  auto reader = c.GetTableReader();
+  ASSERT_EQ(12u, reader->GetTableProperties()->num_data_blocks);
+  ASSERT_EQ(0u, reader->GetTableProperties()->index_key_is_user_key);
+
+  std::unique_ptr<InternalIterator> iter(reader->NewIterator(
+      ReadOptions(), /*prefix_extractor=*/nullptr, /*arena=*/nullptr,
+      /*skip_filters=*/false, TableReaderCaller::kUncategorized));
+  for (const auto& kv : kvmap) {
+    iter->Seek(kv.first);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(kv.first, iter->key().ToString());
+    ASSERT_EQ(kv.second, iter->value().ToString());
+  }
+
+  iter->SeekToFirst();
+  for (auto it = kvmap.begin(); it != kvmap.end(); ++it) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(it->first, iter->key().ToString());
+    iter->Next();
+  }
+  ASSERT_FALSE(iter->Valid());
+
+  iter->SeekToLast();
+  for (auto it = kvmap.rbegin(); it != kvmap.rend(); ++it) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(it->first, iter->key().ToString());
+    iter->Prev();
+  }
+  ASSERT_FALSE(iter->Valid());
+  ASSERT_OK(iter->status());
+  c.ResetTableReader();
+}
+
+// Point lookups go through the key locator instead of the index, unless the
+// versions of a user key span blocks and the table has no locator.
+TEST_P(BlockBasedTableTest, KeyLocator) {
+  for (bool spans_blocks : {false, true}) {
+    BlockBasedTableOptions table_options = GetBlockBasedTableOptions();
+    table_options.key_locator = true;
+    table_options.block_cache = NewLRUCache(1 << 20);
+    // Every user key has two versions, blocks of an even number of entries
+    // keep them together.
+    table_options.flush_block_policy_factory =
+        std::make_shared<CustomFlushBlockPolicy>(
+            std::vector<int>(400, spans_blocks ? 3 : 4));
+    Options options;
+    options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+    const ImmutableCFOptions ioptions(options);
+    const MutableCFOptions moptions(options);
+
+    InternalKeyComparator comparator(BytewiseComparator());
+    TableConstructor c(&comparator);
+    std::vector<std::string> user_keys;
+    for (int i = 0; i < 200; i++) {
+      std::string user_key = "tenant/" + ToString(i % 3) + "/row";
+      PutFixed32(&user_key, static_cast<uint32_t>(i));
+      user_keys.push_back(user_key);
+      c.Add(InternalKey(user_key, 9, kTypeValue).Encode().ToString(),
+            user_key + "9");
+      c.Add(InternalKey(user_key, 5, kTypeValue).Encode().ToString(),
+            user_key + "5");
+    }
+    std::vector<std::string> keys;
+    stl_wrappers::KVMap kvmap;
+    c.Finish(options, ioptions, moptions, table_options, comparator, &keys,
+             &kvmap);
+    auto reader = c.GetTableReader();
+    const BlockBasedTable::Rep* rep =
+        static_cast<BlockBasedTable*>(reader)->get_rep();
+    ASSERT_EQ(!spans_blocks, rep->key_locator != nullptr);
+    // The locator is charged to the block cache.
+    ASSERT_EQ(!spans_blocks, rep->key_locator_cache_handle != nullptr);
+    if (!spans_blocks) {
+      ASSERT_GE(table_options.block_cache->GetPinnedUsage(),
+                rep->key_locator->ApproximateMemoryUsage());
+    }
+
+    std::atomic<int> index_searches(0);
+    SyncPoint::GetInstance()->SetCallBack(
+        "BlockBasedTable::Get:SearchIndex",
+        [&](void* /*arg*/) { index_searches++; });
+    SyncPoint::GetInstance()->EnableProcessing();
+    for (const auto& user_key : user_keys) {
+      for (SequenceNumber seq : {kMaxSequenceNumber, SequenceNumber(6)}) {
+        PinnableSlice value;
+        GetContext get_context(options.comparator, nullptr, nullptr, nullptr,
+                               GetContext::kNotFound, user_key, &value,
+                               nullptr, nullptr, nullptr, nullptr);
+        ASSERT_OK(reader->Get(ReadOptions(),
+                              InternalKey(user_key, seq, kTypeValue).Encode(),
+                              &get_context, moptions.prefix_extractor.get()));
+        ASSERT_EQ(GetContext::kFound, get_context.State());
+        ASSERT_EQ(user_key + (seq == 6 ? "5" : "9"), value.ToString());
+      }
+    }
+    for (const std::string& user_key :
+         {std::string("tenant/"), std::string("tenant/1/row"),
+          std::string("zzz"), user_keys[7] + std::string(1, '\0')}) {
+      PinnableSlice value;
+      GetContext get_context(options.comparator, nullptr, nullptr, nullptr,
+                             GetContext::kNotFound, user_key, &value, nullptr,
+                             nullptr, nullptr, nullptr);
+      ASSERT_OK(reader->Get(
+          ReadOptions(),
+          InternalKey(user_key, kMaxSequenceNumber, kTypeValue).Encode(),
+          &get_context, moptions.prefix_extractor.get()));
+      ASSERT_EQ(GetContext::kNotFound, get_context.State());
+    }
+    SyncPoint::GetInstance()->DisableProcessing();
+    SyncPoint::GetInstance()->ClearAllCallBacks();
+    // Lookups found their block without the index.
+    if (spans_blocks) {
+      ASSERT_GT(index_searches.load(), 0);
+    } else {
+      ASSERT_EQ(0, index_searches.load());
+    }
+    c.ResetTableReader();
+    // Closing the table gives the memory of the locator back.
+    ASSERT_EQ(0, table_options.block_cache->GetPinnedUsage());
+  }
+}
+
+TEST_P(BlockBasedTableTest, PdtFilterStatistics) {
+  BlockBasedTableOptions table_options = GetBlockBasedTableOptions();
+  table_options.filter_policy.reset(NewLexPdtFilterPolicy());
+  table_options.use_pdt = true;
+  Options options;
+  options.statistics = CreateDBStatistics();
+  options.statistics->set_stats_level(kAll);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  const ImmutableCFOptions ioptions(options);
+  const MutableCFOptions moptions(options);
+
+  TableConstructor c(BytewiseComparator());
+  for (int i = 0; i < 100; i++) {
+    c.Add(InternalKey("key" + ToString(1000 + i), 1, kTypeValue)
+              .Encode()
+              .ToString(),
+          "value");
+  }
+  std::vector<std::string> keys;
+  stl_wrappers::KVMap kvmap;
+  c.Finish(options, ioptions, moptions, table_options,
+           GetPlainInternalComparator(options.comparator), &keys, &kvmap);
+  auto reader = c.GetTableReader();
+  ASSERT_GT(options.statistics->getTickerCount(PDT_FILTER_BYTES_LOADED), 0);
+
+  SetPerfLevel(kEnableTimeAndCPUTimeExceptForMutex);
+  get_perf_context()->Reset();
+  for (int i = 0; i < 20; i++) {
+    // Every other key is not in the table.
+    const std::string user_key = "key" + ToString(1000 + 10 * i);
+    PinnableSlice value;
+    GetContext get_context(options.comparator, nullptr, nullptr, nullptr,
+                           GetContext::kNotFound, user_key, &value, nullptr,
+                           nullptr, nullptr, nullptr);
+    ASSERT_OK(reader->Get(ReadOptions(),
+                          InternalKey(user_key, 1, kTypeValue).Encode(),
+                          &get_context, moptions.prefix_extractor.get()));
+    ASSERT_EQ(i < 10 ? GetContext::kFound : GetContext::kNotFound,
+              get_context.State());
+  }
+  SetPerfLevel(kEnableCount);
+
+  ASSERT_EQ(20, options.statistics->getTickerCount(PDT_FILTER_PROBES));
+  ASSERT_GT(options.statistics->getTickerCount(PDT_FILTER_PROBE_CPU_NANOS),
+            0);
+  ASSERT_EQ(20, get_perf_context()->pdt_filter_probe_count);
+  ASSERT_EQ(10, get_perf_context()->bloom_sst_miss_count);
+  ASSERT_GT(get_perf_context()->pdt_filter_probe_cpu_nanos, 0);
+  c.ResetTableReader();
+}
+
+// The PDT filter metrics count the probes of full and partitioned PDT
+// filters too.
+TEST_P(BlockBasedTableTest, PdtFilterStatisticsFullAndPartitioned) {
+  for (bool partition_filters : {false, true}) {
+    BlockBasedTableOptions table_options = GetBlockBasedTableOptions();
+    table_options.filter_policy.reset(NewLexPdtFilterPolicy());
+    if (partition_filters) {
+      table_options.partition_filters = true;
+      table_options.index_type =
+          BlockBasedTableOptions::IndexType::kTwoLevelIndexSearch;
+      table_options.metadata_block_size = 128;
+    }
+    Options options;
+    options.statistics = CreateDBStatistics();
+    options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+    const ImmutableCFOptions ioptions(options);
+    const MutableCFOptions moptions(options);
+
+    TableConstructor c(BytewiseComparator());
+    for (int i = 0; i < 100; i++) {
+      c.Add(InternalKey("key" + ToString(1000 + i), 1, kTypeValue)
+                .Encode()
+                .ToString(),
+            "value");
+    }
+    std::vector<std::string> keys;
+    stl_wrappers::KVMap kvmap;
+    c.Finish(options, ioptions, moptions, table_options,
+             GetPlainInternalComparator(options.comparator), &keys, &kvmap);
+    auto reader = c.GetTableReader();
+    ASSERT_GT(options.statistics->getTickerCount(PDT_FILTER_BYTES_LOADED), 0);
+
+    get_perf_context()->Reset();
+    for (int i = 0; i < 20; i++) {
+      // Every other key is not in the table.
+      const std::string user_key = "key" + ToString(1000 + 10 * i);
+      PinnableSlice value;
+      GetContext get_context(options.comparator, nullptr, nullptr, nullptr,
+                             GetContext::kNotFound, user_key, &value, nullptr,
+                             nullptr, nullptr, nullptr);
+      ASSERT_OK(reader->Get(ReadOptions(),
+                            InternalKey(user_key, 1, kTypeValue).Encode(),
+                            &get_context, moptions.prefix_extractor.get()));
+      ASSERT_EQ(i < 10 ? GetContext::kFound : GetContext::kNotFound,
+                get_context.State());
+    }
+    // Keys past the last partition are filtered without a probe.
+    ASSERT_GE(options.statistics->getTickerCount(PDT_FILTER_PROBES), 10);
+    ASSERT_EQ(options.statistics->getTickerCount(PDT_FILTER_PROBES),
+              get_perf_context()->pdt_filter_probe_count);
+    if (!partition_filters) {
+      ASSERT_EQ(20, options.statistics->getTickerCount(PDT_FILTER_PROBES));
+    }
+    c.ResetTableReader();
+  }
+}
+
+// The PDT filter keeps whole keys, so prefix seeks are filtered with any
+// prefix extractor, even though the table was built without one.
+TEST_P(BlockBasedTableTest, PdtPrefixSeek) {
+  BlockBasedTableOptions table_options = GetBlockBasedTableOptions();
+  table_options.filter_policy.reset(NewOtLexPdtFilterPolicy());
+  table_options.use_pdt = true;
+  Options options;
+  options.statistics = CreateDBStatistics();
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  const ImmutableCFOptions ioptions(options);
+  const MutableCFOptions moptions(options);
+
+  TableConstructor c(BytewiseComparator());
+  for (int i = 0; i < 100; i++) {
+    c.Add(InternalKey("key" + ToString(1000 + i), 1, kTypeValue)
+              .Encode()
+              .ToString(),
+          "value");
+  }
+  std::vector<std::string> keys;
+  stl_wrappers::KVMap kvmap;
+  c.Finish(options, ioptions, moptions, table_options,
+           GetPlainInternalComparator(options.comparator), &keys, &kvmap);
+  auto reader = c.GetTableReader();
+
+  std::unique_ptr<const SliceTransform> extractors[] = {
+      std::unique_ptr<const SliceTransform>(NewFixedPrefixTransform(5)),
+      std::unique_ptr<const SliceTransform>(NewCappedPrefixTransform(6))};
+  std::unique_ptr<InternalIterator> unfiltered(reader->NewIterator(
+      ReadOptions(), /*prefix_extractor=*/nullptr, /*arena=*/nullptr,
+      /*skip_filters=*/true, TableReaderCaller::kUncategorized));
+  for (const auto& extractor : extractors) {
+    SCOPED_TRACE(extractor->Name());
+    options.statistics->Reset();
+    std::unique_ptr<InternalIterator> iter(
+        reader->NewIterator(ReadOptions(), extractor.get(), /*arena=*/nullptr,
+                            /*skip_filters=*/false,
+                            TableReaderCaller::kUncategorized));
+    // "key10..." keys are in the table, "key11..." ones are not. A filtered
+    // seek must land where an unfiltered one does, or be invalidated when
+    // the filter rules the prefix out.
+    for (const std::string user_key : {"key1050", "key1099", "key1100"}) {
+      const InternalKey target(user_key, kMaxSequenceNumber,
+                               kValueTypeForSeek);
+      iter->Seek(target.Encode());
+      unfiltered->Seek(target.Encode());
+      if (user_key >= "key11") {
+        ASSERT_FALSE(iter->Valid()) << user_key;
+        continue;
+      }
+      ASSERT_EQ(unfiltered->Valid(), iter->Valid()) << user_key;
+      if (iter->Valid()) {
+        ASSERT_EQ(unfiltered->key(), iter->key());
+      }
+    }
+    ASSERT_EQ(3,
+              options.statistics->getTickerCount(BLOOM_FILTER_PREFIX_CHECKED));
+    ASSERT_EQ(1,
+              options.statistics->getTickerCount(BLOOM_FILTER_PREFIX_USEFUL));
+  }
+  c.ResetTableReader();
+}
+
 TEST_P(BlockBasedTableTest, BinaryIndexWithFirstKey2) {
   for (int use_first_key = 0; use_first_key < 2; ++use_first_key) {
     SCOPED_TRACE("use_first_key = " + std::to_string(use_first_key));
@@ -30,7 +30,9 @@ DEFINE_string(
     "cache configuration is "
     "cache_name,num_shard_bits,ghost_capacity,cache_capacity_1,...,cache_"
     "capacity_N. Supported cache names are lru, lru_priority, lru_hybrid, and "
-    "lru_hybrid_no_insert_on_row_miss. User may also add a prefix 'ghost_' to "
+    "lru_hybrid_no_insert_on_row_miss. Replacing 'lru' with 'tinylfu' (e.g. "
+    "tinylfu_priority) simulates the W-TinyLFU cache of NewTinyLFUCache "
+    "instead of LRUCache. User may also add a prefix 'ghost_' to "
     "a cache_name to add a ghost cache in front of the real cache. "
     "ghost_capacity and cache_capacity can be xK, xM or xG where x is a "
     "positive number.");
@@ -159,7 +161,10 @@ const std::set<std::string> kGroupbyLabels{
 const std::string kSupportedCacheNames =
     " lru ghost_lru lru_priority ghost_lru_priority lru_hybrid "
     "ghost_lru_hybrid lru_hybrid_no_insert_on_row_miss "
-    "ghost_lru_hybrid_no_insert_on_row_miss ";
+    "ghost_lru_hybrid_no_insert_on_row_miss tinylfu ghost_tinylfu "
+    "tinylfu_priority ghost_tinylfu_priority tinylfu_hybrid "
+    "ghost_tinylfu_hybrid tinylfu_hybrid_no_insert_on_row_miss "
+    "ghost_tinylfu_hybrid_no_insert_on_row_miss ";
 
 // The suffix for the generated csv files.
 const std::string kFileNameSuffixMissRatioTimeline = "miss_ratio_timeline";
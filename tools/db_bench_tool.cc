@@ -779,6 +779,10 @@ DEFINE_string(trace_file, "", "Trace workload to a file. ");
 
 DEFINE_int32(trace_replay_fast_forward, 1,
              "Fast forward trace replay, must >= 1. ");
+DEFINE_int32(trace_replay_threads, 1,
+             "Number of threads running the replayed operations, must >= 1. "
+             "With more than 1, the operations on a key still run in trace "
+             "order.");
 
 DEFINE_int32(block_cache_trace_sampling_frequency, 1,
              "Block cache trace sampling frequency, termed s. It uses spatial "
@@ -832,6 +836,11 @@ static enum rocksdb::CompressionType FLAGS_compression_type_e =
 
 DEFINE_int64(sample_for_compression, 0, "Sample every N block for compression");
 
+DEFINE_string(compressed_cache_compression, "none",
+              "Algorithm to use to compress the blocks stored uncompressed in "
+              "the database when they are demoted from the block cache to the "
+              "compressed block cache (see --compressed_cache_size)");
+
 DEFINE_int32(compression_level, rocksdb::CompressionOptions().level,
              "Compression level. The meaning of this value is library-"
              "dependent. If unset, we try to use the default for the library "
@@ -1197,6 +1206,16 @@ DEFINE_bool(use_hash_search, false, "if use kHashSearch "
 DEFINE_bool(use_block_based_filter, false, "if use kBlockBasedFilter "
             "instead of kFullFilter for filter block. "
             "This is valid if only we use BlockTable");
+DEFINE_string(filter_type, "bloom",
+              "Filter policy of the block based table. bloom: "
+              "NewBloomFilterPolicy(), only used if bloom_bits >= 0. lexpdt, "
+              "centroidpdt, otlexpdt: NewLexPdtFilterPolicy(), "
+              "NewCentriodPdtFilterPolicy() and NewOtLexPdtFilterPolicy(), "
+              "bloom_bits is ignored.");
+DEFINE_bool(use_pdt_filter_block, rocksdb::BlockBasedTableOptions().use_pdt,
+            "if write the filter as a PDT filter block instead of a full "
+            "filter block (BlockBasedTableOptions::use_pdt). "
+            "This is valid if only we use BlockTable");
 DEFINE_string(merge_operator, "", "The merge operator to use with the database."
               "If a new merge operator is specified, be sure to use fresh"
               " database The possible merge operators are defined in"
@@ -2135,6 +2154,25 @@ class Duration {
   uint64_t start_at_;
 };
 
+// Returns the filter policy asked for by --filter_type, nullptr if none.
+static const FilterPolicy* NewFilterPolicyFromFlags() {
+  const char* type = FLAGS_filter_type.c_str();
+  if (!strcasecmp(type, "bloom")) {
+    return FLAGS_bloom_bits >= 0
+               ? NewBloomFilterPolicy(FLAGS_bloom_bits,
+                                      FLAGS_use_block_based_filter)
+               : nullptr;
+  } else if (!strcasecmp(type, "lexpdt")) {
+    return NewLexPdtFilterPolicy(FLAGS_use_block_based_filter);
+  } else if (!strcasecmp(type, "centroidpdt")) {
+    return NewCentriodPdtFilterPolicy(FLAGS_use_block_based_filter);
+  } else if (!strcasecmp(type, "otlexpdt")) {
+    return NewOtLexPdtFilterPolicy(FLAGS_use_block_based_filter);
+  }
+  fprintf(stderr, "Cannot parse filter_type %s\n", type);
+  exit(1);
+}
+
 class Benchmark {
  private:
   std::shared_ptr<Cache> cache_;
@@ -2479,10 +2517,7 @@ class Benchmark {
   Benchmark()
       : cache_(NewCache(FLAGS_cache_size)),
         compressed_cache_(NewCache(FLAGS_compressed_cache_size)),
-        filter_policy_(FLAGS_bloom_bits >= 0
-                           ? NewBloomFilterPolicy(FLAGS_bloom_bits,
-                                                  FLAGS_use_block_based_filter)
-                           : nullptr),
+        filter_policy_(NewFilterPolicyFromFlags()),
         prefix_extractor_(NewFixedPrefixTransform(FLAGS_prefix_size)),
         num_(FLAGS_num),
         value_size_(FLAGS_value_size),
@@ -3613,11 +3648,14 @@ class Benchmark {
       }
       block_based_options.block_cache = cache_;
       block_based_options.block_cache_compressed = compressed_cache_;
+      block_based_options.block_cache_compressed_compression =
+          StringToCompressionType(FLAGS_compressed_cache_compression.c_str());
       block_based_options.block_size = FLAGS_block_size;
       block_based_options.block_restart_interval = FLAGS_block_restart_interval;
       block_based_options.index_block_restart_interval =
           FLAGS_index_block_restart_interval;
       block_based_options.filter_policy = filter_policy_;
+      block_based_options.use_pdt = FLAGS_use_pdt_filter_block;
       block_based_options.format_version =
           static_cast<uint32_t>(FLAGS_format_version);
       block_based_options.read_amp_bytes_per_bit = FLAGS_read_amp_bytes_per_bit;
@@ -3821,9 +3859,8 @@ class Benchmark {
       if (FLAGS_cache_size) {
         table_options->block_cache = cache_;
       }
-      if (FLAGS_bloom_bits >= 0) {
-        table_options->filter_policy.reset(NewBloomFilterPolicy(
-            FLAGS_bloom_bits, FLAGS_use_block_based_filter));
+      if (filter_policy_ != nullptr) {
+        table_options->filter_policy = filter_policy_;
       }
     }
     if (FLAGS_row_cache_size) {
@@ -6421,10 +6458,27 @@ class Benchmark {
                       std::move(trace_reader));
     replayer.SetFastForward(
         static_cast<uint32_t>(FLAGS_trace_replay_fast_forward));
-    s = replayer.Replay();
+    if (FLAGS_trace_replay_threads > 1) {
+      s = replayer.MultiThreadReplay(
+          static_cast<uint32_t>(FLAGS_trace_replay_threads));
+    } else {
+      s = replayer.Replay();
+    }
     if (s.ok()) {
       fprintf(stdout, "Replay started from trace_file: %s\n",
               FLAGS_trace_file.c_str());
+      const std::pair<TraceType, const char*> kReplayedTypes[] = {
+          {kTraceWrite, "Write"},
+          {kTraceGet, "Get"},
+          {kTraceIteratorSeek, "IteratorSeek"},
+          {kTraceIteratorSeekForPrev, "IteratorSeekForPrev"}};
+      for (const auto& type : kReplayedTypes) {
+        const HistogramImpl& hist = replayer.GetLatencyHistogram(type.first);
+        if (!hist.Empty()) {
+          fprintf(stdout, "Microseconds per %s:\n%s\n", type.second,
+                  hist.ToString().c_str());
+        }
+      }
     } else {
       fprintf(stderr, "Starting replay failed. Error: %s\n",
               s.ToString().c_str());
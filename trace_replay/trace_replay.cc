@@ -5,13 +5,18 @@
 
 #include "trace_replay/trace_replay.h"
 
+#include <algorithm>
 #include <chrono>
+#include <deque>
 #include <sstream>
 #include <thread>
 #include "db/db_impl/db_impl.h"
+#include "port/port.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/write_batch.h"
 #include "util/coding.h"
+#include "util/hash.h"
+#include "util/mutexlock.h"
 #include "util/string_util.h"
 
 namespace rocksdb {
@@ -24,7 +29,7 @@ void EncodeCFAndKey(std::string* dst, uint32_t cf_id, const Slice& key) {
   PutLengthPrefixedSlice(dst, key);
 }
 
-void DecodeCFAndKey(std::string& buffer, uint32_t* cf_id, Slice* key) {
+void DecodeCFAndKey(const std::string& buffer, uint32_t* cf_id, Slice* key) {
   Slice buf(buffer);
   GetFixed32(&buf, cf_id);
   GetLengthPrefixedSlice(&buf, key);
@@ -202,11 +207,7 @@ Status Replayer::Replay() {
 
   std::chrono::system_clock::time_point replay_epoch =
       std::chrono::system_clock::now();
-  WriteOptions woptions;
-  ReadOptions roptions;
   Trace trace;
-  uint64_t ops = 0;
-  Iterator* single_iter = nullptr;
   while (s.ok()) {
     trace.reset();
     s = ReadTrace(&trace);
@@ -217,74 +218,299 @@ Status Replayer::Replay() {
     std::this_thread::sleep_until(
         replay_epoch +
         std::chrono::microseconds((trace.ts - header.ts) / fast_forward_));
-    if (trace.type == kTraceWrite) {
-      WriteBatch batch(trace.payload);
-      db_->Write(woptions, &batch);
-      ops++;
-    } else if (trace.type == kTraceGet) {
-      uint32_t cf_id = 0;
-      Slice key;
-      DecodeCFAndKey(trace.payload, &cf_id, &key);
-      if (cf_id > 0 && cf_map_.find(cf_id) == cf_map_.end()) {
-        return Status::Corruption("Invalid Column Family ID.");
-      }
+    if (trace.type == kTraceEnd) {
+      // Do nothing for now.
+      // TODO: Add some validations later.
+      break;
+    }
+    s = CheckColumnFamily(trace);
+    if (!s.ok()) {
+      return s;
+    }
+    ExecuteTrace(trace, latency_hists_);
+  }
 
-      std::string value;
-      if (cf_id == 0) {
-        db_->Get(roptions, key, &value);
-      } else {
-        db_->Get(roptions, cf_map_[cf_id], key, &value);
-      }
-      ops++;
-    } else if (trace.type == kTraceIteratorSeek) {
-      uint32_t cf_id = 0;
-      Slice key;
-      DecodeCFAndKey(trace.payload, &cf_id, &key);
-      if (cf_id > 0 && cf_map_.find(cf_id) == cf_map_.end()) {
-        return Status::Corruption("Invalid Column Family ID.");
+  if (s.IsIncomplete()) {
+    // Reaching eof returns Incomplete status at the moment.
+    // Could happen when killing a process without calling EndTrace() API.
+    // TODO: Add better error handling.
+    return Status::OK();
+  }
+  return s;
+}
+
+namespace {
+// Lets the last of the replay threads serving the keys of a write batch run
+// it, once the others are done with their previous operations.
+struct ReplayBarrier {
+  explicit ReplayBarrier(size_t _pending)
+      : cv(&mutex), pending(_pending), done(false) {}
+
+  port::Mutex mutex;
+  port::CondVar cv;
+  size_t pending;
+  bool done;
+};
+
+struct ReplayTask {
+  std::shared_ptr<Trace> trace;
+  // Only set for the write batches dispatched to several threads.
+  std::shared_ptr<ReplayBarrier> barrier;
+};
+
+// The dispatcher waits for a replay thread falling behind once this many of
+// its operations are queued, rather than reading the whole trace in memory.
+const size_t kMaxQueuedTraces = 1024;
+
+// The operations dispatched to one replay thread, in trace order, and the
+// latencies the thread recorded.
+struct ReplayQueue {
+  ReplayQueue() : cv(&mutex), space_cv(&mutex), closed(false) {}
+
+  port::Mutex mutex;
+  // Signaled when a task is queued or the queue is closed.
+  port::CondVar cv;
+  // Signaled when a task is taken off a full queue.
+  port::CondVar space_cv;
+  std::deque<ReplayTask> tasks;
+  bool closed;
+  HistogramImpl latency_hists[kTraceMax];
+};
+
+size_t GetReplayThread(const Slice& key, size_t threads_num) {
+  return static_cast<size_t>(GetSliceNPHash64(key) % threads_num);
+}
+
+// Finds the replay threads serving the keys of a write batch.
+class ReplayThreadsCollector : public WriteBatch::Handler {
+ public:
+  explicit ReplayThreadsCollector(size_t threads_num)
+      : threads_(threads_num, false) {}
+
+  // A range deletion or an unknown record may cover the keys of any thread.
+  void AddAllThreads() { threads_.assign(threads_.size(), true); }
+  const std::vector<bool>& threads() const { return threads_; }
+
+  Status PutCF(uint32_t /*cf_id*/, const Slice& key,
+               const Slice& /*value*/) override {
+    return AddKey(key);
+  }
+  Status DeleteCF(uint32_t /*cf_id*/, const Slice& key) override {
+    return AddKey(key);
+  }
+  Status SingleDeleteCF(uint32_t /*cf_id*/, const Slice& key) override {
+    return AddKey(key);
+  }
+  Status DeleteRangeCF(uint32_t /*cf_id*/, const Slice& /*begin_key*/,
+                       const Slice& /*end_key*/) override {
+    AddAllThreads();
+    return Status::OK();
+  }
+  Status MergeCF(uint32_t /*cf_id*/, const Slice& key,
+                 const Slice& /*value*/) override {
+    return AddKey(key);
+  }
+  Status PutBlobIndexCF(uint32_t /*cf_id*/, const Slice& key,
+                        const Slice& /*value*/) override {
+    return AddKey(key);
+  }
+  Status MarkBeginPrepare(bool /*unprepare*/) override { return Status::OK(); }
+  Status MarkEndPrepare(const Slice& /*xid*/) override { return Status::OK(); }
+  Status MarkNoop(bool /*empty_batch*/) override { return Status::OK(); }
+  Status MarkRollback(const Slice& /*xid*/) override { return Status::OK(); }
+  Status MarkCommit(const Slice& /*xid*/) override { return Status::OK(); }
+
+ private:
+  Status AddKey(const Slice& key) {
+    threads_[GetReplayThread(key, threads_.size())] = true;
+    return Status::OK();
+  }
+
+  std::vector<bool> threads_;
+};
+}  // namespace
+
+Status Replayer::MultiThreadReplay(uint32_t threads_num) {
+  if (threads_num == 0) {
+    return Status::InvalidArgument("Wrong number of replay threads!");
+  }
+  Status s;
+  Trace header;
+  s = ReadHeader(&header);
+  if (!s.ok()) {
+    return s;
+  }
+
+  std::vector<std::unique_ptr<ReplayQueue>> queues;
+  std::vector<port::Thread> threads;
+  for (uint32_t i = 0; i < threads_num; i++) {
+    queues.emplace_back(new ReplayQueue());
+    ReplayQueue* queue = queues.back().get();
+    threads.emplace_back([this, queue]() {
+      while (true) {
+        ReplayTask task;
+        {
+          MutexLock l(&queue->mutex);
+          while (queue->tasks.empty() && !queue->closed) {
+            queue->cv.Wait();
+          }
+          if (queue->tasks.empty()) {
+            break;
+          }
+          task = std::move(queue->tasks.front());
+          queue->tasks.pop_front();
+          if (queue->tasks.size() + 1 == kMaxQueuedTraces) {
+            queue->space_cv.Signal();
+          }
+        }
+        if (task.barrier == nullptr) {
+          ExecuteTrace(*task.trace, queue->latency_hists);
+          continue;
+        }
+        ReplayBarrier* barrier = task.barrier.get();
+        MutexLock l(&barrier->mutex);
+        if (--barrier->pending == 0) {
+          ExecuteTrace(*task.trace, queue->latency_hists);
+          barrier->done = true;
+          barrier->cv.SignalAll();
+        } else {
+          while (!barrier->done) {
+            barrier->cv.Wait();
+          }
+        }
       }
+    });
+  }
+  auto dispatch = [&queues](size_t thread, ReplayTask task) {
+    ReplayQueue* queue = queues[thread].get();
+    MutexLock l(&queue->mutex);
+    while (queue->tasks.size() >= kMaxQueuedTraces) {
+      queue->space_cv.Wait();
+    }
+    queue->tasks.push_back(std::move(task));
+    queue->cv.Signal();
+  };
+
+  std::chrono::system_clock::time_point replay_epoch =
+      std::chrono::system_clock::now();
+  while (s.ok()) {
+    std::shared_ptr<Trace> trace = std::make_shared<Trace>();
+    trace->reset();
+    s = ReadTrace(trace.get());
+    if (!s.ok()) {
+      break;
+    }
 
-      if (cf_id == 0) {
-        single_iter = db_->NewIterator(roptions);
+    std::this_thread::sleep_until(
+        replay_epoch +
+        std::chrono::microseconds((trace->ts - header.ts) / fast_forward_));
+    if (trace->type == kTraceEnd) {
+      break;
+    } else if (trace->type == kTraceWrite) {
+      ReplayThreadsCollector collector(threads_num);
+      WriteBatch batch(trace->payload);
+      if (!batch.Iterate(&collector).ok()) {
+        collector.AddAllThreads();
+      }
+      const std::vector<bool>& batch_threads = collector.threads();
+      size_t num_batch_threads = static_cast<size_t>(
+          std::count(batch_threads.begin(), batch_threads.end(), true));
+      if (num_batch_threads <= 1) {
+        size_t thread = static_cast<size_t>(
+            std::find(batch_threads.begin(), batch_threads.end(), true) -
+            batch_threads.begin());
+        // An empty batch may run anywhere.
+        dispatch(thread == batch_threads.size() ? 0 : thread,
+                 ReplayTask{trace, nullptr});
       } else {
-        single_iter = db_->NewIterator(roptions, cf_map_[cf_id]);
+        auto barrier = std::make_shared<ReplayBarrier>(num_batch_threads);
+        for (size_t i = 0; i < batch_threads.size(); i++) {
+          if (batch_threads[i]) {
+            dispatch(i, ReplayTask{trace, barrier});
+          }
+        }
+      }
+    } else if (trace->type == kTraceGet || trace->type == kTraceIteratorSeek ||
+               trace->type == kTraceIteratorSeekForPrev) {
+      s = CheckColumnFamily(*trace);
+      if (!s.ok()) {
+        break;
       }
-      single_iter->Seek(key);
-      ops++;
-      delete single_iter;
-    } else if (trace.type == kTraceIteratorSeekForPrev) {
-      // Currently, only support to call the Seek()
       uint32_t cf_id = 0;
       Slice key;
-      DecodeCFAndKey(trace.payload, &cf_id, &key);
-      if (cf_id > 0 && cf_map_.find(cf_id) == cf_map_.end()) {
-        return Status::Corruption("Invalid Column Family ID.");
-      }
+      DecodeCFAndKey(trace->payload, &cf_id, &key);
+      dispatch(GetReplayThread(key, threads_num), ReplayTask{trace, nullptr});
+    }
+  }
 
-      if (cf_id == 0) {
-        single_iter = db_->NewIterator(roptions);
-      } else {
-        single_iter = db_->NewIterator(roptions, cf_map_[cf_id]);
-      }
-      single_iter->SeekForPrev(key);
-      ops++;
-      delete single_iter;
-    } else if (trace.type == kTraceEnd) {
-      // Do nothing for now.
-      // TODO: Add some validations later.
-      break;
+  // Let the threads finish the operations already dispatched.
+  for (auto& queue : queues) {
+    MutexLock l(&queue->mutex);
+    queue->closed = true;
+    queue->cv.SignalAll();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& queue : queues) {
+    for (int type = 0; type < kTraceMax; type++) {
+      latency_hists_[type].Merge(queue->latency_hists[type]);
     }
   }
 
   if (s.IsIncomplete()) {
     // Reaching eof returns Incomplete status at the moment.
-    // Could happen when killing a process without calling EndTrace() API.
-    // TODO: Add better error handling.
     return Status::OK();
   }
   return s;
 }
 
+Status Replayer::CheckColumnFamily(const Trace& trace) {
+  if (trace.type != kTraceGet && trace.type != kTraceIteratorSeek &&
+      trace.type != kTraceIteratorSeekForPrev) {
+    return Status::OK();
+  }
+  uint32_t cf_id = 0;
+  Slice key;
+  DecodeCFAndKey(trace.payload, &cf_id, &key);
+  if (cf_id > 0 && cf_map_.find(cf_id) == cf_map_.end()) {
+    return Status::Corruption("Invalid Column Family ID.");
+  }
+  return Status::OK();
+}
+
+void Replayer::ExecuteTrace(const Trace& trace, HistogramImpl* latency_hists) {
+  Env* env = db_->GetEnv();
+  uint64_t start_micros = env->NowMicros();
+  if (trace.type == kTraceWrite) {
+    WriteBatch batch(trace.payload);
+    db_->Write(WriteOptions(), &batch);
+  } else if (trace.type == kTraceGet || trace.type == kTraceIteratorSeek ||
+             trace.type == kTraceIteratorSeekForPrev) {
+    uint32_t cf_id = 0;
+    Slice key;
+    DecodeCFAndKey(trace.payload, &cf_id, &key);
+    ColumnFamilyHandle* cfh = cf_id == 0 ? db_->DefaultColumnFamily()
+                                         : cf_map_.find(cf_id)->second;
+    if (trace.type == kTraceGet) {
+      std::string value;
+      db_->Get(ReadOptions(), cfh, key, &value);
+    } else {
+      std::unique_ptr<Iterator> single_iter(
+          db_->NewIterator(ReadOptions(), cfh));
+      // Currently, only support to call the Seek() and SeekForPrev()
+      if (trace.type == kTraceIteratorSeek) {
+        single_iter->Seek(key);
+      } else {
+        single_iter->SeekForPrev(key);
+      }
+    }
+  } else {
+    return;
+  }
+  latency_hists[trace.type].Add(env->NowMicros() - start_micros);
+}
+
 Status Replayer::ReadHeader(Trace* header) {
   assert(header != nullptr);
   Status s = ReadTrace(header);
@@ -9,6 +9,7 @@
 #include <unordered_map>
 #include <utility>
 
+#include "monitoring/histogram.h"
 #include "rocksdb/env.h"
 #include "rocksdb/options.h"
 #include "rocksdb/trace_reader_writer.h"
@@ -137,6 +138,17 @@ class Replayer {
   // between the traces into consideration.
   Status Replay();
 
+  // Same as Replay(), but the operations are run by a pool of `threads_num`
+  // threads while this thread reads the traces and dispatches them on time,
+  // so that the concurrency of the traced workload is reproduced. A thread
+  // falling behind holds up the dispatch once a bounded number of operations
+  // are queued to it, and the latencies are recorded by each thread and
+  // merged when the replay is over.
+  // The operations on a key run in trace order: each key is served by a
+  // single thread, and a write batch whose keys are served by several
+  // threads runs once all of them are done with the previous operations.
+  Status MultiThreadReplay(uint32_t threads_num);
+
   // Enables fast forwarding a replay by reducing the delay between the ingested
   // traces.
   // fast_forward : Rate of replay speedup.
@@ -144,15 +156,29 @@ class Replayer {
   //   If > 1, speed up the replay by this amount.
   Status SetFastForward(uint32_t fast_forward);
 
+  // Latency in microseconds of the operations of the given type run by the
+  // replays done so far, e.g. kTraceGet or kTraceWrite.
+  const HistogramImpl& GetLatencyHistogram(TraceType type) const {
+    assert(type < kTraceMax);
+    return latency_hists_[type];
+  }
+
  private:
   Status ReadHeader(Trace* header);
   Status ReadFooter(Trace* footer);
   Status ReadTrace(Trace* trace);
 
+  // Check that the column family of a Get or Iterator trace is known.
+  Status CheckColumnFamily(const Trace& trace);
+  // Run the operation of a trace and record its latency in
+  // `latency_hists[trace.type]`.
+  void ExecuteTrace(const Trace& trace, HistogramImpl* latency_hists);
+
   DBImpl* db_;
   std::unique_ptr<TraceReader> trace_reader_;
   std::unordered_map<uint32_t, ColumnFamilyHandle*> cf_map_;
   uint32_t fast_forward_;
+  HistogramImpl latency_hists_[kTraceMax];
 };
 
 }  // namespace rocksdb
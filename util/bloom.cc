@@ -16,6 +16,8 @@
 #include "util/coding.h"
 #include "util/hash.h"
 
+#include "succinct/mapper.hpp"
+
 namespace rocksdb {
 
 class BlockBasedFilterBlockBuilder;
@@ -214,6 +216,8 @@ class FullFilterBitsReader : public FilterBitsReader {
     }
   }
 
+  size_t ApproximateMemoryUsage() const override { return sizeof(*this); }
+
  private:
   // Filter meta data
   char* data_;
@@ -316,12 +320,9 @@ bool FullFilterBitsReader::HashMayMatch(const uint32_t& hash,
 //wp
 class OtLexPdtBloomBitsReader : public FilterBitsReader {
  public:
-  explicit OtLexPdtBloomBitsReader() {
-    fprintf(stderr, "DEBUG pqc7a26 init OtLexPdtBloomBitsReader\n");
-  }
+  explicit OtLexPdtBloomBitsReader() {}
 
   explicit OtLexPdtBloomBitsReader(const char* buf) {
-    //fprintf(stderr,"in OtLexPdtBloomBitsReader\n");
     // construct a ot lex pdt
     // restore essential members from buf
     ot_pdt.pub_m_centroid_path_string.clear();
@@ -339,47 +340,13 @@ class OtLexPdtBloomBitsReader : public FilterBitsReader {
                          sub_impl,
                          fake_num_probes,
                          buf);
-          
-    //fprintf(stderr,"in OtLexPdtBloomBitsReader2\n");
-//    fprintf(stdout, "DEBUG uq7zbt in otReader sizes for string,label,branch,char,bit,size:%ld,%ld,%ld,%ld,%ld,%ld\n",
-//            ot_pdt.pub_m_centroid_path_string.size(),
-//            ot_pdt.pub_m_labels.size(),
-//            ot_pdt.pub_m_centroid_path_branches.size(),
-//            ot_pdt.pub_m_branching_chars.size(),
-//            ot_pdt.pub_m_bp_m_bits.size(),
-//            ot_pdt.pub_m_bp_m_size);
-
-    //    for (size_t i = 0; i < ot_pdt.pub_m_centroid_path_string.size(); i++) {
-//      fprintf(stdout, "Rstring:%ld,%d\n", i, ot_pdt.pub_m_centroid_path_string[i]);
-//    }
-//    for (size_t i = 0; i < ot_pdt.pub_m_labels.size(); i++) {
-//      fprintf(stdout, "Rlabel:%ld,%d\n", i, ot_pdt.pub_m_labels[i]);
-//    }
-//    for (size_t i = 0; i < ot_pdt.pub_m_centroid_path_branches.size(); i++) {
-//      fprintf(stdout, "Rbranch:%ld,%d\n", i, ot_pdt.pub_m_centroid_path_branches[i]);
-//    }
-//    for (size_t i = 0; i < ot_pdt.pub_m_branching_chars.size(); i++) {
-//      fprintf(stdout, "Rchar:%ld,%d\n", i, ot_pdt.pub_m_branching_chars[i]);
-//    }
-//    for (size_t i = 0; i < ot_pdt.pub_m_bp_m_bits.size(); i++) {
-//      fprintf(stdout, "Rbit:%ld,%ld\n", i, ot_pdt.pub_m_bp_m_bits[i]);
-//    }
-
-//    fprintf(stderr, "DEBUG c2ys95 after RecoverFromCharArray pub_m_bp_m_size:%lu pub_m_bp_m_bits.size():%lu\n",
-//            ot_pdt.pub_m_bp_m_size, ot_pdt.pub_m_bp_m_bits.size());
+
     // init pub_* members, and create a ot lex pdt instance from it
 //        ot_pdt.init_pubs();
-//    auto chrono_start = std::chrono::system_clock::now();
-//fprintf(stderr,"in OtLexPdtBloomBitsReader3\n");
     ot_pdt.instance();
     // ot_pdt.instance(ot_pdt.pub_m_centroid_path_string,ot_pdt.pub_m_centroid_path_branches,
     // ot_pdt.get_bp(),
     // ot_pdt.pub_m_branching_chars,ot_pdt.pub_m_labels);
-//    auto chrono_end = std::chrono::system_clock::now();
-//    std::chrono::microseconds elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(chrono_end-chrono_start);
-//    std::cout << "DEBUG cor73n ot_pdt.instance() takes " <<
-//              elapsed_us.count() << " us." << std::endl;
-//fprintf(stderr,"in OtLexPdtBloomBitsReader4\n");
   }
 
   // No Copy allowed
@@ -392,23 +359,13 @@ class OtLexPdtBloomBitsReader : public FilterBitsReader {
     // idx = search_odt(key.data)
     // if idx != -1, success
     std::string key_string(key.data(), key.data()+key.size());
-//    auto chrono_start = std::chrono::system_clock::now();
     size_t idx = ot_pdt.index(key_string);
-//    auto chrono_end = std::chrono::system_clock::now();
-//    std::chrono::microseconds elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(chrono_end-chrono_start);
-//    std::cout << "DEBUG la045n ot_pdt.index ret:" << idx << ", takes(us) " <<
-//              elapsed_us.count() << std::endl;
-
-    //    fprintf(stdout, "DEBUG ab42kf in OtLexPdtBloomBitsReader::MayMatch(%s): %ld\n",
-//            key.ToString().c_str(), idx);
 
 //     XXX for test
 //    return true;
 
     if (idx != (size_t)-1) {  // hit
       //??? blk_offset = vector<>.find(idx)
-//      fprintf(stdout, "DEBUG i0j5xn ot bitsReader MayMatch(%s): %ld,\n",
-//              key.ToString().c_str(), idx);
       return true;
     } else {
       return false;
@@ -416,12 +373,23 @@ class OtLexPdtBloomBitsReader : public FilterBitsReader {
   }
 
   virtual void MayMatch(int num_keys, Slice** keys, bool* may_match) override {
-    fprintf(stdout, "DEBUG w3xm82 in OtBitsReader::MayMatch(num_keys)\n");
     for (int i = 0; i < num_keys; ++i) {
       may_match[i] = MayMatch(*keys[i]);
     }
   }
 
+  // The trie is rebuilt from the filter rather than mapped, and the buffers
+  // it was rebuilt from are kept along with it.
+  size_t ApproximateMemoryUsage() const override {
+    auto& pdt = const_cast<decltype(ot_pdt)&>(ot_pdt);
+    return sizeof(*this) + rocksdb::succinct::mapper::size_of(pdt) +
+           pdt.pub_m_centroid_path_string.capacity() * sizeof(uint16_t) +
+           pdt.pub_m_labels.capacity() * sizeof(uint16_t) +
+           pdt.pub_m_centroid_path_branches.capacity() +
+           pdt.pub_m_branching_chars.capacity() +
+           pdt.pub_m_bp_m_bits.capacity() * sizeof(uint64_t);
+  }
+
   //wp
   void RecoverFromCharArray(std::vector<uint16_t>& v1,
                             std::vector<uint16_t>& v2,
@@ -482,7 +450,6 @@ class OtLexPdtBloomBitsReader : public FilterBitsReader {
 
     uint64_t *p3 = (uint64_t *) (buf + 4 + size1 * 2 + 4 + size2 * 2 + 4 + size3 + 4 + size4 + 4 + size5 * 8);
     num = *p3;
-//    fprintf(stderr, "DEBUG m72qa4 RecoverFromCharArray num: %lu\n", num);
 
     //xp, be compatible with full filter
     char* pc1 = (char*) (buf + 4 + size1 * 2 + 4 + size2 * 2 + 4 + size3 + 4 + size4 + 4 + size5 * 8 + 8);
@@ -495,10 +462,6 @@ class OtLexPdtBloomBitsReader : public FilterBitsReader {
     tmp_fake_num_probes = *pc4;
     char* pc5 = (char*) (buf + 4 + size1 * 2 + 4 + size2 * 2 + 4 + size3 + 4 + size4 + 4 + size5 * 8 + 8+1+1+1+1);
     tmp_fake_num_probes = *pc5;
-
-    uint64_t sssize=pc5-buf+1;
-    fprintf(stderr,"in Recover buf size=%ld\n\n\n",pc5-buf+1);
-
   }
 
   // be compatible with full filter in GetBloomBitsReader
@@ -535,7 +498,6 @@ class BloomFilterPolicy : public FilterPolicy {
   const char* Name() const override { return "rocksdb.BuiltinBloomFilter"; }
 
   void CreateFilter(const Slice* keys, int n, std::string* dst) const override {
-    printf("in bloom CreateFilter\n");
     // Compute bloom filter size (in both bits and bytes)
     size_t bits = n * bits_per_key_;
 
@@ -564,7 +526,6 @@ class BloomFilterPolicy : public FilterPolicy {
   }
 
   bool KeyMayMatch(const Slice& key, const Slice& bloom_filter) const override {
-    printf("in bloom KeyMayMatch\n");
     const size_t len = bloom_filter.size();
     if (len < 2) return false;
 
@@ -605,8 +566,6 @@ class BloomFilterPolicy : public FilterPolicy {
   }
 
   FilterBitsReader* GetFilterBitsReader(const Slice& contents) const override {
-
-    //fprintf(stderr,"in bloom GetFilterBitsReader\n");
     if(isPdt)
     {
       return new OtLexPdtBloomBitsReader(contents.data());
@@ -0,0 +1,419 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef GFLAGS
+#include <cstdio>
+int main() {
+  fprintf(stderr, "Please install gflags to run rocksdb tools\n");
+  return 1;
+}
+#else
+
+#include <algorithm>
+#include <cinttypes>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "port/port.h"
+#include "rocksdb/env.h"
+#include "rocksdb/filter_policy.h"
+#include "rocksdb/slice.h"
+#include "util/gflags_compat.h"
+#include "util/random.h"
+#include "util/stop_watch.h"
+
+using GFLAGS_NAMESPACE::ParseCommandLineFlags;
+using GFLAGS_NAMESPACE::SetUsageMessage;
+
+DEFINE_string(filter_policies, "blockbloom,bloom,lexpdt,centroidpdt,otlexpdt",
+              "Comma separated list of the filter policies to benchmark, out "
+              "of blockbloom (NewBloomFilterPolicy() with the block based "
+              "builder), bloom (NewBloomFilterPolicy() full filter), lexpdt, "
+              "centroidpdt and otlexpdt.");
+DEFINE_int32(bits_per_key, 10, "Bits per key of the bloom filters.");
+
+DEFINE_uint32(keys_per_filter, 10000,
+              "Number of keys per filter, i.e. per SST file or partition.");
+DEFINE_uint32(num_filters, 100,
+              "Number of filters. Cold probes go to a random filter, so the "
+              "filters together should not fit in the CPU caches.");
+DEFINE_uint32(queries, 1000000, "Number of probes of every kind.");
+DEFINE_uint32(batch_size, 32, "Number of keys per batched probe.");
+DEFINE_uint32(positive_percent, 50,
+              "Percentage of the probes for keys added to the filter.");
+DEFINE_uint32(seed, 301, "Seed of the key and probe generators.");
+
+DEFINE_string(keys_file, "",
+              "If set, keys are sampled from this file, one key per line, "
+              "instead of being generated. Probes for absent keys are keys of "
+              "the file with the last byte changed.");
+DEFINE_uint32(key_len_min, 16, "Minimum length of the generated keys.");
+DEFINE_uint32(key_len_max, 16,
+              "Maximum length of the generated keys, lengths are uniform "
+              "between key_len_min and key_len_max.");
+DEFINE_uint32(prefix_len, 0,
+              "Length of the prefix shared by the generated keys of a group, "
+              "e.g. the tenant/table part of the keys. Included in the key "
+              "length.");
+DEFINE_uint32(num_prefixes, 100, "Number of distinct generated prefixes.");
+DEFINE_bool(printable_keys, false,
+            "Generate keys out of [a-z0-9] instead of all the byte values.");
+
+namespace rocksdb {
+namespace {
+// Generates keys following the key length flags.
+class KeyGenerator {
+ public:
+  explicit KeyGenerator(uint32_t seed) : rnd_(seed) {
+    for (uint32_t i = 0; i < std::max(FLAGS_num_prefixes, 1u); i++) {
+      prefixes_.push_back(RandomBytes(FLAGS_prefix_len));
+    }
+  }
+
+  std::string Next() {
+    uint32_t len = FLAGS_key_len_min;
+    if (FLAGS_key_len_max > FLAGS_key_len_min) {
+      len += rnd_.Uniform(FLAGS_key_len_max - FLAGS_key_len_min + 1);
+    }
+    std::string key;
+    if (FLAGS_prefix_len > 0) {
+      key = prefixes_[rnd_.Uniform(static_cast<int>(prefixes_.size()))];
+    }
+    if (len > key.size()) {
+      key.append(RandomBytes(len - key.size()));
+    }
+    return key;
+  }
+
+  char RandomByte() {
+    if (FLAGS_printable_keys) {
+      static const char kChars[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+      return kChars[rnd_.Uniform(static_cast<int>(sizeof(kChars) - 1))];
+    }
+    return static_cast<char>(rnd_.Uniform(256));
+  }
+
+  Random* rnd() { return &rnd_; }
+
+ private:
+  std::string RandomBytes(size_t len) {
+    std::string bytes;
+    for (size_t i = 0; i < len; i++) {
+      bytes.push_back(RandomByte());
+    }
+    return bytes;
+  }
+
+  Random rnd_;
+  std::vector<std::string> prefixes_;
+};
+
+struct Query {
+  uint32_t filter;
+  std::string key;
+  bool positive;
+};
+
+// Keys of every filter and the probes, shared by all the policies.
+struct Workload {
+  std::vector<std::vector<std::string>> keys;
+  uint64_t num_keys = 0;
+  // Probes of the first filter only, and probes of random filters.
+  std::vector<Query> hot_queries;
+  std::vector<Query> cold_queries;
+};
+
+Status LoadKeys(std::vector<std::string>* keys) {
+  std::ifstream in(FLAGS_keys_file);
+  if (!in) {
+    return Status::IOError("Cannot open " + FLAGS_keys_file);
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    keys->push_back(line);
+  }
+  if (keys->empty()) {
+    return Status::InvalidArgument("No key in " + FLAGS_keys_file);
+  }
+  return Status::OK();
+}
+
+Status MakeWorkload(Workload* w) {
+  KeyGenerator gen(FLAGS_seed);
+  std::vector<std::string> sampled;
+  if (!FLAGS_keys_file.empty()) {
+    Status s = LoadKeys(&sampled);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+
+  w->keys.resize(FLAGS_num_filters);
+  std::vector<std::unordered_set<std::string>> members(FLAGS_num_filters);
+  for (uint32_t f = 0; f < FLAGS_num_filters; f++) {
+    for (uint32_t i = 0; i < FLAGS_keys_per_filter; i++) {
+      if (sampled.empty()) {
+        members[f].insert(gen.Next());
+      } else {
+        const size_t n = sampled.size();
+        members[f].insert(
+            sampled[(static_cast<size_t>(f) * FLAGS_keys_per_filter + i) % n]);
+      }
+    }
+    // Table builders add the keys in order.
+    w->keys[f].assign(members[f].begin(), members[f].end());
+    std::sort(w->keys[f].begin(), w->keys[f].end());
+    w->num_keys += w->keys[f].size();
+  }
+
+  auto make_query = [&](uint32_t f) {
+    Query q;
+    q.filter = f;
+    q.positive = gen.rnd()->Uniform(100) < FLAGS_positive_percent;
+    const std::vector<std::string>& keys = w->keys[f];
+    if (q.positive) {
+      q.key = keys[gen.rnd()->Uniform(static_cast<int>(keys.size()))];
+      return q;
+    }
+    do {
+      if (sampled.empty()) {
+        q.key = gen.Next();
+      } else {
+        q.key = keys[gen.rnd()->Uniform(static_cast<int>(keys.size()))];
+        if (q.key.empty()) {
+          q.key.push_back(gen.RandomByte());
+        } else {
+          q.key.back() = gen.RandomByte();
+        }
+      }
+    } while (members[f].count(q.key) > 0);
+    return q;
+  };
+  // Batches go to a single filter, as a MultiGet batch goes to one file.
+  const uint32_t batch_size = std::max(FLAGS_batch_size, 1u);
+  uint32_t filter = 0;
+  for (uint32_t i = 0; i < FLAGS_queries; i++) {
+    w->hot_queries.push_back(make_query(0));
+    if (i % batch_size == 0) {
+      filter = gen.rnd()->Uniform(static_cast<int>(FLAGS_num_filters));
+    }
+    w->cold_queries.push_back(make_query(filter));
+  }
+  return Status::OK();
+}
+
+const FilterPolicy* NewPolicy(const std::string& name) {
+  if (name == "blockbloom") {
+    return NewBloomFilterPolicy(FLAGS_bits_per_key, true);
+  } else if (name == "bloom") {
+    return NewBloomFilterPolicy(FLAGS_bits_per_key, false);
+  } else if (name == "lexpdt") {
+    return NewLexPdtFilterPolicy(false);
+  } else if (name == "centroidpdt") {
+    return NewCentriodPdtFilterPolicy(false);
+  } else if (name == "otlexpdt") {
+    return NewOtLexPdtFilterPolicy(false);
+  }
+  return nullptr;
+}
+
+class FilterBench {
+ public:
+  FilterBench(const Workload& w, const FilterPolicy* policy)
+      : w_(w), policy_(policy), env_(Env::Default()) {}
+
+  void Run() {
+    Build();
+    uint64_t false_positives = 0;
+    uint64_t negatives = 0;
+    const double hot = ProbeSingle(w_.hot_queries, &false_positives, &negatives);
+    const double cold = ProbeSingle(w_.cold_queries, nullptr, nullptr);
+    const double hot_batched = ProbeBatched(w_.hot_queries);
+    const double cold_batched = ProbeBatched(w_.cold_queries);
+
+    fprintf(stdout, "%-12s %10.2f %10.4f%% %12.1f %9.1f %9.1f %9.1f %9.1f\n",
+            name_.c_str(), 8.0 * filter_bytes_ / w_.num_keys,
+            negatives == 0 ? 0.0 : 100.0 * false_positives / negatives,
+            static_cast<double>(build_nanos_) / w_.num_keys, hot, cold,
+            hot_batched, cold_batched);
+    fflush(stdout);
+  }
+
+  void set_name(const std::string& name) { name_ = name; }
+
+ private:
+  // Policies without a FilterBitsBuilder are built with CreateFilter() and
+  // probed with KeyMayMatch(), as the block based filter does.
+  void Build() {
+    StopWatchNano timer(env_, true);
+    for (const auto& keys : w_.keys) {
+      std::unique_ptr<FilterBitsBuilder> builder(
+          policy_->GetFilterBitsBuilder());
+      if (builder == nullptr) {
+        std::vector<Slice> key_slices(keys.begin(), keys.end());
+        std::string filter;
+        policy_->CreateFilter(key_slices.data(),
+                              static_cast<int>(key_slices.size()), &filter);
+        filter_bytes_ += filter.size();
+        block_based_filters_.push_back(std::move(filter));
+        continue;
+      }
+      for (const auto& key : keys) {
+        builder->AddKey(key);
+      }
+      std::unique_ptr<const char[]> buf;
+      Slice filter = builder->Finish(&buf);
+      filter_bytes_ += filter.size();
+      bufs_.push_back(std::move(buf));
+      filters_.push_back(filter);
+    }
+    build_nanos_ = timer.ElapsedNanos();
+    for (const auto& filter : filters_) {
+      readers_.emplace_back(policy_->GetFilterBitsReader(filter));
+    }
+  }
+
+  bool MayMatch(const Query& q) {
+    if (readers_.empty()) {
+      return policy_->KeyMayMatch(q.key, block_based_filters_[q.filter]);
+    }
+    return readers_[q.filter]->MayMatch(q.key);
+  }
+
+  void CheckNoFalseNegative(const Query& q, bool may_match) {
+    if (q.positive && !may_match) {
+      fprintf(stderr, "%s: false negative on filter %u\n", name_.c_str(),
+              q.filter);
+      exit(1);
+    }
+  }
+
+  // Returns ns per probe.
+  double ProbeSingle(const std::vector<Query>& queries,
+                     uint64_t* false_positives, uint64_t* negatives) {
+    std::vector<char> results(queries.size());
+    StopWatchNano timer(env_, true);
+    for (size_t i = 0; i < queries.size(); i++) {
+      results[i] = MayMatch(queries[i]);
+    }
+    const uint64_t nanos = timer.ElapsedNanos();
+    for (size_t i = 0; i < queries.size(); i++) {
+      CheckNoFalseNegative(queries[i], results[i] != 0);
+      if (negatives != nullptr && !queries[i].positive) {
+        ++*negatives;
+        *false_positives += results[i];
+      }
+    }
+    return queries.empty() ? 0.0 : static_cast<double>(nanos) / queries.size();
+  }
+
+  double ProbeBatched(const std::vector<Query>& queries) {
+    const size_t batch_size = std::max(FLAGS_batch_size, 1u);
+    std::vector<Slice> keys(queries.size());
+    std::vector<Slice*> key_ptrs(queries.size());
+    for (size_t i = 0; i < queries.size(); i++) {
+      keys[i] = queries[i].key;
+      key_ptrs[i] = &keys[i];
+    }
+    std::unique_ptr<bool[]> results(new bool[queries.size()]);
+    StopWatchNano timer(env_, true);
+    for (size_t i = 0; i < queries.size(); i += batch_size) {
+      const size_t n = std::min(batch_size, queries.size() - i);
+      if (readers_.empty()) {
+        for (size_t j = i; j < i + n; j++) {
+          results[j] = MayMatch(queries[j]);
+        }
+      } else {
+        readers_[queries[i].filter]->MayMatch(static_cast<int>(n),
+                                              &key_ptrs[i], &results[i]);
+      }
+    }
+    const uint64_t nanos = timer.ElapsedNanos();
+    for (size_t i = 0; i < queries.size(); i++) {
+      CheckNoFalseNegative(queries[i], results[i]);
+    }
+    return queries.empty() ? 0.0 : static_cast<double>(nanos) / queries.size();
+  }
+
+  const Workload& w_;
+  const FilterPolicy* policy_;
+  Env* env_;
+  std::string name_;
+  std::vector<std::unique_ptr<const char[]>> bufs_;
+  std::vector<Slice> filters_;
+  std::vector<std::unique_ptr<FilterBitsReader>> readers_;
+  std::vector<std::string> block_based_filters_;
+  uint64_t filter_bytes_ = 0;
+  uint64_t build_nanos_ = 0;
+};
+
+void PrintEnv(const Workload& w) {
+  fprintf(stdout, "Filters             : %u\n", FLAGS_num_filters);
+  fprintf(stdout, "Keys                : %" PRIu64 "\n", w.num_keys);
+  if (FLAGS_keys_file.empty()) {
+    fprintf(stdout, "Key length          : %u - %u\n", FLAGS_key_len_min,
+            FLAGS_key_len_max);
+    fprintf(stdout, "Prefix              : %u x %u bytes\n",
+            FLAGS_num_prefixes, FLAGS_prefix_len);
+  } else {
+    fprintf(stdout, "Keys file           : %s\n", FLAGS_keys_file.c_str());
+  }
+  fprintf(stdout, "Queries             : %u, %u%% positive\n", FLAGS_queries,
+          FLAGS_positive_percent);
+  fprintf(stdout, "Batch size          : %u\n", FLAGS_batch_size);
+  fprintf(stdout, "----------------------------\n");
+  fprintf(stdout, "%-12s %10s %11s %12s %9s %9s %9s %9s\n", "policy",
+          "bits/key", "fp rate", "build ns/key", "hot ns", "cold ns",
+          "hot b.ns", "cold b.ns");
+}
+}  // namespace
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  SetUsageMessage(std::string("\nUSAGE:\n") + std::string(argv[0]) +
+                  " [OPTIONS]...");
+  ParseCommandLineFlags(&argc, &argv, true);
+
+  if (FLAGS_num_filters == 0 || FLAGS_keys_per_filter == 0) {
+    fprintf(stderr, "num_filters and keys_per_filter must be positive\n");
+    exit(1);
+  }
+  if (FLAGS_key_len_max < FLAGS_key_len_min ||
+      FLAGS_prefix_len > FLAGS_key_len_min) {
+    fprintf(stderr,
+            "key_len_min <= key_len_max and prefix_len <= key_len_min are "
+            "expected\n");
+    exit(1);
+  }
+
+  rocksdb::Workload w;
+  rocksdb::Status s = rocksdb::MakeWorkload(&w);
+  if (!s.ok()) {
+    fprintf(stderr, "%s\n", s.ToString().c_str());
+    exit(1);
+  }
+  rocksdb::PrintEnv(w);
+
+  std::stringstream names(FLAGS_filter_policies);
+  std::string name;
+  while (std::getline(names, name, ',')) {
+    std::unique_ptr<const rocksdb::FilterPolicy> policy(
+        rocksdb::NewPolicy(name));
+    if (policy == nullptr) {
+      fprintf(stderr, "Unknown filter policy %s\n", name.c_str());
+      exit(1);
+    }
+    rocksdb::FilterBench bench(w, policy.get());
+    bench.set_name(name);
+    bench.Run();
+  }
+  return 0;
+}
+
+#endif  // GFLAGS
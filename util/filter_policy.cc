@@ -9,8 +9,70 @@
 
 #include "rocksdb/filter_policy.h"
 
+#include <string.h>
+
 namespace rocksdb {
 
 FilterPolicy::~FilterPolicy() { }
 
+namespace {
+
+class LevelFilterPolicySelector : public FilterPolicySelector {
+ public:
+  LevelFilterPolicySelector(std::shared_ptr<const FilterPolicy> upper_policy,
+                            std::shared_ptr<const FilterPolicy> lower_policy,
+                            int num_upper_levels, uint64_t max_upper_file_size)
+      : upper_policy_(std::move(upper_policy)),
+        lower_policy_(std::move(lower_policy)),
+        num_upper_levels_(num_upper_levels),
+        max_upper_file_size_(max_upper_file_size) {}
+
+  const char* Name() const override {
+    return "rocksdb.LevelFilterPolicySelector";
+  }
+
+  std::shared_ptr<const FilterPolicy> Select(
+      const FilterPolicySelectionContext& context) const override {
+    if (context.level < num_upper_levels_ ||
+        (context.target_file_size > 0 &&
+         context.target_file_size <= max_upper_file_size_)) {
+      return upper_policy_;
+    }
+    return lower_policy_;
+  }
+
+  std::vector<std::shared_ptr<const FilterPolicy>> Policies() const override {
+    std::vector<std::shared_ptr<const FilterPolicy>> policies;
+    for (const auto& policy : {upper_policy_, lower_policy_}) {
+      if (policy != nullptr &&
+          (policies.empty() || policies.back() != policy)) {
+        policies.push_back(policy);
+      }
+    }
+    return policies;
+  }
+
+ private:
+  const std::shared_ptr<const FilterPolicy> upper_policy_;
+  const std::shared_ptr<const FilterPolicy> lower_policy_;
+  const int num_upper_levels_;
+  const uint64_t max_upper_file_size_;
+};
+
+}  // namespace
+
+FilterPolicySelector* NewLevelFilterPolicySelector(
+    std::shared_ptr<const FilterPolicy> upper_policy,
+    std::shared_ptr<const FilterPolicy> lower_policy, int num_upper_levels,
+    uint64_t max_upper_file_size) {
+  if (upper_policy != nullptr && lower_policy != nullptr &&
+      upper_policy != lower_policy &&
+      strcmp(upper_policy->Name(), lower_policy->Name()) == 0) {
+    return nullptr;
+  }
+  return new LevelFilterPolicySelector(std::move(upper_policy),
+                                       std::move(lower_policy),
+                                       num_upper_levels, max_upper_file_size);
+}
+
 }  // namespace rocksdb
@@ -6,54 +6,243 @@
 // Copyright (c) 2012 The LevelDB Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
-#include <tries/vbyte_string_pool.hpp>
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include "include/rocksdb/filter_policy.h"
 #include "port/port.h"
 #include "util/coding.h"
-#include "utilities/ot/tries/compacted_trie_builder.hpp"
-#include "utilities/ot/tries/path_decomposed_trie.hpp"
 
-#include <algorithm>
+#include "succinct/mapper.hpp"
+#include "tries/compressed_string_pool.hpp"
+#include "tries/path_decomposed_trie.hpp"
 
 namespace rocksdb {
-// An implementation of filter policy
 namespace {
-//template <bool Lexicographic = false>
-//class OtLexPdtFilterPolicy : public FilterPolicy {
-// public:
-//  explicit OtLexPdtFilterPolicy(bool use_block_based_builder)
-//      : use_block_based_builder_(use_block_based_builder) {}
+// A lexicographic path-decomposed trie whose node labels are kept in a
+// Re-Pair compressed string pool: label strings shared by many nodes (the
+// common tenant/table/row parts of the keys) are stored once in the
+// dictionary and referenced by code. The filter is the frozen trie followed
+// by a fixed size trailer:
+//
+// +-------------------------------------------------------------+
+// | frozen path_decomposed_trie<compressed_string_pool, true>   |
+// +-------------------------------------------------------------+
+// | fixed64 frozen size | fixed32 format tag (kOtLexPdtFormat)   |
+// +-------------------------------------------------------------+
+//
+// The trie is mapped in place, so the filter contents must be 8 bytes
+// aligned to be used without a copy.
+typedef succinct::tries::path_decomposed_trie<
+    succinct::tries::compressed_string_pool, true>
+    OtLexPdt;
+
+const uint32_t kOtLexPdtFormat = 1;
+const size_t kOtLexPdtTrailerSize = sizeof(uint64_t) + sizeof(uint32_t);
+
+// Labels are compressed, most of the filter is taken by the bp, branch and
+// code stream bits of every key.
+const uint32_t kOtLexEstimatedBytesPerKey = 6;
+
+// The trie takes null-terminated strings, so 0x00 and 0x01 are escaped as
+// 0x01 0x01 and 0x01 0x02. The escaping keeps the order of the keys.
+void EscapeKey(const Slice& key, std::string* dst) {
+  dst->clear();
+  dst->reserve(key.size() + 1);
+  for (size_t i = 0; i < key.size(); i++) {
+    const char c = key[i];
+    if (c == '\0' || c == '\x01') {
+      dst->push_back('\x01');
+      dst->push_back(static_cast<char>(c + 1));
+    } else {
+      dst->push_back(c);
+    }
+  }
+}
+
+void BuildOtLexPdt(std::vector<std::string>* escaped_keys, std::string* dst) {
+  if (escaped_keys->empty()) {
+    return;
+  }
+  std::sort(escaped_keys->begin(), escaped_keys->end());
+  escaped_keys->erase(std::unique(escaped_keys->begin(), escaped_keys->end()),
+                      escaped_keys->end());
+  OtLexPdt trie(*escaped_keys);
+  std::ostringstream frozen;
+  succinct::mapper::freeze(trie, frozen);
+  const std::string data = frozen.str();
+  const size_t init_size = dst->size();
+  dst->append(data);
+  PutFixed64(dst, dst->size() - init_size);
+  PutFixed32(dst, kOtLexPdtFormat);
+}
+
+class OtLexPdtFilterBitsBuilder : public FilterBitsBuilder {
+ public:
+  OtLexPdtFilterBitsBuilder() {}
+
+  // No copying allowed
+  OtLexPdtFilterBitsBuilder(const OtLexPdtFilterBitsBuilder&) = delete;
+  void operator=(const OtLexPdtFilterBitsBuilder&) = delete;
+
+  ~OtLexPdtFilterBitsBuilder() override {}
+
+  void AddKey(const Slice& key) override {
+    escaped_keys_.emplace_back();
+    EscapeKey(key, &escaped_keys_.back());
+  }
+
+  Slice Finish(std::unique_ptr<const char[]>* buf) override {
+    std::string filter;
+    BuildOtLexPdt(&escaped_keys_, &filter);
+    escaped_keys_.clear();
+
+    char* data = new char[filter.size()];
+    memcpy(data, filter.data(), filter.size());
+    buf->reset(data);
+    return Slice(data, filter.size());
+  }
+
+  int CalculateNumEntry(const uint32_t space) override {
+    return std::max(1, static_cast<int>(space / kOtLexEstimatedBytesPerKey));
+  }
+
+ private:
+  std::vector<std::string> escaped_keys_;
+};
+
+// Maps the frozen trie over `contents`, which must outlive the reader. Only
+// contents that are not 8 bytes aligned are copied first.
+class OtLexPdtFilterBitsReader : public FilterBitsReader {
+ public:
+  explicit OtLexPdtFilterBitsReader(const Slice& contents)
+      : empty_(contents.empty()), ok_(false) {
+    if (contents.size() < kOtLexPdtTrailerSize) {
+      return;
+    }
+    const char* trailer =
+        contents.data() + contents.size() - kOtLexPdtTrailerSize;
+    const uint64_t frozen_size = DecodeFixed64(trailer);
+    if (DecodeFixed32(trailer + sizeof(uint64_t)) != kOtLexPdtFormat ||
+        frozen_size != contents.size() - kOtLexPdtTrailerSize) {
+      return;
+    }
+    const char* data = contents.data();
+    if (reinterpret_cast<uintptr_t>(data) % sizeof(uint64_t) != 0) {
+      aligned_size_ = static_cast<size_t>((frozen_size + 7) / 8 * 8);
+      aligned_.reset(new uint64_t[aligned_size_ / 8]);
+      memcpy(aligned_.get(), data, frozen_size);
+      data = reinterpret_cast<const char*>(aligned_.get());
+    }
+    ok_ = succinct::mapper::map(trie_, data) <= frozen_size;
+  }
+
+  // No copying allowed
+  OtLexPdtFilterBitsReader(const OtLexPdtFilterBitsReader&) = delete;
+  void operator=(const OtLexPdtFilterBitsReader&) = delete;
+
+  ~OtLexPdtFilterBitsReader() override {}
+
+  bool MayMatch(const Slice& entry) override {
+    if (empty_) {
+      return false;
+    }
+    if (!ok_) {
+      // broken filter, regarded as match
+      return true;
+    }
+    std::string escaped;
+    EscapeKey(entry, &escaped);
+    return trie_.index(escaped) != static_cast<size_t>(-1);
+  }
+
+  // The escaping maps a prefix of a key to a prefix of the escaped key.
+  bool PrefixMayMatch(const Slice& prefix) override {
+    if (empty_) {
+      return false;
+    }
+    if (!ok_) {
+      return true;
+    }
+    std::string escaped;
+    EscapeKey(prefix, &escaped);
+    const uint8_t* begin = reinterpret_cast<const uint8_t*>(escaped.data());
+    return trie_.has_prefix(
+        succinct::util::char_range(begin, begin + escaped.size()));
+  }
+
+  void MayMatch(int num_keys, Slice** keys, bool* may_match) override {
+    for (int i = 0; i < num_keys; i++) {
+      may_match[i] = MayMatch(*keys[i]);
+    }
+  }
+
+  // The trie is mapped, only an unaligned filter is copied.
+  size_t ApproximateMemoryUsage() const override {
+    return sizeof(*this) + aligned_size_;
+  }
+
+ private:
+  const bool empty_;
+  bool ok_;
+  size_t aligned_size_ = 0;
+  std::unique_ptr<uint64_t[]> aligned_;
+  OtLexPdt trie_;
+};
+
+class OtLexPdtFilterPolicy : public FilterPolicy {
+ public:
+  explicit OtLexPdtFilterPolicy(bool use_block_based_builder)
+      : use_block_based_builder_(use_block_based_builder) {}
 
-//  ~OtLexPdtFilterPolicy() override {}
+  ~OtLexPdtFilterPolicy() override {}
 
-//  const char* Name() const override { return "rocksdb.OtLexPdtFilter"; }
+  const char* Name() const override { return "rocksdb.OtLexPdtFilter"; }
 
-  // xp
-  // please ensure keys are sorted
-//  void CreateFilter(const Slice* keys, int n, std::string* dst) const override {
-//    fprintf(stdout, "in OtLexPdt CreateFilter() do nothing\n");
-//  }
+  void CreateFilter(const Slice* keys, int n, std::string* dst) const override {
+    std::vector<std::string> escaped_keys(std::max(n, 0));
+    for (int i = 0; i < n; i++) {
+      EscapeKey(keys[i], &escaped_keys[i]);
+    }
+    BuildOtLexPdt(&escaped_keys, dst);
+  }
 
+  bool KeyMayMatch(const Slice& key, const Slice& filter) const override {
+    if (filter.empty()) {
+      return false;
+    }
+    OtLexPdtFilterBitsReader reader(filter);
+    return reader.MayMatch(key);
+  }
 
-//  bool KeyMayMatch(const Slice& key, const Slice& bloom_filter) const override {
-//    fprintf(stdout, "in OtLexPdt KeyMayMatch() always return 1\n");
-//    return true;
-//  }
+  // Full filter is used unless the block based builder is asked for
+  // explicitly.
+  FilterBitsBuilder* GetFilterBitsBuilder() const override {
+    if (use_block_based_builder_) {
+      return nullptr;
+    }
+    return new OtLexPdtFilterBitsBuilder();
+  }
 
-//  FilterBitsBuilder* GetFilterBitsBuilder() const { return nullptr; }
+  FilterBitsReader* GetFilterBitsReader(const Slice& contents) const override {
+    return new OtLexPdtFilterBitsReader(contents);
+  }
 
-//  FilterBitsReader* GetFilterBitsReader(const Slice& /*contents*/) const {
-//    return nullptr;
-//  }
+  // CreateFilter() escapes the keys the way the bits builder does.
+  FilterBitsReader* DecodeFilter(const Slice& filter) const override {
+    return new OtLexPdtFilterBitsReader(filter);
+  }
 
-// private:
-//  const bool use_block_based_builder_;
-//};
+ private:
+  const bool use_block_based_builder_;
+};
 }  // namespace
 
-//const FilterPolicy* NewOtLexPdtFilterPolicy(bool use_block_based_builer) {
-//  return new OtLexPdtFilterPolicy<true>(use_block_based_builer);
-//}
+const FilterPolicy* NewOtLexPdtFilterPolicy(bool use_block_based_builder) {
+  return new OtLexPdtFilterPolicy(use_block_based_builder);
+}
 
-}  // namespace rocksdb
\ No newline at end of file
+}  // namespace rocksdb
@@ -6,114 +6,667 @@
 // Copyright (c) 2012 The LevelDB Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "include/rocksdb/filter_policy.h"
 #include "port/port.h"
+#include "test_util/sync_point.h"
+#include "util/autovector.h"
 #include "util/coding.h"
+#include "util/pdt.h"
 #include "utilities/pdt/default_tree_builder.h"
 #include "utilities/pdt/path_decomposed_trie.h"
 
 namespace rocksdb {
 // An implementation of filter policy
 namespace {
-template<bool Lexicographic = false>
-class PdtFilterPolicy : public FilterPolicy {
+// Layout of a pdt filter written by `CreateFilter`:
+//
+// +-----------------------------------------------------------------+
+// | varint32 format tag (kPdtFormatEliasFano)                       |
+// | varint64 bp bit size                                            |
+// | varint64 number of word positions                               |
+// | varint64 word pos low bit width | varint64 word pos high bits    |
+// | varint64 byte size of every section below (in order)            |
+// | varint64 internal nodes of bp min-excess tree                   |
+// | padding to 8 bytes                                              |
+// +-----------------------------------------------------------------+
+// | bp words | word_pos high words | word_pos high rank pairs       |
+// | word_pos high select hints | word_pos low words                 |
+// | rank pairs | select hints | select0 hints                       |
+// | superblock excess min | labels | branches | block excess min    |
+// +-----------------------------------------------------------------+
+//
+// Rank/select indices and min-excess tree of `bp` are persisted, so decoding
+// is only a mapping of the sections and a probe does not rebuild anything.
+// Word positions are an Elias-Fano sequence (see EliasFanoVector), mapped
+// the same way. Sections are ordered by their alignment.
+//
+// kPdtFormatIndexed has no word position fields in the header and a single
+// word_pos section of raw uint64_t instead of the four Elias-Fano ones. It's
+// still readable, the word positions are encoded when the filter is mapped.
+//
+// The legacy layout (no format tag, no indices) starts with the bp bit size,
+// which is always even, so an odd format tag can't be confused with it.
+// Legacy filters are still readable, their indices are rebuilt per probe.
+const uint32_t kPdtFormatIndexed = 1;
+const uint32_t kPdtFormatEliasFano = 3;
+
+// Word position, delimiter, branch and bp bits taken by every key, plus some
+// labels for its suffix.
+const uint32_t kEstimatedBytesPerKey = 10;
+
+struct PdtFilterLayout {
+    bool indexed = false;
+    uint64_t bp_bit_size = 0;
+    const uint64_t* bp = nullptr;
+    uint64_t bp_len = 0;
+    const uint64_t* word_pos = nullptr;
+    uint64_t word_pos_len = 0;
+    bool elias_fano = false;
+    uint64_t ef_size = 0;
+    uint64_t ef_low_width = 0;
+    uint64_t ef_high_bit_size = 0;
+    const uint64_t* ef_high = nullptr;
+    uint64_t ef_high_len = 0;
+    const uint64_t* ef_rank_pairs = nullptr;
+    uint64_t ef_rank_pairs_len = 0;
+    const uint64_t* ef_select_hints = nullptr;
+    uint64_t ef_select_hints_len = 0;
+    const uint64_t* ef_low = nullptr;
+    uint64_t ef_low_len = 0;
+    const uint64_t* rank_pairs = nullptr;
+    uint64_t rank_pairs_len = 0;
+    const uint64_t* select_hints = nullptr;
+    uint64_t select_hints_len = 0;
+    const uint64_t* select0_hints = nullptr;
+    uint64_t select0_hints_len = 0;
+    const succinct::BpVector::excess_t* superblock_excess_min = nullptr;
+    uint64_t superblock_excess_min_len = 0;
+    const uint16_t* labels = nullptr;
+    uint64_t labels_len = 0;
+    const uint16_t* branches = nullptr;
+    uint64_t branches_len = 0;
+    const succinct::BpVector::block_min_excess_t* block_excess_min = nullptr;
+    uint64_t block_excess_min_len = 0;
+    uint64_t internal_nodes = 0;
+};
+
+template <typename T>
+void AppendRaw(std::string* dst, const succinct::mappable_vector<T>& vec) {
+    // raw encoding is not portable now for the sake of performance.
+    dst->append(reinterpret_cast<const char*>(vec.data()), vec.size() * sizeof(T));
+}
+
+// Map `byte_size` bytes of `input` as an array of T.
+template <typename T>
+bool MapSection(Slice* input, uint64_t byte_size, const T** ptr, uint64_t* len) {
+    if (byte_size % sizeof(T) != 0 || byte_size > input->size()) {
+        return false;
+    }
+    *ptr = reinterpret_cast<const T*>(input->data());
+    *len = byte_size / sizeof(T);
+    input->remove_prefix(static_cast<size_t>(byte_size));
+    return true;
+}
+
+template <bool Lexicographic>
+void EncodePdtFilter(const succinct::trie::DefaultPathDecomposedTrie<Lexicographic>& pdt,
+                     std::string* dst) {
+    const size_t init_size = dst->size();
+    auto& bp = pdt.get_bp();
+    auto& labels = pdt.get_labels();
+    auto& branches = pdt.get_branches();
+    auto& word_pos = pdt.get_word_pos();
+    auto& word_pos_high = word_pos.high_bits();
+
+    PutVarint32(dst, kPdtFormatEliasFano);
+    PutVarint64(dst, static_cast<uint64_t>(bp.size()));
+    PutVarint64(dst, word_pos.size());
+    PutVarint64(dst, word_pos.low_width());
+    PutVarint64(dst, static_cast<uint64_t>(word_pos_high.size()));
+    PutVarint64(dst, bp.data().size() * sizeof(uint64_t));
+    PutVarint64(dst, word_pos_high.data().size() * sizeof(uint64_t));
+    PutVarint64(dst, word_pos_high.get_block_rank_pairs().size() * sizeof(uint64_t));
+    PutVarint64(dst, word_pos_high.get_select_hints().size() * sizeof(uint64_t));
+    PutVarint64(dst, word_pos.low_bits().data().size() * sizeof(uint64_t));
+    PutVarint64(dst, bp.get_block_rank_pairs().size() * sizeof(uint64_t));
+    PutVarint64(dst, bp.get_select_hints().size() * sizeof(uint64_t));
+    PutVarint64(dst, bp.get_select0_hints().size() * sizeof(uint64_t));
+    PutVarint64(dst, bp.get_superblock_excess_min().size() *
+                     sizeof(succinct::BpVector::excess_t));
+    PutVarint64(dst, labels.size() * sizeof(uint16_t));
+    PutVarint64(dst, branches.size() * sizeof(uint16_t));
+    PutVarint64(dst, bp.get_block_excess_min().size() *
+                     sizeof(succinct::BpVector::block_min_excess_t));
+    PutVarint64(dst, bp.get_internal_nodes());
+    dst->append((8 - (dst->size() - init_size) % 8) % 8, '\0');
+
+    AppendRaw(dst, bp.data());
+    AppendRaw(dst, word_pos_high.data());
+    AppendRaw(dst, word_pos_high.get_block_rank_pairs());
+    AppendRaw(dst, word_pos_high.get_select_hints());
+    AppendRaw(dst, word_pos.low_bits().data());
+    AppendRaw(dst, bp.get_block_rank_pairs());
+    AppendRaw(dst, bp.get_select_hints());
+    AppendRaw(dst, bp.get_select0_hints());
+    AppendRaw(dst, bp.get_superblock_excess_min());
+    for (size_t i = 0; i < static_cast<size_t>(labels.size()); i++) {
+        PutFixed16(dst, labels[i]);
+    }
+    for (size_t i = 0; i < static_cast<size_t>(branches.size()); i++) {
+        PutFixed16(dst, branches[i]);
+    }
+    AppendRaw(dst, bp.get_block_excess_min());
+}
+
+bool DecodeLegacyPdtFilter(Slice input, PdtFilterLayout* layout) {
+    uint64_t label_size, branch_size, bp_byte_size, pos_size;
+    if (!GetVarint64(&input, &layout->bp_bit_size) ||
+        !GetVarint64(&input, &label_size) ||
+        !GetVarint64(&input, &branch_size) ||
+        !GetVarint64(&input, &bp_byte_size) ||
+        !GetVarint64(&input, &pos_size)) {
+        return false;
+    }
+    layout->indexed = false;
+    return MapSection(&input, label_size, &layout->labels, &layout->labels_len) &&
+           MapSection(&input, branch_size, &layout->branches, &layout->branches_len) &&
+           MapSection(&input, bp_byte_size, &layout->bp, &layout->bp_len) &&
+           MapSection(&input, pos_size, &layout->word_pos, &layout->word_pos_len);
+}
+
+bool DecodePdtFilter(const Slice& filter, PdtFilterLayout* layout) {
+    Slice input(filter);
+    uint64_t tag;
+    if (!GetVarint64(&input, &tag)) {
+        return false;
+    }
+    if (tag % 2 == 0) {
+        return DecodeLegacyPdtFilter(filter, layout);
+    }
+    if (tag != kPdtFormatIndexed && tag != kPdtFormatEliasFano) {
+        return false;
+    }
+    layout->elias_fano = tag == kPdtFormatEliasFano;
+
+    if (!GetVarint64(&input, &layout->bp_bit_size)) {
+        return false;
+    }
+    if (layout->elias_fano &&
+        (!GetVarint64(&input, &layout->ef_size) ||
+         !GetVarint64(&input, &layout->ef_low_width) ||
+         !GetVarint64(&input, &layout->ef_high_bit_size) ||
+         layout->ef_low_width >= 64)) {
+        return false;
+    }
+    // Word positions take 4 sections in kPdtFormatEliasFano and 1 otherwise.
+    uint64_t sizes[12];
+    const size_t num_sections = layout->elias_fano ? 12 : 9;
+    for (size_t i = 0; i < num_sections; i++) {
+        if (!GetVarint64(&input, &sizes[i])) {
+            return false;
+        }
+    }
+    if (!GetVarint64(&input, &layout->internal_nodes)) {
+        return false;
+    }
+    size_t header_size = filter.size() - input.size();
+    size_t padding = (8 - header_size % 8) % 8;
+    if (padding > input.size()) {
+        return false;
+    }
+    input.remove_prefix(padding);
+
+    layout->indexed = true;
+    const uint64_t* size = sizes;
+    if (!MapSection(&input, *size++, &layout->bp, &layout->bp_len)) {
+        return false;
+    }
+    if (layout->elias_fano) {
+        if (!MapSection(&input, *size++, &layout->ef_high, &layout->ef_high_len) ||
+            !MapSection(&input, *size++, &layout->ef_rank_pairs, &layout->ef_rank_pairs_len) ||
+            !MapSection(&input, *size++, &layout->ef_select_hints,
+                        &layout->ef_select_hints_len) ||
+            !MapSection(&input, *size++, &layout->ef_low, &layout->ef_low_len) ||
+            layout->ef_high_bit_size > layout->ef_high_len * 64 ||
+            layout->ef_size * layout->ef_low_width > layout->ef_low_len * 64) {
+            return false;
+        }
+    } else if (!MapSection(&input, *size++, &layout->word_pos, &layout->word_pos_len)) {
+        return false;
+    }
+    return MapSection(&input, size[0], &layout->rank_pairs, &layout->rank_pairs_len) &&
+           MapSection(&input, size[1], &layout->select_hints, &layout->select_hints_len) &&
+           MapSection(&input, size[2], &layout->select0_hints, &layout->select0_hints_len) &&
+           MapSection(&input, size[3], &layout->superblock_excess_min,
+                      &layout->superblock_excess_min_len) &&
+           MapSection(&input, size[4], &layout->labels, &layout->labels_len) &&
+           MapSection(&input, size[5], &layout->branches, &layout->branches_len) &&
+           MapSection(&input, size[6], &layout->block_excess_min,
+                      &layout->block_excess_min_len);
+}
+
+// Map the `bp` of `layout` into `bp`. Indices are rebuilt for legacy layout only.
+void MapBpVector(const PdtFilterLayout& layout, succinct::BpVector* bp) {
+    if (layout.indexed) {
+        succinct::BpVector tmp(layout.bp, layout.bp_len, layout.bp_bit_size,
+                               layout.rank_pairs, layout.rank_pairs_len,
+                               layout.select_hints, layout.select_hints_len,
+                               layout.select0_hints, layout.select0_hints_len,
+                               layout.internal_nodes,
+                               layout.block_excess_min, layout.block_excess_min_len,
+                               layout.superblock_excess_min,
+                               layout.superblock_excess_min_len);
+        bp->swap(tmp);
+    } else {
+        succinct::BpVector tmp(layout.bp, layout.bp_len, layout.bp_bit_size, false, true);
+        bp->swap(tmp);
+    }
+}
+
+}  // namespace
+
+template <bool Lexicographic>
+void BuildPdt(std::vector<Slice>* keys, std::string* dst) {
+    succinct::DefaultTreeBuilder<Lexicographic> pdt_builder;
+    succinct::trie::compacted_trie_builder
+            <succinct::DefaultTreeBuilder<Lexicographic>>
+            trieBuilder(pdt_builder);
+
+    auto less = [] (const Slice& s1, const Slice& s2) {
+        return s1.compare(s2) < 0;
+    };
+    if (!std::is_sorted(keys->begin(), keys->end(), less)) {
+        std::sort(keys->begin(), keys->end(), less);
+    }
+    keys->erase(std::unique(keys->begin(), keys->end()), keys->end());
+
+    for (size_t i = 0; i < keys->size(); i++) {
+        const Slice& key = (*keys)[i];
+        trieBuilder.append(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+    }
+    trieBuilder.finish();
+    succinct::trie::DefaultPathDecomposedTrie<Lexicographic> pdt(trieBuilder);
+    EncodePdtFilter(pdt, dst);
+}
+
+template <bool Lexicographic>
+succinct::trie::DefaultPathDecomposedTrie<Lexicographic>* MapPdt(
+        const Slice& data) {
+    PdtFilterLayout layout;
+    if (data.empty() || !DecodePdtFilter(data, &layout)) {
+        return nullptr;
+    }
+    succinct::BpVector bp;
+    MapBpVector(layout, &bp);
+    if (layout.elias_fano) {
+        succinct::EliasFanoVector word_pos(
+            layout.ef_size, layout.ef_low_width,
+            layout.ef_high, layout.ef_high_len, layout.ef_high_bit_size,
+            layout.ef_rank_pairs, layout.ef_rank_pairs_len,
+            layout.ef_select_hints, layout.ef_select_hints_len,
+            layout.ef_low, layout.ef_low_len);
+        return new succinct::trie::DefaultPathDecomposedTrie<Lexicographic>(
+            layout.labels, layout.labels_len,
+            layout.branches, layout.branches_len,
+            bp, word_pos, true);
+    }
+    return new succinct::trie::DefaultPathDecomposedTrie<Lexicographic>(
+        layout.labels, layout.labels_len,
+        layout.branches, layout.branches_len,
+        bp,
+        layout.word_pos, layout.word_pos_len, true);
+}
+
+template void BuildPdt<false>(std::vector<Slice>* keys, std::string* dst);
+template void BuildPdt<true>(std::vector<Slice>* keys, std::string* dst);
+template succinct::trie::DefaultPathDecomposedTrie<false>* MapPdt<false>(
+        const Slice& data);
+template succinct::trie::DefaultPathDecomposedTrie<true>* MapPdt<true>(
+        const Slice& data);
+
+namespace {
+// Builds a whole-file (or whole-partition) pdt filter. Keys come from the
+// table builder in sorted order, so they are streamed into the trie as they
+// are added and only the last key is kept.
+//
+// With a prefix extractor every whole key is followed by its prefix, which
+// sorts before it. The second key added sorting before the first one is taken
+// as that pattern: from then on whole keys and prefixes go into two sorted
+// streams of their own, kept in lexicographic tries, and `Finish` merges them
+// into the filter trie in a single pass. Only a key fitting in neither stream
+// is set aside, and if there is any, the trie is rebuilt over all of the keys
+// on `Finish`.
+template <bool Lexicographic>
+class PdtFilterBitsBuilder : public FilterBitsBuilder {
 public:
-    explicit PdtFilterPolicy(bool use_block_based_builder)
-        : use_block_based_builder_(use_block_based_builder){}
+    typedef succinct::DefaultTreeBuilder<Lexicographic> TreeBuilder;
+    typedef succinct::trie::compacted_trie_builder<TreeBuilder> TrieBuilder;
 
-    ~PdtFilterPolicy() override {}
+    PdtFilterBitsBuilder() {}
 
-    const char* Name() const override { return "rocksdb.PdtFilter"; } 
+    // No copying allowed
+    PdtFilterBitsBuilder(const PdtFilterBitsBuilder&) = delete;
+    void operator=(const PdtFilterBitsBuilder&) = delete;
 
-    void CreateFilter(const Slice* keys, int n, std::string* dst) const override {
-        succinct::DefaultTreeBuilder<Lexicographic> pdt_builder;
-        succinct::trie::compacted_trie_builder
-                <succinct::DefaultTreeBuilder<Lexicographic>>
-                trieBuilder(pdt_builder);
-        
-        std::vector<Slice> sorted_slices;
-        for (size_t i = 0; i < static_cast<size_t>(n); i++) {
-            sorted_slices.push_back(keys[i]);
-        }
-        std::sort(sorted_slices.begin(), sorted_slices.end(), [] (const Slice& s1, const Slice& s2) {
-            return s1.compare(s2) < 0;
-        });
+    ~PdtFilterBitsBuilder() override {}
+
+    void AddKey(const Slice& key) override {
+        if (whole_keys_ != nullptr) {
+            if (!whole_keys_->Append(key) && !prefixes_->Append(key)) {
+                unsorted_keys_.emplace_back(key.data(), key.size());
+            }
+            return;
+        }
+        if (trie_builder_ == nullptr) {
+            tree_builder_.reset(new TreeBuilder());
+            trie_builder_.reset(new TrieBuilder(*tree_builder_));
+        } else {
+            int cmp = key.compare(last_key_);
+            if (cmp == 0) {
+                return;
+            }
+            if (cmp < 0) {
+                if (num_keys_ == 1) {
+                    // Split the streams, the trie holds the first key only.
+                    whole_keys_.reset(new SortedStream());
+                    prefixes_.reset(new SortedStream());
+                    whole_keys_->Append(last_key_);
+                    prefixes_->Append(key);
+                    trie_builder_.reset();
+                    tree_builder_.reset();
+                } else {
+                    unsorted_keys_.emplace_back(key.data(), key.size());
+                }
+                return;
+            }
+        }
+        trie_builder_->append(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+        last_key_.assign(key.data(), key.size());
+        num_keys_++;
+    }
+
+    Slice Finish(std::unique_ptr<const char[]>* buf) override {
+        std::string filter;
+        if (whole_keys_ != nullptr) {
+            MergeStreams(&filter);
+        } else if (trie_builder_ != nullptr) {
+            trie_builder_->finish();
+            succinct::trie::DefaultPathDecomposedTrie<Lexicographic> pdt(*trie_builder_);
+            if (unsorted_keys_.empty()) {
+                EncodePdtFilter(pdt, &filter);
+            } else {
+                AppendKeys(pdt, &unsorted_keys_);
+                Rebuild(&filter);
+            }
+        }
+        trie_builder_.reset();
+        tree_builder_.reset();
+        whole_keys_.reset();
+        prefixes_.reset();
+        last_key_.clear();
+        num_keys_ = 0;
+        unsorted_keys_.clear();
 
-        // for (size_t i = 0; i + 1 < sorted_slices.size(); i++) {
-        //     int res = sorted_slices[i].compare(sorted_slices[i + 1]);
-        //     assert(res < 0);
-        // }
+        char* data = new char[filter.size()];
+        memcpy(data, filter.data(), filter.size());
+        buf->reset(data);
+        return Slice(data, filter.size());
+    }
+
+    // Used by partitioned filters to request a partition cut. The size of a
+    // trie depends on the keys, so this is a rough estimate only; partitions
+    // are still cut along the index partitions.
+    int CalculateNumEntry(const uint32_t space) override {
+        return std::max(1, static_cast<int>(space / kEstimatedBytesPerKey));
+    }
+
+private:
+    typedef succinct::DefaultTreeBuilder<true> LexTreeBuilder;
+    typedef succinct::trie::compacted_trie_builder<LexTreeBuilder> LexTrieBuilder;
+
+    // Keys of a lexicographic trie are numbered in order, so the stream can
+    // be read back sorted once it is finished.
+    struct SortedStream {
+        SortedStream() : trie_builder(tree_builder) {}
+
+        // Returns false, and leaves the stream alone, if `key` sorts before
+        // the last key.
+        bool Append(const Slice& key) {
+            if (num_keys > 0) {
+                int cmp = key.compare(last_key);
+                if (cmp <= 0) {
+                    return cmp == 0;
+                }
+            }
+            trie_builder.append(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+            last_key.assign(key.data(), key.size());
+            num_keys++;
+            return true;
+        }
+
+        LexTreeBuilder tree_builder;
+        LexTrieBuilder trie_builder;
+        std::string last_key;
+        size_t num_keys = 0;
+    };
 
-        for (size_t i = 0; i < sorted_slices.size(); i++) {
-            std::vector<uint8_t> bytes(sorted_slices[i].data(), 
-                                       sorted_slices[i].data() + sorted_slices[i].size());
-            trieBuilder.append(bytes);
+    template <bool Lex>
+    static void AppendKeys(const succinct::trie::DefaultPathDecomposedTrie<Lex>& pdt,
+                           std::vector<std::string>* keys) {
+        for (size_t i = 0; i < pdt.num_keys(); i++) {
+            keys->emplace_back();
+            pdt.get_key(i, &keys->back());
         }
-        trieBuilder.finish();
-        succinct::trie::DefaultPathDecomposedTrie<Lexicographic> pdt(trieBuilder);
-        
-        auto& labels = pdt.get_labels();
-        auto& branches = pdt.get_branches();
-        auto& bp = pdt.get_bp().data();
-        auto& word_pos = pdt.get_word_pos();
+    }
+
+    // Sorts all of the keys over again.
+    void Rebuild(std::string* filter) {
+        TEST_SYNC_POINT("PdtFilterBitsBuilder::Finish:Rebuild");
+        std::vector<Slice> slices(unsorted_keys_.begin(), unsorted_keys_.end());
+        BuildPdt<Lexicographic>(&slices, filter);
+    }
+
+    void MergeStreams(std::string* filter) {
+        whole_keys_->trie_builder.finish();
+        prefixes_->trie_builder.finish();
+        succinct::trie::DefaultPathDecomposedTrie<true> a(whole_keys_->trie_builder);
+        succinct::trie::DefaultPathDecomposedTrie<true> b(prefixes_->trie_builder);
+        if (!unsorted_keys_.empty()) {
+            AppendKeys(a, &unsorted_keys_);
+            AppendKeys(b, &unsorted_keys_);
+            Rebuild(filter);
+            return;
+        }
+
+        TreeBuilder tree_builder;
+        TrieBuilder trie_builder(tree_builder);
+        const size_t num_a = a.num_keys();
+        const size_t num_b = b.num_keys();
+        size_t i = 0;
+        size_t j = 0;
+        std::string key_a;
+        std::string key_b;
+        a.get_key(0, &key_a);
+        b.get_key(0, &key_b);
+        while (i < num_a || j < num_b) {
+            int cmp = i == num_a ? 1 : (j == num_b ? -1 : Slice(key_a).compare(key_b));
+            const std::string& key = cmp <= 0 ? key_a : key_b;
+            trie_builder.append(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+            if (cmp <= 0 && ++i < num_a) {
+                key_a.clear();
+                a.get_key(i, &key_a);
+            }
+            if (cmp >= 0 && ++j < num_b) {
+                key_b.clear();
+                b.get_key(j, &key_b);
+            }
+        }
+        trie_builder.finish();
+        succinct::trie::DefaultPathDecomposedTrie<Lexicographic> pdt(trie_builder);
+        EncodePdtFilter(pdt, filter);
+    }
+
+    std::unique_ptr<TreeBuilder> tree_builder_;
+    std::unique_ptr<TrieBuilder> trie_builder_;
+    std::string last_key_;
+    size_t num_keys_ = 0;
+    // Whole keys and prefixes once the streams are split.
+    std::unique_ptr<SortedStream> whole_keys_;
+    std::unique_ptr<SortedStream> prefixes_;
+    // Keys added out of order, not in the trie yet.
+    std::vector<std::string> unsorted_keys_;
+};
+
+// Maps the filter once, every probe afterwards is a plain trie walk. The
+// reader does not own `contents`, which must outlive it (the
+// ParsedFullFilterBlock holding both takes care of it).
+template <bool Lexicographic>
+class PdtFilterBitsReader : public FilterBitsReader {
+public:
+    explicit PdtFilterBitsReader(const Slice& contents)
+        : empty_(contents.empty()), pdt_(MapPdt<Lexicographic>(contents)) {}
+
+    // No copying allowed
+    PdtFilterBitsReader(const PdtFilterBitsReader&) = delete;
+    void operator=(const PdtFilterBitsReader&) = delete;
+
+    ~PdtFilterBitsReader() override {}
+
+    bool MayMatch(const Slice& entry) override {
+        if (empty_) {
+            return false;
+        }
+        if (pdt_ == nullptr) {
+            // broken filter, regarded as match
+            return true;
+        }
+        return pdt_->index(entry) != -1;
+    }
+
+    // Keys are numbered in order in a lexicographic trie only.
+    bool RangeMayMatch(const Slice& lo, const Slice& hi) override {
+        if (empty_) {
+            return false;
+        }
+        if (pdt_ == nullptr || !Lexicographic) {
+            return true;
+        }
+        return pdt_->lower_bound(lo) < pdt_->lower_bound(hi);
+    }
+
+    // Both kinds of trie keep whole keys, so any prefix can be walked.
+    bool PrefixMayMatch(const Slice& prefix) override {
+        if (empty_) {
+            return false;
+        }
+        if (pdt_ == nullptr) {
+            return true;
+        }
+        return pdt_->has_prefix(prefix);
+    }
 
-        PutVarint64(dst, static_cast<uint64_t>(pdt.get_bp().size())); // valid bits size of bp
-        PutVarint64(dst, labels.size() * sizeof(uint16_t));           // label byte size
-        PutVarint64(dst, branches.size() * sizeof(uint16_t));         // branch byte size
-        PutVarint64(dst, bp.size() * sizeof(uint64_t));               // bp byte size
-        PutVarint64(dst, word_pos.size() * sizeof(uint64_t));         // word_pos byte size
+    // The trie maps the filter, it only owns the indices that were not
+    // persisted with it.
+    size_t ApproximateMemoryUsage() const override {
+        size_t usage = sizeof(*this);
+        if (pdt_ != nullptr) {
+            usage += sizeof(*pdt_) + pdt_->owned_bytes();
+        }
+        return usage;
+    }
 
-        for (size_t i = 0; i < static_cast<size_t>(labels.size()); i++) {
-            PutFixed16(dst, labels[i]);
+    // Keys are probed in sorted order so that the trie walks of keys sharing a
+    // prefix share their nodes as well.
+    void MayMatch(int num_keys, Slice** keys, bool* may_match) override {
+        if (num_keys <= 0) {
+            return;
         }
-        for (size_t i = 0; i < static_cast<size_t>(branches.size()); i++) {
-            PutFixed16(dst, branches[i]);
+        if (empty_ || pdt_ == nullptr) {
+            for (int i = 0; i < num_keys; i++) {
+                may_match[i] = !empty_;
+            }
+            return;
         }
-        // bp encoding is not portable now for the sake of performance.
-        for (size_t i = 0; i < static_cast<size_t>(bp.size()); i++) {
-            dst->append(reinterpret_cast<const char*>(&bp[i]), sizeof(uint64_t));
+        autovector<int, kBatchSize> order;
+        for (int i = 0; i < num_keys; i++) {
+            order.push_back(i);
         }
-        for (size_t i = 0; i < static_cast<size_t>(word_pos.size()); i++) {
-            PutFixed64(dst, word_pos[i]);
+        std::sort(order.begin(), order.end(), [keys](int a, int b) {
+            return keys[a]->compare(*keys[b]) < 0;
+        });
+        autovector<const Slice*, kBatchSize> sorted_keys;
+        autovector<int, kBatchSize> res;
+        for (int i = 0; i < num_keys; i++) {
+            sorted_keys.push_back(keys[order[i]]);
+            res.push_back(-1);
         }
+        pdt_->index(&sorted_keys[0], sorted_keys.size(), &res[0]);
+        for (int i = 0; i < num_keys; i++) {
+            may_match[order[i]] = res[i] != -1;
+        }
+    }
+
+private:
+    // MultiGet batch size, larger batches spill to the heap once per batch.
+    static const size_t kBatchSize = 32;
+
+    const bool empty_;
+    std::unique_ptr<succinct::trie::DefaultPathDecomposedTrie<Lexicographic>> pdt_;
+};
+
+template<bool Lexicographic = false>
+class PdtFilterPolicy : public FilterPolicy {
+public:
+    explicit PdtFilterPolicy(bool use_block_based_builder)
+        : use_block_based_builder_(use_block_based_builder){}
+
+    ~PdtFilterPolicy() override {}
+
+    // The two orders lay out different tries, so their filters must not be
+    // mistaken for each other.
+    const char* Name() const override {
+        return Lexicographic ? "rocksdb.LexPdtFilter" : "rocksdb.CentroidPdtFilter";
+    }
+
+    void CreateFilter(const Slice* keys, int n, std::string* dst) const override {
+        if (n <= 0) {
+            return;
+        }
+        std::vector<Slice> sorted_slices(keys, keys + n);
+        BuildPdt<Lexicographic>(&sorted_slices, dst);
     }
 
     bool KeyMayMatch(const Slice& key, const Slice& bloom_filter) const override {
-        const size_t len = bloom_filter.size();
-        const char* array = bloom_filter.data();
-
-        Slice tmp(bloom_filter);
-        uint64_t bp_bit_size, label_size, branch_size, bp_byte_size, pos_size;
-        assert(GetVarint64(&tmp, &bp_bit_size));
-        assert(GetVarint64(&tmp, &label_size));
-        assert(GetVarint64(&tmp, &branch_size));
-        assert(GetVarint64(&tmp, &bp_byte_size));
-        assert(GetVarint64(&tmp, &pos_size));
-        
-        auto label_ptr = reinterpret_cast<const uint16_t*>(tmp.data());
-        auto branch_ptr = reinterpret_cast<const uint16_t*>(tmp.data() + label_size);
-        auto bp_ptr = reinterpret_cast<const uint64_t*>(
-                            tmp.data() + label_size + branch_size);
-        auto pos_ptr = reinterpret_cast<const uint64_t*>(
-                            tmp.data() + label_size + branch_size + bp_byte_size);
-        succinct::trie::DefaultPathDecomposedTrie<Lexicographic> pdt(
-            label_ptr, label_size / sizeof(uint16_t),
-            branch_ptr, branch_size / sizeof(uint16_t),
-            bp_ptr, bp_byte_size / sizeof(uint64_t), bp_bit_size,
-            pos_ptr, pos_size / sizeof(uint64_t), true
-        );
-
-        std::string s = key.ToString();
-        int res = pdt.index(s);
-        return res != -1;
-    }
-
-    FilterBitsBuilder* GetFilterBitsBuilder() const {
-        return nullptr;
+        if (bloom_filter.empty()) {
+            return false;
+        }
+        PdtFilterBitsReader<Lexicographic> reader(bloom_filter);
+        return reader.MayMatch(key);
     }
 
-    FilterBitsReader* GetFilterBitsReader(const Slice& /*contents*/) const {
-        return nullptr;
+    // Full filter is used unless the block based builder is asked for
+    // explicitly.
+    FilterBitsBuilder* GetFilterBitsBuilder() const override {
+        if (use_block_based_builder_) {
+            return nullptr;
+        }
+        return new PdtFilterBitsBuilder<Lexicographic>();
+    }
+
+    FilterBitsReader* GetFilterBitsReader(const Slice& contents) const override {
+        return new PdtFilterBitsReader<Lexicographic>(contents);
+    }
+
+    bool SupportsRangeMayMatch() const override { return Lexicographic; }
+
+    // CreateFilter() encodes the trie with BuildPdt() too.
+    FilterBitsReader* DecodeFilter(const Slice& filter) const override {
+        return new PdtFilterBitsReader<Lexicographic>(filter);
     }
 private:
     const bool use_block_based_builder_;
@@ -127,4 +680,14 @@ const FilterPolicy* NewLexPdtFilterPolicy(bool use_block_based_builer) {
 const FilterPolicy* NewCentriodPdtFilterPolicy(bool use_block_based_builder) {
     return new PdtFilterPolicy<false>(use_block_based_builder);
 }
-}
\ No newline at end of file
+
+bool IsPdtFilterPolicy(const FilterPolicy* policy) {
+    if (policy == nullptr) {
+        return false;
+    }
+    const Slice name(policy->Name());
+    return name == "rocksdb.LexPdtFilter" ||
+           name == "rocksdb.CentroidPdtFilter" ||
+           name == "rocksdb.OtLexPdtFilter";
+}
+}
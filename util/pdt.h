@@ -0,0 +1,33 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "rocksdb/filter_policy.h"
+#include "rocksdb/slice.h"
+#include "utilities/pdt/path_decomposed_trie.h"
+
+namespace rocksdb {
+
+// Build a path-decomposed trie over `keys` and append it to `dst` in the
+// layout of pdt filters. `keys` is sorted and deduplicated in place, the
+// trie is built over a set.
+template <bool Lexicographic>
+void BuildPdt(std::vector<Slice>* keys, std::string* dst);
+
+// Map a trie written by `BuildPdt` without copying it, `data` must outlive
+// the returned trie. Returns nullptr if `data` can't be decoded.
+template <bool Lexicographic>
+succinct::trie::DefaultPathDecomposedTrie<Lexicographic>* MapPdt(
+    const Slice& data);
+
+// Whether the filters of `policy` are PDTs, of any of the PDT filter
+// policies.
+bool IsPdtFilterPolicy(const FilterPolicy* policy);
+
+}  // namespace rocksdb
@@ -1,11 +1,15 @@
+#include <set>
+
 #include "include/rocksdb/filter_policy.h"
 #include "include/rocksdb/slice.h"
+#include "include/rocksdb/slice_transform.h"
+#include "table/block_based/full_filter_block.h"
 #include "util/coding.h"
 #include "test_util/testharness.h"
+#include "test_util/sync_point.h"
 #include "test_util/testutil.h"
-#include "util/gflags_compat.h"
-
-using GFLAGS_NAMESPACE::ParseCommandLineFlags;
+#include "util/stop_watch.h"
+#include "utilities/pdt/path_decomposed_trie.h"
 
 namespace rocksdb {
     static const int kVerbose = 1;
@@ -106,10 +110,367 @@ namespace rocksdb {
         ASSERT_TRUE(! Matches("foo"));
     }
 
-    // TEST_F(PdtTest, EmptyFilter) {
-    //     ASSERT_TRUE(! Matches("hello"));
-    //     ASSERT_TRUE(! Matches("world"));
-    // }
+    // Encode `keys` in the legacy filter layout, which has no persisted
+    // indices and thus rebuilds rank/select and min-excess tree per probe.
+    static std::string LegacyFilter(std::vector<std::string> keys) {
+        std::sort(keys.begin(), keys.end());
+        succinct::DefaultTreeBuilder<false> pdt_builder;
+        succinct::trie::compacted_trie_builder<succinct::DefaultTreeBuilder<false>>
+                trie_builder(pdt_builder);
+        for (auto& key : keys) {
+            std::vector<uint8_t> bytes(key.begin(), key.end());
+            trie_builder.append(bytes);
+        }
+        trie_builder.finish();
+        succinct::trie::DefaultPathDecomposedTrie<false> pdt(trie_builder);
+
+        std::string dst;
+        auto& labels = pdt.get_labels();
+        auto& branches = pdt.get_branches();
+        auto& bp = pdt.get_bp().data();
+        auto& word_pos = pdt.get_word_pos();
+        PutVarint64(&dst, static_cast<uint64_t>(pdt.get_bp().size()));
+        PutVarint64(&dst, labels.size() * sizeof(uint16_t));
+        PutVarint64(&dst, branches.size() * sizeof(uint16_t));
+        PutVarint64(&dst, bp.size() * sizeof(uint64_t));
+        PutVarint64(&dst, word_pos.size() * sizeof(uint64_t));
+        for (size_t i = 0; i < static_cast<size_t>(labels.size()); i++) {
+            PutFixed16(&dst, labels[i]);
+        }
+        for (size_t i = 0; i < static_cast<size_t>(branches.size()); i++) {
+            PutFixed16(&dst, branches[i]);
+        }
+        for (size_t i = 0; i < static_cast<size_t>(bp.size()); i++) {
+            dst.append(reinterpret_cast<const char*>(&bp[i]), sizeof(uint64_t));
+        }
+        for (size_t i = 0; i < static_cast<size_t>(word_pos.size()); i++) {
+            PutFixed64(&dst, word_pos[i]);
+        }
+        return dst;
+    }
+
+    TEST_F(PdtTest, DuplicateKeys) {
+        Add("hello");
+        Add("hello");
+        Add("world");
+        ASSERT_TRUE(Matches("hello"));
+        ASSERT_TRUE(Matches("world"));
+        ASSERT_TRUE(! Matches("hell"));
+    }
+
+    TEST_F(PdtTest, LegacyFormat) {
+        std::unique_ptr<const FilterPolicy> policy(NewCentriodPdtFilterPolicy());
+        char buffer[sizeof(int)];
+        std::vector<std::string> keys;
+        for (int i = 0; i < 1000; i++) {
+            keys.push_back(Key(i * 2, buffer).ToString());
+        }
+        std::string legacy = LegacyFilter(keys);
+        for (int i = 0; i < 1000; i++) {
+            ASSERT_TRUE(policy->KeyMayMatch(Key(i * 2, buffer), legacy));
+            ASSERT_TRUE(! policy->KeyMayMatch(Key(i * 2 + 1, buffer), legacy));
+        }
+    }
+
+    // Per-probe latency of the legacy layout (indices rebuilt per probe) and
+    // the indexed layout (indices mapped from the filter).
+    TEST_F(PdtTest, ProbeLatency) {
+        std::unique_ptr<const FilterPolicy> policy(NewCentriodPdtFilterPolicy());
+        char buffer[sizeof(int)];
+        for (int length = 1000; length <= 100000; length *= 10) {
+            std::vector<std::string> keys;
+            std::vector<Slice> key_slices;
+            for (int i = 0; i < length; i++) {
+                keys.push_back(Key(i, buffer).ToString());
+            }
+            for (auto& key : keys) {
+                key_slices.push_back(Slice(key));
+            }
+            std::string indexed;
+            policy->CreateFilter(&key_slices[0], length, &indexed);
+            std::string legacy = LegacyFilter(keys);
+
+            const int kProbes = 1000;
+            StopWatchNano timer(Env::Default(), true);
+            for (int i = 0; i < kProbes; i++) {
+                ASSERT_TRUE(policy->KeyMayMatch(key_slices[i % length], legacy));
+            }
+            uint64_t legacy_nanos = timer.ElapsedNanos(true);
+            for (int i = 0; i < kProbes; i++) {
+                ASSERT_TRUE(policy->KeyMayMatch(key_slices[i % length], indexed));
+            }
+            uint64_t indexed_nanos = timer.ElapsedNanos();
+
+            if (kVerbose >= 1) {
+                fprintf(stderr, "Keys %6d: legacy %9.1f ns/probe (%7d bytes), "
+                        "indexed %7.1f ns/probe (%7d bytes)\n",
+                        length, legacy_nanos * 1.0 / kProbes,
+                        static_cast<int>(legacy.size()),
+                        indexed_nanos * 1.0 / kProbes,
+                        static_cast<int>(indexed.size()));
+            }
+        }
+    }
+
+    TEST_F(PdtTest, FullFilterBits) {
+        std::unique_ptr<const FilterPolicy> block_based(NewLexPdtFilterPolicy(true));
+        ASSERT_TRUE(block_based->GetFilterBitsBuilder() == nullptr);
+
+        std::unique_ptr<const FilterPolicy> policy(NewLexPdtFilterPolicy());
+        std::unique_ptr<FilterBitsBuilder> builder(policy->GetFilterBitsBuilder());
+        ASSERT_TRUE(builder != nullptr);
+        char buffer[sizeof(int)];
+        // Out of order and duplicated, like whole keys interleaved with prefixes.
+        for (int i = 999; i >= 0; i--) {
+            builder->AddKey(Key(i * 2, buffer));
+            builder->AddKey(Key(i * 2, buffer));
+        }
+        std::unique_ptr<const char[]> buf;
+        Slice filter = builder->Finish(&buf);
+        ASSERT_TRUE(! filter.empty());
+
+        std::unique_ptr<FilterBitsReader> reader(policy->GetFilterBitsReader(filter));
+        for (int i = 0; i < 1000; i++) {
+            ASSERT_TRUE(reader->MayMatch(Key(i * 2, buffer)));
+            ASSERT_TRUE(! reader->MayMatch(Key(i * 2 + 1, buffer)));
+        }
+
+        std::vector<std::string> probes;
+        for (int i = 0; i < 8; i++) {
+            probes.push_back(Key(i, buffer).ToString());
+        }
+        std::vector<Slice> probe_slices(probes.begin(), probes.end());
+        Slice* keys[8];
+        bool may_match[8];
+        for (int i = 0; i < 8; i++) {
+            keys[i] = &probe_slices[i];
+        }
+        reader->MayMatch(8, keys, may_match);
+        for (int i = 0; i < 8; i++) {
+            ASSERT_EQ(i % 2 == 0, may_match[i]);
+        }
+
+        std::unique_ptr<FilterBitsReader> empty_reader(
+            policy->GetFilterBitsReader(Slice()));
+        ASSERT_TRUE(! empty_reader->MayMatch("hello"));
+    }
+
+    TEST_F(PdtTest, StreamedFilterBits) {
+        for (bool lexicographic : {true, false}) {
+            std::unique_ptr<const FilterPolicy> policy(
+                lexicographic ? NewLexPdtFilterPolicy() : NewCentriodPdtFilterPolicy());
+            std::unique_ptr<FilterBitsBuilder> builder(policy->GetFilterBitsBuilder());
+            // The builder is reused across partitions.
+            for (int round = 0; round < 2; round++) {
+                // Sorted whole keys, each followed by its 3-byte prefix.
+                std::set<std::string> added;
+                for (int i = round * 1000; i < round * 1000 + 1000; i++) {
+                    std::string key = "k" + std::to_string(i * 7);
+                    builder->AddKey(key);
+                    builder->AddKey(key.substr(0, 3));
+                    added.insert(key);
+                    added.insert(key.substr(0, 3));
+                }
+                std::unique_ptr<const char[]> buf;
+                Slice filter = builder->Finish(&buf);
+                std::unique_ptr<FilterBitsReader> reader(policy->GetFilterBitsReader(filter));
+                for (int i = 0; i < 20000; i++) {
+                    std::string key = "k" + std::to_string(i);
+                    ASSERT_EQ(added.count(key) > 0, reader->MayMatch(key)) << key;
+                }
+            }
+        }
+    }
+
+    TEST_F(PdtTest, PrefixExtractorStreams) {
+        std::unique_ptr<const SliceTransform> prefix_extractor(NewFixedPrefixTransform(3));
+        for (bool lexicographic : {true, false}) {
+            std::unique_ptr<const FilterPolicy> policy(
+                lexicographic ? NewLexPdtFilterPolicy() : NewCentriodPdtFilterPolicy());
+            int rebuilds = 0;
+            SyncPoint::GetInstance()->SetCallBack(
+                "PdtFilterBitsBuilder::Finish:Rebuild", [&](void*) { rebuilds++; });
+            SyncPoint::GetInstance()->EnableProcessing();
+
+            // Whole keys interleaved with their prefixes, as a table builder
+            // adds them.
+            FullFilterBlockBuilder builder(prefix_extractor.get(), true,
+                                           policy->GetFilterBitsBuilder());
+            std::set<std::string> added;
+            char key[16];
+            for (int i = 0; i < 5000; i++) {
+                snprintf(key, sizeof(key), "k%05d", i * 3);
+                builder.Add(key);
+                added.insert(key);
+                added.insert(std::string(key, 3));
+            }
+            Slice filter = builder.Finish();
+            ASSERT_EQ(0, rebuilds);
+
+            std::unique_ptr<FilterBitsReader> reader(policy->GetFilterBitsReader(filter));
+            for (int i = 0; i < 15000; i++) {
+                snprintf(key, sizeof(key), "k%05d", i);
+                ASSERT_EQ(added.count(key) > 0, reader->MayMatch(key)) << key;
+                ASSERT_EQ(added.count(std::string(key, 3)) > 0,
+                          reader->MayMatch(Slice(key, 3))) << key;
+            }
+
+            // A key fitting in neither stream still lands in the filter.
+            std::unique_ptr<FilterBitsBuilder> bits(policy->GetFilterBitsBuilder());
+            for (const char* k : {"k00003", "k00", "k00006", "j", "a"}) {
+                bits->AddKey(k);
+            }
+            std::unique_ptr<const char[]> buf;
+            filter = bits->Finish(&buf);
+            ASSERT_EQ(1, rebuilds);
+            reader.reset(policy->GetFilterBitsReader(filter));
+            for (const char* k : {"k00003", "k00", "k00006", "j", "a"}) {
+                ASSERT_TRUE(reader->MayMatch(k)) << k;
+            }
+            ASSERT_TRUE(! reader->MayMatch("k00004"));
+
+            SyncPoint::GetInstance()->DisableProcessing();
+            SyncPoint::GetInstance()->ClearAllCallBacks();
+        }
+    }
+
+    TEST_F(PdtTest, OtLexFilterBits) {
+        std::unique_ptr<const FilterPolicy> policy(NewOtLexPdtFilterPolicy());
+        std::unique_ptr<const FilterPolicy> lex(NewLexPdtFilterPolicy());
+        std::unique_ptr<FilterBitsBuilder> builder(policy->GetFilterBitsBuilder());
+        std::unique_ptr<FilterBitsBuilder> lex_builder(lex->GetFilterBitsBuilder());
+        char buffer[sizeof(int)];
+        // Repetitive prefixes, with 0x00 and 0x01 bytes in the keys.
+        auto key = [&](int i) {
+            return "tenant" + std::to_string(i % 3) + "/table" + std::to_string(i % 7) +
+                   "/row/" + Key(i, buffer).ToString();
+        };
+        for (int i = 1999; i >= 0; i -= 2) {
+            builder->AddKey(key(i));
+            builder->AddKey(key(i));
+            lex_builder->AddKey(key(i));
+        }
+        std::unique_ptr<const char[]> buf;
+        Slice filter = builder->Finish(&buf);
+        std::unique_ptr<const char[]> lex_buf;
+        Slice lex_filter = lex_builder->Finish(&lex_buf);
+        ASSERT_LT(filter.size(), lex_filter.size());
+        if (kVerbose >= 1) {
+            fprintf(stderr, "1000 keys: ot lex %d bytes, lex %d bytes\n",
+                    static_cast<int>(filter.size()), static_cast<int>(lex_filter.size()));
+        }
+
+        // Misaligned contents are copied, aligned ones are mapped in place.
+        std::string misaligned = "x" + filter.ToString();
+        for (const Slice& contents : {filter, Slice(misaligned.data() + 1, filter.size())}) {
+            std::unique_ptr<FilterBitsReader> reader(policy->GetFilterBitsReader(contents));
+            for (int i = 0; i < 2000; i++) {
+                ASSERT_EQ(i % 2 == 1, reader->MayMatch(key(i))) << i;
+            }
+            ASSERT_TRUE(! reader->MayMatch("tenant0"));
+            ASSERT_TRUE(! reader->MayMatch(key(1) + std::string(1, '\0')));
+        }
+
+        std::unique_ptr<FilterBitsReader> empty_reader(
+            policy->GetFilterBitsReader(Slice()));
+        ASSERT_TRUE(! empty_reader->MayMatch("hello"));
+
+        // The block based builder goes through CreateFilter.
+        std::unique_ptr<const FilterPolicy> block_based(NewOtLexPdtFilterPolicy(true));
+        ASSERT_TRUE(block_based->GetFilterBitsBuilder() == nullptr);
+        std::vector<std::string> keys;
+        for (int i = 0; i < 100; i++) {
+            keys.push_back(key(i * 3));
+        }
+        std::vector<Slice> slices(keys.begin(), keys.end());
+        std::string block_filter;
+        block_based->CreateFilter(slices.data(), static_cast<int>(slices.size()),
+                                  &block_filter);
+        for (int i = 0; i < 300; i++) {
+            ASSERT_EQ(i % 3 == 0, block_based->KeyMayMatch(key(i), block_filter)) << i;
+        }
+    }
+
+    TEST_F(PdtTest, RangeMayMatch) {
+        std::unique_ptr<const FilterPolicy> policy(NewLexPdtFilterPolicy());
+        std::unique_ptr<FilterBitsBuilder> builder(policy->GetFilterBitsBuilder());
+        char buffer[sizeof(int)];
+        // Big-endian keys, so bytewise order is numeric order.
+        auto key = [&](int i) {
+            EncodeFixed32(buffer, static_cast<uint32_t>(i));
+            std::reverse(buffer, buffer + sizeof(buffer));
+            return std::string(buffer, sizeof(buffer));
+        };
+        for (int i = 0; i < 100; i++) {
+            builder->AddKey(key(i * 10));
+        }
+        std::unique_ptr<const char[]> buf;
+        Slice filter = builder->Finish(&buf);
+        std::unique_ptr<FilterBitsReader> reader(policy->GetFilterBitsReader(filter));
+
+        for (int lo = 0; lo < 1000; lo += 3) {
+            for (int hi = lo + 1; hi <= lo + 25; hi++) {
+                bool expected = (lo + 9) / 10 * 10 < hi && (lo + 9) / 10 < 100;
+                ASSERT_EQ(expected, reader->RangeMayMatch(key(lo), key(hi)))
+                    << "[" << lo << ", " << hi << ")";
+            }
+        }
+        ASSERT_TRUE(reader->RangeMayMatch(Slice(), key(1)));
+        ASSERT_TRUE(! reader->RangeMayMatch(key(991), key(100000)));
+        ASSERT_TRUE(! reader->RangeMayMatch(key(5), key(5)));
+
+        std::unique_ptr<FilterBitsReader> empty_reader(
+            policy->GetFilterBitsReader(Slice()));
+        ASSERT_TRUE(! empty_reader->RangeMayMatch(Slice(), "z"));
+    }
+
+    TEST_F(PdtTest, PrefixMayMatch) {
+        char buffer[sizeof(int)];
+        std::vector<std::string> keys;
+        for (int i = 0; i < 500; i += 3) {
+            keys.push_back("tenant" + std::to_string(i % 5) + "/row/" + Key(i, buffer).ToString());
+        }
+        keys.push_back("tenant");
+        // Every prefix of a key, and one byte off every prefix.
+        std::set<std::string> present;
+        std::vector<std::string> probes;
+        for (const std::string& k : keys) {
+            for (size_t len = 0; len <= k.size(); len++) {
+                present.insert(k.substr(0, len));
+                probes.push_back(k.substr(0, len));
+                for (char c : {'\0', '\x01', '/', 'z'}) {
+                    probes.push_back(k.substr(0, len) + c);
+                }
+            }
+        }
+
+        std::unique_ptr<const FilterPolicy> policies[] = {
+            std::unique_ptr<const FilterPolicy>(NewLexPdtFilterPolicy()),
+            std::unique_ptr<const FilterPolicy>(NewCentriodPdtFilterPolicy()),
+            std::unique_ptr<const FilterPolicy>(NewOtLexPdtFilterPolicy())};
+        for (const auto& policy : policies) {
+            std::unique_ptr<FilterBitsBuilder> builder(policy->GetFilterBitsBuilder());
+            for (const std::string& k : keys) {
+                builder->AddKey(k);
+            }
+            std::unique_ptr<const char[]> buf;
+            Slice filter = builder->Finish(&buf);
+            std::unique_ptr<FilterBitsReader> reader(policy->GetFilterBitsReader(filter));
+            for (const std::string& p : probes) {
+                ASSERT_EQ(present.count(p) > 0, reader->PrefixMayMatch(p))
+                    << policy->Name() << " " << Slice(p).ToString(true);
+            }
+
+            std::unique_ptr<FilterBitsReader> empty_reader(
+                policy->GetFilterBitsReader(Slice()));
+            ASSERT_TRUE(! empty_reader->PrefixMayMatch("tenant"));
+        }
+    }
+
+    TEST_F(PdtTest, EmptyFilter) {
+        ASSERT_TRUE(! Matches("hello"));
+        ASSERT_TRUE(! Matches("world"));
+    }
 
     TEST_F(PdtTest, VaryingLengths) {
         char buffer[sizeof(int)];
@@ -139,7 +500,6 @@ namespace rocksdb {
 
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
-  ParseCommandLineFlags(&argc, &argv, true);
 
   return RUN_ALL_TESTS();
 }
\ No newline at end of file
@@ -45,7 +45,7 @@ struct size_node {
 namespace detail {
 class freeze_visitor : boost::noncopyable {
  public:
-  freeze_visitor(std::ofstream& fout, uint64_t flags)
+  freeze_visitor(std::ostream& fout, uint64_t flags)
       : m_fout(fout), m_flags(flags), m_written(0) {
     // Save freezing flags
     m_fout.write(reinterpret_cast<const char*>(&m_flags), sizeof(m_flags));
@@ -82,7 +82,7 @@ class freeze_visitor : boost::noncopyable {
   size_t written() const { return m_written; }
 
  protected:
-  std::ofstream& m_fout;
+  std::ostream& m_fout;
   const uint64_t m_flags;
   uint64_t m_written;
 };
@@ -210,7 +210,7 @@ class sizeof_visitor : boost::noncopyable {
 }
 
     template <typename T>
-size_t freeze(T& val, std::ofstream& fout, uint64_t flags = 0,
+size_t freeze(T& val, std::ostream& fout, uint64_t flags = 0,
               const char* friendly_name = "<TOP>") {
   detail::freeze_visitor freezer(fout, flags);
   freezer(val, friendly_name);
@@ -242,6 +242,68 @@ struct path_decomposed_trie {
     return index(val, stl_string_adaptor());
   }
 
+  // Same walk as index(), but stops as soon as the whole of `s` is consumed:
+  // true if some string of the set starts with `s`. `s` must not contain the
+  // terminator.
+  bool has_prefix(char_range s) const {
+    size_t len = boost::size(s);
+
+    size_t cur_pos = 0;
+    size_t cur_node_pos = 1;
+
+    size_t first_child_rank = 0;
+
+    while (true) {
+      if (cur_pos == len) return true;
+      size_t rank0 = cur_node_pos - first_child_rank - 1;
+
+      typename labels_pool_type::string_enumerator label_enumerator =
+          m_labels.get_string_enumerator(rank0);
+
+      size_t branching_chars_begin = 0;
+      size_t branching_chars = 0;
+      size_t last_branching_point = -1;
+      while (true) {
+        if (cur_pos == len) return true;
+
+        typename labels_pool_type::char_type label = label_enumerator.next();
+        if (label >= branching_point) {
+          branching_chars_begin += branching_chars;
+          branching_chars = label - branching_point + 1;
+          last_branching_point = cur_pos;
+        } else {
+          uint8_t c = s.first[cur_pos];
+          // The terminator never matches `c`, so the walk leaves the node
+          // here at the latest.
+          if (label != c) {
+            if (last_branching_point != cur_pos) return false;
+            break;
+          }
+          cur_pos += 1;
+        }
+      }
+
+      bool found_child = false;
+
+      for (size_t i = branching_chars_begin;
+           i < branching_chars_begin + branching_chars; ++i) {
+        uint8_t c = m_branching_chars[first_child_rank + i];
+        if (s.first[cur_pos] == c) {
+          cur_pos += 1;
+          found_child = true;
+
+          size_t child = i;
+          size_t child_open = cur_node_pos + child;
+          cur_node_pos = m_bp.find_close(child_open) + 1;
+          first_child_rank += child + (cur_node_pos - child_open) / 2;
+          break;
+        }
+      }
+
+      if (!found_child) return false;
+    }
+  }
+
   std::string operator[](size_t idx) const {
     std::string ret;
     ret.reserve(256);  // reasonable tradeoff
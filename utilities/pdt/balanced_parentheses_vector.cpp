@@ -223,6 +223,10 @@ namespace succinct {
     // `pos`: bit index
     uint64_t BpVector::find_open(uint64_t pos) const {
         assert(pos);
+        // The mate of most ")" is right before it (the leaves).
+        if ((*this)[pos - 1]) {
+            return pos - 1;
+        }
         uint64_t ret = -1U;
         // Search in current word
         uint64_t word_pos = (pos / 64);
@@ -310,6 +314,10 @@ namespace succinct {
 
     uint64_t BpVector::find_close(uint64_t pos) const {
         assert((*this)[pos]); // check there is an opening parenthesis in pos
+        // The mate of most "(" is right after it (the leaves).
+        if (!(*this)[pos + 1]) {
+            return pos + 1;
+        }
         uint64_t ret = -1U;
         // Search in current word
         uint64_t word_pos = (pos + 1) / 64;
@@ -635,6 +643,7 @@ namespace succinct {
     }
 
     void BpVector::build_min_tree() {
+        m_internal_nodes_ = 0;
         if (!size()) return;
 
         std::vector<block_min_excess_t> block_excess_min;
@@ -56,7 +56,7 @@ namespace succinct {
     //
     class BpVector : public RsBitVector {
     public:
-        BpVector() : RsBitVector() {}
+        BpVector() : RsBitVector(), m_internal_nodes_(0) {}
 
         BpVector(const std::vector<bool>& bools,
                  bool with_select_hints = false,
@@ -81,6 +81,29 @@ namespace succinct {
             build_min_tree();
         }
 
+        typedef int32_t excess_t;
+        typedef int16_t block_min_excess_t;
+
+        // The constructor is used for decoding with persisted indices.
+        // Both rank/select indices and min-excess tree are mapped, so the
+        // construction is O(1) and no memory is allocated.
+        BpVector(const uint64_t* raw_data,
+                 uint64_t word_size,
+                 size_t bit_size,
+                 const uint64_t* rank_pairs, uint64_t rank_pairs_len,
+                 const uint64_t* select_hints, uint64_t select_hints_len,
+                 const uint64_t* select0_hints, uint64_t select0_hints_len,
+                 uint64_t internal_nodes,
+                 const block_min_excess_t* block_excess_min, uint64_t block_excess_min_len,
+                 const excess_t* superblock_excess_min, uint64_t superblock_excess_min_len)
+                 : RsBitVector(raw_data, word_size, bit_size,
+                               rank_pairs, rank_pairs_len,
+                               select_hints, select_hints_len,
+                               select0_hints, select0_hints_len)
+                 , m_internal_nodes_(internal_nodes)
+                 , m_block_excess_min_(block_excess_min, block_excess_min_len)
+                 , m_superblock_excess_min_(superblock_excess_min, superblock_excess_min_len) {}
+
         void swap(BpVector& other) {
             RsBitVector::swap(other);
             std::swap(m_internal_nodes_, other.m_internal_nodes_);
@@ -92,8 +115,6 @@ namespace succinct {
 
         uint64_t find_close(uint64_t pos) const;
 
-        typedef int32_t excess_t;
-
         excess_t excess(uint64_t pos) const {
             return static_cast<excess_t>(2 * rank(pos) - pos);
         }
@@ -105,12 +126,28 @@ namespace succinct {
             return excess_rmq(a, b, foo);
         }
 
+        // min-excess tree accessors, used for persisting the indices.
+        uint64_t get_internal_nodes() const {
+            return m_internal_nodes_;
+        }
+
+        const mappable_vector<block_min_excess_t>& get_block_excess_min() const {
+            return m_block_excess_min_;
+        }
+
+        const mappable_vector<excess_t>& get_superblock_excess_min() const {
+            return m_superblock_excess_min_;
+        }
+
+        uint64_t owned_bytes() const {
+            return RsBitVector::owned_bytes() + m_block_excess_min_.owned_bytes() +
+                   m_superblock_excess_min_.owned_bytes();
+        }
+
     protected:
         static const size_t bp_block_size = 4; // to increase confusion, bp block_size is not necessarily rs_bit_vector block_size
         static const size_t superblock_size = 32; // number of blocks in superblock
 
-        typedef int16_t block_min_excess_t;
-
         // return true if we can find matched "(" in block, the position is returned by `ret`
         // `ret` is the bit index relative to `m_bits_`.
         //
@@ -7,6 +7,15 @@
 
 #include <cstdint>
 #include <cassert>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+// `pdep`/`tzcnt` can be used for in-word select. When the build does not
+// target BMI2 (e.g. PORTABLE=ON) the instructions are still compiled into a
+// separate function and picked at runtime if the cpu supports them.
+#define PDT_HAVE_BMI2_TARGET
+#endif
+
 namespace rocksdb {
 namespace succinct {
     namespace util {
@@ -125,7 +134,11 @@ namespace succinct {
         // count set-bits in `x`.
         // idea: Divide & Conquer, similar with `reserve_bits`
         inline uint64_t popcount(uint64_t x) {
+#if defined(__POPCNT__)
+            return static_cast<uint64_t>(__builtin_popcountll(x));
+#else
             return bytes_sum(byte_counts(x));
+#endif
         }
 
         // REQUIRE: x has only 1 bit set.
@@ -139,6 +152,9 @@ namespace succinct {
             if (!x) {
                 return false;
             }
+#if defined(__GNUC__) || defined(__clang__)
+            ret = static_cast<unsigned long>(63 - __builtin_clzll(x));
+#else
             // set the bit that is lower than MSB to 1
             x |= x >> 1;
             x |= x >> 2;
@@ -149,6 +165,7 @@ namespace succinct {
             // isolate the MSB
             x ^= x >> 1;
             ret = bit_position(x);
+#endif
             return true;
         }
 
@@ -166,7 +183,11 @@ namespace succinct {
             if (!x) {
                 return false;
             }
+#if defined(__GNUC__) || defined(__clang__)
+            ret = static_cast<unsigned long>(__builtin_ctzll(x));
+#else
             ret = bit_position(x & (-x));
+#endif
             return true;
         }
 
@@ -184,9 +205,9 @@ namespace succinct {
             return (((((y | indicator) - (x & (~indicator))) & (~(x ^ y))) | (x & (~y))) & indicator) >> 7;
         }
 
-        // get position of `k`-th 1-bit in `x`.
+        // get position of `k`-th 1-bit in `x` without any special instruction.
         // `k` starts from 0.
-        inline uint64_t select_in_word(const uint64_t x, const uint64_t k) {
+        inline uint64_t select_in_word_broadword(const uint64_t x, const uint64_t k) {
             assert(k < popcount(x));
 
             uint64_t byte_sums = byte_counts(x) * BYTE_UNIT;
@@ -204,6 +225,36 @@ namespace succinct {
             return byte_block_pos +
                 select_in_byte[((x >> byte_block_pos) & (uint64_t(0xFF))) | (byte_rank << 8)];
         }
+
+#ifdef PDT_HAVE_BMI2_TARGET
+        // `pdep` deposits the single bit of `1 << k` at the position of the
+        // `k`-th 1-bit of `x`, `tzcnt` reads the position back.
+        __attribute__((__target__("bmi,bmi2")))
+        inline uint64_t select_in_word_bmi2(const uint64_t x, const uint64_t k) {
+            return _tzcnt_u64(_pdep_u64(uint64_t(1) << k, x));
+        }
+
+        inline bool cpu_has_bmi2() {
+            static const bool has_bmi2 = __builtin_cpu_supports("bmi2");
+            return has_bmi2;
+        }
+#endif
+
+        // get position of `k`-th 1-bit in `x`.
+        // `k` starts from 0.
+        inline uint64_t select_in_word(const uint64_t x, const uint64_t k) {
+            assert(k < popcount(x));
+#if defined(__BMI2__)
+            return _tzcnt_u64(_pdep_u64(uint64_t(1) << k, x));
+#else
+#ifdef PDT_HAVE_BMI2_TARGET
+            if (cpu_has_bmi2()) {
+                return select_in_word_bmi2(x, k);
+            }
+#endif
+            return select_in_word_broadword(x, k);
+#endif
+        }
     }
 }
 }
@@ -246,6 +246,10 @@ namespace succinct {
             return m_size_;
         }
 
+        uint64_t owned_bytes() const {
+            return m_bits_.owned_bytes();
+        }
+
         // get bit at `pos`.
         inline bool operator[](uint64_t pos) const {
             assert(pos < m_size_);
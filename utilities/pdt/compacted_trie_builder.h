@@ -26,7 +26,15 @@ namespace succinct {
             }
 
             void append(std::vector<uint8_t>& raw_bytes) {
-                std::vector<uint16_t> bytes(raw_bytes.begin(), raw_bytes.end());
+                append(raw_bytes.data(), raw_bytes.size());
+            }
+
+            // Strings must be appended in strictly increasing order. The
+            // bytes are copied, nothing is allocated once the buffers have
+            // grown to the longest string.
+            void append(const uint8_t* raw_bytes, size_t len) {
+                std::vector<uint16_t>& bytes = next_string;
+                bytes.assign(raw_bytes, raw_bytes + len);
                 bytes.push_back(1024);
 
                 assert(!is_finish_);
@@ -34,7 +42,7 @@ namespace succinct {
 
                 if (node_stack.empty()) {
                     // first bytes
-                    last_string.assign(bytes.begin(), bytes.end());
+                    last_string.swap(bytes);
                     node_stack.push_back(node(0, last_string.size()));
                 } else {
                     size_t min_len = std::min(bytes.size(), last_string.size());
@@ -87,8 +95,8 @@ namespace succinct {
                     // open a new leaf with the current suffix
                     node_stack.push_back(node(mismatch_idx + 1, bytes.size() - mismatch_idx - 1));
 
-                    // copy the current string (iter could be invalid in next iteration)
-                    last_string.assign(bytes.begin(), bytes.end());
+                    // keep the current string, the buffer of the last one is reused
+                    last_string.swap(bytes);
                 }
             }
 
@@ -147,6 +155,7 @@ namespace succinct {
             TreeBuilder& builder;
             std::vector<node> node_stack;
             std::vector<uint16_t> last_string;
+            std::vector<uint16_t> next_string;
 
         };
     }
@@ -0,0 +1,125 @@
+//
+// Elias-Fano encoding of a monotone sequence, in the style of RsBitVector.
+//
+
+#ifndef PATH_DECOMPOSITION_TRIE_ELIAS_FANO_VECTOR_H
+#define PATH_DECOMPOSITION_TRIE_ELIAS_FANO_VECTOR_H
+
+#include <vector>
+
+#include "rank_select_bit_vector.h"
+
+namespace rocksdb {
+namespace succinct {
+
+    // EliasFanoVector keeps `n` non-decreasing values in [0, `universe`] in
+    // about 2 + log(universe / n) bits each. Every value is split into
+    // `m_low_width_` low bits and the remaining high bits:
+    //
+    //   low bits:   the low bits of all the values, concatenated
+    //               +-------+-------+-------+     +-------+
+    //               | low 0 | low 1 | low 2 | ... | low n |
+    //               +-------+-------+-------+     +-------+
+    //
+    //   high bits:  the i-th 1-bit is at (value i >> m_low_width_) + i
+    //               (the high bits in unary, gaps are 0-bits)
+    //
+    // so the i-th value is (select(i) - i) << m_low_width_ | low i, one select
+    // on the (hinted) high bits and one read of the low bits.
+    class EliasFanoVector {
+    public:
+        EliasFanoVector() : m_size_(0), m_low_width_(0) {}
+
+        explicit EliasFanoVector(const std::vector<uint64_t>& values) {
+            build(values.data(), values.size());
+        }
+
+        // Encode `size` non-decreasing values read from `values`.
+        EliasFanoVector(const uint64_t* values, uint64_t size) {
+            build(values, size);
+        }
+
+        // The constructor is used for decoding with persisted indices,
+        // nothing is rebuilt.
+        EliasFanoVector(uint64_t size, uint64_t low_width,
+                        const uint64_t* high_data, uint64_t high_word_size, size_t high_bit_size,
+                        const uint64_t* rank_pairs, uint64_t rank_pairs_len,
+                        const uint64_t* select_hints, uint64_t select_hints_len,
+                        const uint64_t* low_data, uint64_t low_word_size)
+                        : m_size_(size)
+                        , m_low_width_(low_width)
+                        , m_high_bits_(high_data, high_word_size, high_bit_size,
+                                       rank_pairs, rank_pairs_len,
+                                       select_hints, select_hints_len,
+                                       nullptr, 0)
+                        , m_low_bits_(low_data, low_word_size, size * low_width) {}
+
+        void swap(EliasFanoVector& other) {
+            std::swap(m_size_, other.m_size_);
+            std::swap(m_low_width_, other.m_low_width_);
+            m_high_bits_.swap(other.m_high_bits_);
+            m_low_bits_.swap(other.m_low_bits_);
+        }
+
+        inline uint64_t size() const {
+            return m_size_;
+        }
+
+        // get the `i`-th value, `i` starts from 0.
+        inline uint64_t operator[](uint64_t i) const {
+            assert(i < m_size_);
+            uint64_t high = m_high_bits_.select(i) - i;
+            return (high << m_low_width_) | m_low_bits_.get_bits(i * m_low_width_, m_low_width_);
+        }
+
+        // accessors, used for persisting the sequence.
+        uint64_t low_width() const {
+            return m_low_width_;
+        }
+
+        const RsBitVector& high_bits() const {
+            return m_high_bits_;
+        }
+
+        const BitVector& low_bits() const {
+            return m_low_bits_;
+        }
+
+        uint64_t owned_bytes() const {
+            return m_high_bits_.owned_bytes() + m_low_bits_.owned_bytes();
+        }
+
+    private:
+        void build(const uint64_t* values, uint64_t size) {
+            m_size_ = size;
+            m_low_width_ = 0;
+            uint64_t universe = size ? values[size - 1] : 0;
+            while (size && (universe >> m_low_width_) > size) {
+                ++m_low_width_;
+            }
+
+            BitVectorBuilder high((universe >> m_low_width_) + size + 1);
+            BitVectorBuilder low;
+            low.reserve(size * m_low_width_);
+            const uint64_t low_mask = (uint64_t(1) << m_low_width_) - 1;
+            for (uint64_t i = 0; i < size; i++) {
+                assert(i == 0 || values[i - 1] <= values[i]);
+                high.set((values[i] >> m_low_width_) + i, true);
+                low.append_bits(values[i] & low_mask, m_low_width_);
+            }
+
+            RsBitVector high_bits(&high, true, false);
+            m_high_bits_.swap(high_bits);
+            BitVector low_bits(&low);
+            m_low_bits_.swap(low_bits);
+        }
+
+        uint64_t m_size_;
+        uint64_t m_low_width_;
+        RsBitVector m_high_bits_;
+        BitVector m_low_bits_;
+    };
+}
+}
+
+#endif //PATH_DECOMPOSITION_TRIE_ELIAS_FANO_VECTOR_H
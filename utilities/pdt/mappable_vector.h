@@ -86,6 +86,11 @@ namespace succinct {
             return m_size;
         }
 
+        // Bytes allocated by the vector, 0 when it maps memory it doesn't own.
+        uint64_t owned_bytes() const {
+            return m_deleter ? m_size * sizeof(T) : 0;
+        }
+
         inline const_iterator begin() const {
             return m_data;
         }
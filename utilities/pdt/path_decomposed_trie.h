@@ -5,10 +5,14 @@
 #ifndef PATH_DECOMPOSITION_TRIE_PATH_DECOMPOSED_TRIE_H
 #define PATH_DECOMPOSITION_TRIE_PATH_DECOMPOSED_TRIE_H
 
+#include <algorithm>
+#include <string>
+
 #include "util/coding.h"
 #include "compacted_trie_builder.h"
 #include "default_tree_builder.h"
 #include "balanced_parentheses_vector.h"
+#include "elias_fano_vector.h"
 
 namespace rocksdb {
 namespace succinct {
@@ -19,8 +23,8 @@ namespace succinct {
             mappable_vector<uint16_t> m_labels;      // `L` in paper
             mappable_vector<uint16_t> m_branches;     // `B` in paper
             BpVector m_bp;                       // `BP` in paper
-            // TODO: Use elias-fano encoding later.
-            mappable_vector<uint64_t> word_positions;
+            // Label index where each node begins, plus `m_labels.size()`.
+            EliasFanoVector word_positions;
             bool is_portable = false;
 
             DefaultPathDecomposedTrie(compacted_trie_builder
@@ -31,8 +35,10 @@ namespace succinct {
                         root = trieBuilder.get_root();
                 m_labels.steal(root->m_labels);
                 m_branches.steal(root->m_branches);
-                // [double free error] m_bp = BpVector(&root->m_bp, false, true);(fxxk c++!!!!)
-                auto tmp = BpVector(&root->m_bp, false, true);
+                // [double free error] m_bp = BpVector(&root->m_bp, true, true);(fxxk c++!!!!)
+                // Both select hints are built, they are persisted with the trie
+                // so that select/select0 don't binary search the whole vector.
+                auto tmp = BpVector(&root->m_bp, true, true);
                 m_bp.swap(tmp);
 
                 assert(m_labels.back() == DefaultTreeBuilder<Lexicographic>::DELIMITER_FLAG);
@@ -47,7 +53,8 @@ namespace succinct {
                     }
                 }
                 tmp_vec.push_back(m_labels.size());
-                word_positions.steal(tmp_vec);
+                EliasFanoVector positions(tmp_vec);
+                word_positions.swap(positions);
             }
 
             // The constructor is used for decoding.
@@ -59,9 +66,38 @@ namespace succinct {
                                       : m_labels(label_ptr, label_len)
                                       , m_branches(branch_ptr, branch_len)
                                       , m_bp(raw_data, word_size, bit_size, false, true)
-                                      , word_positions(pos_ptr, pos_len)
+                                      , word_positions(decode_positions(pos_ptr, pos_len, portable))
                                       , is_portable(portable) {}
 
+            // The constructor is used for decoding with a BpVector and word
+            // positions whose indices have been mapped already, both are
+            // swapped into the trie.
+            DefaultPathDecomposedTrie(const uint16_t* label_ptr, uint64_t label_len,
+                                      const uint16_t* branch_ptr, uint64_t branch_len,
+                                      BpVector& bp, EliasFanoVector& positions,
+                                      bool portable = false)
+                                      : m_labels(label_ptr, label_len)
+                                      , m_branches(branch_ptr, branch_len)
+                                      , is_portable(portable) {
+                m_bp.swap(bp);
+                word_positions.swap(positions);
+            }
+
+            // The constructor is used for decoding with a BpVector whose indices
+            // have been mapped already, `bp` is swapped into the trie. The raw
+            // word positions are encoded again.
+            DefaultPathDecomposedTrie(const uint16_t* label_ptr, uint64_t label_len,
+                                      const uint16_t* branch_ptr, uint64_t branch_len,
+                                      BpVector& bp,
+                                      const uint64_t* pos_ptr, uint64_t pos_len,
+                                      bool portable = false)
+                                      : m_labels(label_ptr, label_len)
+                                      , m_branches(branch_ptr, branch_len)
+                                      , word_positions(decode_positions(pos_ptr, pos_len, portable))
+                                      , is_portable(portable) {
+                m_bp.swap(bp);
+            }
+
             const mappable_vector<uint16_t> &get_labels() const {
                 return m_labels;
             }
@@ -75,7 +111,7 @@ namespace succinct {
                 return m_bp;
             }
 
-            const mappable_vector<uint64_t> &get_word_pos() const {
+            const EliasFanoVector &get_word_pos() const {
                 return word_positions;
             }
 
@@ -83,6 +119,13 @@ namespace succinct {
                 return m_labels.size() + m_branches.size() + m_bp.size();
             }
 
+            // Bytes allocated by the trie, beyond the data it maps. A mapped
+            // trie owns the indices that were not persisted with it.
+            size_t owned_bytes() const {
+                return static_cast<size_t>(m_labels.owned_bytes() + m_branches.owned_bytes() +
+                                           m_bp.owned_bytes() + word_positions.owned_bytes());
+            }
+
             bool get_branch_idx_by_node_idx(size_t node_idx, size_t& end, size_t& num) const {
                 size_t bp_idx = m_bp.select0(node_idx);
                 if (m_bp.rank(bp_idx) < 2) {
@@ -119,87 +162,192 @@ namespace succinct {
                 return true;
             }
 
-            // In rocksdb, we will not use string any more, maybe InternalKey...
-            // get the index of `val` in the string set, if not exists return -1.
+            // State of matching a key in a node. `matching_idx` symbols of the
+            // key were consumed before entering the node.
+            struct node_cursor {
+                size_t node_idx;
+                size_t matching_idx;
+                size_t label_idx;      // first label of the node
+                size_t bp_idx;         // `m_bp.select0(node_idx)`
+                size_t branch_begin;   // first branch of the node in `m_branches`
+                size_t branch_end;     // last branch of the node in `m_branches`
+            };
+
+            // Deepest path of a batched lookup remembered for the next key.
+            static const size_t MAX_BATCH_DEPTH = 64;
+
+            // get the index of `key` in the string set, if not exists return -1.
+            int index(const Slice& key) const {
+                node_cursor root;
+                enter_node(0, 0, &root);
+                return match(key, root, nullptr, nullptr, 0);
+            }
+
             int index(const std::string &s) const {
-                std::vector<uint16_t> val;
-                val.resize(s.size());
-                std::transform(s.begin(), s.end(), val.begin(), [] (char c) {
-                    return static_cast<uint16_t>(static_cast<uint8_t>(c));
-                });
-                val.push_back(DefaultTreeBuilder<Lexicographic>::WORD_EOF);
-                size_t len = val.size();
-                size_t cur_node_idx = 0;
-                size_t matching_idx = 0;
-                // matching in the trie.
+                return index(Slice(s));
+            }
+
+            int index(const char* s) const {
+                return index(Slice(s));
+            }
+
+            // Look up `num_keys` keys, `res[i]` is set to the index of `*keys[i]`
+            // or -1. Nodes on the common prefix of two consecutive keys are
+            // matched once, so keys should be sorted to share as much as possible.
+            void index(const Slice* const* keys, size_t num_keys, int* res) const {
+                node_cursor path[MAX_BATCH_DEPTH];
+                size_t path_len = 1;
+                enter_node(0, 0, &path[0]);
+                for (size_t i = 0; i < num_keys; i++) {
+                    size_t resume = 0;
+                    if (i > 0) {
+                        size_t lcp = common_prefix(*keys[i - 1], *keys[i]);
+                        while (resume + 1 < path_len &&
+                               path[resume + 1].matching_idx <= lcp) {
+                            resume++;
+                        }
+                    }
+                    // `match` records the resumed node again.
+                    path_len = resume;
+                    res[i] = match(*keys[i], path[resume], path, &path_len, MAX_BATCH_DEPTH);
+                }
+            }
+
+            // True if some key of the set starts with `prefix`. The walk stops
+            // as soon as the prefix is consumed, so it never goes deeper than
+            // the prefix whatever the length of the keys.
+            bool has_prefix(const Slice& prefix) const {
+                if (!num_keys()) return false;
+                node_cursor c;
+                enter_node(0, 0, &c);
                 while (true) {
-                    size_t cur_label_idx = static_cast<size_t>(get_portable64(word_positions[cur_node_idx]));
-                    size_t cur_node_bp_idx = m_bp.select0(cur_node_idx);
-                    size_t all_branch_num = 0, branch_end = 0;
-                    get_branch_idx_by_node_idx(cur_node_idx, branch_end, all_branch_num);
-                    size_t cur_branch_idx = (branch_end + 1) - all_branch_num;
-                    // matching in a node.
-                    while (true) {
-                        if (get_portable16(m_labels[cur_label_idx]) ==
-                            DefaultTreeBuilder<Lexicographic>::DELIMITER_FLAG) {
-                            return (matching_idx == len ? cur_node_idx : -1);
+                    size_t cur_label_idx = c.label_idx;
+                    size_t cur_branch_idx = c.branch_begin;
+                    size_t matching_idx = c.matching_idx;
+                    bool find_branch = false;
+                    while (!find_branch) {
+                        if (matching_idx == prefix.size()) {
+                            return true;
                         }
-                        if (matching_idx >= len) {
-                            return -1;
+                        uint16_t label = get_portable16(m_labels[cur_label_idx]);
+                        if (label == DefaultTreeBuilder<Lexicographic>::DELIMITER_FLAG) {
+                            return false;
                         }
-                        if (get_portable16(m_labels[cur_label_idx]) >> 8 == 1) {
-                            // assert(get_portable16(m_labels[cur_label_idx + 1]) >> 8 == 0);
+                        uint16_t symbol = symbol_at(prefix, matching_idx);
+                        if (label >> 8 == 1) {
                             auto branch0 = get_portable16(m_labels[cur_label_idx + 1]);
-                            size_t cur_branch_num = static_cast<uint8_t>(get_portable16(m_labels[cur_label_idx])) + 1;
-
-                            if (branch0 == val[matching_idx]) {
-                                // update `cur_branch_idx`.
+                            size_t cur_branch_num = static_cast<uint8_t>(label) + 1;
+                            if (branch0 == symbol) {
                                 cur_branch_idx += cur_branch_num;
                                 matching_idx++;
                                 cur_label_idx += 2;
                                 continue;
-                            } else {
-                                // check branches.
-                                assert(cur_branch_num <= all_branch_num);
-                                bool find_branch = false;
-                                size_t cur_branch_end = cur_branch_idx + cur_branch_num - 1;
-                                while (cur_branch_idx <= cur_branch_end) {
-                                    if (get_portable16(m_branches[cur_branch_idx]) == val[matching_idx]) {
-                                        matching_idx++;
-                                        // update `cur_node_idx`.
-                                        cur_node_idx = get_node_idx_by_branch_idx(
-                                                cur_node_bp_idx + cur_branch_idx - (branch_end + 1)
-                                                );
-                                        find_branch = true;
-                                        break;
-                                    }
-                                    cur_branch_idx++;
+                            }
+                            size_t cur_branch_end = cur_branch_idx + cur_branch_num;
+                            for (; cur_branch_idx < cur_branch_end; cur_branch_idx++) {
+                                if (get_portable16(m_branches[cur_branch_idx]) == symbol) {
+                                    enter_node(child_by_branch(c, cur_branch_idx),
+                                               matching_idx + 1, &c);
+                                    find_branch = true;
+                                    break;
                                 }
-                                if (find_branch) break;
-                                return -1;
                             }
+                            if (!find_branch) return false;
                         } else {
-                            if (get_portable16(m_labels[cur_label_idx]) == val[matching_idx]) {
+                            if (label != symbol) {
+                                return false;
+                            }
+                            matching_idx++;
+                            cur_label_idx++;
+                        }
+                    }
+                }
+            }
+
+            // Number of keys in the set.
+            size_t num_keys() const {
+                return word_positions.size() ? static_cast<size_t>(word_positions.size()) - 1 : 0;
+            }
+
+            // Index of the first key not less than `key`, `num_keys()` if none.
+            // Node indices follow the key order in a lexicographic trie only: a
+            // node holds the smallest key of its subtree, followed by the subtrees
+            // hanging off its path from the deepest branching point up, and the
+            // branches of a point are stored in descending order.
+            size_t lower_bound(const Slice& key) const {
+                assert(Lexicographic);
+                if (!num_keys()) return 0;
+                // end of the subtree of the current node
+                size_t sub_end = num_keys();
+                node_cursor c;
+                enter_node(0, 0, &c);
+                while (true) {
+                    size_t cur_label_idx = c.label_idx;
+                    size_t cur_branch_idx = c.branch_begin;
+                    size_t matching_idx = c.matching_idx;
+                    bool find_branch = false;
+                    while (!find_branch) {
+                        uint16_t label = get_portable16(m_labels[cur_label_idx]);
+                        if (label == DefaultTreeBuilder<Lexicographic>::DELIMITER_FLAG) {
+                            return c.node_idx;
+                        }
+                        uint16_t symbol = symbol_at(key, matching_idx);
+                        if (label >> 8 == 1) {
+                            auto branch0 = get_portable16(m_labels[cur_label_idx + 1]);
+                            size_t cur_branch_num = static_cast<uint8_t>(label) + 1;
+                            if (branch0 == symbol) {
+                                cur_branch_idx += cur_branch_num;
                                 matching_idx++;
-                            } else {
-                                return -1;
+                                cur_label_idx += 2;
+                                continue;
+                            }
+                            if (symbol_order(symbol) < symbol_order(branch0)) {
+                                return c.node_idx;
+                            }
+                            size_t b = cur_branch_idx;
+                            size_t b_end = cur_branch_idx + cur_branch_num;
+                            while (b < b_end &&
+                                   symbol_order(get_portable16(m_branches[b])) > symbol_order(symbol)) {
+                                b++;
+                            }
+                            if (b < b_end && get_portable16(m_branches[b]) == symbol) {
+                                if (b > c.branch_begin) {
+                                    sub_end = child_by_branch(c, b - 1);
+                                }
+                                enter_node(child_by_branch(c, b), matching_idx + 1, &c);
+                                find_branch = true;
+                                break;
                             }
+                            // The first greater key starts the subtree of branch `b - 1`.
+                            return b > c.branch_begin ? child_by_branch(c, b - 1) : sub_end;
+                        }
+                        if (label == symbol) {
+                            matching_idx++;
+                            cur_label_idx++;
+                            continue;
+                        }
+                        if (symbol_order(symbol) < symbol_order(label)) {
+                            return c.node_idx;
                         }
-                        cur_label_idx++;
+                        // Greater than the path and the subtrees of deeper branching points.
+                        return cur_branch_idx > c.branch_begin
+                               ? child_by_branch(c, cur_branch_idx - 1) : sub_end;
                     }
                 }
             }
 
-            // It seems that we can't avoid copy for returning result.
-            // get `idx`-th string in string set.
-            std::vector<uint8_t> operator[](size_t idx) const {
-                std::vector<uint8_t> res;
-                if (idx + 1 >= word_positions.size()) return res;
+            // Append the `idx`-th string in string set to `key`. The key is
+            // rebuilt from the node up to the root in place, so nothing is
+            // allocated once `key` has the capacity.
+            void get_key(size_t idx, std::string* key) const {
+                if (idx + 1 >= word_positions.size()) return;
+                const size_t key_begin = key->size();
                 uint16_t branch;
                 size_t branch_no = 0;
                 do {
-                    if (get_portable64(word_positions[idx + 1]) < 2) continue;
-                    size_t cur_label_idx = static_cast<size_t>(get_portable64(word_positions[idx + 1])) - 2;
+                    const uint64_t next_word_pos = word_positions[idx + 1];
+                    if (next_word_pos < 2) continue;
+                    size_t cur_label_idx = static_cast<size_t>(next_word_pos) - 2;
                     size_t branch_cnt = 0;
                     while (true) {
                         if (get_portable16(m_labels[cur_label_idx]) ==
@@ -211,13 +359,13 @@ namespace succinct {
                             if (branch_no) {
                                 if (branch_cnt + cur_branch_num >= branch_no) {
                                     if (branch_cnt < branch_no) {
-                                        res.push_back(branch);
+                                        key->push_back(static_cast<char>(branch));
                                     } else {
-                                        res.push_back(static_cast<uint8_t>(get_portable16(m_labels[cur_label_idx])));
+                                        key->push_back(static_cast<char>(get_portable16(m_labels[cur_label_idx])));
                                     }
                                 }
                             } else {
-                                res.push_back(static_cast<uint8_t>(get_portable16(m_labels[cur_label_idx])));
+                                key->push_back(static_cast<char>(get_portable16(m_labels[cur_label_idx])));
                             }
                             branch_cnt += cur_branch_num;
                             if (cur_label_idx == 1) break;
@@ -225,19 +373,131 @@ namespace succinct {
                             continue;
                         } else {
                             if (!branch_no || branch_cnt >= branch_no) {
-                                res.push_back(static_cast<uint8_t>(get_portable16(m_labels[cur_label_idx])));
+                                key->push_back(static_cast<char>(get_portable16(m_labels[cur_label_idx])));
                             }
                         }
                         if (!cur_label_idx) break;
                         cur_label_idx--;
                     }
                 } while (get_parent_node_branch_by_node_idx(idx, idx, branch, branch_no));
-                std::reverse(res.begin(), res.end());
-                res.pop_back();
-                return res;
+                std::reverse(key->begin() + key_begin, key->end());
+                // drop the end of word symbol.
+                key->pop_back();
+            }
+
+            // get `idx`-th string in string set.
+            std::vector<uint8_t> operator[](size_t idx) const {
+                std::string key;
+                get_key(idx, &key);
+                return std::vector<uint8_t>(key.begin(), key.end());
             }
 
             private:
+                static size_t common_prefix(const Slice& a, const Slice& b) {
+                    size_t n = std::min(a.size(), b.size());
+                    size_t i = 0;
+                    while (i < n && a[i] == b[i]) i++;
+                    return i;
+                }
+
+                // `key` is matched as if WORD_EOF was appended.
+                static uint16_t symbol_at(const Slice& key, size_t i) {
+                    return i < key.size() ? static_cast<uint8_t>(key[i])
+                                          : DefaultTreeBuilder<Lexicographic>::WORD_EOF;
+                }
+
+                // WORD_EOF ends a key, so it goes before every byte.
+                static int symbol_order(uint16_t symbol) {
+                    return symbol == DefaultTreeBuilder<Lexicographic>::WORD_EOF ? -1 : symbol;
+                }
+
+                // Node reached by the `branch_idx`-th branch (in `m_branches`) of `c`.
+                size_t child_by_branch(const node_cursor& c, size_t branch_idx) const {
+                    return get_node_idx_by_branch_idx(c.bp_idx + branch_idx - (c.branch_end + 1));
+                }
+
+                void enter_node(size_t node_idx, size_t matching_idx, node_cursor* c) const {
+                    c->node_idx = node_idx;
+                    c->matching_idx = matching_idx;
+                    c->label_idx = static_cast<size_t>(word_positions[node_idx]);
+                    // The labels are needed right after the rank/select below.
+                    PREFETCH(m_labels.data() + c->label_idx, 0, 1);
+                    c->bp_idx = m_bp.select0(node_idx);
+                    size_t end = 0, num = 0;
+                    size_t rank = m_bp.rank(c->bp_idx);
+                    if (rank >= 2) {
+                        end = rank - 2;
+                        num = node_idx ? c->bp_idx - m_bp.predecessor0(c->bp_idx - 1) - 1
+                                       : end + 1;
+                    }
+                    c->branch_end = end;
+                    c->branch_begin = (end + 1) - num;
+                    if (num) {
+                        PREFETCH(m_branches.data() + c->branch_begin, 0, 1);
+                    }
+                }
+
+                // Match `key` from node `start`. Every node entered (`start`
+                // included) is appended to `path` while it has room.
+                int match(const Slice& key, node_cursor start, node_cursor* path,
+                          size_t* path_len, size_t path_cap) const {
+                    const size_t len = key.size() + 1;
+                    node_cursor c = start;
+                    // matching in the trie.
+                    while (true) {
+                        if (path != nullptr && *path_len < path_cap) {
+                            path[(*path_len)++] = c;
+                        }
+                        size_t cur_label_idx = c.label_idx;
+                        size_t cur_branch_idx = c.branch_begin;
+                        size_t matching_idx = c.matching_idx;
+                        bool find_branch = false;
+                        // matching in a node.
+                        while (!find_branch) {
+                            uint16_t label = get_portable16(m_labels[cur_label_idx]);
+                            if (label == DefaultTreeBuilder<Lexicographic>::DELIMITER_FLAG) {
+                                return (matching_idx == len ? static_cast<int>(c.node_idx) : -1);
+                            }
+                            if (matching_idx >= len) {
+                                return -1;
+                            }
+                            uint16_t symbol = symbol_at(key, matching_idx);
+                            if (label >> 8 == 1) {
+                                auto branch0 = get_portable16(m_labels[cur_label_idx + 1]);
+                                size_t cur_branch_num = static_cast<uint8_t>(label) + 1;
+
+                                if (branch0 == symbol) {
+                                    // update `cur_branch_idx`.
+                                    cur_branch_idx += cur_branch_num;
+                                    matching_idx++;
+                                    cur_label_idx += 2;
+                                    continue;
+                                }
+                                // check branches.
+                                assert(cur_branch_num <= c.branch_end + 1 - c.branch_begin);
+                                size_t cur_branch_end = cur_branch_idx + cur_branch_num - 1;
+                                while (cur_branch_idx <= cur_branch_end) {
+                                    if (get_portable16(m_branches[cur_branch_idx]) == symbol) {
+                                        // update `c` to the child.
+                                        enter_node(child_by_branch(c, cur_branch_idx),
+                                                   matching_idx + 1, &c);
+                                        find_branch = true;
+                                        break;
+                                    }
+                                    cur_branch_idx++;
+                                }
+                                if (!find_branch) return -1;
+                            } else {
+                                if (label != symbol) {
+                                    return -1;
+                                }
+                                matching_idx++;
+                                cur_label_idx++;
+                            }
+                        }
+                    }
+                }
+
                 inline uint16_t get_portable16(uint16_t n) const {
                     if (!is_portable) return n;
                     return DecodeFixed16(reinterpret_cast<const char*>(&n));
@@ -248,6 +508,17 @@ namespace succinct {
                     return DecodeFixed32(reinterpret_cast<const char*>(&n));
                 }
 
+                static std::vector<uint64_t> decode_positions(
+                        const uint64_t* pos_ptr, uint64_t pos_len, bool portable) {
+                    std::vector<uint64_t> positions(pos_ptr, pos_ptr + pos_len);
+                    if (portable) {
+                        for (auto& pos : positions) {
+                            pos = DecodeFixed64(reinterpret_cast<const char*>(&pos));
+                        }
+                    }
+                    return positions;
+                }
+
                 inline uint64_t get_portable64(uint64_t n) const {
                     if (!is_portable) return n;
                     return DecodeFixed64(reinterpret_cast<const char*>(&n));
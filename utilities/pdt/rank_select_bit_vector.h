@@ -66,6 +66,20 @@ namespace succinct {
             build_indices(with_select_hints, with_select0_hints);
         }
 
+        // The constructor is used for decoding with persisted indices.
+        // Nothing is rebuilt, all of the indices are mapped from the raw pointers.
+        // `select_hints_len`/`select0_hints_len` can be 0 if hints are not persisted.
+        RsBitVector(const uint64_t* raw_data,
+                    uint64_t word_size,
+                    size_t bit_size,
+                    const uint64_t* rank_pairs, uint64_t rank_pairs_len,
+                    const uint64_t* select_hints, uint64_t select_hints_len,
+                    const uint64_t* select0_hints, uint64_t select0_hints_len)
+                    : BitVector(raw_data, word_size, bit_size)
+                    , m_block_rank_pairs_(rank_pairs, rank_pairs_len)
+                    , m_select_hints_(select_hints, select_hints_len)
+                    , m_select0_hints_(select0_hints, select0_hints_len) {}
+
         void swap(RsBitVector& other) {
             BitVector::swap(other);
             m_block_rank_pairs_.swap(other.m_block_rank_pairs_);
@@ -185,6 +199,25 @@ namespace succinct {
             return word_offset * 64 + util::select_in_word(~m_bits_[word_offset], n - cur_rank0);
         }
 
+        // indices accessors, used for persisting the indices.
+        const mappable_vector<uint64_t>& get_block_rank_pairs() const {
+            return m_block_rank_pairs_;
+        }
+
+        const mappable_vector<uint64_t>& get_select_hints() const {
+            return m_select_hints_;
+        }
+
+        const mappable_vector<uint64_t>& get_select0_hints() const {
+            return m_select0_hints_;
+        }
+
+        // Bytes allocated by the bits and the indices built over them.
+        uint64_t owned_bytes() const {
+            return BitVector::owned_bytes() + m_block_rank_pairs_.owned_bytes() +
+                   m_select_hints_.owned_bytes() + m_select0_hints_.owned_bytes();
+        }
+
     protected:
         inline uint64_t num_blocks() const {
             // dummy block is excluded.
@@ -3,8 +3,10 @@
 //
 #include <gtest/gtest.h>
 #include <iostream>
+#include <random>
 #include "bit_vector.h"
 #include "rank_select_bit_vector.h"
+#include "elias_fano_vector.h"
 
 using namespace rocksdb;
 
@@ -60,6 +62,86 @@ TEST(BIT_VECTOR_TEST, SELECT_1) {
     EXPECT_EQ(res, s.size() - 1);
 }
 
+TEST(BIT_VECTOR_TEST, SELECT_IN_WORD) {
+    std::mt19937_64 rnd(301);
+    for (int i = 0; i < 10000; i++) {
+        uint64_t x = rnd() & rnd();
+        if (!x) {
+            continue;
+        }
+        uint64_t k = 0;
+        for (uint64_t pos = 0; pos < 64; pos++) {
+            if (!((x >> pos) & 1)) {
+                continue;
+            }
+            EXPECT_EQ(succinct::util::select_in_word(x, k), pos);
+            EXPECT_EQ(succinct::util::select_in_word_broadword(x, k), pos);
+#ifdef PDT_HAVE_BMI2_TARGET
+            if (succinct::util::cpu_has_bmi2()) {
+                EXPECT_EQ(succinct::util::select_in_word_bmi2(x, k), pos);
+            }
+#endif
+            k++;
+        }
+    }
+}
+
+TEST(BIT_VECTOR_TEST, SELECT_WITH_HINTS) {
+    std::mt19937_64 rnd(301);
+    for (int density : {2, 8, 64}) {
+        std::vector<bool> bools(100000);
+        std::vector<uint64_t> ones, zeros;
+        for (size_t i = 0; i < bools.size(); i++) {
+            bools[i] = rnd() % density == 0;
+            (bools[i] ? ones : zeros).push_back(i);
+        }
+        succinct::RsBitVector plain(bools);
+        succinct::RsBitVector hinted(bools, true, true);
+        EXPECT_EQ(plain.get_select_hints().size(), 0);
+        EXPECT_GT(hinted.get_select_hints().size(), 0);
+        EXPECT_GT(hinted.get_select0_hints().size(), 0);
+        for (uint64_t n = 0; n < ones.size(); n++) {
+            EXPECT_EQ(plain.select(n), ones[n]);
+            EXPECT_EQ(hinted.select(n), ones[n]);
+        }
+        for (uint64_t n = 0; n < zeros.size(); n++) {
+            EXPECT_EQ(plain.select0(n), zeros[n]);
+            EXPECT_EQ(hinted.select0(n), zeros[n]);
+        }
+    }
+}
+
+TEST(BIT_VECTOR_TEST, ELIAS_FANO) {
+    std::mt19937_64 rnd(301);
+    for (uint64_t max_gap : {1, 2, 10, 1000, 1000000}) {
+        std::vector<uint64_t> values;
+        uint64_t value = 0;
+        for (int i = 0; i < 10000; i++) {
+            value += rnd() % max_gap;
+            values.push_back(value);
+        }
+        succinct::EliasFanoVector ef(values);
+        ASSERT_EQ(ef.size(), values.size());
+        for (size_t i = 0; i < values.size(); i++) {
+            EXPECT_EQ(ef[i], values[i]);
+        }
+
+        // decode from the persisted words
+        auto& high = ef.high_bits();
+        succinct::EliasFanoVector mapped(
+                ef.size(), ef.low_width(),
+                high.data().data(), high.data().size(), high.size(),
+                high.get_block_rank_pairs().data(), high.get_block_rank_pairs().size(),
+                high.get_select_hints().data(), high.get_select_hints().size(),
+                ef.low_bits().data().data(), ef.low_bits().data().size());
+        for (size_t i = 0; i < values.size(); i++) {
+            EXPECT_EQ(mapped[i], values[i]);
+        }
+    }
+    succinct::EliasFanoVector empty(std::vector<uint64_t>{});
+    EXPECT_EQ(empty.size(), 0);
+}
+
 GTEST_API_ int main(int argc, char ** argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -305,6 +305,42 @@ TEST(PDT_TEST, INDEX_3) {
     }
 }
 
+TEST(PDT_TEST, INDEX_BATCH) {
+    succinct::DefaultTreeBuilder<true> pdt_builder;
+    succinct::trie::compacted_trie_builder
+            <succinct::DefaultTreeBuilder<true>>
+            trieBuilder(pdt_builder);
+    std::vector<std::string> strs{"p", "pa", "pac",
+                                  "pace", "pack", "packa", "package", "pacman", "pancake",
+                                  "pea", "peek", "peel", "pikachu",
+                                  "pod", "poe", "poem", "pok", "poke", "pokem", "pokemon",
+                                  "pool", "proof",
+                                  "three", "trial", "triangle", "triangular",
+                                  "triangulaus", "trie", "triple", "triply"};
+    for (auto s : strs) {
+        append_to_trie(trieBuilder, s);
+    }
+    trieBuilder.finish();
+
+    succinct::trie::DefaultPathDecomposedTrie<true> pdt(trieBuilder);
+
+    // Existing and missing keys, sorted, with duplicates.
+    std::vector<std::string> probes(strs);
+    probes.insert(probes.end(), {"", "pac", "pacm", "packages", "pe", "pokemons",
+                                 "tri", "triangl", "triangulate", "triplz", "z"});
+    std::sort(probes.begin(), probes.end());
+    std::vector<Slice> slices(probes.begin(), probes.end());
+    std::vector<const Slice*> keys;
+    for (auto& slice : slices) {
+        keys.push_back(&slice);
+    }
+    std::vector<int> res(keys.size());
+    pdt.index(keys.data(), keys.size(), res.data());
+    for (size_t i = 0; i < probes.size(); i++) {
+        EXPECT_EQ(res[i], pdt.index(probes[i])) << probes[i];
+    }
+}
+
 inline std::string ubyes2str(std::vector<uint8_t> ubyte) {
     return std::string(ubyte.begin(), ubyte.end());
 }
@@ -374,6 +410,60 @@ TEST(PDT_TEST, OPERATOR_INDEX_2) {
     EXPECT_EQ(ubyes2str(pdt[6]), "peel");
 }
 
+TEST(PDT_TEST, GET_KEY) {
+    succinct::DefaultTreeBuilder<true> pdt_builder;
+    succinct::trie::compacted_trie_builder
+            <succinct::DefaultTreeBuilder<true>>
+            trieBuilder(pdt_builder);
+    std::vector<std::string> strs{"", std::string("\0", 1), "pace", "package",
+                                  "pacman", "pancake", "pea", "peek", "peel",
+                                  "pokemon", "pool", "three", "trial", "trie"};
+    for (auto s : strs) {
+        append_to_trie(trieBuilder, s);
+    }
+    trieBuilder.finish();
+
+    succinct::trie::DefaultPathDecomposedTrie<true> pdt(trieBuilder);
+
+    // Keys are appended to what the buffer holds already.
+    std::string key = "prefix:";
+    for (size_t i = 0; i < strs.size(); i++) {
+        key.resize(7);
+        pdt.get_key(i, &key);
+        EXPECT_EQ(key, "prefix:" + strs[i]);
+        EXPECT_EQ(ubyes2str(pdt[i]), strs[i]);
+    }
+    key.clear();
+    pdt.get_key(strs.size(), &key);
+    EXPECT_TRUE(key.empty());
+}
+
+TEST(PDT_TEST, LOWER_BOUND) {
+    succinct::DefaultTreeBuilder<true> pdt_builder;
+    succinct::trie::compacted_trie_builder
+            <succinct::DefaultTreeBuilder<true>>
+            trieBuilder(pdt_builder);
+    std::vector<std::string> strs{"pace", "package", "pacman", "pancake",
+                                  "pea", "peek", "peel", "pikachu", "pod",
+                                  "pokemon", "pool", "proof", "three", "trial",
+                                  "triangle", "triangular", "trie", "triple"};
+    for (auto s : strs) {
+        append_to_trie(trieBuilder, s);
+    }
+    trieBuilder.finish();
+
+    succinct::trie::DefaultPathDecomposedTrie<true> pdt(trieBuilder);
+
+    std::vector<std::string> probes(strs);
+    probes.insert(probes.end(), {"", "a", "p", "pac", "pacz", "packagea", "pe",
+                                 "peeka", "pz", "tri", "triangl", "triangulaz",
+                                 "tripl", "triplz", "z"});
+    for (auto& probe : probes) {
+        size_t expected = std::lower_bound(strs.begin(), strs.end(), probe) - strs.begin();
+        EXPECT_EQ(pdt.lower_bound(probe), expected) << probe;
+    }
+}
+
 TEST(PDT_TEST, TEST_ONLY_ONE) {
     succinct::DefaultTreeBuilder<true> pdt_builder;
     succinct::trie::compacted_trie_builder
@@ -11,6 +11,7 @@ namespace rocksdb {
 
 namespace {
 const std::string kGhostCachePrefix = "ghost_";
+const std::string kTinyLFUCachePrefix = "tinylfu";
 }  // namespace
 
 GhostCache::GhostCache(std::shared_ptr<Cache> sim_cache)
@@ -212,31 +213,37 @@ Status BlockCacheTraceSimulator::InitializeCaches() {
                         /*high_pri_pool_ratio=*/0)));
         cache_name = cache_name.substr(kGhostCachePrefix.size());
       }
+      // The cache name starts with the eviction policy, lru or tinylfu, and
+      // ends with what the simulator caches.
+      bool tinylfu = false;
+      if (cache_name.compare(0, kTinyLFUCachePrefix.size(),
+                             kTinyLFUCachePrefix) == 0) {
+        tinylfu = true;
+        cache_name = "lru" + cache_name.substr(kTinyLFUCachePrefix.size());
+      }
+      auto new_cache = [&](double high_pri_pool_ratio) {
+        if (tinylfu) {
+          // High priority entries are always protected.
+          return NewTinyLFUCache(simulate_cache_capacity, config.num_shard_bits,
+                                 /*strict_capacity_limit=*/false);
+        }
+        return NewLRUCache(simulate_cache_capacity, config.num_shard_bits,
+                           /*strict_capacity_limit=*/false,
+                           high_pri_pool_ratio);
+      };
       if (cache_name == "lru") {
         sim_cache = std::make_shared<CacheSimulator>(
-            std::move(ghost_cache),
-            NewLRUCache(simulate_cache_capacity, config.num_shard_bits,
-                        /*strict_capacity_limit=*/false,
-                        /*high_pri_pool_ratio=*/0));
+            std::move(ghost_cache), new_cache(/*high_pri_pool_ratio=*/0));
       } else if (cache_name == "lru_priority") {
         sim_cache = std::make_shared<PrioritizedCacheSimulator>(
-            std::move(ghost_cache),
-            NewLRUCache(simulate_cache_capacity, config.num_shard_bits,
-                        /*strict_capacity_limit=*/false,
-                        /*high_pri_pool_ratio=*/0.5));
+            std::move(ghost_cache), new_cache(/*high_pri_pool_ratio=*/0.5));
       } else if (cache_name == "lru_hybrid") {
         sim_cache = std::make_shared<HybridRowBlockCacheSimulator>(
-            std::move(ghost_cache),
-            NewLRUCache(simulate_cache_capacity, config.num_shard_bits,
-                        /*strict_capacity_limit=*/false,
-                        /*high_pri_pool_ratio=*/0.5),
+            std::move(ghost_cache), new_cache(/*high_pri_pool_ratio=*/0.5),
             /*insert_blocks_upon_row_kvpair_miss=*/true);
       } else if (cache_name == "lru_hybrid_no_insert_on_row_miss") {
         sim_cache = std::make_shared<HybridRowBlockCacheSimulator>(
-            std::move(ghost_cache),
-            NewLRUCache(simulate_cache_capacity, config.num_shard_bits,
-                        /*strict_capacity_limit=*/false,
-                        /*high_pri_pool_ratio=*/0.5),
+            std::move(ghost_cache), new_cache(/*high_pri_pool_ratio=*/0.5),
             /*insert_blocks_upon_row_kvpair_miss=*/false);
       } else {
         // Not supported.
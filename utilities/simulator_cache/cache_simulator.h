@@ -14,7 +14,7 @@ namespace rocksdb {
 
 // A cache configuration provided by user.
 struct CacheConfiguration {
-  std::string cache_name;  // LRU.
+  std::string cache_name;  // LRU or TinyLFU.
   uint32_t num_shard_bits;
   uint64_t ghost_cache_capacity;  // ghost cache capacity in bytes.
   std::vector<uint64_t>
@@ -176,6 +176,27 @@ TEST_F(CacheSimulatorTest, PrioritizedCacheSimulator) {
   sim_cache->Release(handle);
 }
 
+TEST_F(CacheSimulatorTest, TinyLFUCacheSimulator) {
+  const BlockCacheTraceRecord& access = GenerateGetRecord(kGetId);
+  const BlockCacheTraceRecord& compaction_access = GenerateCompactionRecord();
+  std::shared_ptr<Cache> sim_cache =
+      NewTinyLFUCache(/*capacity=*/kCacheSize, /*num_shard_bits=*/1,
+                      /*strict_capacity_limit=*/false);
+  std::unique_ptr<PrioritizedCacheSimulator> cache_simulator(
+      new PrioritizedCacheSimulator(nullptr, sim_cache));
+  cache_simulator->Access(access);
+  cache_simulator->Access(access);
+  cache_simulator->Access(compaction_access);
+  ASSERT_EQ(3, cache_simulator->miss_ratio_stats().total_accesses());
+  ASSERT_EQ(2, cache_simulator->miss_ratio_stats().total_misses());
+
+  auto handle = sim_cache->Lookup(access.block_key);
+  ASSERT_NE(nullptr, handle);
+  sim_cache->Release(handle);
+  handle = sim_cache->Lookup(compaction_access.block_key);
+  ASSERT_EQ(nullptr, handle);
+}
+
 TEST_F(CacheSimulatorTest, GhostPrioritizedCacheSimulator) {
   const BlockCacheTraceRecord& access = GenerateGetRecord(kGetId);
   std::unique_ptr<GhostCache> ghost_cache(new GhostCache(